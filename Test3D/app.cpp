@@ -8,9 +8,14 @@
 #include "lua/script_system.h"
 
 #include "lua/lua_imgui.h"
+#include "util/log_file.h"
+#include "util/log_json.h"
+#include "util/logger.h"
 
 static HINSTANCE g_hInstance = nullptr;
 static HWND g_hWnd = nullptr;
+static FileLogSink* g_LogFile = nullptr;
+static JsonLogSink* g_LogJson = nullptr;
 
 LRESULT WINAPI _WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
@@ -74,6 +79,12 @@ static void _App_CreateWnd()
 
 bool App_Init()
 {
+	util_log_start_async(1 << 20, LogOverflow_Count);
+	g_LogFile = new FileLogSink("test3d.log", 4 << 20, 4);
+	util_log_add_sink(g_LogFile);
+	g_LogJson = new JsonLogSink("test3d.jsonl");
+	util_log_add_sink(g_LogJson);
+
 	if(!script_system_init())
 		return false;
 		
@@ -107,6 +118,14 @@ void App_UnInit()
 	D3D_UnInit();
 
 	UnregisterClass(_T("Testbed"), g_hInstance);
+
+	util_log_stop_async();
+	util_log_remove_sink(g_LogFile);
+	delete g_LogFile;
+	g_LogFile = nullptr;
+	util_log_remove_sink(g_LogJson);
+	delete g_LogJson;
+	g_LogJson = nullptr;
 }
 
 void App_Run()
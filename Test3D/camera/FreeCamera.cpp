@@ -5,7 +5,6 @@
 #include <stdint.h>
 #include <windows.h>
 #include <vector>
-#include "math/Quaternion.h"
 
 enum FreeCameraKeys
 {
@@ -61,10 +60,11 @@ CameraType FreeCamera::Type()
 
 void FreeCamera::Enter()
 {
-	m_Info->position = Vector3::ZERO;
-	m_Info->orient   = Vector3::ZERO;
-	m_Info->rotation = Matrix3::IDENTITY;
-	m_Info->fov      = Vector2(80.f, 80.f);
+	m_Info->SetPosition(Vector3::ZERO);
+	m_Info->SetOrientation(Vector3::ZERO);
+	m_Info->SetRotation(Matrix3::IDENTITY);
+	m_Info->SetFov(Vector2(80.f, 80.f));
+	m_Info->SetClip(0.1f, 1000.f);
 }
 
 void FreeCamera::Leave()
@@ -80,13 +80,14 @@ void FreeCamera::Update(float dt)
 		Vector2 delta = m_Input->GetMouseDelta();
 		delta *= m_RotSpeed;
 
-		Vector3& orient = m_Info->orient;
+		Vector3 orient = m_Info->GetOrientation();
 		orient.x += delta.x;
 		orient.y += delta.y;
 
 		orient.y = Math::Clamp(orient.y, -80.f, 80.f);
 
-		m_Info->rotation = Quaternion(orient.x, orient.y, orient.z).RotationMatrix();
+		// Only a change of the angles rebuilds the rotation and the cached matrices.
+		m_Info->SetOrientation(orient);
 	}
 }
 
@@ -1,6 +1,183 @@
 #include "camera.h"
 #include "FreeCamera.h"
 
+#include "math/Quaternion.h"
+
+CameraInfo::CameraInfo() :
+	m_Position(Vector3::ZERO),
+	m_Orient(Vector3::ZERO),
+	m_Rotation(Matrix3::IDENTITY),
+	m_Fov(80.0f, 80.0f),
+	m_NearClip(0.1f),
+	m_FarClip(1000.0f),
+	m_DepthRange(DepthRange::ReversedInfinite),
+	m_Version(0),
+	m_ViewDirty(true),
+	m_ProjectionDirty(true),
+	m_ViewProjectionDirty(true)
+{
+}
+
+void CameraInfo::SetPosition(const Vector3& position)
+{
+	if (position != m_Position) {
+		m_Position = position;
+		SetViewDirty();
+	}
+}
+
+void CameraInfo::SetOrientation(const Vector3& orient)
+{
+	if (orient != m_Orient) {
+		m_Orient = orient;
+		SetRotation(Quaternion(orient.x, orient.y, orient.z).RotationMatrix());
+	}
+}
+
+void CameraInfo::SetRotation(const Matrix3& rotation)
+{
+	if (rotation != m_Rotation) {
+		m_Rotation = rotation;
+		SetViewDirty();
+	}
+}
+
+void CameraInfo::SetFov(const Vector2& fov)
+{
+	if (fov != m_Fov) {
+		m_Fov = fov;
+		SetProjectionDirty();
+	}
+}
+
+void CameraInfo::SetClip(float nearClip, float farClip)
+{
+	if (nearClip != m_NearClip || farClip != m_FarClip) {
+		m_NearClip = nearClip;
+		m_FarClip = farClip;
+		SetProjectionDirty();
+	}
+}
+
+void CameraInfo::SetDepthRange(DepthRange depthRange)
+{
+	if (depthRange != m_DepthRange) {
+		m_DepthRange = depthRange;
+		SetProjectionDirty();
+	}
+}
+
+const Matrix3x4& CameraInfo::GetTransform() const
+{
+	if (m_ViewDirty)
+		UpdateView();
+	return m_Transform;
+}
+
+const Matrix3x4& CameraInfo::GetView() const
+{
+	if (m_ViewDirty)
+		UpdateView();
+	return m_View;
+}
+
+const Matrix4& CameraInfo::GetProjection() const
+{
+	if (m_ProjectionDirty)
+		UpdateProjection();
+	return m_Projection;
+}
+
+const Matrix4& CameraInfo::GetInverseProjection() const
+{
+	if (m_ProjectionDirty)
+		UpdateProjection();
+	return m_InverseProjection;
+}
+
+const Matrix4& CameraInfo::GetViewProjection() const
+{
+	UpdateViewProjection();
+	return m_ViewProjection;
+}
+
+const Matrix4& CameraInfo::GetInverseViewProjection() const
+{
+	UpdateViewProjection();
+	return m_InverseViewProjection;
+}
+
+const Frustum& CameraInfo::GetFrustum() const
+{
+	UpdateViewProjection();
+	return m_Frustum;
+}
+
+void CameraInfo::UpdateView() const
+{
+	// The camera transform is rigid, so the view takes the cheap inverse.
+	m_Transform = Matrix3x4(m_Rotation);
+	m_Transform.SetTranslation(m_Position);
+	m_View = m_Transform.Inverse(TransformClass::Rigid);
+	m_ViewDirty = false;
+	m_ViewProjectionDirty = true;
+}
+
+void CameraInfo::UpdateProjection() const
+{
+	// Camera x, z and y go to clip x, y and w. Clip z is depthScale * y + depthOffset, which puts z / w at the ends
+	// of the depth range on the clip distances.
+	float n = m_NearClip;
+	float f = m_FarClip;
+	float scaleX = 1.0f / Math::TanDeg(m_Fov.x * 0.5f);
+	float scaleY = 1.0f / Math::TanDeg(m_Fov.y * 0.5f);
+	float depthScale, depthOffset;
+	switch (m_DepthRange) {
+	case DepthRange::Forward:
+		depthScale = f / (f - n);
+		depthOffset = -n * f / (f - n);
+		break;
+	case DepthRange::Reversed:
+		depthScale = -n / (f - n);
+		depthOffset = n * f / (f - n);
+		break;
+	default:
+		depthScale = 0.0f;
+		depthOffset = n;
+		break;
+	}
+
+	m_Projection = Matrix4(
+		scaleX, 0.0f, 0.0f,   0.0f,
+		0.0f,   0.0f, scaleY, 0.0f,
+		0.0f,   depthScale, 0.0f, depthOffset,
+		0.0f,   1.0f, 0.0f,   0.0f);
+	// Solved in closed form, which also holds for the infinite projection where a general inverse loses precision.
+	m_InverseProjection = Matrix4(
+		1.0f / scaleX, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+		0.0f, 1.0f / scaleY, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f / depthOffset, -depthScale / depthOffset);
+	m_ProjectionDirty = false;
+	m_ViewProjectionDirty = true;
+}
+
+void CameraInfo::UpdateViewProjection() const
+{
+	if (m_ViewDirty)
+		UpdateView();
+	if (m_ProjectionDirty)
+		UpdateProjection();
+	if (!m_ViewProjectionDirty)
+		return;
+
+	m_ViewProjection = m_Projection * m_View.ToMatrix4();
+	m_InverseViewProjection = m_Transform.ToMatrix4() * m_InverseProjection;
+	// The planes come from the placement rather than the matrix, whose far plane is degenerate when infinite.
+	m_Frustum.Define(m_Fov.x, m_Fov.y, m_NearClip, m_FarClip, m_Position, m_Rotation);
+	m_ViewProjectionDirty = false;
+}
+
 void CameraControl::Register(CameraBase* camera)
 {
 	m_Cameras.emplace(camera->Type(), camera);
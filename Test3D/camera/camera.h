@@ -1,7 +1,10 @@
 #pragma once
 
 #include "util/util.h"
+#include "math/Frustum.h"
 #include "math/Matrix3.h"
+#include "math/Matrix3x4.h"
+#include "math/Matrix4.h"
 #include "math/Vector2.h"
 #include "math/Vector3.h"
 
@@ -14,12 +17,96 @@ enum class CameraType
 	Follow,
 };
 
-struct CameraInfo
+/// Depth mapping of the projection matrix, in D3D clip space (0 <= z <= w).
+enum class DepthRange
 {
-	Vector3  position;
-	Vector3  orient;
-	Matrix3  rotation;
-	Vector2  fov;
+	/// Depth 0 at the near plane and 1 at the far plane.
+	Forward,
+	/// Depth 1 at the near plane and 0 at the far plane, which spreads float precision evenly over the distance.
+	Reversed,
+	/// Depth 1 at the near plane and 0 at infinity; the far distance only limits the frustum.
+	ReversedInfinite,
+};
+
+/// Camera placement and lens, plus the matrices and frustum derived from them.
+///
+/// The derived state is cached and recomputed on the first query after the placement or the lens changed: the view
+/// side on position and rotation, the projection side on fov, clip distances and depth range. Every change bumps
+/// the version, so downstream systems can keep their own derived data until it moves. The queries update the cache
+/// of a const object and must not race with each other.
+class CameraInfo
+{
+public:
+	CameraInfo();
+
+	void SetPosition(const Vector3& position);
+	/// Set the rotation from Euler angles in degrees.
+	void SetOrientation(const Vector3& orient);
+	void SetRotation(const Matrix3& rotation);
+	/// Set the horizontal and vertical field of view in degrees.
+	void SetFov(const Vector2& fov);
+	void SetClip(float nearClip, float farClip);
+	void SetDepthRange(DepthRange depthRange);
+
+	const Vector3&   GetPosition() const    { return m_Position; }
+	/// Euler angles of the last SetOrientation.
+	const Vector3&   GetOrientation() const { return m_Orient; }
+	const Matrix3&   GetRotation() const    { return m_Rotation; }
+	const Vector2&   GetFov() const         { return m_Fov; }
+	float            GetNearClip() const    { return m_NearClip; }
+	float            GetFarClip() const     { return m_FarClip; }
+	DepthRange       GetDepthRange() const  { return m_DepthRange; }
+	/// Incremented by every change of the placement or the lens.
+	unsigned         GetVersion() const     { return m_Version; }
+
+	/// Camera to world transform, which is the inverse of the view.
+	const Matrix3x4& GetTransform() const;
+	/// World to camera transform.
+	const Matrix3x4& GetView() const;
+	/// Camera to clip space. The camera looks along +y with +z up, like the world.
+	const Matrix4&   GetProjection() const;
+	const Matrix4&   GetInverseProjection() const;
+	const Matrix4&   GetViewProjection() const;
+	const Matrix4&   GetInverseViewProjection() const;
+	/// World space frustum, up to the far clip distance also with an infinite projection.
+	const Frustum&   GetFrustum() const;
+
+private:
+	void SetViewDirty()
+	{
+		m_ViewDirty = true;
+		++m_Version;
+	}
+	void SetProjectionDirty()
+	{
+		m_ProjectionDirty = true;
+		++m_Version;
+	}
+	void UpdateView() const;
+	void UpdateProjection() const;
+	void UpdateViewProjection() const;
+
+	Vector3            m_Position;
+	Vector3            m_Orient;
+	Matrix3            m_Rotation;
+	Vector2            m_Fov;
+	float              m_NearClip;
+	float              m_FarClip;
+	DepthRange         m_DepthRange;
+	unsigned           m_Version;
+
+	mutable Matrix3x4  m_Transform;
+	mutable Matrix3x4  m_View;
+	mutable Matrix4    m_Projection;
+	mutable Matrix4    m_InverseProjection;
+	mutable Matrix4    m_ViewProjection;
+	mutable Matrix4    m_InverseViewProjection;
+	mutable Frustum    m_Frustum;
+	/// Set when the view or the projection changed after the last update of the part derived from them.
+	mutable bool       m_ViewDirty;
+	mutable bool       m_ProjectionDirty;
+	/// Set when the view-projection matrices and the frustum lag behind either part.
+	mutable bool       m_ViewProjectionDirty;
 };
 
 class CameraBase
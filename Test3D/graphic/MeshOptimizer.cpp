@@ -0,0 +1,590 @@
+#include "MeshOptimizer.h"
+
+#include "math/Vector3.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+
+/// Entries of the LRU cache the vertex cache optimizer models. Larger than real FIFO caches on purpose: the
+/// scores of the last entries are small, and it makes the result good for any cache size up to it.
+const unsigned kSCORE_CACHE_SIZE = 32;
+/// Score of the vertices of the last triangle, lower than the next entries so that strips do not wrap around.
+const float kLAST_TRIANGLE_SCORE = 0.75f;
+const float kCACHE_DECAY_POWER = 1.5f;
+/// Bonus for vertices with few triangles left, so that the optimizer finishes them instead of leaving islands.
+const float kVALENCE_BOOST_SCALE = 2.0f;
+const float kVALENCE_BOOST_POWER = 0.5f;
+/// Valence above which the bonus no longer changes enough to be tabled.
+const unsigned kMAX_SCORED_VALENCE = 32;
+
+/// First byte of an encoded index buffer, which identifies the format version.
+const unsigned char kINDEX_FORMAT = 0xe1;
+/// Edge code of a triangle that shares no recent edge; the edges of the FIFO take codes 0 to 14.
+const unsigned kFREE_TRIANGLE = 15;
+/// Vertex codes of the third vertex of a triangle: the next unseen vertex, a delta, or 1 + a vertex FIFO entry.
+const unsigned kNEXT_VERTEX = 0;
+const unsigned kDELTA_VERTEX = 15;
+/// Bytes of one vertex delta at most.
+const unsigned kMAX_VARINT = 5;
+
+struct VertexScores
+{
+	VertexScores()
+	{
+		// Entry 0 is a vertex not in the cache.
+		cache[0] = 0.0f;
+		for (unsigned i = 0; i < kSCORE_CACHE_SIZE; ++i) {
+			if (i < 3)
+				cache[i + 1] = kLAST_TRIANGLE_SCORE;
+			else
+				cache[i + 1] = powf(1.0f - (float)(i - 3) / (kSCORE_CACHE_SIZE - 3), kCACHE_DECAY_POWER);
+		}
+		valence[0] = 0.0f;
+		for (unsigned i = 1; i <= kMAX_SCORED_VALENCE; ++i)
+			valence[i] = kVALENCE_BOOST_SCALE * powf((float)i, -kVALENCE_BOOST_POWER);
+	}
+
+	/// Score of a vertex at cache position (-1 when not cached) with the given number of triangles left.
+	float Get(int position, unsigned triangles) const
+	{
+		if (!triangles)
+			return -1.0f;
+		return cache[position + 1] + valence[triangles < kMAX_SCORED_VALENCE ? triangles : kMAX_SCORED_VALENCE];
+	}
+
+	float cache[kSCORE_CACHE_SIZE + 1];
+	float valence[kMAX_SCORED_VALENCE + 1];
+};
+
+const VertexScores kSCORES;
+
+/// Triangles of every vertex in one array: the triangles of vertex v start at offsets[v], and the first live[v]
+/// of them are not emitted yet.
+struct Adjacency
+{
+	Adjacency(const unsigned* indices, unsigned indexCount, unsigned vertexCount) :
+		offsets(vertexCount + 1, 0),
+		live(vertexCount, 0),
+		triangles(indexCount)
+	{
+		for (unsigned i = 0; i < indexCount; ++i) {
+			assert(indices[i] < vertexCount);
+			++live[indices[i]];
+		}
+		for (unsigned v = 0; v < vertexCount; ++v)
+			offsets[v + 1] = offsets[v] + live[v];
+		std::vector<unsigned> fill(offsets.begin(), offsets.end() - 1);
+		for (unsigned i = 0; i < indexCount; ++i)
+			triangles[fill[indices[i]]++] = i / 3;
+	}
+
+	void Remove(unsigned vertex, unsigned triangle)
+	{
+		unsigned* begin = &triangles[offsets[vertex]];
+		unsigned* last = begin + --live[vertex];
+		for (unsigned* t = begin; t < last; ++t) {
+			if (*t == triangle) {
+				*t = *last;
+				break;
+			}
+		}
+		*last = triangle;
+	}
+
+	std::vector<unsigned> offsets;
+	std::vector<unsigned> live;
+	std::vector<unsigned> triangles;
+};
+
+/// FIFO cache simulation without a queue: a vertex is cached while fewer than cacheSize misses happened since
+/// its own.
+struct FifoCache
+{
+	FifoCache(unsigned vertexCount, unsigned size) :
+		stamps(vertexCount, 0),
+		time(size + 1),
+		cacheSize(size)
+	{
+	}
+
+	/// Empty the cache.
+	void Reset() { time += cacheSize + 1; }
+
+	/// Touch a vertex and return whether it missed.
+	bool Miss(unsigned vertex)
+	{
+		if (time - stamps[vertex] <= cacheSize)
+			return false;
+		stamps[vertex] = time++;
+		return true;
+	}
+
+	std::vector<unsigned> stamps;
+	unsigned              time;
+	unsigned              cacheSize;
+};
+
+/// Cluster of consecutive triangles and its overdraw sort key.
+struct Cluster
+{
+	unsigned begin;
+	unsigned end;
+	float    key;
+};
+
+/// Recent edges and vertices, shared by the encoder and the decoder so that both see the same state.
+struct IndexHistory
+{
+	IndexHistory() : edgeOffset(0), vertexOffset(0), next(0), last(0)
+	{
+		memset(edges, 0, sizeof(edges));
+		memset(vertices, 0, sizeof(vertices));
+	}
+
+	/// Edge k, 0 the newest.
+	const unsigned* Edge(unsigned k) const { return edges[(edgeOffset - 1 - k) & 15]; }
+	/// Vertex k, 0 the newest.
+	unsigned Vertex(unsigned k) const { return vertices[(vertexOffset - 1 - k) & 15]; }
+
+	/// Push the edge a triangle adjacent across it starts with, b to a for the edge a to b.
+	void PushEdge(unsigned a, unsigned b)
+	{
+		unsigned* edge = edges[edgeOffset++ & 15];
+		edge[0] = b;
+		edge[1] = a;
+	}
+	void PushVertex(unsigned v) { vertices[vertexOffset++ & 15] = v; }
+
+	/// Push the edges of a new triangle, or of one built on the edge a to b, which is not pushed again.
+	void PushTriangle(unsigned a, unsigned b, unsigned c)
+	{
+		PushEdge(a, b);
+		PushEdge(b, c);
+		PushEdge(c, a);
+	}
+	void PushFan(unsigned a, unsigned b, unsigned c)
+	{
+		PushEdge(b, c);
+		PushEdge(c, a);
+	}
+
+	unsigned edges[16][2];
+	unsigned vertices[16];
+	unsigned edgeOffset;
+	unsigned vertexOffset;
+	unsigned next;
+	unsigned last;
+};
+
+unsigned char* WriteDelta(unsigned char* p, unsigned value, unsigned last)
+{
+	// Zigzag, so that small negative deltas stay small.
+	int delta = (int)(value - last);
+	unsigned v = ((unsigned)delta << 1) ^ (unsigned)(delta >> 31);
+	while (v >= 0x80) {
+		*p++ = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char)v;
+	return p;
+}
+
+bool ReadDelta(const unsigned char*& p, const unsigned char* end, unsigned& value, unsigned last)
+{
+	unsigned v = 0;
+	for (unsigned shift = 0; shift < kMAX_VARINT * 7; shift += 7) {
+		if (p == end)
+			return false;
+		unsigned byte = *p++;
+		v |= (byte & 0x7f) << shift;
+		if (byte < 0x80) {
+			value = last + ((v >> 1) ^ (0u - (v & 1)));
+			return true;
+		}
+	}
+	return false;
+}
+
+}
+
+namespace MeshOptimizer
+{
+
+float ComputeACMR(const unsigned* indices, unsigned indexCount, unsigned vertexCount, unsigned cacheSize)
+{
+	assert(indexCount % 3 == 0);
+	if (!indexCount)
+		return 0.0f;
+
+	FifoCache cache(vertexCount, cacheSize);
+	unsigned misses = 0;
+	for (unsigned i = 0; i < indexCount; ++i)
+		misses += cache.Miss(indices[i]);
+	return (float)misses / (indexCount / 3);
+}
+
+void OptimizeVertexCache(unsigned* dest, const unsigned* indices, unsigned indexCount, unsigned vertexCount)
+{
+	assert(indexCount % 3 == 0);
+	unsigned triangleCount = indexCount / 3;
+	if (!triangleCount)
+		return;
+	std::vector<unsigned> source(indices, indices + indexCount);
+	Adjacency adjacency(&source[0], indexCount, vertexCount);
+
+	std::vector<float> vertexScores(vertexCount);
+	for (unsigned v = 0; v < vertexCount; ++v)
+		vertexScores[v] = kSCORES.Get(-1, adjacency.live[v]);
+	std::vector<float> triangleScores(triangleCount);
+	for (unsigned t = 0; t < triangleCount; ++t)
+		triangleScores[t] = vertexScores[source[t * 3]] + vertexScores[source[t * 3 + 1]] + vertexScores[source[t * 3 + 2]];
+	std::vector<bool> emitted(triangleCount, false);
+
+	// Cache entries after the vertices of the emitted triangle are pushed, before the ones past the end drop out.
+	unsigned cache[kSCORE_CACHE_SIZE + 3], nextCache[kSCORE_CACHE_SIZE + 3];
+	unsigned cacheCount = 0;
+	unsigned cursor = 0;
+	int best = -1;
+
+	for (unsigned emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+		// Without a candidate in the cache, continue with the first triangle not emitted.
+		if (best < 0) {
+			while (emitted[cursor])
+				++cursor;
+			best = (int)cursor;
+		}
+
+		const unsigned* triangle = &source[best * 3];
+		memcpy(dest + emittedCount * 3, triangle, 3 * sizeof(unsigned));
+		emitted[best] = true;
+
+		// The triangle's vertices move to the front, the others keep their order behind them.
+		unsigned nextCount = 0;
+		for (unsigned k = 0; k < 3; ++k) {
+			unsigned v = triangle[k];
+			adjacency.Remove(v, (unsigned)best);
+			if (std::find(nextCache, nextCache + nextCount, v) == nextCache + nextCount)
+				nextCache[nextCount++] = v;
+		}
+		for (unsigned i = 0; i < cacheCount; ++i) {
+			unsigned v = cache[i];
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+				nextCache[nextCount++] = v;
+		}
+
+		// Rescore the vertices whose position or valence changed and pass the change on to their triangles,
+		// remembering the best triangle on the way.
+		float bestScore = -1.0f;
+		best = -1;
+		for (unsigned i = 0; i < nextCount; ++i) {
+			unsigned v = nextCache[i];
+			int position = i < kSCORE_CACHE_SIZE ? (int)i : -1;
+			float score = kSCORES.Get(position, adjacency.live[v]);
+			float delta = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			const unsigned* begin = &adjacency.triangles[adjacency.offsets[v]];
+			for (const unsigned* t = begin; t < begin + adjacency.live[v]; ++t) {
+				float triangleScore = triangleScores[*t] += delta;
+				if (triangleScore > bestScore && position >= 0) {
+					bestScore = triangleScore;
+					best = (int)*t;
+				}
+			}
+		}
+
+		cacheCount = nextCount < kSCORE_CACHE_SIZE ? nextCount : kSCORE_CACHE_SIZE;
+		memcpy(cache, nextCache, cacheCount * sizeof(unsigned));
+	}
+}
+
+unsigned OptimizeOverdraw(unsigned* dest, const unsigned* indices, unsigned indexCount, const float* positions,
+	unsigned vertexCount, size_t positionStride, float threshold)
+{
+	assert(indexCount % 3 == 0);
+	unsigned triangleCount = indexCount / 3;
+	if (!triangleCount)
+		return 0;
+	std::vector<unsigned> source(indices, indices + indexCount);
+
+	// Hard boundaries where the cache restarts, which cost nothing to reorder at.
+	std::vector<unsigned> hard;
+	FifoCache cache(vertexCount, DEFAULT_CACHE_SIZE);
+	std::vector<unsigned char> misses(triangleCount);
+	for (unsigned t = 0; t < triangleCount; ++t) {
+		misses[t] = (unsigned char)(cache.Miss(source[t * 3]) + cache.Miss(source[t * 3 + 1]) + cache.Miss(source[t * 3 + 2]));
+		if (!t || misses[t] == 3)
+			hard.push_back(t);
+	}
+	hard.push_back(triangleCount);
+
+	// Soft boundaries within them, after Sander et al.: a cluster starting on a cold cache ends as soon as its
+	// own ACMR falls to threshold times the ACMR of the hard cluster, which bounds the cost of the cold start.
+	std::vector<Cluster> clusters;
+	for (size_t h = 0; h + 1 < hard.size(); ++h) {
+		unsigned hardMisses = 0;
+		for (unsigned t = hard[h]; t < hard[h + 1]; ++t)
+			hardMisses += misses[t];
+		float limit = threshold * hardMisses / (hard[h + 1] - hard[h]);
+
+		cache.Reset();
+		Cluster cluster = { hard[h], hard[h + 1], 0.0f };
+		unsigned clusterMisses = 0;
+		for (unsigned t = hard[h]; t < hard[h + 1]; ++t) {
+			clusterMisses += cache.Miss(source[t * 3]) + cache.Miss(source[t * 3 + 1]) + cache.Miss(source[t * 3 + 2]);
+			if (t + 1 < hard[h + 1] && clusterMisses <= limit * (t + 1 - cluster.begin)) {
+				cluster.end = t + 1;
+				clusters.push_back(cluster);
+				cluster.begin = t + 1;
+				cache.Reset();
+				clusterMisses = 0;
+			}
+		}
+		cluster.end = hard[h + 1];
+		clusters.push_back(cluster);
+	}
+
+	// Area-weighted centroid and normal of every cluster and of the mesh; the sort key is how far the cluster
+	// lies out along its own normal.
+	const unsigned char* base = reinterpret_cast<const unsigned char*>(positions);
+	std::vector<Vector3> centroids(clusters.size()), normals(clusters.size());
+	Vector3 meshCentroid = Vector3::ZERO;
+	float meshArea = 0.0f;
+	for (size_t k = 0; k < clusters.size(); ++k) {
+		Vector3 centroid = Vector3::ZERO, normal = Vector3::ZERO;
+		float area = 0.0f;
+		for (unsigned t = clusters[k].begin; t < clusters[k].end; ++t) {
+			Vector3 p[3];
+			for (unsigned j = 0; j < 3; ++j) {
+				const float* position = reinterpret_cast<const float*>(base + source[t * 3 + j] * positionStride);
+				p[j] = Vector3(position[0], position[1], position[2]);
+			}
+			Vector3 cross = (p[1] - p[0]).Cross(p[2] - p[0]);
+			float triangleArea = cross.Length();
+			centroid += (p[0] + p[1] + p[2]) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+		meshCentroid += centroid;
+		meshArea += area;
+		centroids[k] = area > 0.0f ? centroid / area : centroid;
+		normals[k] = normal.Normalized();
+	}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+	for (size_t k = 0; k < clusters.size(); ++k)
+		clusters[k].key = (centroids[k] - meshCentroid).Dot(normals[k]);
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+	unsigned* out = dest;
+	for (const Cluster& cluster : clusters) {
+		unsigned size = (cluster.end - cluster.begin) * 3;
+		memcpy(out, &source[cluster.begin * 3], size * sizeof(unsigned));
+		out += size;
+	}
+	return (unsigned)clusters.size();
+}
+
+unsigned OptimizeVertexFetchRemap(unsigned* remap, const unsigned* indices, unsigned indexCount, unsigned vertexCount)
+{
+	memset(remap, 0xff, vertexCount * sizeof(unsigned));
+	unsigned next = 0;
+	for (unsigned i = 0; i < indexCount; ++i) {
+		assert(indices[i] < vertexCount);
+		unsigned& target = remap[indices[i]];
+		if (target == ~0u)
+			target = next++;
+	}
+	return next;
+}
+
+void RemapIndexBuffer(unsigned* dest, const unsigned* indices, unsigned indexCount, const unsigned* remap)
+{
+	for (unsigned i = 0; i < indexCount; ++i)
+		dest[i] = remap[indices[i]];
+}
+
+void RemapVertexBuffer(void* dest, const void* vertices, unsigned vertexCount, size_t vertexSize, const unsigned* remap)
+{
+	assert(dest != vertices);
+	unsigned char* out = static_cast<unsigned char*>(dest);
+	const unsigned char* in = static_cast<const unsigned char*>(vertices);
+	for (unsigned v = 0; v < vertexCount; ++v) {
+		if (remap[v] != ~0u)
+			memcpy(out + remap[v] * vertexSize, in + v * vertexSize, vertexSize);
+	}
+}
+
+unsigned OptimizeVertexFetch(void* destVertices, unsigned* indices, unsigned indexCount, const void* vertices,
+	unsigned vertexCount, size_t vertexSize)
+{
+	std::vector<unsigned> remap(vertexCount);
+	unsigned used = OptimizeVertexFetchRemap(&remap[0], indices, indexCount, vertexCount);
+	RemapIndexBuffer(indices, indices, indexCount, &remap[0]);
+	RemapVertexBuffer(destVertices, vertices, vertexCount, vertexSize, &remap[0]);
+	return used;
+}
+
+size_t EncodeIndexBufferBound(unsigned indexCount)
+{
+	// A free triangle with three deltas is the longest.
+	return 1 + (size_t)(indexCount / 3) * (1 + 3 * kMAX_VARINT);
+}
+
+size_t EncodeIndexBuffer(unsigned char* buffer, size_t capacity, const unsigned* indices, unsigned indexCount)
+{
+	assert(indexCount % 3 == 0);
+	if (!capacity)
+		return 0;
+
+	IndexHistory history;
+	unsigned char* out = buffer;
+	unsigned char* end = buffer + capacity;
+	*out++ = kINDEX_FORMAT;
+	// The longest triangle. Closer than that to the end, triangles are encoded here first and copied when they fit.
+	unsigned char scratch[1 + 3 * kMAX_VARINT];
+
+	for (unsigned i = 0; i < indexCount; i += 3) {
+		bool nearEnd = (size_t)(end - out) < sizeof(scratch);
+		unsigned char* p = nearEnd ? scratch : out;
+		unsigned a = indices[i], b = indices[i + 1], c = indices[i + 2];
+
+		// Find a recent edge in any rotation of the triangle.
+		unsigned edge = kFREE_TRIANGLE;
+		for (unsigned k = 0; k < kFREE_TRIANGLE && edge == kFREE_TRIANGLE; ++k) {
+			const unsigned* e = history.Edge(k);
+			unsigned rotation[3];
+			if (e[0] == a && e[1] == b) {
+				rotation[0] = a; rotation[1] = b; rotation[2] = c;
+			}
+			else if (e[0] == b && e[1] == c) {
+				rotation[0] = b; rotation[1] = c; rotation[2] = a;
+			}
+			else if (e[0] == c && e[1] == a) {
+				rotation[0] = c; rotation[1] = a; rotation[2] = b;
+			}
+			else
+				continue;
+			edge = k;
+			a = rotation[0];
+			b = rotation[1];
+			c = rotation[2];
+		}
+
+		if (edge != kFREE_TRIANGLE) {
+			unsigned code = kDELTA_VERTEX;
+			if (c == history.next)
+				code = kNEXT_VERTEX;
+			else {
+				for (unsigned k = 0; k < kDELTA_VERTEX - 1; ++k) {
+					if (history.Vertex(k) == c) {
+						code = k + 1;
+						break;
+					}
+				}
+			}
+
+			*p++ = (unsigned char)(edge << 4 | code);
+			if (code == kDELTA_VERTEX)
+				p = WriteDelta(p, c, history.last);
+			if (code == kNEXT_VERTEX)
+				++history.next;
+			if (code == kNEXT_VERTEX || code == kDELTA_VERTEX)
+				history.PushVertex(c);
+			history.last = c;
+			history.PushFan(a, b, c);
+		}
+		else {
+			// One bit per vertex that is the next unseen one; the others follow as deltas.
+			const unsigned triangle[3] = { a, b, c };
+			unsigned char* code = p++;
+			*code = (unsigned char)(kFREE_TRIANGLE << 4);
+			for (unsigned k = 0; k < 3; ++k) {
+				if (triangle[k] == history.next) {
+					*code |= (unsigned char)(1 << k);
+					++history.next;
+				}
+				else
+					p = WriteDelta(p, triangle[k], history.last);
+				history.last = triangle[k];
+				history.PushVertex(triangle[k]);
+			}
+			history.PushTriangle(a, b, c);
+		}
+
+		if (nearEnd) {
+			size_t size = (size_t)(p - scratch);
+			if (size > (size_t)(end - out))
+				return 0;
+			memcpy(out, scratch, size);
+			p = out + size;
+		}
+		out = p;
+	}
+	return (size_t)(out - buffer);
+}
+
+bool DecodeIndexBuffer(unsigned* dest, unsigned indexCount, const unsigned char* buffer, size_t size)
+{
+	if (indexCount % 3 || !size || buffer[0] != kINDEX_FORMAT)
+		return false;
+
+	IndexHistory history;
+	const unsigned char* p = buffer + 1;
+	const unsigned char* end = buffer + size;
+
+	for (unsigned i = 0; i < indexCount; i += 3) {
+		if (p == end)
+			return false;
+		unsigned code = *p++;
+		unsigned edge = code >> 4;
+		unsigned vertex = code & 15;
+
+		if (edge != kFREE_TRIANGLE) {
+			const unsigned* e = history.Edge(edge);
+			unsigned a = e[0], b = e[1], c;
+			if (vertex == kNEXT_VERTEX) {
+				c = history.next++;
+				history.PushVertex(c);
+			}
+			else if (vertex == kDELTA_VERTEX) {
+				if (!ReadDelta(p, end, c, history.last))
+					return false;
+				history.PushVertex(c);
+			}
+			else
+				c = history.Vertex(vertex - 1);
+
+			dest[i] = a;
+			dest[i + 1] = b;
+			dest[i + 2] = c;
+			history.last = c;
+			history.PushFan(a, b, c);
+		}
+		else {
+			if (vertex & 8)
+				return false;
+			for (unsigned k = 0; k < 3; ++k) {
+				unsigned v;
+				if (vertex & (1 << k))
+					v = history.next++;
+				else if (!ReadDelta(p, end, v, history.last))
+					return false;
+				dest[i + k] = v;
+				history.last = v;
+				history.PushVertex(v);
+			}
+			history.PushTriangle(dest[i], dest[i + 1], dest[i + 2]);
+		}
+	}
+	return p == end;
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+
+// Index and vertex buffer preprocessing for meshes before they are uploaded to a GpuBuffer. The usual order is
+// OptimizeVertexCache, then OptimizeOverdraw on its result, then OptimizeVertexFetch to renumber the vertices in
+// the order the optimized index buffer first uses them, and EncodeIndexBuffer to store the result compactly.
+//
+// Index buffers are triangle lists of 32-bit indices. Every function that writes an index buffer may reorder the
+// triangles and rotate the vertices of a triangle, which keeps its winding, but never changes the set of
+// triangles. dest may alias indices.
+
+namespace MeshOptimizer
+{
+
+/// Entries of the FIFO post-transform cache that ComputeACMR simulates unless told otherwise, which is the
+/// smallest size of current hardware.
+static const unsigned DEFAULT_CACHE_SIZE = 16;
+
+/// Average cache miss ratio: vertices transformed per triangle for a FIFO post-transform cache of cacheSize
+/// entries. 3 is the worst case; well optimized regular meshes reach about 0.6.
+float ComputeACMR(const unsigned* indices, unsigned indexCount, unsigned vertexCount,
+	unsigned cacheSize = DEFAULT_CACHE_SIZE);
+
+/// Reorder the triangles for the post-transform vertex cache with Tom Forsyth's linear-speed algorithm: the
+/// triangle emitted next is the one whose vertices score highest, the score favouring vertices recently used and
+/// vertices with few triangles left. Runs in time linear in the triangle count.
+void OptimizeVertexCache(unsigned* dest, const unsigned* indices, unsigned indexCount, unsigned vertexCount);
+
+/// Reorder clusters of a cache-optimized index buffer so that triangles facing outward from the centre of the
+/// mesh draw first, which lets them occlude the rest for most view directions. Clusters end where the cache
+/// simulation restarts, and where a cluster started on an empty cache has reached threshold times the ACMR of
+/// the input around it, so the ACMR grows by about threshold at most. positions holds three floats per vertex at
+/// positionStride bytes apart. Returns the number of clusters.
+unsigned OptimizeOverdraw(unsigned* dest, const unsigned* indices, unsigned indexCount, const float* positions,
+	unsigned vertexCount, size_t positionStride, float threshold = 1.05f);
+
+/// Build a remap table that numbers the vertices in the order the index buffer first references them, so that
+/// vertex fetch walks the vertex buffer forward. remap[old] is the new index, or ~0u for a vertex no triangle
+/// uses. Returns the number of vertices used.
+unsigned OptimizeVertexFetchRemap(unsigned* remap, const unsigned* indices, unsigned indexCount, unsigned vertexCount);
+/// Apply a remap table to an index buffer.
+void RemapIndexBuffer(unsigned* dest, const unsigned* indices, unsigned indexCount, const unsigned* remap);
+/// Apply a remap table to vertexCount vertices of vertexSize bytes, dropping the unused ones. dest holds the used
+/// vertices and must not alias vertices.
+void RemapVertexBuffer(void* dest, const void* vertices, unsigned vertexCount, size_t vertexSize, const unsigned* remap);
+/// OptimizeVertexFetchRemap followed by both remaps. Returns the number of vertices used.
+unsigned OptimizeVertexFetch(void* destVertices, unsigned* indices, unsigned indexCount, const void* vertices,
+	unsigned vertexCount, size_t vertexSize);
+
+/// Upper bound of the size EncodeIndexBuffer produces.
+size_t EncodeIndexBufferBound(unsigned indexCount);
+/// Encode an index buffer into buffer and return the encoded size, or 0 when it needs more than capacity bytes.
+/// A capacity of EncodeIndexBufferBound bytes always suffices, but any capacity of at least the encoded size works.
+/// Each triangle takes one code byte that refers to an edge among the last 15 ones and to its third vertex as
+/// the next unseen vertex or one of the last 14 ones, so cache-optimized and fetch-remapped buffers take about
+/// one byte per triangle. Other vertices follow as variable-length deltas.
+size_t EncodeIndexBuffer(unsigned char* buffer, size_t capacity, const unsigned* indices, unsigned indexCount);
+/// Decode indexCount indices. Returns false when the data is malformed or does not hold that many indices.
+bool DecodeIndexBuffer(unsigned* dest, unsigned indexCount, const unsigned char* buffer, size_t size);
+
+}
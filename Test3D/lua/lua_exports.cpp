@@ -1,5 +1,6 @@
 #include "script_system.h"
 #include "lua_imgui.h"
+#include "lua_math.h"
 
 extern void lua_open_util_lib(lua_State*);
 
@@ -7,4 +8,5 @@ void script_system_register_libs(lua_State* L)
 {
 	lua_open_util_lib(L);
 	lua_open_imgui_lib(L);
+	lua_open_math_lib(L);
 }
@@ -39,7 +39,7 @@ void imgui_lua_wrapped(ImGuiIO& io, void* luafunc)
 
 		int type = lua_rawgeti(L, abs_index, func_ref); //+1
 		if (type != LUA_TFUNCTION) {
-			util_log_err("[Lua ImGui]: function %s not exists.", func_name);
+			util_log_limited(LogCategory_ImGui, LogLevel_Error, 4, "function %s not exists.", func_name);
 			lua_pop(L, 1);
 			return;
 		}
@@ -49,14 +49,16 @@ void imgui_lua_wrapped(ImGuiIO& io, void* luafunc)
 		const char* imgui_msg = LuaImGuiEnd();
 		if (err) {
 			func->func_result = false;
-			util_log_err("[Lua ImGui]: call function '%s' error: %s", func_name, lua_tostring(L, -1));
+			util_log_limited(LogCategory_ImGui, LogLevel_Error, 4, "call function '%s' error: %s", func_name,
+				lua_tostring(L, -1));
 			lua_pop(L, 1);
 			return;
 		}
 		else {
 			if (imgui_msg) {
 				func->func_result = false;
-				util_log_warn("[Lua ImGui]: call function '%s' warning:\n %s", func_name, imgui_msg);
+				util_log_limited(LogCategory_ImGui, LogLevel_Warn, 4, "call function '%s' warning:\n %s", func_name,
+					imgui_msg);
 			}
 		}
 		lua_pop(L, 1);
@@ -0,0 +1,1005 @@
+#include "script_system.h"
+#include "lua_math.h"
+
+#include "math/Matrix3x4.h"
+#include "math/Quaternion.h"
+#include "math/Vector3.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Lua bindings of Vector3, Quaternion and Matrix3x4, plus Vector3Array for batches, that allocate nothing once
+// they are warm.
+//
+// Values are full userdata holding the C++ object. Methods ending in an underscore modify self and return it, so
+// they chain: v:add_(w):mul_(0.5). Methods without one return numbers or write into objects passed in. Only the
+// constructors and clone() allocate.
+//
+// Operators return temporaries instead of new userdata: every type owns a ring of LUA_MATH_TEMPS userdata that
+// the first operator results allocate and later ones recycle, so a result is overwritten LUA_MATH_TEMPS results
+// of its type later. Use an operator result right away, or keep it with clone() or set() into an owned value.
+//
+// Every function gets the metatables as upvalues and checks types by comparing against them, instead of looking
+// the type name up in the registry the way luaL_checkudata does. The metatables hold the methods as well: Vector3
+// and Quaternion reach them through an __index function that serves the components first, the other types through
+// __index pointing at the metatable itself.
+
+enum LuaMathUpvalue
+{
+	LUA_MATH_VECTOR3 = 1,
+	LUA_MATH_QUATERNION,
+	LUA_MATH_MATRIX3X4,
+	LUA_MATH_VECTOR3ARRAY,
+	/// LuaMathTemps userdata with the ring positions.
+	LUA_MATH_TEMP_STATE,
+	/// Table of the temporaries of all types.
+	LUA_MATH_TEMP_TABLE,
+
+	LUA_MATH_UPVALUES = LUA_MATH_TEMP_TABLE,
+};
+
+static const char* lua_math_type_names[] = { "", "Vector3", "Quaternion", "Matrix3x4", "Vector3Array" };
+
+struct LuaMathTemps
+{
+	unsigned next[LUA_MATH_MATRIX3X4];
+};
+
+/// Header of a Vector3Array userdata, followed by the x, y and z arrays of count floats each.
+struct LuaVector3Array
+{
+	unsigned count;
+
+	float* X() { return reinterpret_cast<float*>(this + 1); }
+	float* Y() { return X() + count; }
+	float* Z() { return X() + count * 2; }
+};
+
+static void* lua_math_to(lua_State* L, int arg, int type)
+{
+	void* p = lua_touserdata(L, arg);
+	if (!p || !lua_getmetatable(L, arg))
+		return nullptr;
+	bool match = lua_rawequal(L, -1, lua_upvalueindex(type)) != 0;
+	lua_pop(L, 1);
+	return match ? p : nullptr;
+}
+
+static void* lua_math_check(lua_State* L, int arg, int type)
+{
+	void* p = lua_math_to(L, arg, type);
+	if (!p)
+		luaL_argerror(L, arg, lua_pushfstring(L, "%s expected", lua_math_type_names[type]));
+	return p;
+}
+
+static Vector3*         lua_to_vector3(lua_State* L, int arg)       { return (Vector3*)lua_math_to(L, arg, LUA_MATH_VECTOR3); }
+static Vector3*         lua_check_vector3(lua_State* L, int arg)    { return (Vector3*)lua_math_check(L, arg, LUA_MATH_VECTOR3); }
+static Quaternion*      lua_to_quaternion(lua_State* L, int arg)    { return (Quaternion*)lua_math_to(L, arg, LUA_MATH_QUATERNION); }
+static Quaternion*      lua_check_quaternion(lua_State* L, int arg) { return (Quaternion*)lua_math_check(L, arg, LUA_MATH_QUATERNION); }
+static Matrix3x4*       lua_to_matrix3x4(lua_State* L, int arg)     { return (Matrix3x4*)lua_math_to(L, arg, LUA_MATH_MATRIX3X4); }
+static Matrix3x4*       lua_check_matrix3x4(lua_State* L, int arg)  { return (Matrix3x4*)lua_math_check(L, arg, LUA_MATH_MATRIX3X4); }
+static LuaVector3Array* lua_check_vector3array(lua_State* L, int arg)
+{
+	return (LuaVector3Array*)lua_math_check(L, arg, LUA_MATH_VECTOR3ARRAY);
+}
+
+static float lua_check_float(lua_State* L, int arg)
+{
+	return (float)luaL_checknumber(L, arg);
+}
+
+/// Push a new userdata of the given type.
+template <class T>
+static T* lua_math_new(lua_State* L, int type, const T& value)
+{
+	T* p = (T*)lua_newuserdata(L, sizeof(T));
+	*p = value;
+	lua_pushvalue(L, lua_upvalueindex(type));
+	lua_setmetatable(L, -2);
+	return p;
+}
+
+/// Push the next temporary of the given type, allocating it on the first round of the ring only.
+template <class T>
+static T* lua_math_temp(lua_State* L, int type, const T& value)
+{
+	LuaMathTemps* temps = (LuaMathTemps*)lua_touserdata(L, lua_upvalueindex(LUA_MATH_TEMP_STATE));
+	unsigned& next = temps->next[type - 1];
+	lua_Integer slot = (type - 1) * LUA_MATH_TEMPS + next + 1;
+	next = (next + 1) % LUA_MATH_TEMPS;
+
+	if (lua_rawgeti(L, lua_upvalueindex(LUA_MATH_TEMP_TABLE), slot) != LUA_TNIL) {
+		T* p = (T*)lua_touserdata(L, -1);
+		*p = value;
+		return p;
+	}
+	lua_pop(L, 1);
+	T* p = lua_math_new(L, type, value);
+	lua_pushvalue(L, -1);
+	lua_rawseti(L, lua_upvalueindex(LUA_MATH_TEMP_TABLE), slot);
+	return p;
+}
+
+/// Look a method up in the metatable of the type, which holds the methods next to the metamethods.
+static int lua_math_method(lua_State* L, int type)
+{
+	lua_settop(L, 2);
+	lua_rawget(L, lua_upvalueindex(type));
+	return 1;
+}
+
+/// Return the component of a single letter key among names, or -1.
+static int lua_math_component(lua_State* L, int arg, const char* names)
+{
+	// Only real strings: lua_tolstring would convert a number key in place, which allocates.
+	if (lua_type(L, arg) != LUA_TSTRING)
+		return -1;
+	size_t len;
+	const char* key = lua_tolstring(L, arg, &len);
+	if (len != 1)
+		return -1;
+	for (int i = 0; names[i]; ++i) {
+		if (names[i] == key[0])
+			return i;
+	}
+	return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Vector3
+
+static int lua_vector3_new(lua_State* L)
+{
+	Vector3* v = lua_to_vector3(L, 1);
+	if (v)
+		lua_math_new(L, LUA_MATH_VECTOR3, *v);
+	else
+		lua_math_new(L, LUA_MATH_VECTOR3, Vector3((float)luaL_optnumber(L, 1, 0.0), (float)luaL_optnumber(L, 2, 0.0),
+			(float)luaL_optnumber(L, 3, 0.0)));
+	return 1;
+}
+
+static int lua_vector3_index(lua_State* L)
+{
+	int i = lua_math_component(L, 2, "xyz");
+	if (i < 0)
+		return lua_math_method(L, LUA_MATH_VECTOR3);
+	lua_pushnumber(L, lua_check_vector3(L, 1)->Data()[i]);
+	return 1;
+}
+
+static int lua_vector3_newindex(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	int i = lua_math_component(L, 2, "xyz");
+	luaL_argcheck(L, i >= 0, 2, "x, y or z expected");
+	const_cast<float*>(v->Data())[i] = lua_check_float(L, 3);
+	return 0;
+}
+
+static int lua_vector3_tostring(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	lua_pushfstring(L, "Vector3(%f, %f, %f)", (lua_Number)v->x, (lua_Number)v->y, (lua_Number)v->z);
+	return 1;
+}
+
+static int lua_vector3_eq(lua_State* L)
+{
+	Vector3* lhs = lua_to_vector3(L, 1);
+	Vector3* rhs = lua_to_vector3(L, 2);
+	lua_pushboolean(L, lhs && rhs && *lhs == *rhs);
+	return 1;
+}
+
+static int lua_vector3_add(lua_State* L)
+{
+	lua_math_temp(L, LUA_MATH_VECTOR3, *lua_check_vector3(L, 1) + *lua_check_vector3(L, 2));
+	return 1;
+}
+
+static int lua_vector3_sub(lua_State* L)
+{
+	lua_math_temp(L, LUA_MATH_VECTOR3, *lua_check_vector3(L, 1) - *lua_check_vector3(L, 2));
+	return 1;
+}
+
+static int lua_vector3_mul(lua_State* L)
+{
+	// Vector * number, number * vector or the component-wise product.
+	Vector3* lhs = lua_to_vector3(L, 1);
+	Vector3* rhs = lua_to_vector3(L, 2);
+	if (lhs && rhs)
+		lua_math_temp(L, LUA_MATH_VECTOR3, *lhs * *rhs);
+	else if (lhs)
+		lua_math_temp(L, LUA_MATH_VECTOR3, *lhs * lua_check_float(L, 2));
+	else
+		lua_math_temp(L, LUA_MATH_VECTOR3, *lua_check_vector3(L, 2) * lua_check_float(L, 1));
+	return 1;
+}
+
+static int lua_vector3_div(lua_State* L)
+{
+	lua_math_temp(L, LUA_MATH_VECTOR3, *lua_check_vector3(L, 1) / lua_check_float(L, 2));
+	return 1;
+}
+
+static int lua_vector3_unm(lua_State* L)
+{
+	lua_math_temp(L, LUA_MATH_VECTOR3, -*lua_check_vector3(L, 1));
+	return 1;
+}
+
+static int lua_vector3_set(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	Vector3* rhs = lua_to_vector3(L, 2);
+	*v = rhs ? *rhs : Vector3(lua_check_float(L, 2), lua_check_float(L, 3), lua_check_float(L, 4));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_clone(lua_State* L)
+{
+	lua_math_new(L, LUA_MATH_VECTOR3, *lua_check_vector3(L, 1));
+	return 1;
+}
+
+static int lua_vector3_unpack(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	lua_pushnumber(L, v->x);
+	lua_pushnumber(L, v->y);
+	lua_pushnumber(L, v->z);
+	return 3;
+}
+
+static int lua_vector3_add_(lua_State* L)
+{
+	*lua_check_vector3(L, 1) += *lua_check_vector3(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_sub_(lua_State* L)
+{
+	*lua_check_vector3(L, 1) -= *lua_check_vector3(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_mul_(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	Vector3* rhs = lua_to_vector3(L, 2);
+	if (rhs)
+		*v *= *rhs;
+	else
+		*v *= lua_check_float(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_div_(lua_State* L)
+{
+	*lua_check_vector3(L, 1) /= lua_check_float(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_neg_(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	*v = -*v;
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_normalize_(lua_State* L)
+{
+	lua_check_vector3(L, 1)->Normalize();
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_cross_(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	*v = v->Cross(*lua_check_vector3(L, 2));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_lerp_(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	*v = v->Lerp(*lua_check_vector3(L, 2), lua_check_float(L, 3));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_rotate_(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	*v = *lua_check_quaternion(L, 2) * *v;
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_transform_(lua_State* L)
+{
+	Vector3* v = lua_check_vector3(L, 1);
+	*v = *lua_check_matrix3x4(L, 2) * *v;
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3_dot(lua_State* L)
+{
+	lua_pushnumber(L, lua_check_vector3(L, 1)->Dot(*lua_check_vector3(L, 2)));
+	return 1;
+}
+
+static int lua_vector3_length(lua_State* L)
+{
+	lua_pushnumber(L, lua_check_vector3(L, 1)->Length());
+	return 1;
+}
+
+static int lua_vector3_length_squared(lua_State* L)
+{
+	lua_pushnumber(L, lua_check_vector3(L, 1)->LengthSquared());
+	return 1;
+}
+
+static int lua_vector3_distance(lua_State* L)
+{
+	lua_pushnumber(L, (*lua_check_vector3(L, 1) - *lua_check_vector3(L, 2)).Length());
+	return 1;
+}
+
+static const luaL_Reg lua_vector3_class[] = {
+	{ "new", lua_vector3_new },
+	{ nullptr, nullptr },
+};
+
+static const luaL_Reg lua_vector3_meta[] = {
+	{ "__index",        lua_vector3_index },
+	{ "__newindex",     lua_vector3_newindex },
+	{ "__tostring",     lua_vector3_tostring },
+	{ "__eq",           lua_vector3_eq },
+	{ "__add",          lua_vector3_add },
+	{ "__sub",          lua_vector3_sub },
+	{ "__mul",          lua_vector3_mul },
+	{ "__div",          lua_vector3_div },
+	{ "__unm",          lua_vector3_unm },
+	{ "set",            lua_vector3_set },
+	{ "clone",          lua_vector3_clone },
+	{ "unpack",         lua_vector3_unpack },
+	{ "add_",           lua_vector3_add_ },
+	{ "sub_",           lua_vector3_sub_ },
+	{ "mul_",           lua_vector3_mul_ },
+	{ "div_",           lua_vector3_div_ },
+	{ "neg_",           lua_vector3_neg_ },
+	{ "normalize_",     lua_vector3_normalize_ },
+	{ "cross_",         lua_vector3_cross_ },
+	{ "lerp_",          lua_vector3_lerp_ },
+	{ "rotate_",        lua_vector3_rotate_ },
+	{ "transform_",     lua_vector3_transform_ },
+	{ "dot",            lua_vector3_dot },
+	{ "length",         lua_vector3_length },
+	{ "length_squared", lua_vector3_length_squared },
+	{ "distance",       lua_vector3_distance },
+	{ nullptr, nullptr },
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Quaternion
+
+static int lua_quaternion_new(lua_State* L)
+{
+	Quaternion* q = (Quaternion*)lua_math_to(L, 1, LUA_MATH_QUATERNION);
+	if (q)
+		lua_math_new(L, LUA_MATH_QUATERNION, *q);
+	else if (lua_isnoneornil(L, 1))
+		lua_math_new(L, LUA_MATH_QUATERNION, Quaternion::IDENTITY);
+	else
+		lua_math_new(L, LUA_MATH_QUATERNION, Quaternion(lua_check_float(L, 1), lua_check_float(L, 2),
+			lua_check_float(L, 3), lua_check_float(L, 4)));
+	return 1;
+}
+
+/// Quaternion.from_euler(x, y, z) with angles in degrees.
+static int lua_quaternion_from_euler(lua_State* L)
+{
+	lua_math_new(L, LUA_MATH_QUATERNION, Quaternion(lua_check_float(L, 1), lua_check_float(L, 2), lua_check_float(L, 3)));
+	return 1;
+}
+
+/// Quaternion.from_angle_axis(angle, axis) with the angle in degrees.
+static int lua_quaternion_from_angle_axis(lua_State* L)
+{
+	lua_math_new(L, LUA_MATH_QUATERNION, Quaternion(lua_check_float(L, 1), *lua_check_vector3(L, 2)));
+	return 1;
+}
+
+static int lua_quaternion_index(lua_State* L)
+{
+	int i = lua_math_component(L, 2, "wxyz");
+	if (i < 0)
+		return lua_math_method(L, LUA_MATH_QUATERNION);
+	lua_pushnumber(L, lua_check_quaternion(L, 1)->Data()[i]);
+	return 1;
+}
+
+static int lua_quaternion_newindex(lua_State* L)
+{
+	Quaternion* q = lua_check_quaternion(L, 1);
+	int i = lua_math_component(L, 2, "wxyz");
+	luaL_argcheck(L, i >= 0, 2, "w, x, y or z expected");
+	const_cast<float*>(q->Data())[i] = lua_check_float(L, 3);
+	return 0;
+}
+
+static int lua_quaternion_tostring(lua_State* L)
+{
+	Quaternion* q = lua_check_quaternion(L, 1);
+	lua_pushfstring(L, "Quaternion(%f, %f, %f, %f)", (lua_Number)q->w, (lua_Number)q->x, (lua_Number)q->y,
+		(lua_Number)q->z);
+	return 1;
+}
+
+static int lua_quaternion_eq(lua_State* L)
+{
+	Quaternion* lhs = lua_to_quaternion(L, 1);
+	Quaternion* rhs = lua_to_quaternion(L, 2);
+	lua_pushboolean(L, lhs && rhs && *lhs == *rhs);
+	return 1;
+}
+
+static int lua_quaternion_mul(lua_State* L)
+{
+	// Quaternion * quaternion, or quaternion * vector for the rotated vector.
+	Quaternion* q = lua_check_quaternion(L, 1);
+	Vector3* v = lua_to_vector3(L, 2);
+	if (v)
+		lua_math_temp(L, LUA_MATH_VECTOR3, *q * *v);
+	else
+		lua_math_temp(L, LUA_MATH_QUATERNION, *q * *lua_check_quaternion(L, 2));
+	return 1;
+}
+
+static int lua_quaternion_set(lua_State* L)
+{
+	Quaternion* q = lua_check_quaternion(L, 1);
+	Quaternion* rhs = (Quaternion*)lua_math_to(L, 2, LUA_MATH_QUATERNION);
+	*q = rhs ? *rhs : Quaternion(lua_check_float(L, 2), lua_check_float(L, 3), lua_check_float(L, 4), lua_check_float(L, 5));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_quaternion_set_euler_(lua_State* L)
+{
+	lua_check_quaternion(L, 1)->FromEulerAngles(lua_check_float(L, 2), lua_check_float(L, 3), lua_check_float(L, 4));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_quaternion_set_angle_axis_(lua_State* L)
+{
+	lua_check_quaternion(L, 1)->FromAngleAxis(lua_check_float(L, 2), *lua_check_vector3(L, 3));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_quaternion_clone(lua_State* L)
+{
+	lua_math_new(L, LUA_MATH_QUATERNION, *lua_check_quaternion(L, 1));
+	return 1;
+}
+
+static int lua_quaternion_unpack(lua_State* L)
+{
+	Quaternion* q = lua_check_quaternion(L, 1);
+	lua_pushnumber(L, q->w);
+	lua_pushnumber(L, q->x);
+	lua_pushnumber(L, q->y);
+	lua_pushnumber(L, q->z);
+	return 4;
+}
+
+static int lua_quaternion_mul_(lua_State* L)
+{
+	Quaternion* q = lua_check_quaternion(L, 1);
+	*q = *q * *lua_check_quaternion(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_quaternion_normalize_(lua_State* L)
+{
+	lua_check_quaternion(L, 1)->Normalize();
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_quaternion_inverse_(lua_State* L)
+{
+	Quaternion* q = lua_check_quaternion(L, 1);
+	*q = q->Inverse();
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_quaternion_slerp_(lua_State* L)
+{
+	Quaternion* q = lua_check_quaternion(L, 1);
+	*q = q->Slerp(*lua_check_quaternion(L, 2), lua_check_float(L, 3));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_quaternion_nlerp_(lua_State* L)
+{
+	Quaternion* q = lua_check_quaternion(L, 1);
+	*q = q->Nlerp(*lua_check_quaternion(L, 2), lua_check_float(L, 3), true);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_quaternion_dot(lua_State* L)
+{
+	lua_pushnumber(L, lua_check_quaternion(L, 1)->Dot(*lua_check_quaternion(L, 2)));
+	return 1;
+}
+
+static int lua_quaternion_euler(lua_State* L)
+{
+	Vector3 angles = lua_check_quaternion(L, 1)->EulerAngles();
+	lua_pushnumber(L, angles.x);
+	lua_pushnumber(L, angles.y);
+	lua_pushnumber(L, angles.z);
+	return 3;
+}
+
+static const luaL_Reg lua_quaternion_class[] = {
+	{ "new",             lua_quaternion_new },
+	{ "from_euler",      lua_quaternion_from_euler },
+	{ "from_angle_axis", lua_quaternion_from_angle_axis },
+	{ nullptr, nullptr },
+};
+
+static const luaL_Reg lua_quaternion_meta[] = {
+	{ "__index",         lua_quaternion_index },
+	{ "__newindex",      lua_quaternion_newindex },
+	{ "__tostring",      lua_quaternion_tostring },
+	{ "__eq",            lua_quaternion_eq },
+	{ "__mul",           lua_quaternion_mul },
+	{ "set",             lua_quaternion_set },
+	{ "set_euler_",      lua_quaternion_set_euler_ },
+	{ "set_angle_axis_", lua_quaternion_set_angle_axis_ },
+	{ "clone",           lua_quaternion_clone },
+	{ "unpack",          lua_quaternion_unpack },
+	{ "mul_",            lua_quaternion_mul_ },
+	{ "normalize_",      lua_quaternion_normalize_ },
+	{ "inverse_",        lua_quaternion_inverse_ },
+	{ "slerp_",          lua_quaternion_slerp_ },
+	{ "nlerp_",          lua_quaternion_nlerp_ },
+	{ "dot",             lua_quaternion_dot },
+	{ "euler",           lua_quaternion_euler },
+	{ nullptr, nullptr },
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Matrix3x4
+
+/// Vector3 or uniform number scale at arg.
+static Vector3 lua_check_scale(lua_State* L, int arg)
+{
+	Vector3* v = lua_to_vector3(L, arg);
+	if (v)
+		return *v;
+	float scale = (float)luaL_optnumber(L, arg, 1.0);
+	return Vector3(scale, scale, scale);
+}
+
+/// Matrix3x4.new() for identity, Matrix3x4.new(m) for a copy, Matrix3x4.new(position, rotation[, scale]).
+static int lua_matrix3x4_new(lua_State* L)
+{
+	Matrix3x4* m = (Matrix3x4*)lua_math_to(L, 1, LUA_MATH_MATRIX3X4);
+	if (m)
+		lua_math_new(L, LUA_MATH_MATRIX3X4, *m);
+	else if (lua_isnoneornil(L, 1))
+		lua_math_new(L, LUA_MATH_MATRIX3X4, Matrix3x4::IDENTITY);
+	else
+		lua_math_new(L, LUA_MATH_MATRIX3X4, Matrix3x4(*lua_check_vector3(L, 1), *lua_check_quaternion(L, 2), lua_check_scale(L, 3)));
+	return 1;
+}
+
+static int lua_matrix3x4_tostring(lua_State* L)
+{
+	Matrix3x4* m = lua_check_matrix3x4(L, 1);
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "Matrix3x4(%g %g %g %g, %g %g %g %g, %g %g %g %g)", m->m00, m->m01, m->m02, m->m03,
+		m->m10, m->m11, m->m12, m->m13, m->m20, m->m21, m->m22, m->m23);
+	lua_pushstring(L, buffer);
+	return 1;
+}
+
+static int lua_matrix3x4_eq(lua_State* L)
+{
+	Matrix3x4* lhs = lua_to_matrix3x4(L, 1);
+	Matrix3x4* rhs = lua_to_matrix3x4(L, 2);
+	lua_pushboolean(L, lhs && rhs && *lhs == *rhs);
+	return 1;
+}
+
+static int lua_matrix3x4_mul(lua_State* L)
+{
+	// Matrix * matrix, or matrix * vector for the transformed point.
+	Matrix3x4* m = lua_check_matrix3x4(L, 1);
+	Vector3* v = lua_to_vector3(L, 2);
+	if (v)
+		lua_math_temp(L, LUA_MATH_VECTOR3, *m * *v);
+	else
+		lua_math_temp(L, LUA_MATH_MATRIX3X4, *m * *lua_check_matrix3x4(L, 2));
+	return 1;
+}
+
+static int lua_matrix3x4_set(lua_State* L)
+{
+	*lua_check_matrix3x4(L, 1) = *lua_check_matrix3x4(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_matrix3x4_set_identity_(lua_State* L)
+{
+	*lua_check_matrix3x4(L, 1) = Matrix3x4::IDENTITY;
+	lua_settop(L, 1);
+	return 1;
+}
+
+/// m:compose_(position, rotation[, scale])
+static int lua_matrix3x4_compose_(lua_State* L)
+{
+	*lua_check_matrix3x4(L, 1) = Matrix3x4(*lua_check_vector3(L, 2), *lua_check_quaternion(L, 3), lua_check_scale(L, 4));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_matrix3x4_clone(lua_State* L)
+{
+	lua_math_new(L, LUA_MATH_MATRIX3X4, *lua_check_matrix3x4(L, 1));
+	return 1;
+}
+
+/// m:get(row, column) with zero based indices, as in m00 to m23.
+static int lua_matrix3x4_get(lua_State* L)
+{
+	Matrix3x4* m = lua_check_matrix3x4(L, 1);
+	lua_Integer row = luaL_checkinteger(L, 2);
+	lua_Integer column = luaL_checkinteger(L, 3);
+	luaL_argcheck(L, row >= 0 && row < 3, 2, "row out of range");
+	luaL_argcheck(L, column >= 0 && column < 4, 3, "column out of range");
+	lua_pushnumber(L, m->Data()[row * 4 + column]);
+	return 1;
+}
+
+static int lua_matrix3x4_mul_(lua_State* L)
+{
+	Matrix3x4* m = lua_check_matrix3x4(L, 1);
+	*m = *m * *lua_check_matrix3x4(L, 2);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_matrix3x4_inverse_(lua_State* L)
+{
+	Matrix3x4* m = lua_check_matrix3x4(L, 1);
+	*m = m->Inverse();
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_matrix3x4_set_translation_(lua_State* L)
+{
+	lua_check_matrix3x4(L, 1)->SetTranslation(*lua_check_vector3(L, 2));
+	lua_settop(L, 1);
+	return 1;
+}
+
+/// m:decompose(position, rotation, scale) writes into the given objects.
+static int lua_matrix3x4_decompose(lua_State* L)
+{
+	lua_check_matrix3x4(L, 1)->Decompose(*lua_check_vector3(L, 2), *lua_check_quaternion(L, 3), *lua_check_vector3(L, 4));
+	return 0;
+}
+
+static const luaL_Reg lua_matrix3x4_class[] = {
+	{ "new", lua_matrix3x4_new },
+	{ nullptr, nullptr },
+};
+
+static const luaL_Reg lua_matrix3x4_meta[] = {
+	{ "__tostring",       lua_matrix3x4_tostring },
+	{ "__eq",             lua_matrix3x4_eq },
+	{ "__mul",            lua_matrix3x4_mul },
+	{ "set",              lua_matrix3x4_set },
+	{ "set_identity_",    lua_matrix3x4_set_identity_ },
+	{ "compose_",         lua_matrix3x4_compose_ },
+	{ "clone",            lua_matrix3x4_clone },
+	{ "get",              lua_matrix3x4_get },
+	{ "mul_",             lua_matrix3x4_mul_ },
+	{ "inverse_",         lua_matrix3x4_inverse_ },
+	{ "set_translation_", lua_matrix3x4_set_translation_ },
+	{ "decompose",        lua_matrix3x4_decompose },
+	{ nullptr, nullptr },
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Vector3Array: count vectors in one userdata, stored as x, y and z arrays for the bulk kernels. Indices are one
+// based like Lua arrays.
+
+static int lua_vector3array_new(lua_State* L)
+{
+	lua_Integer count = luaL_checkinteger(L, 1);
+	luaL_argcheck(L, count >= 0 && count <= 0x10000000, 1, "count out of range");
+	size_t size = sizeof(LuaVector3Array) + (size_t)count * 3 * sizeof(float);
+	LuaVector3Array* a = (LuaVector3Array*)lua_newuserdata(L, size);
+	a->count = (unsigned)count;
+	memset(a->X(), 0, (size_t)count * 3 * sizeof(float));
+	lua_pushvalue(L, lua_upvalueindex(LUA_MATH_VECTOR3ARRAY));
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static unsigned lua_vector3array_check_index(lua_State* L, LuaVector3Array* a, int arg)
+{
+	lua_Integer i = luaL_checkinteger(L, arg);
+	luaL_argcheck(L, i >= 1 && i <= (lua_Integer)a->count, arg, "index out of range");
+	return (unsigned)(i - 1);
+}
+
+/// Second array of a batch operation, which must have as many elements as the first.
+static LuaVector3Array* lua_vector3array_check_same(lua_State* L, LuaVector3Array* a, int arg)
+{
+	LuaVector3Array* b = lua_check_vector3array(L, arg);
+	luaL_argcheck(L, b->count == a->count, arg, "array sizes differ");
+	return b;
+}
+
+static int lua_vector3array_len(lua_State* L)
+{
+	lua_pushinteger(L, lua_check_vector3array(L, 1)->count);
+	return 1;
+}
+
+/// a:get(i) returns x, y, z; a:get(i, v) writes into v instead.
+static int lua_vector3array_get(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	unsigned i = lua_vector3array_check_index(L, a, 2);
+	if (!lua_isnoneornil(L, 3)) {
+		*lua_check_vector3(L, 3) = Vector3(a->X()[i], a->Y()[i], a->Z()[i]);
+		return 0;
+	}
+	lua_pushnumber(L, a->X()[i]);
+	lua_pushnumber(L, a->Y()[i]);
+	lua_pushnumber(L, a->Z()[i]);
+	return 3;
+}
+
+/// a:set(i, v) or a:set(i, x, y, z)
+static int lua_vector3array_set(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	unsigned i = lua_vector3array_check_index(L, a, 2);
+	Vector3* v = lua_to_vector3(L, 3);
+	Vector3 value = v ? *v : Vector3(lua_check_float(L, 3), lua_check_float(L, 4), lua_check_float(L, 5));
+	a->X()[i] = value.x;
+	a->Y()[i] = value.y;
+	a->Z()[i] = value.z;
+	return 0;
+}
+
+static int lua_vector3array_copy_(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	LuaVector3Array* b = lua_vector3array_check_same(L, a, 2);
+	memmove(a->X(), b->X(), (size_t)a->count * 3 * sizeof(float));
+	lua_settop(L, 1);
+	return 1;
+}
+
+/// a:add_(b) adds the elements of array b, a:add_(v) adds vector v to every element.
+static int lua_vector3array_add_(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	float* x = a->X();
+	float* y = a->Y();
+	float* z = a->Z();
+	Vector3* v = lua_to_vector3(L, 2);
+	if (v) {
+		for (unsigned i = 0; i < a->count; ++i) {
+			x[i] += v->x;
+			y[i] += v->y;
+			z[i] += v->z;
+		}
+	}
+	else {
+		LuaVector3Array* b = lua_vector3array_check_same(L, a, 2);
+		const float* bx = b->X();
+		const float* by = b->Y();
+		const float* bz = b->Z();
+		for (unsigned i = 0; i < a->count; ++i) {
+			x[i] += bx[i];
+			y[i] += by[i];
+			z[i] += bz[i];
+		}
+	}
+	lua_settop(L, 1);
+	return 1;
+}
+
+/// a:mul_(s) scales every element, a:mul_(v) multiplies them component-wise with vector v.
+static int lua_vector3array_mul_(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	Vector3* v = lua_to_vector3(L, 2);
+	Vector3 scale = v ? *v : Vector3::ONE * lua_check_float(L, 2);
+	float* x = a->X();
+	float* y = a->Y();
+	float* z = a->Z();
+	for (unsigned i = 0; i < a->count; ++i) {
+		x[i] *= scale.x;
+		y[i] *= scale.y;
+		z[i] *= scale.z;
+	}
+	lua_settop(L, 1);
+	return 1;
+}
+
+/// a:lerp_(b, t)
+static int lua_vector3array_lerp_(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	LuaVector3Array* b = lua_vector3array_check_same(L, a, 2);
+	float t = lua_check_float(L, 3);
+	float* x = a->X();
+	float* y = a->Y();
+	float* z = a->Z();
+	const float* bx = b->X();
+	const float* by = b->Y();
+	const float* bz = b->Z();
+	for (unsigned i = 0; i < a->count; ++i) {
+		x[i] = Math::Lerp(x[i], bx[i], t);
+		y[i] = Math::Lerp(y[i], by[i], t);
+		z[i] = Math::Lerp(z[i], bz[i], t);
+	}
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3array_normalize_(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	float* x = a->X();
+	float* y = a->Y();
+	float* z = a->Z();
+	for (unsigned i = 0; i < a->count; ++i) {
+		Vector3 v(x[i], y[i], z[i]);
+		v.Normalize();
+		x[i] = v.x;
+		y[i] = v.y;
+		z[i] = v.z;
+	}
+	lua_settop(L, 1);
+	return 1;
+}
+
+/// a:transform_(m) transforms the elements as points, a:transform_(m, true) as directions.
+static int lua_vector3array_transform_(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	Matrix3x4* m = lua_check_matrix3x4(L, 2);
+	if (lua_toboolean(L, 3))
+		m->BulkTransformDirections(a->X(), a->Y(), a->Z(), a->X(), a->Y(), a->Z(), a->count);
+	else
+		m->BulkTransformPoints(a->X(), a->Y(), a->Z(), a->X(), a->Y(), a->Z(), a->count);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int lua_vector3array_rotate_(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	Matrix3x4 rotation(lua_check_quaternion(L, 2)->RotationMatrix());
+	rotation.BulkTransformDirections(a->X(), a->Y(), a->Z(), a->X(), a->Y(), a->Z(), a->count);
+	lua_settop(L, 1);
+	return 1;
+}
+
+/// a:sum(v) writes the sum of the elements into v.
+static int lua_vector3array_sum(lua_State* L)
+{
+	LuaVector3Array* a = lua_check_vector3array(L, 1);
+	Vector3* sum = lua_check_vector3(L, 2);
+	*sum = Vector3::ZERO;
+	for (unsigned i = 0; i < a->count; ++i)
+		*sum += Vector3(a->X()[i], a->Y()[i], a->Z()[i]);
+	return 0;
+}
+
+static const luaL_Reg lua_vector3array_class[] = {
+	{ "new", lua_vector3array_new },
+	{ nullptr, nullptr },
+};
+
+static const luaL_Reg lua_vector3array_meta[] = {
+	{ "__len",       lua_vector3array_len },
+	{ "get",         lua_vector3array_get },
+	{ "set",         lua_vector3array_set },
+	{ "copy_",       lua_vector3array_copy_ },
+	{ "add_",        lua_vector3array_add_ },
+	{ "mul_",        lua_vector3array_mul_ },
+	{ "lerp_",       lua_vector3array_lerp_ },
+	{ "normalize_",  lua_vector3array_normalize_ },
+	{ "transform_",  lua_vector3array_transform_ },
+	{ "rotate_",     lua_vector3array_rotate_ },
+	{ "sum",         lua_vector3array_sum },
+	{ nullptr, nullptr },
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Set the functions into the table at index, each with the upvalues that start at index first.
+static void lua_math_set_funcs(lua_State* L, int table, const luaL_Reg* funcs, int first)
+{
+	for (; funcs->name; ++funcs) {
+		for (int i = 0; i < LUA_MATH_UPVALUES; ++i)
+			lua_pushvalue(L, first + i);
+		lua_pushcclosure(L, funcs->func, LUA_MATH_UPVALUES);
+		lua_setfield(L, table, funcs->name);
+	}
+}
+
+void lua_open_math_lib(lua_State* L)
+{
+	int first = lua_gettop(L) + 1;
+	for (int type = LUA_MATH_VECTOR3; type <= LUA_MATH_VECTOR3ARRAY; ++type)
+		lua_newtable(L);
+	LuaMathTemps* temps = (LuaMathTemps*)lua_newuserdata(L, sizeof(LuaMathTemps));
+	memset(temps, 0, sizeof(LuaMathTemps));
+	// Sized up front, so that filling the rings does not rehash.
+	lua_createtable(L, LUA_MATH_MATRIX3X4 * LUA_MATH_TEMPS, 0);
+
+	struct
+	{
+		const luaL_Reg* meta;
+		const luaL_Reg* klass;
+	} types[] = {
+		{ lua_vector3_meta,      lua_vector3_class },
+		{ lua_quaternion_meta,   lua_quaternion_class },
+		{ lua_matrix3x4_meta,    lua_matrix3x4_class },
+		{ lua_vector3array_meta, lua_vector3array_class },
+	};
+	for (int type = LUA_MATH_VECTOR3; type <= LUA_MATH_VECTOR3ARRAY; ++type) {
+		int meta = first + type - 1;
+		lua_math_set_funcs(L, meta, types[type - 1].meta, first);
+		lua_pushstring(L, lua_math_type_names[type]);
+		lua_setfield(L, meta, "__name");
+		// Types without components look their methods up in the metatable directly, which saves the C call.
+		if (lua_getfield(L, meta, "__index") == LUA_TNIL) {
+			lua_pushvalue(L, meta);
+			lua_setfield(L, meta, "__index");
+		}
+		lua_pop(L, 1);
+
+		lua_newtable(L);
+		lua_math_set_funcs(L, lua_gettop(L), types[type - 1].klass, first);
+		lua_setglobal(L, lua_math_type_names[type]);
+	}
+	lua_settop(L, first - 1);
+}
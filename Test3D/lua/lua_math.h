@@ -0,0 +1,8 @@
+#pragma once
+
+struct lua_State;
+
+/// Number of operator results each math type recycles; see lua_math.cpp.
+#define LUA_MATH_TEMPS 256
+
+void lua_open_math_lib(lua_State*);
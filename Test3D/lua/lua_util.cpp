@@ -1,14 +1,23 @@
 #include "script_system.h"
 
+#include "util/log_format.h"
 #include "util/logger.h"
 
+#include <map>
+#include <string.h>
+#include <string>
+
+/// Level names of util_log_set_level, from LogLevel_Debug; "off" is LogLevel_Max.
+static const char* const lua_util_level_names[] = { "debug", "info", "sys", "warn", "err", "off", nullptr };
 
 static int lua_util_log_message(lua_State* L)
 {
-	const char* msg = luaL_optstring(L, 1, "");
 	int level = (int)lua_tointeger(L, lua_upvalueindex(1));
+	if (!util_log_enabled(LogCategory_Script, level))
+		return 0;
+	const char* msg = luaL_optstring(L, 1, "");
 
-	util_log_message(level, msg);
+	util_log_category_message(LogCategory_Script, level, nullptr, nullptr, 0, "%s", msg);
 	return 0;
 }
 
@@ -19,6 +28,120 @@ static void lua_util_register_log(lua_State* L, int level, const char* name)
 	lua_setglobal(L, name);
 }
 
+/// Category of the argument at index: a category name, or "all" for LogCategory_Max.
+static int lua_util_check_category(lua_State* L, int index)
+{
+	const char* name = luaL_checkstring(L, index);
+	if (!strcmp(name, "all"))
+		return LogCategory_Max;
+	int category = util_log_find_category(name);
+	if (category == LogCategory_Max)
+		return luaL_argerror(L, index, lua_pushfstring(L, "unknown log category '%s'", name));
+	return category;
+}
+
+/// util_log_set_level(category, level): category is a name such as "script" or "imgui", or "all"; level is one of
+/// "debug", "info", "sys", "warn", "err" and "off".
+static int lua_util_set_log_level(lua_State* L)
+{
+	int category = lua_util_check_category(L, 1);
+	int level = LogLevel_Debug + luaL_checkoption(L, 2, nullptr, lua_util_level_names);
+	util_log_set_level(category, level);
+	return 0;
+}
+
+/// util_log_get_level(category): the level name of a category.
+static int lua_util_get_log_level(lua_State* L)
+{
+	int category = lua_util_check_category(L, 1);
+	if (category == LogCategory_Max)
+		return luaL_argerror(L, 1, "a single category");
+	int level = util_log_get_level(category);
+	if (level < LogLevel_Debug)
+		level = LogLevel_Debug;
+	else if (level > LogLevel_Max)
+		level = LogLevel_Max;
+	lua_pushstring(L, lua_util_level_names[level - LogLevel_Debug]);
+	return 1;
+}
+
+/// util_log_enabled(level [, category]): whether messages of a level are logged in a category, "script" by default.
+/// Lets scripts skip building a message that would be dropped.
+static int lua_util_log_enabled(lua_State* L)
+{
+	int level = LogLevel_Debug + luaL_checkoption(L, 1, nullptr, lua_util_level_names);
+	int category = lua_isnoneornil(L, 2) ? LogCategory_Script : lua_util_check_category(L, 2);
+	if (category == LogCategory_Max)
+		return luaL_argerror(L, 2, "a single category");
+	lua_pushboolean(L, util_log_enabled(category, level));
+	return 1;
+}
+
+/// Rate limit of a Lua call site, with the "source:line" its suppressed notice quotes.
+struct LuaRateLimit
+{
+	std::string  where;
+	LogRateLimit limit;
+};
+
+/// util_log_allow(level [, per_second=1 [, depth=1]]): whether the function depth levels up the stack may log a
+/// message of a level now, in the script category. Keyed on that call site, like util_log_limited in C++.
+static int lua_util_log_allow(lua_State* L)
+{
+	int level = LogLevel_Debug + luaL_checkoption(L, 1, nullptr, lua_util_level_names);
+	if (!util_log_enabled(LogCategory_Script, level)) {
+		lua_pushboolean(L, 0);
+		return 1;
+	}
+	unsigned per_second = (unsigned)luaL_optinteger(L, 2, 1);
+	int depth = (int)luaL_optinteger(L, 3, 1);
+
+	lua_Debug ar;
+	if (!lua_getstack(L, depth, &ar) || !lua_getinfo(L, "Sl", &ar))
+		return luaL_argerror(L, 3, "no function at this depth");
+
+	// Sites are keyed on the source name and the line, so that a script loaded again finds its limits, and a
+	// different script cannot. There are as many as lines that call it.
+	static std::map<std::string, std::map<int, LuaRateLimit>, std::less<>> limits;
+	auto source = limits.find(ar.source);
+	if (source == limits.end())
+		source = limits.emplace(ar.source, std::map<int, LuaRateLimit>()).first;
+	LuaRateLimit& site = source->second[ar.currentline];
+	if (site.where.empty()) {
+		site.where = std::string(ar.short_src) + ":" + std::to_string(ar.currentline);
+		site.limit.fmt = site.where.c_str();
+	}
+	site.limit.per_second = per_second;
+	lua_pushboolean(L, util_log_rate_allow(site.limit, LogCategory_Script, level));
+	return 1;
+}
+
+/// util_log_set_dedup(ms): the dedup window of repeated messages; 0 turns it off.
+static int lua_util_set_log_dedup(lua_State* L)
+{
+	util_log_set_dedup((unsigned)luaL_checkinteger(L, 1));
+	return 0;
+}
+
+/// util_log_get_stats(): a table of the logger's counters: written, dropped, blocked, suppressed and repeated.
+static int lua_util_get_log_stats(lua_State* L)
+{
+	LogStats stats;
+	util_log_get_stats(&stats);
+	lua_createtable(L, 0, 5);
+	lua_pushinteger(L, (lua_Integer)stats.written);
+	lua_setfield(L, -2, "written");
+	lua_pushinteger(L, (lua_Integer)stats.dropped);
+	lua_setfield(L, -2, "dropped");
+	lua_pushinteger(L, (lua_Integer)stats.blocked);
+	lua_setfield(L, -2, "blocked");
+	lua_pushinteger(L, (lua_Integer)stats.suppressed);
+	lua_setfield(L, -2, "suppressed");
+	lua_pushinteger(L, (lua_Integer)stats.repeated);
+	lua_setfield(L, -2, "repeated");
+	return 1;
+}
+
 void lua_open_util_lib(lua_State* L)
 {
 	lua_util_register_log(L, LogLevel_Debug, "util_log_debug");
@@ -27,4 +150,10 @@ void lua_open_util_lib(lua_State* L)
 	lua_util_register_log(L, LogLevel_Warn,  "util_log_warn");
 	lua_util_register_log(L, LogLevel_Error, "util_log_err");
 
+	lua_register(L, "util_log_set_level", lua_util_set_log_level);
+	lua_register(L, "util_log_get_level", lua_util_get_log_level);
+	lua_register(L, "util_log_enabled", lua_util_log_enabled);
+	lua_register(L, "util_log_allow", lua_util_log_allow);
+	lua_register(L, "util_log_set_dedup", lua_util_set_log_dedup);
+	lua_register(L, "util_log_get_stats", lua_util_get_log_stats);
 }
@@ -88,13 +88,14 @@ bool script_system_do_file(const char* fname)
 	lua_State* L = g_LuaState;
 	int err = luaL_loadfile(L, fname);
 	if (err) {
-		util_log_err("script_system_do_file: load file '%s' failed\nreason: %s", fname, lua_tostring(L, -1));
+		util_log_cat_err(LogCategory_Script, "script_system_do_file: load file '%s' failed\nreason: %s", fname,
+			lua_tostring(L, -1));
 		lua_pop(L, 1);
 		return false;
 	}
 	err = lua_pcall_stacktrace(L, 0, 0);
 	if (err) {
-		util_log_err(lua_tostring(L, -1));
+		util_log_cat_err(LogCategory_Script, "%s", lua_tostring(L, -1));
 		lua_pop(L, 1);
 		return false;
 	}
@@ -114,13 +115,14 @@ bool script_system_invoke(ScriptSystemFunc func_index)
 	if (func_ref != LUA_NOREF) {
 		int type = lua_rawgeti(L, LUA_REGISTRYINDEX, func_ref);
 		if (type != LUA_TFUNCTION) {
-			util_log_err("script_system_invoke: function %s not exists.", g_ScriptSystemFuncNames[func_index]);
+			util_log_limited(LogCategory_Script, LogLevel_Error, 4, "script_system_invoke: function %s not exists.",
+				g_ScriptSystemFuncNames[func_index]);
 			lua_pop(L, 1);
 			return false;
 		}
 		int err = lua_pcall_stacktrace(L, 0, 0);
 		if (err) {
-			util_log_err(lua_tostring(L, -1));
+			util_log_limited(LogCategory_Script, LogLevel_Error, 4, "script_system_invoke: %s", lua_tostring(L, -1));
 			lua_pop(L, 1);
 			return false;
 		}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Matrix3x4.h"
+#include "Sphere.h"
+
+#include <float.h>
+
+MATH_CONTRACT_OFF_BEGIN
+
+/// Axis-aligned bounding box.
+class BoundingBox
+{
+public:
+	/// Construct an undefined box that any merge replaces.
+	BoundingBox() : minimum(FLT_MAX, FLT_MAX, FLT_MAX), maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+	BoundingBox(const Vector3& _minimum, const Vector3& _maximum) : minimum(_minimum), maximum(_maximum) {}
+	BoundingBox(const Sphere& sphere) :
+		minimum(sphere.center - Vector3(sphere.radius, sphere.radius, sphere.radius)),
+		maximum(sphere.center + Vector3(sphere.radius, sphere.radius, sphere.radius))
+	{
+	}
+
+	bool operator ==(const BoundingBox& rhs) const { return minimum == rhs.minimum && maximum == rhs.maximum; }
+	bool operator !=(const BoundingBox& rhs) const { return minimum != rhs.minimum || maximum != rhs.maximum; }
+
+	void Define(const Vector3& _minimum, const Vector3& _maximum)
+	{
+		minimum = _minimum;
+		maximum = _maximum;
+	}
+
+	/// Reset to the undefined state.
+	void Clear()
+	{
+		minimum = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+		maximum = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	}
+
+	bool Defined() const { return minimum.x <= maximum.x; }
+
+	void Merge(const Vector3& point)
+	{
+		minimum = Vector3(Math::Min(minimum.x, point.x), Math::Min(minimum.y, point.y), Math::Min(minimum.z, point.z));
+		maximum = Vector3(Math::Max(maximum.x, point.x), Math::Max(maximum.y, point.y), Math::Max(maximum.z, point.z));
+	}
+
+	void Merge(const BoundingBox& box)
+	{
+		minimum = Vector3(Math::Min(minimum.x, box.minimum.x), Math::Min(minimum.y, box.minimum.y), Math::Min(minimum.z, box.minimum.z));
+		maximum = Vector3(Math::Max(maximum.x, box.maximum.x), Math::Max(maximum.y, box.maximum.y), Math::Max(maximum.z, box.maximum.z));
+	}
+
+	/// Return the union of this box and another one.
+	BoundingBox Merged(const BoundingBox& box) const
+	{
+		BoundingBox ret(*this);
+		ret.Merge(box);
+		return ret;
+	}
+
+	/// Grow by margin on every side.
+	BoundingBox Expanded(float margin) const
+	{
+		Vector3 m(margin, margin, margin);
+		return BoundingBox(minimum - m, maximum + m);
+	}
+
+	Vector3 Center() const   { return (maximum + minimum) * 0.5f; }
+	Vector3 Size() const     { return maximum - minimum; }
+	Vector3 HalfSize() const { return (maximum - minimum) * 0.5f; }
+
+	float SurfaceArea() const
+	{
+		Vector3 s = maximum - minimum;
+		return 2.0f * (s.x * s.y + s.y * s.z + s.z * s.x);
+	}
+
+	bool IsInside(const Vector3& point) const
+	{
+		return point.x >= minimum.x && point.x <= maximum.x &&
+			point.y >= minimum.y && point.y <= maximum.y &&
+			point.z >= minimum.z && point.z <= maximum.z;
+	}
+
+	/// Return whether the box fully contains another box.
+	bool Contains(const BoundingBox& box) const
+	{
+		return box.minimum.x >= minimum.x && box.maximum.x <= maximum.x &&
+			box.minimum.y >= minimum.y && box.maximum.y <= maximum.y &&
+			box.minimum.z >= minimum.z && box.maximum.z <= maximum.z;
+	}
+
+	bool Intersects(const BoundingBox& box) const
+	{
+		return box.maximum.x >= minimum.x && box.minimum.x <= maximum.x &&
+			box.maximum.y >= minimum.y && box.minimum.y <= maximum.y &&
+			box.maximum.z >= minimum.z && box.minimum.z <= maximum.z;
+	}
+
+	/// Return the box enclosing this box after transformation.
+	BoundingBox Transformed(const Matrix3x4& transform) const
+	{
+		Vector3 newCenter = transform * Center();
+		Vector3 oldEdge = HalfSize();
+		Vector3 newEdge(
+			Math::Abs(transform.m00) * oldEdge.x + Math::Abs(transform.m01) * oldEdge.y + Math::Abs(transform.m02) * oldEdge.z,
+			Math::Abs(transform.m10) * oldEdge.x + Math::Abs(transform.m11) * oldEdge.y + Math::Abs(transform.m12) * oldEdge.z,
+			Math::Abs(transform.m20) * oldEdge.x + Math::Abs(transform.m21) * oldEdge.y + Math::Abs(transform.m22) * oldEdge.z
+		);
+		return BoundingBox(newCenter - newEdge, newCenter + newEdge);
+	}
+
+	Vector3 minimum;
+	Vector3 maximum;
+};
+
+MATH_CONTRACT_OFF_END
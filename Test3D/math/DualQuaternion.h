@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Matrix3x4.h"
+#include "Quaternion.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+/// Rigid transform as a unit dual quaternion real + eps * dual, where real is the rotation and
+/// dual = 0.5 * (0, t) * real encodes the translation t applied after it. Dual quaternions blend without the
+/// volume loss of blended matrices, which is what dual-quaternion skinning relies on. Scale is not representable.
+class DualQuaternion
+{
+public:
+	DualQuaternion() : real(Quaternion::IDENTITY), dual(0.0f, 0.0f, 0.0f, 0.0f) {}
+	DualQuaternion(const Quaternion& _real, const Quaternion& _dual) : real(_real), dual(_dual) {}
+	/// Construct from a rotation and a translation applied after it.
+	DualQuaternion(const Quaternion& rotation, const Vector3& translation) :
+		real(rotation),
+		dual(Quaternion(0.0f, translation.x, translation.y, translation.z) * rotation * 0.5f)
+	{
+	}
+	/// Construct from the rotation and translation of a matrix. Scale and shear are discarded.
+	explicit DualQuaternion(const Matrix3x4& matrix) : DualQuaternion(matrix.Rotation(), matrix.Translation()) {}
+
+	/// Apply rhs first, then this.
+	DualQuaternion operator *(const DualQuaternion& rhs) const
+	{
+		return DualQuaternion(real * rhs.real, real * rhs.dual + dual * rhs.real);
+	}
+	DualQuaternion operator *(float rhs) const { return DualQuaternion(real * rhs, dual * rhs); }
+	DualQuaternion operator +(const DualQuaternion& rhs) const { return DualQuaternion(real + rhs.real, dual + rhs.dual); }
+
+	/// Transform a point.
+	Vector3 operator *(const Vector3& rhs) const { return real * rhs + Translation(); }
+
+	/// Scale both parts by the inverse length of the real part and remove the component of the dual part along
+	/// it, which restores a unit dual quaternion after blending.
+	DualQuaternion Normalized() const
+	{
+		float invLen = 1.0f / sqrtf(real.LengthSquared());
+		Quaternion r = real * invLen;
+		Quaternion d = dual * invLen;
+		return DualQuaternion(r, d + r * -r.Dot(d));
+	}
+
+	Quaternion Rotation() const { return real; }
+	Vector3 Translation() const
+	{
+		Quaternion t = dual * real.Conjugate();
+		return Vector3(t.x, t.y, t.z) * 2.0f;
+	}
+
+	Matrix3x4 ToMatrix3x4() const { return Matrix3x4(Translation(), real, 1.0f); }
+
+	/// Return float data: real w, x, y, z, then dual w, x, y, z.
+	const float* Data() const { return real.Data(); }
+
+	Quaternion real;
+	Quaternion dual;
+};
+
+MATH_CONTRACT_OFF_END
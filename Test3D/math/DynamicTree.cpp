@@ -0,0 +1,492 @@
+#include "DynamicTree.h"
+
+#include <algorithm>
+#include <assert.h>
+
+MATH_CONTRACT_OFF_BEGIN
+
+namespace
+{
+
+/// Pending nodes of a depth first walk. Lives on the call stack and only spills to the heap for unusually deep
+/// trees; the walk never holds more than height + 1 nodes.
+class NodeStack
+{
+public:
+	NodeStack(int root) : m_Data(m_Fixed), m_Count(1), m_Capacity(kFIXED) { m_Fixed[0] = root; }
+
+	bool Empty() const { return m_Count == 0; }
+	int  Pop()         { return m_Data[--m_Count]; }
+	void Push(int index)
+	{
+		if (m_Count == m_Capacity) {
+			m_Capacity *= 2;
+			m_Heap.resize(m_Capacity);
+			if (m_Data == m_Fixed)
+				std::copy(m_Fixed, m_Fixed + kFIXED, m_Heap.begin());
+			m_Data = &m_Heap[0];
+		}
+		m_Data[m_Count++] = index;
+	}
+
+private:
+	static const int kFIXED = 64;
+
+	int              m_Fixed[kFIXED];
+	std::vector<int> m_Heap;
+	int*             m_Data;
+	int              m_Count;
+	int              m_Capacity;
+};
+
+}
+
+DynamicTree::DynamicTree(float margin) :
+	m_Root(NULL_NODE),
+	m_FreeList(NULL_NODE),
+	m_ProxyCount(0),
+	m_Margin(margin)
+{
+}
+
+int DynamicTree::AllocateNode()
+{
+	int index;
+	if (m_FreeList != NULL_NODE) {
+		index = m_FreeList;
+		m_FreeList = m_Nodes[index].parent;
+	}
+	else {
+		index = (int)m_Nodes.size();
+		m_Nodes.push_back(Node());
+	}
+
+	Node& node = m_Nodes[index];
+	node.parent = NULL_NODE;
+	node.child1 = NULL_NODE;
+	node.child2 = NULL_NODE;
+	node.height = 0;
+	node.userData = 0;
+	return index;
+}
+
+void DynamicTree::FreeNode(int index)
+{
+	m_Nodes[index].parent = m_FreeList;
+	m_Nodes[index].height = -1;
+	m_FreeList = index;
+}
+
+void DynamicTree::Clear()
+{
+	m_Nodes.clear();
+	m_Root = NULL_NODE;
+	m_FreeList = NULL_NODE;
+	m_ProxyCount = 0;
+}
+
+int DynamicTree::Insert(const BoundingBox& box, unsigned userData)
+{
+	int proxy = AllocateNode();
+	m_Nodes[proxy].box = box.Expanded(m_Margin);
+	m_Nodes[proxy].userData = userData;
+	InsertLeaf(proxy);
+	++m_ProxyCount;
+	return proxy;
+}
+
+void DynamicTree::Remove(int proxy)
+{
+	assert(proxy >= 0 && proxy < (int)m_Nodes.size() && m_Nodes[proxy].IsLeaf() && m_Nodes[proxy].height == 0);
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	--m_ProxyCount;
+}
+
+bool DynamicTree::Move(int proxy, const BoundingBox& box, const Vector3& displacement)
+{
+	assert(proxy >= 0 && proxy < (int)m_Nodes.size() && m_Nodes[proxy].IsLeaf() && m_Nodes[proxy].height == 0);
+
+	BoundingBox fatBox = box.Expanded(m_Margin);
+	fatBox.Merge(BoundingBox(fatBox.minimum + displacement, fatBox.maximum + displacement));
+
+	const BoundingBox& treeBox = m_Nodes[proxy].box;
+	if (treeBox.Contains(box)) {
+		// Still enclosed, but a box fattened by an earlier fast move would be kept forever; only keep it while it
+		// is reasonably close to the new fat box.
+		if (fatBox.Expanded(4.0f * m_Margin).Contains(treeBox))
+			return false;
+	}
+
+	RemoveLeaf(proxy);
+	m_Nodes[proxy].box = fatBox;
+	InsertLeaf(proxy);
+	return true;
+}
+
+void DynamicTree::InsertLeaf(int leaf)
+{
+	if (m_Root == NULL_NODE) {
+		m_Root = leaf;
+		m_Nodes[leaf].parent = NULL_NODE;
+		return;
+	}
+
+	// Walk down to the best sibling by the surface area heuristic: creating a parent for a node costs the area
+	// of the merged box, and every ancestor above it grows by the area the leaf adds to it.
+	BoundingBox leafBox = m_Nodes[leaf].box;
+	int index = m_Root;
+	while (!m_Nodes[index].IsLeaf()) {
+		const Node& node = m_Nodes[index];
+		float area = node.box.SurfaceArea();
+		float combinedArea = node.box.Merged(leafBox).SurfaceArea();
+
+		float cost = 2.0f * combinedArea;
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { node.child1, node.child2 };
+		for (unsigned i = 0; i < 2; ++i) {
+			const Node& child = m_Nodes[children[i]];
+			float childArea = child.box.Merged(leafBox).SurfaceArea();
+			if (!child.IsLeaf())
+				childArea -= child.box.SurfaceArea();
+			childCost[i] = childArea + inheritanceCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+
+	int sibling = index;
+	int oldParent = m_Nodes[sibling].parent;
+	int newParent = AllocateNode();
+	Node& parent = m_Nodes[newParent];
+	parent.parent = oldParent;
+	parent.box = leafBox.Merged(m_Nodes[sibling].box);
+	parent.height = m_Nodes[sibling].height + 1;
+	parent.child1 = sibling;
+	parent.child2 = leaf;
+	m_Nodes[sibling].parent = newParent;
+	m_Nodes[leaf].parent = newParent;
+
+	if (oldParent != NULL_NODE) {
+		if (m_Nodes[oldParent].child1 == sibling)
+			m_Nodes[oldParent].child1 = newParent;
+		else
+			m_Nodes[oldParent].child2 = newParent;
+	}
+	else
+		m_Root = newParent;
+
+	Refit(m_Nodes[leaf].parent);
+}
+
+void DynamicTree::RemoveLeaf(int leaf)
+{
+	if (leaf == m_Root) {
+		m_Root = NULL_NODE;
+		return;
+	}
+
+	int parent = m_Nodes[leaf].parent;
+	int grandParent = m_Nodes[parent].parent;
+	int sibling = m_Nodes[parent].child1 == leaf ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+
+	if (grandParent != NULL_NODE) {
+		// Replace the parent with the sibling.
+		if (m_Nodes[grandParent].child1 == parent)
+			m_Nodes[grandParent].child1 = sibling;
+		else
+			m_Nodes[grandParent].child2 = sibling;
+		m_Nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+		Refit(grandParent);
+	}
+	else {
+		m_Root = sibling;
+		m_Nodes[sibling].parent = NULL_NODE;
+		FreeNode(parent);
+	}
+}
+
+void DynamicTree::Refit(int index)
+{
+	while (index != NULL_NODE) {
+		Rotate(index);
+		RefitNode(index);
+		index = m_Nodes[index].parent;
+	}
+}
+
+void DynamicTree::RefitNode(int index)
+{
+	Node& node = m_Nodes[index];
+	const Node& child1 = m_Nodes[node.child1];
+	const Node& child2 = m_Nodes[node.child2];
+	node.height = 1 + (child1.height > child2.height ? child1.height : child2.height);
+	node.box = child1.box.Merged(child2.box);
+}
+
+void DynamicTree::Exchange(int lhs, int rhs)
+{
+	int lhsParent = m_Nodes[lhs].parent;
+	int rhsParent = m_Nodes[rhs].parent;
+	Node& a = m_Nodes[lhsParent];
+	Node& b = m_Nodes[rhsParent];
+	(a.child1 == lhs ? a.child1 : a.child2) = rhs;
+	(b.child1 == rhs ? b.child1 : b.child2) = lhs;
+	m_Nodes[lhs].parent = rhsParent;
+	m_Nodes[rhs].parent = lhsParent;
+}
+
+void DynamicTree::Rotate(int iA)
+{
+	// Try swapping a child of A with a grandchild, or two grandchildren across A, and keep the swap that shrinks
+	// the summed surface area of A's children the most. Only the children's boxes change, A's own box does not.
+	const Node& A = m_Nodes[iA];
+	int iB = A.child1;
+	int iC = A.child2;
+	const Node& B = m_Nodes[iB];
+	const Node& C = m_Nodes[iC];
+	if (B.IsLeaf() && C.IsLeaf())
+		return;
+
+	float areaB = B.box.SurfaceArea();
+	float areaC = C.box.SurfaceArea();
+	float bestCost = areaB + areaC;
+	int swapLhs = NULL_NODE;
+	int swapRhs = NULL_NODE;
+
+	if (!C.IsLeaf()) {
+		const BoundingBox& F = m_Nodes[C.child1].box;
+		const BoundingBox& G = m_Nodes[C.child2].box;
+		// B <-> F leaves C with B and G, B <-> G leaves it with B and F.
+		float cost = areaB + B.box.Merged(G).SurfaceArea();
+		if (cost < bestCost) {
+			bestCost = cost;
+			swapLhs = iB;
+			swapRhs = C.child1;
+		}
+		cost = areaB + B.box.Merged(F).SurfaceArea();
+		if (cost < bestCost) {
+			bestCost = cost;
+			swapLhs = iB;
+			swapRhs = C.child2;
+		}
+	}
+
+	if (!B.IsLeaf()) {
+		const BoundingBox& D = m_Nodes[B.child1].box;
+		const BoundingBox& E = m_Nodes[B.child2].box;
+		float cost = areaC + C.box.Merged(E).SurfaceArea();
+		if (cost < bestCost) {
+			bestCost = cost;
+			swapLhs = iC;
+			swapRhs = B.child1;
+		}
+		cost = areaC + C.box.Merged(D).SurfaceArea();
+		if (cost < bestCost) {
+			bestCost = cost;
+			swapLhs = iC;
+			swapRhs = B.child2;
+		}
+
+		if (!C.IsLeaf()) {
+			const BoundingBox& F = m_Nodes[C.child1].box;
+			const BoundingBox& G = m_Nodes[C.child2].box;
+			// D <-> F pairs E with F and D with G; D <-> G pairs E with G and D with F.
+			cost = E.Merged(F).SurfaceArea() + D.Merged(G).SurfaceArea();
+			if (cost < bestCost) {
+				bestCost = cost;
+				swapLhs = B.child1;
+				swapRhs = C.child1;
+			}
+			cost = E.Merged(G).SurfaceArea() + D.Merged(F).SurfaceArea();
+			if (cost < bestCost) {
+				bestCost = cost;
+				swapLhs = B.child1;
+				swapRhs = C.child2;
+			}
+		}
+	}
+
+	if (swapLhs == NULL_NODE)
+		return;
+
+	// swapRhs is always a grandchild of A, so its parent changed; swapLhs is a child or a grandchild.
+	int lhsParent = m_Nodes[swapLhs].parent;
+	int rhsParent = m_Nodes[swapRhs].parent;
+	Exchange(swapLhs, swapRhs);
+	RefitNode(rhsParent);
+	if (lhsParent != iA)
+		RefitNode(lhsParent);
+}
+
+void DynamicTree::CollectLeaves(int index, std::vector<int>& result) const
+{
+	NodeStack stack(index);
+	while (!stack.Empty()) {
+		index = stack.Pop();
+		const Node& node = m_Nodes[index];
+		if (node.IsLeaf())
+			result.push_back(index);
+		else {
+			stack.Push(node.child1);
+			stack.Push(node.child2);
+		}
+	}
+}
+
+void DynamicTree::Query(const BoundingBox& box, std::vector<int>& result) const
+{
+	if (m_Root == NULL_NODE)
+		return;
+
+	NodeStack stack(m_Root);
+	while (!stack.Empty()) {
+		int index = stack.Pop();
+		const Node& node = m_Nodes[index];
+		if (!node.box.Intersects(box))
+			continue;
+
+		if (node.IsLeaf())
+			result.push_back(index);
+		else {
+			stack.Push(node.child1);
+			stack.Push(node.child2);
+		}
+	}
+}
+
+void DynamicTree::Query(const Frustum& frustum, std::vector<int>& result) const
+{
+	if (m_Root == NULL_NODE)
+		return;
+
+	NodeStack stack(m_Root);
+	while (!stack.Empty()) {
+		int index = stack.Pop();
+		const Node& node = m_Nodes[index];
+
+		if (node.IsLeaf()) {
+			if (frustum.IsInsideFast(node.box))
+				result.push_back(index);
+			continue;
+		}
+
+		Intersection test = frustum.IsInside(node.box);
+		if (test == INSIDE)
+			CollectLeaves(index, result);
+		else if (test == INTERSECTS) {
+			stack.Push(node.child1);
+			stack.Push(node.child2);
+		}
+	}
+}
+
+void DynamicTree::Query(const Ray& ray, float maxDistance, std::vector<int>& result) const
+{
+	if (m_Root == NULL_NODE)
+		return;
+
+	NodeStack stack(m_Root);
+	while (!stack.Empty()) {
+		int index = stack.Pop();
+		const Node& node = m_Nodes[index];
+		if (ray.HitDistance(node.box) > maxDistance)
+			continue;
+
+		if (node.IsLeaf())
+			result.push_back(index);
+		else {
+			stack.Push(node.child1);
+			stack.Push(node.child2);
+		}
+	}
+}
+
+void DynamicTree::QueryPairs(std::vector<std::pair<int, int> >& result) const
+{
+	// Every internal node contributes the pairs between its two subtrees.
+	for (int i = 0; i < (int)m_Nodes.size(); ++i) {
+		const Node& node = m_Nodes[i];
+		if (node.height > 0)
+			QueryPairs(node.child1, node.child2, result);
+	}
+}
+
+void DynamicTree::QueryPairs(int lhs, int rhs, std::vector<std::pair<int, int> >& result) const
+{
+	const Node& a = m_Nodes[lhs];
+	const Node& b = m_Nodes[rhs];
+	if (!a.box.Intersects(b.box))
+		return;
+
+	if (a.IsLeaf() && b.IsLeaf())
+		result.push_back(lhs < rhs ? std::make_pair(lhs, rhs) : std::make_pair(rhs, lhs));
+	else if (b.IsLeaf() || (!a.IsLeaf() && a.height >= b.height)) {
+		QueryPairs(a.child1, rhs, result);
+		QueryPairs(a.child2, rhs, result);
+	}
+	else {
+		QueryPairs(lhs, b.child1, result);
+		QueryPairs(lhs, b.child2, result);
+	}
+}
+
+float DynamicTree::GetAreaRatio() const
+{
+	if (m_Root == NULL_NODE)
+		return 0.0f;
+
+	float totalArea = 0.0f;
+	for (unsigned i = 0; i < m_Nodes.size(); ++i) {
+		if (m_Nodes[i].height >= 0)
+			totalArea += m_Nodes[i].box.SurfaceArea();
+	}
+	return totalArea / m_Nodes[m_Root].box.SurfaceArea();
+}
+
+void DynamicTree::Validate() const
+{
+#ifndef NDEBUG
+	int freeCount = 0;
+	for (int index = m_FreeList; index != NULL_NODE; index = m_Nodes[index].parent)
+		++freeCount;
+
+	int leafCount = 0;
+	int nodeCount = 0;
+	if (m_Root != NULL_NODE) {
+		assert(m_Nodes[m_Root].parent == NULL_NODE);
+
+		std::vector<int> stack(1, m_Root);
+		while (!stack.empty()) {
+			int index = stack.back();
+			stack.pop_back();
+			const Node& node = m_Nodes[index];
+			++nodeCount;
+
+			if (node.IsLeaf()) {
+				assert(node.child2 == NULL_NODE && node.height == 0);
+				++leafCount;
+				continue;
+			}
+
+			const Node& child1 = m_Nodes[node.child1];
+			const Node& child2 = m_Nodes[node.child2];
+			assert(child1.parent == index && child2.parent == index);
+			assert(node.height == 1 + (child1.height > child2.height ? child1.height : child2.height));
+			assert(node.box == child1.box.Merged(child2.box));
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+	assert(leafCount == m_ProxyCount);
+	assert(nodeCount + freeCount == (int)m_Nodes.size());
+#endif
+}
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Frustum.h"
+#include "Ray.h"
+
+#include <utility>
+#include <vector>
+
+MATH_CONTRACT_OFF_BEGIN
+
+/// Incrementally updated bounding volume hierarchy.
+///
+/// Every object is a leaf holding a "fat" box, its actual box grown by a margin, so that objects moving a little
+/// do not touch the tree. Leaves are inserted by the surface area heuristic and every refit applies the tree
+/// rotation that most reduces the surface area below the node, which keeps the query cost low. Nodes live in one
+/// contiguous pool and refer to each other by index; a proxy id returned by Insert is the index of its leaf and
+/// stays valid until Remove.
+class DynamicTree
+{
+public:
+	static const int NULL_NODE = -1;
+
+	explicit DynamicTree(float margin = 0.1f);
+
+	/// Add an object and return its proxy id.
+	int  Insert(const BoundingBox& box, unsigned userData);
+	void Remove(int proxy);
+	/// Update the box of an object. The leaf is only reinserted when the box has left its fat box, in which case
+	/// the new fat box is extended along displacement as well and true is returned.
+	bool Move(int proxy, const BoundingBox& box, const Vector3& displacement = Vector3::ZERO);
+	void Clear();
+
+	unsigned           GetUserData(int proxy) const { return m_Nodes[proxy].userData; }
+	const BoundingBox& GetFatBox(int proxy) const   { return m_Nodes[proxy].box; }
+
+	/// Append the proxies whose fat boxes overlap box.
+	void Query(const BoundingBox& box, std::vector<int>& result) const;
+	/// Append the proxies whose fat boxes are at least partially inside the frustum.
+	void Query(const Frustum& frustum, std::vector<int>& result) const;
+	/// Append the proxies whose fat boxes the ray hits within maxDistance.
+	void Query(const Ray& ray, float maxDistance, std::vector<int>& result) const;
+	/// Append every pair of proxies with overlapping fat boxes, the lower id first.
+	void QueryPairs(std::vector<std::pair<int, int> >& result) const;
+
+	/// Return the height of the tree, 0 for a single leaf and -1 when empty.
+	int   GetHeight() const { return m_Root == NULL_NODE ? -1 : m_Nodes[m_Root].height; }
+	int   GetProxyCount() const { return m_ProxyCount; }
+	/// Return the summed surface area of all nodes divided by that of the root, a measure of tree quality.
+	float GetAreaRatio() const;
+	/// Check the structural invariants with assert.
+	void  Validate() const;
+
+private:
+	struct Node
+	{
+		bool IsLeaf() const { return child1 == NULL_NODE; }
+
+		BoundingBox box;
+		/// Parent index, or the next free node while the node is on the free list.
+		int         parent;
+		int         child1;
+		int         child2;
+		/// 0 for leaves, -1 for free nodes.
+		int         height;
+		unsigned    userData;
+	};
+
+	int  AllocateNode();
+	void FreeNode(int node);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	/// Refit and rotate every node from index up to the root.
+	void Refit(int index);
+	/// Recompute box and height of an internal node from its children.
+	void RefitNode(int index);
+	/// Swap two nodes that are not ancestors of each other, parents included.
+	void Exchange(int lhs, int rhs);
+	/// Apply the tree rotation below index that most reduces surface area, if any.
+	void Rotate(int index);
+	void CollectLeaves(int index, std::vector<int>& result) const;
+	void QueryPairs(int lhs, int rhs, std::vector<std::pair<int, int> >& result) const;
+
+	std::vector<Node>  m_Nodes;
+	int                m_Root;
+	int                m_FreeList;
+	int                m_ProxyCount;
+	float              m_Margin;
+};
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,222 @@
+#include "Frustum.h"
+#include "SimdLane.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+void Frustum::Define(float fovX, float fovY, float nearZ, float farZ, const Vector3& position, const Matrix3& rotation)
+{
+	Vector3 right(rotation.m00, rotation.m10, rotation.m20);
+	Vector3 forward(rotation.m01, rotation.m11, rotation.m21);
+	Vector3 up(rotation.m02, rotation.m12, rotation.m22);
+	float tanX = Math::TanDeg(fovX * 0.5f);
+	float tanY = Math::TanDeg(fovY * 0.5f);
+
+	planes[PLANE_NEAR].Define(forward, position + forward * nearZ);
+	planes[PLANE_FAR].Define(-forward, position + forward * farZ);
+	planes[PLANE_LEFT].Define(right + forward * tanX, position);
+	planes[PLANE_RIGHT].Define(-right + forward * tanX, position);
+	planes[PLANE_UP].Define(-up + forward * tanY, position);
+	planes[PLANE_DOWN].Define(up + forward * tanY, position);
+}
+
+void Frustum::Define(const Matrix4& m)
+{
+	// Gribb & Hartmann: every clip plane is a sum or difference of the rows of the clip transform.
+	planes[PLANE_LEFT].Define(m.m30 + m.m00, m.m31 + m.m01, m.m32 + m.m02, m.m33 + m.m03);
+	planes[PLANE_RIGHT].Define(m.m30 - m.m00, m.m31 - m.m01, m.m32 - m.m02, m.m33 - m.m03);
+	planes[PLANE_DOWN].Define(m.m30 + m.m10, m.m31 + m.m11, m.m32 + m.m12, m.m33 + m.m13);
+	planes[PLANE_UP].Define(m.m30 - m.m10, m.m31 - m.m11, m.m32 - m.m12, m.m33 - m.m13);
+	planes[PLANE_NEAR].Define(m.m20, m.m21, m.m22, m.m23);
+	planes[PLANE_FAR].Define(m.m30 - m.m20, m.m31 - m.m21, m.m32 - m.m22, m.m33 - m.m23);
+}
+
+Intersection Frustum::IsInside(const Vector3& point) const
+{
+	for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i) {
+		if (planes[i].Distance(point) < 0.0f)
+			return OUTSIDE;
+	}
+	return INSIDE;
+}
+
+Intersection Frustum::IsInside(const Sphere& sphere) const
+{
+	bool allInside = true;
+	for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i) {
+		float dist = planes[i].Distance(sphere.center);
+		if (dist < -sphere.radius)
+			return OUTSIDE;
+		else if (dist < sphere.radius)
+			allInside = false;
+	}
+	return allInside ? INSIDE : INTERSECTS;
+}
+
+Intersection Frustum::IsInside(const BoundingBox& box) const
+{
+	Vector3 center = box.Center();
+	Vector3 edge = box.HalfSize();
+	bool allInside = true;
+
+	for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i) {
+		const Plane& plane = planes[i];
+		float dist = plane.Distance(center);
+		float absDist = plane.normal.AbsDot(edge);
+
+		if (dist < -absDist)
+			return OUTSIDE;
+		else if (dist < absDist)
+			allInside = false;
+	}
+	return allInside ? INSIDE : INTERSECTS;
+}
+
+bool Frustum::IsInsideFast(const Sphere& sphere) const
+{
+	for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i) {
+		if (planes[i].Distance(sphere.center) < -sphere.radius)
+			return false;
+	}
+	return true;
+}
+
+bool Frustum::IsInsideFast(const BoundingBox& box) const
+{
+	Vector3 center = box.Center();
+	Vector3 edge = box.HalfSize();
+
+	for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i) {
+		const Plane& plane = planes[i];
+		if (plane.Distance(center) < -plane.normal.AbsDot(edge))
+			return false;
+	}
+	return true;
+}
+
+namespace
+{
+
+/// Broadcast copy of the six planes.
+template <class L>
+struct FrustumLanes
+{
+	FrustumLanes(const Plane* planes)
+	{
+		for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i) {
+			const Vector3& n = planes[i].normal;
+			nx[i] = L::Set(n.x);
+			ny[i] = L::Set(n.y);
+			nz[i] = L::Set(n.z);
+			ax[i] = L::Set(Math::Abs(n.x));
+			ay[i] = L::Set(Math::Abs(n.y));
+			az[i] = L::Set(Math::Abs(n.z));
+			d[i] = L::Set(planes[i].d);
+		}
+	}
+
+	typename L::Type Distance(unsigned i, typename L::Type x, typename L::Type y, typename L::Type z) const
+	{
+		return L::Add(L::Add(L::Add(L::Mul(nx[i], x), L::Mul(ny[i], y)), L::Mul(nz[i], z)), d[i]);
+	}
+
+	typename L::Type nx[NUM_FRUSTUM_PLANES], ny[NUM_FRUSTUM_PLANES], nz[NUM_FRUSTUM_PLANES];
+	typename L::Type ax[NUM_FRUSTUM_PLANES], ay[NUM_FRUSTUM_PLANES], az[NUM_FRUSTUM_PLANES];
+	typename L::Type d[NUM_FRUSTUM_PLANES];
+};
+
+/// Append the indices of the lanes set in mask. Every lane is written unconditionally and only the visible ones
+/// advance the output position, so the compaction has no data-dependent branches.
+template <class L>
+unsigned Compact(int mask, unsigned first, unsigned* visible, unsigned n)
+{
+	for (unsigned lane = 0; lane < L::Width; ++lane) {
+		visible[n] = first + lane;
+		n += (mask >> lane) & 1;
+	}
+	return n;
+}
+
+// Like the other bulk kernels, each cull starts at element i and returns the first element it did not process;
+// n is the running number of visible indices.
+
+template <class L>
+unsigned CullBoxes(const Plane* planes, const float* cx, const float* cy, const float* cz,
+	const float* hx, const float* hy, const float* hz, unsigned* visible, unsigned& n, unsigned i, unsigned count)
+{
+	const FrustumLanes<L> f(planes);
+	const typename L::Type zero = L::Set(0.0f);
+	const typename L::Mask all = L::CmpGe(zero, zero);
+
+	for (; i + L::Width <= count; i += L::Width) {
+		typename L::Type x = L::Load(cx + i);
+		typename L::Type y = L::Load(cy + i);
+		typename L::Type z = L::Load(cz + i);
+		typename L::Type ex = L::Load(hx + i);
+		typename L::Type ey = L::Load(hy + i);
+		typename L::Type ez = L::Load(hz + i);
+
+		typename L::Mask inside = all;
+		for (unsigned p = 0; p < NUM_FRUSTUM_PLANES; ++p) {
+			typename L::Type radius = L::Add(L::Add(L::Mul(f.ax[p], ex), L::Mul(f.ay[p], ey)), L::Mul(f.az[p], ez));
+			inside = L::And(inside, L::CmpGe(L::Add(f.Distance(p, x, y, z), radius), zero));
+		}
+		n = Compact<L>(L::MoveMask(inside), i, visible, n);
+	}
+	return i;
+}
+
+template <class L>
+unsigned CullSpheres(const Plane* planes, const float* cx, const float* cy, const float* cz,
+	const float* r, unsigned* visible, unsigned& n, unsigned i, unsigned count)
+{
+	const FrustumLanes<L> f(planes);
+	const typename L::Type zero = L::Set(0.0f);
+	const typename L::Mask all = L::CmpGe(zero, zero);
+
+	for (; i + L::Width <= count; i += L::Width) {
+		typename L::Type x = L::Load(cx + i);
+		typename L::Type y = L::Load(cy + i);
+		typename L::Type z = L::Load(cz + i);
+		typename L::Type radius = L::Load(r + i);
+
+		typename L::Mask inside = all;
+		for (unsigned p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+			inside = L::And(inside, L::CmpGe(L::Add(f.Distance(p, x, y, z), radius), zero));
+		n = Compact<L>(L::MoveMask(inside), i, visible, n);
+	}
+	return i;
+}
+
+}
+
+unsigned Frustum::CullBoxes(const float* centerX, const float* centerY, const float* centerZ,
+	const float* halfX, const float* halfY, const float* halfZ, unsigned count, unsigned* visible) const
+{
+	unsigned i = 0;
+	unsigned n = 0;
+#ifdef MATH_AVX2
+	i = ::CullBoxes<LaneAVX>(planes, centerX, centerY, centerZ, halfX, halfY, halfZ, visible, n, i, count);
+#endif
+#ifdef MATH_SSE
+	i = ::CullBoxes<LaneSSE>(planes, centerX, centerY, centerZ, halfX, halfY, halfZ, visible, n, i, count);
+#endif
+	::CullBoxes<LaneScalar>(planes, centerX, centerY, centerZ, halfX, halfY, halfZ, visible, n, i, count);
+	return n;
+}
+
+unsigned Frustum::CullSpheres(const float* centerX, const float* centerY, const float* centerZ,
+	const float* radius, unsigned count, unsigned* visible) const
+{
+	unsigned i = 0;
+	unsigned n = 0;
+#ifdef MATH_AVX2
+	i = ::CullSpheres<LaneAVX>(planes, centerX, centerY, centerZ, radius, visible, n, i, count);
+#endif
+#ifdef MATH_SSE
+	i = ::CullSpheres<LaneSSE>(planes, centerX, centerY, centerZ, radius, visible, n, i, count);
+#endif
+	::CullSpheres<LaneScalar>(planes, centerX, centerY, centerZ, radius, visible, n, i, count);
+	return n;
+}
+
+MATH_CONTRACT_OFF_END
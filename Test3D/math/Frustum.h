@@ -0,0 +1,48 @@
+#pragma once
+
+#include "BoundingBox.h"
+#include "Plane.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+enum FrustumPlane
+{
+	PLANE_NEAR = 0,
+	PLANE_LEFT,
+	PLANE_RIGHT,
+	PLANE_UP,
+	PLANE_DOWN,
+	PLANE_FAR,
+	NUM_FRUSTUM_PLANES,
+};
+
+/// View frustum stored as six planes with normals pointing inwards.
+class Frustum
+{
+public:
+	/// Define from field of view angles in degrees, clip distances and the camera placement. The camera looks along
+	/// rotation * Vector3::FORWARD with rotation * Vector3::UP as its up direction.
+	void Define(float fovX, float fovY, float nearZ, float farZ, const Vector3& position, const Matrix3& rotation);
+	/// Define from a view-projection matrix that maps into D3D clip space (0 <= z <= w).
+	void Define(const Matrix4& viewProjection);
+
+	Intersection IsInside(const Vector3& point) const;
+	Intersection IsInside(const Sphere& sphere) const;
+	Intersection IsInside(const BoundingBox& box) const;
+	/// Return whether the sphere is at least partially inside, without telling INSIDE and INTERSECTS apart.
+	bool IsInsideFast(const Sphere& sphere) const;
+	/// Return whether the box is at least partially inside, without telling INSIDE and INTERSECTS apart.
+	bool IsInsideFast(const BoundingBox& box) const;
+
+	/// Test count boxes given as center and half-size arrays. Writes the indices of the boxes that are at least
+	/// partially inside to visible, which must have room for count entries, and returns how many were written.
+	unsigned CullBoxes(const float* centerX, const float* centerY, const float* centerZ,
+		const float* halfX, const float* halfY, const float* halfZ, unsigned count, unsigned* visible) const;
+	/// Test count spheres given as center and radius arrays. Same output convention as CullBoxes.
+	unsigned CullSpheres(const float* centerX, const float* centerY, const float* centerZ,
+		const float* radius, unsigned count, unsigned* visible) const;
+
+	Plane planes[NUM_FRUSTUM_PLANES];
+};
+
+MATH_CONTRACT_OFF_END
@@ -1,7 +1,11 @@
 #include "Math.h"
 
+MATH_CONTRACT_OFF_BEGIN
+
 namespace Math
 {
 
 
 }
+
+MATH_CONTRACT_OFF_END
@@ -2,30 +2,102 @@
 
 #include <cmath>
 
+// MATH_SSE enables the SSE2 code paths. When the compiler targets AVX2 as well (/arch:AVX2 or -mavx2),
+// the bulk kernels additionally process eight lanes at a time.
+#if defined(MATH_SSE) && defined(__AVX2__)
+#define MATH_AVX2
+#endif
+
+// MATH_DETERMINISTIC makes the results of math/ bit-identical across compilers, optimization levels and x86
+// processors, for lockstep simulation and replays. Math::Policy becomes Math::Deterministic (MathPolicy.h), the
+// SSE paths use exact square roots instead of the hardware estimate, and the math/ headers and sources disable FMA
+// contraction between MATH_CONTRACT_OFF_BEGIN and MATH_CONTRACT_OFF_END, which restores the setting of the build for
+// the code that includes them. The results still differ between builds with and without MATH_SSE, so every peer has
+// to use the same switches. The build must not use fast math, and Clang honours the pragmas only without
+// -ffp-contract=fast.
+#ifdef MATH_DETERMINISTIC
+#include <cfloat>
+#if defined(MATH_FAST)
+#error MATH_DETERMINISTIC and MATH_FAST are exclusive
+#endif
+#if defined(__FAST_MATH__) || defined(_M_FP_FAST)
+#error MATH_DETERMINISTIC requires IEEE floating point semantics; do not build with fast math
+#endif
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+#error MATH_DETERMINISTIC requires float arithmetic in float precision; build for SSE2 instead of x87
+#endif
+#if defined(__clang__)
+#define MATH_CONTRACT_OFF_BEGIN _Pragma("float_control(push)") _Pragma("clang fp contract(off)")
+#define MATH_CONTRACT_OFF_END _Pragma("float_control(pop)")
+#elif defined(__GNUC__)
+#define MATH_CONTRACT_OFF_BEGIN _Pragma("GCC push_options") _Pragma("GCC optimize(\"fp-contract=off\")")
+#define MATH_CONTRACT_OFF_END _Pragma("GCC pop_options")
+#elif defined(_MSC_VER)
+// Visual Studio has no stack for fp_contract; the default is on before Visual Studio 2022 and off since.
+#define MATH_CONTRACT_OFF_BEGIN __pragma(fp_contract(off))
+#if _MSC_VER < 1930 && !defined(_M_FP_STRICT)
+#define MATH_CONTRACT_OFF_END __pragma(fp_contract(on))
+#else
+#define MATH_CONTRACT_OFF_END
+#endif
+#endif
+#endif
+#ifndef MATH_CONTRACT_OFF_BEGIN
+#define MATH_CONTRACT_OFF_BEGIN
+#define MATH_CONTRACT_OFF_END
+#endif
+
+// Constant evaluation can be detected on GCC 9, Clang 9 and Visual Studio 2019 16.5 and later. There the constexpr
+// functions with an SSE path are usable in constant expressions in MATH_SSE builds as well; elsewhere only without it.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define MATH_HAS_CONSTANT_EVALUATED
+#endif
+
+MATH_CONTRACT_OFF_BEGIN
+
+/// Result of an intersection test between two volumes.
+enum Intersection
+{
+	OUTSIDE,
+	INTERSECTS,
+	INSIDE,
+};
+
 namespace Math
 {
-static const float kSMALL_EPSILON = 0.00001f;
-static const float kLARGE_EPSILON = 0.0001f;
-static const float kHUGE_EPSILON  = 0.001f;
-static const float kPI            = 3.14159265358979323846264338327950288f;
-static const float kDEG2RAD       = kPI  / 180.0f;
-static const float kDEG2RAD_2     = kPI  / 360.0f;    // kDEG2RAD / 2.f
-static const float kRAD2DEG       = 1.0f / kDEG2RAD;
-
-inline bool   Equals(float lhs, float rhs, float epsilon = kLARGE_EPSILON)
+/// Return whether the caller is being evaluated in a constant expression, where constexpr functions have to take
+/// their scalar path because intrinsics are not allowed. Always false without MATH_HAS_CONSTANT_EVALUATED.
+constexpr bool IsConstantEvaluated()
+{
+#ifdef MATH_HAS_CONSTANT_EVALUATED
+	return __builtin_is_constant_evaluated();
+#else
+	return false;
+#endif
+}
+
+constexpr float kSMALL_EPSILON = 0.00001f;
+constexpr float kLARGE_EPSILON = 0.0001f;
+constexpr float kHUGE_EPSILON  = 0.001f;
+constexpr float kPI            = 3.14159265358979323846264338327950288f;
+constexpr float kDEG2RAD       = kPI  / 180.0f;
+constexpr float kDEG2RAD_2     = kPI  / 360.0f;    // kDEG2RAD / 2.f
+constexpr float kRAD2DEG       = 1.0f / kDEG2RAD;
+
+constexpr bool   Equals(float lhs, float rhs, float epsilon = kLARGE_EPSILON)
 {
 	return lhs + epsilon >= rhs && lhs - epsilon <= rhs;
 }
-inline bool   IsZero(float lhs, float epsilon = kLARGE_EPSILON) { return Equals(lhs, 0.f, epsilon); } 
+constexpr bool   IsZero(float lhs, float epsilon = kLARGE_EPSILON) { return Equals(lhs, 0.f, epsilon); } 
 
-inline float  Lerp(float lhs, float rhs, float t)   { return lhs * (1.0f - t) + rhs * t; }
-inline double Lerp(double lhs, double rhs, float t) { return lhs * (1.0f - t) + rhs * t; }
+constexpr float  Lerp(float lhs, float rhs, float t)   { return lhs * (1.0f - t) + rhs * t; }
+constexpr double Lerp(double lhs, double rhs, float t) { return lhs * (1.0f - t) + rhs * t; }
 
-inline float  Min(float lhs, float rhs)              { return lhs < rhs ? lhs : rhs; }
-inline float  Max(float lhs, float rhs)              { return lhs > rhs ? lhs : rhs; }
+constexpr float  Min(float lhs, float rhs)              { return lhs < rhs ? lhs : rhs; }
+constexpr float  Max(float lhs, float rhs)              { return lhs > rhs ? lhs : rhs; }
 
-inline float  Abs(float v)                           { return v >= 0.0f ? v : -v; }
-inline float  Sign(float v)                          { return v > 0.0f ? 1.0f : (v < 0.0f ? -1.0f : 0.0f); }
+constexpr float  Abs(float v)                           { return v >= 0.0f ? v : -v; }
+constexpr float  Sign(float v)                          { return v > 0.0f ? 1.0f : (v < 0.0f ? -1.0f : 0.0f); }
 
 inline bool   IsNaN(float value)
 {
@@ -33,7 +105,7 @@ inline bool   IsNaN(float value)
 	return (u & 0x7fffffff) > 0x7f800000;
 }
 
-inline float  Clamp(float v, float min, float max)
+constexpr float  Clamp(float v, float min, float max)
 {
 	if (v < min)
 		return min;
@@ -43,18 +115,18 @@ inline float  Clamp(float v, float min, float max)
 		return v;
 }
 
-inline float  SmoothStep(float lhs, float rhs, float t)
+constexpr float  SmoothStep(float lhs, float rhs, float t)
 {
 	t = Clamp((t - lhs) / (rhs - lhs), 0.0f, 1.0f); // Saturate t
 	return t * t * (3.0f - 2.0f * t);
 }
 
-inline int Min(int lhs, int rhs) { return lhs < rhs ? lhs : rhs; }
-inline int Max(int lhs, int rhs) { return lhs > rhs ? lhs : rhs; }
+constexpr int Min(int lhs, int rhs) { return lhs < rhs ? lhs : rhs; }
+constexpr int Max(int lhs, int rhs) { return lhs > rhs ? lhs : rhs; }
 
-inline int Abs(int value) { return value >= 0 ? value : -value; }
+constexpr int Abs(int value) { return value >= 0 ? value : -value; }
 
-inline int Clamp(int value, int min, int max)
+constexpr int Clamp(int value, int min, int max)
 {
 	if (value < min)
 		return min;
@@ -64,7 +136,7 @@ inline int Clamp(int value, int min, int max)
 		return value;
 }
 
-inline bool IsPowerOfTwo(unsigned v)
+constexpr bool IsPowerOfTwo(unsigned v)
 {
 	if (!v)
 		return true;
@@ -73,7 +145,7 @@ inline bool IsPowerOfTwo(unsigned v)
 	return v == 1;
 }
 
-inline unsigned NextPowerOfTwo(unsigned v)
+constexpr unsigned NextPowerOfTwo(unsigned v)
 {
 	unsigned ret = 1;
 	while (ret < v && ret < 0x80000000)
@@ -81,7 +153,7 @@ inline unsigned NextPowerOfTwo(unsigned v)
 	return ret;
 }
 
-inline unsigned CountSetBits(unsigned v)
+constexpr unsigned CountSetBits(unsigned v)
 {
 	// Brian Kernighan's method
 	unsigned count = 0;
@@ -90,14 +162,10 @@ inline unsigned CountSetBits(unsigned v)
 	return count;
 }
 
-inline float SinDeg(float angle)         { return sinf(angle * kDEG2RAD); }
-inline float CosDeg(float angle)         { return cosf(angle * kDEG2RAD); }
-inline float TanDeg(float angle)         { return tanf(angle * kDEG2RAD); }
-inline float AsinDeg(float x)            { return kRAD2DEG * asinf(Clamp(x, -1.0f, 1.0f)); }
-inline float AcosDeg(float x)            { return kRAD2DEG * acosf(Clamp(x, -1.0f, 1.0f)); }
-inline float AtanDeg(float x)            { return kRAD2DEG * atanf(x); }
-inline float Atan2Deg(float y, float x)  { return kRAD2DEG * atan2f(y, x); }
+// SinDeg, CosDeg and the other functions in degrees are in MathPolicy.h, as they follow Math::Policy.
 
 
 
-}
\ No newline at end of file
+}
+
+MATH_CONTRACT_OFF_END
\ No newline at end of file
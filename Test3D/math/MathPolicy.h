@@ -0,0 +1,209 @@
+#pragma once
+
+#include "Math.h"
+
+#ifdef MATH_SSE
+#include <xmmintrin.h>
+#endif
+
+MATH_CONTRACT_OFF_BEGIN
+
+// Precision policies for the functions the hot paths spend their time in.
+//
+// Math::Precise forwards to the C library. Math::Fast uses approximations without library calls. Math::
+// Deterministic gives the same bits on every compiler, C library and x86 processor: the Fast polynomials, which
+// are plain float arithmetic, and exact square roots instead of the hardware estimate, whose bits differ between
+// vendors. Math::Policy is the one the math classes use internally: Precise by default, Fast when MATH_FAST is
+// defined and Deterministic when MATH_DETERMINISTIC is (see Math.h). Code that wants a particular precision
+// regardless of the build calls one of the namespaces directly.
+//
+// The error bounds below are over the whole float range unless stated otherwise and are checked by the
+// Math.Fast cases of the benchmark in bench/.
+
+namespace Math
+{
+
+namespace Precise
+{
+
+/// 1 / sqrt(x). Correctly rounded sqrtf and division, at most 1 ulp.
+inline float RSqrt(float x)                             { return 1.0f / sqrtf(x); }
+
+/// Sine and cosine of an angle in radians.
+inline void  SinCos(float angle, float& s, float& c)
+{
+	s = sinf(angle);
+	c = cosf(angle);
+}
+
+inline float Atan2(float y, float x)                    { return atan2f(y, x); }
+
+inline float Sin(float angle)                           { return sinf(angle); }
+inline float Cos(float angle)                           { return cosf(angle); }
+inline float Tan(float angle)                           { return tanf(angle); }
+inline float Asin(float x)                              { return asinf(Clamp(x, -1.0f, 1.0f)); }
+inline float Acos(float x)                              { return acosf(Clamp(x, -1.0f, 1.0f)); }
+inline float Atan(float x)                              { return atanf(x); }
+
+}
+
+namespace Fast
+{
+
+/// 1 / sqrt(x) for x > 0. Hardware estimate plus one Newton-Raphson step with MATH_SSE, relative error below
+/// 3e-7; otherwise a bit-level initial guess plus two steps, relative error below 5e-6.
+inline float RSqrt(float x)
+{
+#ifdef MATH_SSE
+	float e = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+	return e * (1.5f - 0.5f * x * e * e);
+#else
+	union
+	{
+		float    f;
+		unsigned u;
+	} bits;
+	bits.f = x;
+	bits.u = 0x5f375a86u - (bits.u >> 1);
+	float e = bits.f;
+	e = e * (1.5f - 0.5f * x * e * e);
+	return e * (1.5f - 0.5f * x * e * e);
+#endif
+}
+
+/// Sine and cosine of an angle in radians, computed together from one range reduction. Absolute error below
+/// 1e-7 for |angle| < 8192; accuracy degrades slowly beyond that as the reduction loses bits.
+inline void  SinCos(float angle, float& s, float& c)
+{
+	// Reduce to [-pi/4, pi/4] around the nearest multiple of pi/2, with pi/2 split in three parts so that the
+	// products with the quadrant number are exact (Cody-Waite). Adding and subtracting 1.5 * 2^23 rounds to the
+	// nearest integer without a branch.
+	float fq = (angle * 0.63661977f + 12582912.0f) - 12582912.0f;
+	unsigned quadrant = (unsigned)(int)fq;
+	float x = ((angle - fq * 1.5703125f) - fq * 4.8375129699707031e-4f) - fq * 7.5497899548918821e-8f;
+	float x2 = x * x;
+
+	// Minimax polynomials on [-pi/4, pi/4] (Cephes sinf/cosf).
+	union
+	{
+		float    f;
+		unsigned u;
+	} sinX, cosX;
+	sinX.f = x + x * x2 * (-1.6666654611e-1f + x2 * (8.3321608736e-3f + x2 * -1.9515295891e-4f));
+	cosX.f = 1.0f - 0.5f * x2 + x2 * x2 * (4.1666645683e-2f + x2 * (-1.3887316255e-3f + x2 * 2.4433157118e-5f));
+
+	// Rotate by the quadrant with bit operations; branches would mispredict on varying angles. Odd quadrants swap
+	// sine and cosine, and the sign bits follow bit 1 of quadrant and of quadrant + 1.
+	unsigned swap = 0u - (quadrant & 1u);
+	unsigned sinBits = (sinX.u & ~swap) | (cosX.u & swap);
+	unsigned cosBits = (cosX.u & ~swap) | (sinX.u & swap);
+	sinX.u = sinBits ^ ((quadrant & 2u) << 30);
+	cosX.u = cosBits ^ (((quadrant + 1u) & 2u) << 30);
+	s = sinX.f;
+	c = cosX.f;
+}
+
+/// atan2 without a library call: one division and a polynomial. Absolute error below 3e-7 radians. Returns 0
+/// for (0, 0) and ignores the sign of a zero y.
+inline float Atan2(float y, float x)
+{
+	float ax = Abs(x);
+	float ay = Abs(y);
+	float hi = Max(ax, ay);
+	float lo = Min(ax, ay);
+
+	// atan(lo / hi) in [0, pi/4]. Above tan(pi/8) use atan(a) = pi/4 + atan((a - 1) / (a + 1)), which keeps the
+	// polynomial argument within [-tan(pi/8), tan(pi/8)] (Cephes atanf).
+	float offset = 0.0f;
+	float num = lo;
+	float den = hi;
+	if (lo > 0.41421356f * hi) {
+		offset = kPI * 0.25f;
+		num = lo - hi;
+		den = lo + hi;
+	}
+	float a = den > 0.0f ? num / den : 0.0f;
+	float z = a * a;
+	float r = offset + a + a * z * (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f);
+
+	if (ay > ax)
+		r = kPI * 0.5f - r;
+	if (x < 0.0f)
+		r = kPI - r;
+	return y < 0.0f ? -r : r;
+}
+
+inline float Sin(float angle)
+{
+	float s, c;
+	SinCos(angle, s, c);
+	return s;
+}
+
+inline float Cos(float angle)
+{
+	float s, c;
+	SinCos(angle, s, c);
+	return c;
+}
+
+inline float Tan(float angle)
+{
+	float s, c;
+	SinCos(angle, s, c);
+	return s / c;
+}
+
+/// asin and acos through Atan2 with sqrt(1 - x^2) as the other side. The input is clamped to [-1, 1].
+inline float Asin(float x)
+{
+	x = Clamp(x, -1.0f, 1.0f);
+	return Atan2(x, sqrtf((1.0f - x) * (1.0f + x)));
+}
+
+inline float Acos(float x)
+{
+	x = Clamp(x, -1.0f, 1.0f);
+	return Atan2(sqrtf((1.0f - x) * (1.0f + x)), x);
+}
+
+inline float Atan(float x)                              { return Atan2(x, 1.0f); }
+
+}
+
+namespace Deterministic
+{
+
+// sqrtf and division are correctly rounded by IEEE 754, so the precise square root is portable where the SSE
+// estimate is not.
+using Precise::RSqrt;
+using Fast::SinCos;
+using Fast::Atan2;
+using Fast::Sin;
+using Fast::Cos;
+using Fast::Tan;
+using Fast::Asin;
+using Fast::Acos;
+using Fast::Atan;
+
+}
+
+#if defined(MATH_DETERMINISTIC)
+namespace Policy = Deterministic;
+#elif defined(MATH_FAST)
+namespace Policy = Fast;
+#else
+namespace Policy = Precise;
+#endif
+
+inline float SinDeg(float angle)         { return Policy::Sin(angle * kDEG2RAD); }
+inline float CosDeg(float angle)         { return Policy::Cos(angle * kDEG2RAD); }
+inline float TanDeg(float angle)         { return Policy::Tan(angle * kDEG2RAD); }
+inline float AsinDeg(float x)            { return kRAD2DEG * Policy::Asin(x); }
+inline float AcosDeg(float x)            { return kRAD2DEG * Policy::Acos(x); }
+inline float AtanDeg(float x)            { return kRAD2DEG * Policy::Atan(x); }
+inline float Atan2Deg(float y, float x)  { return kRAD2DEG * Policy::Atan2(y, x); }
+
+}
+
+MATH_CONTRACT_OFF_END
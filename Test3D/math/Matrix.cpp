@@ -2,28 +2,75 @@
 #include "Matrix4.h"
 #include "Matrix3x4.h"
 
+MATH_CONTRACT_OFF_BEGIN
 
-const Matrix3 Matrix3::ZERO(
-	0.0f, 0.0f, 0.0f,
-	0.0f, 0.0f, 0.0f,
-	0.0f, 0.0f, 0.0f);
+// The constants are inline constexpr in the headers. These checks run at compile time and cost nothing at runtime.
+static_assert(Matrix3::ZERO + Matrix3::IDENTITY == Matrix3::IDENTITY && Matrix3::IDENTITY * Vector3::ONE == Vector3::ONE,
+	"Matrix3 identity");
 
-const Matrix3 Matrix3::IDENTITY;
+#if !defined(MATH_SSE) || defined(MATH_HAS_CONSTANT_EVALUATED)
+// Quarter turn around UP and a translation, both exact in float.
+static constexpr Matrix3 kQUARTER_TURN(
+	0.0f, -1.0f, 0.0f,
+	1.0f,  0.0f, 0.0f,
+	0.0f,  0.0f, 1.0f);
+static constexpr Matrix3x4 kTRANSLATION(
+	1.0f, 0.0f, 0.0f, 5.0f,
+	0.0f, 1.0f, 0.0f, 6.0f,
+	0.0f, 0.0f, 1.0f, 7.0f);
 
-const Matrix4 Matrix4::ZERO(
-	0.0f, 0.0f, 0.0f, 0.0f,
-	0.0f, 0.0f, 0.0f, 0.0f,
-	0.0f, 0.0f, 0.0f, 0.0f,
-	0.0f, 0.0f, 0.0f, 0.0f);
+static_assert(kQUARTER_TURN * Vector3::RIGHT == Vector3::FORWARD && kQUARTER_TURN * kQUARTER_TURN.Transpose() == Matrix3::IDENTITY,
+	"Matrix3 rotation");
 
-const Matrix4 Matrix4::IDENTITY;
+static_assert(Matrix4::IDENTITY * Matrix4::IDENTITY == Matrix4::IDENTITY && Matrix4::IDENTITY.Transpose() == Matrix4::IDENTITY,
+	"Matrix4 identity");
+static_assert(Matrix4(Matrix3::IDENTITY) == Matrix4::IDENTITY && Matrix4::ZERO * 2.0f == Matrix4::ZERO, "Matrix4 construction");
+static_assert(Matrix4(kQUARTER_TURN) * Vector4(Vector3::RIGHT, 1.0f) == Vector4(Vector3::FORWARD, 1.0f), "Matrix4 rotation");
 
-const Matrix3x4 Matrix3x4::ZERO(
-	0.0f, 0.0f, 0.0f, 0.0f,
-	0.0f, 0.0f, 0.0f, 0.0f,
-	0.0f, 0.0f, 0.0f, 0.0f);
+static_assert(Matrix3x4::IDENTITY.ToMatrix4() == Matrix4::IDENTITY && Matrix3x4(Matrix4::IDENTITY) == Matrix3x4::IDENTITY,
+	"Matrix3x4 identity");
+static_assert(kTRANSLATION * Vector3::ZERO == Vector3(5.0f, 6.0f, 7.0f) && (kTRANSLATION * kTRANSLATION).Translation() == Vector3(10.0f, 12.0f, 14.0f),
+	"Matrix3x4 translation");
+static_assert(kTRANSLATION * Matrix4::IDENTITY == kTRANSLATION.ToMatrix4() && kTRANSLATION.ToMatrix4() * Vector3::ONE == Vector3(6.0f, 7.0f, 8.0f),
+	"Matrix3x4 and Matrix4 agree");
+#endif
 
-const Matrix3x4 Matrix3x4::IDENTITY;
+#ifdef MATH_SSE
+// 2x2 matrices packed row-major into a register: (m00, m01, m10, m11).
+
+// A * B
+static inline __m128 Mat2Mul(__m128 a, __m128 b)
+{
+	return _mm_add_ps(
+		_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// adj(A) * B
+static inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+// A * adj(B)
+static inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(
+		_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// Cross product of the xyz lanes; the w lane of the result is zero for finite inputs.
+static inline __m128 Cross3(__m128 a, __m128 b)
+{
+	__m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+#endif
 
 Matrix3 Matrix3::Inverse() const
 {
@@ -51,20 +98,65 @@ Matrix3 Matrix3::Inverse() const
 
 void Matrix4::Decompose(Vector3& translation, Quaternion& rotation, Vector3& scale) const
 {
-	translation.x = m03;
-	translation.y = m13;
-	translation.z = m23;
-
-	scale.x = sqrtf(m00 * m00 + m10 * m10 + m20 * m20);
-	scale.y = sqrtf(m01 * m01 + m11 * m11 + m21 * m21);
-	scale.z = sqrtf(m02 * m02 + m12 * m12 + m22 * m22);
-
-	Vector3 invScale(1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z);
-	rotation = Quaternion(ToMatrix3().Scaled(invScale));
+	Matrix3x4(*this).Decompose(translation, rotation, scale);
 }
 
 Matrix4 Matrix4::Inverse() const
 {
+#ifdef MATH_SSE
+	// Block-wise inverse: split the matrix into the 2x2 sub-matrices | A B |
+	//                                                                 | C D |
+	// and build the adjugate from 2x2 products, so the whole inverse costs a single division.
+	__m128 row0 = _mm_loadu_ps(&m00);
+	__m128 row1 = _mm_loadu_ps(&m10);
+	__m128 row2 = _mm_loadu_ps(&m20);
+	__m128 row3 = _mm_loadu_ps(&m30);
+
+	// Each 2x2 sub-matrix is packed row-major into one register.
+	__m128 A = _mm_movelh_ps(row0, row1);
+	__m128 B = _mm_movehl_ps(row1, row0);
+	__m128 C = _mm_movelh_ps(row2, row3);
+	__m128 D = _mm_movehl_ps(row3, row2);
+
+	// Determinants of the sub-matrices as (|A| |B| |C| |D|).
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(2, 0, 2, 0))));
+	__m128 detA = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128 detB = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128 detC = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128 detD = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(3, 3, 3, 3));
+
+	// Adjugate products D#C and A#B.
+	__m128 D_C = Mat2AdjMul(D, C);
+	__m128 A_B = Mat2AdjMul(A, B);
+
+	// Adjugates of the blocks of the inverse.
+	__m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+	__m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+	__m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+	__m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	__m128 tr = _mm_mul_ps(A_B, _mm_shuffle_ps(D_C, D_C, _MM_SHUFFLE(3, 1, 2, 0)));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(2, 3, 0, 1)));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+	__m128 invDetM = _mm_div_ps(_mm_set_ps(1.f, -1.f, -1.f, 1.f), detM);
+	X_ = _mm_mul_ps(X_, invDetM);
+	Y_ = _mm_mul_ps(Y_, invDetM);
+	Z_ = _mm_mul_ps(Z_, invDetM);
+	W_ = _mm_mul_ps(W_, invDetM);
+
+	// Apply the final adjugate swizzle while interleaving the blocks back into rows.
+	Matrix4 ret;
+	_mm_storeu_ps(&ret.m00, _mm_shuffle_ps(X_, Y_, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(&ret.m10, _mm_shuffle_ps(X_, Y_, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_storeu_ps(&ret.m20, _mm_shuffle_ps(Z_, W_, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(&ret.m30, _mm_shuffle_ps(Z_, W_, _MM_SHUFFLE(0, 2, 0, 2)));
+	return ret;
+#else
 	float v0 = m20 * m31 - m21 * m30;
 	float v1 = m20 * m32 - m22 * m30;
 	float v2 = m20 * m33 - m23 * m30;
@@ -118,25 +210,206 @@ Matrix4 Matrix4::Inverse() const
 		i10, i11, i12, i13,
 		i20, i21, i22, i23,
 		i30, i31, i32, i33);
+#endif
 }
 
+Matrix3x4 Matrix3x4::InverseRigid() const
+{
+#ifdef MATH_SSE
+	// The rows of the inverse rotation are the columns of the rotation.
+	const __m128 xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	__m128 row0 = _mm_loadu_ps(&m00);
+	__m128 row1 = _mm_loadu_ps(&m10);
+	__m128 row2 = _mm_loadu_ps(&m20);
+	__m128 t = _mm_unpackhi_ps(_mm_unpackhi_ps(row0, row2), _mm_unpackhi_ps(row1, _mm_setzero_ps()));
+	row0 = _mm_and_ps(row0, xyz);
+	row1 = _mm_and_ps(row1, xyz);
+	row2 = _mm_and_ps(row2, xyz);
+
+	// New translation is -(R^T * t), a combination of the rows of R.
+	__m128 nt = _mm_mul_ps(row0, _mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0)));
+	nt = _mm_add_ps(nt, _mm_mul_ps(row1, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1))));
+	nt = _mm_add_ps(nt, _mm_mul_ps(row2, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2))));
+	nt = _mm_sub_ps(_mm_setzero_ps(), nt);
+
+	_MM_TRANSPOSE4_PS(row0, row1, row2, nt);
 
-void Matrix3x4::Decompose(Vector3& translation, Quaternion& rotation, Vector3& scale) const
+	Matrix3x4 ret;
+	_mm_storeu_ps(&ret.m00, row0);
+	_mm_storeu_ps(&ret.m10, row1);
+	_mm_storeu_ps(&ret.m20, row2);
+	return ret;
+#else
+	// The same expressions as the bulk kernel, so that single and bulk inverses agree.
+	return Matrix3x4(
+		m00, m10, m20, 0.0f - ((m00 * m03 + m10 * m13) + m20 * m23),
+		m01, m11, m21, 0.0f - ((m01 * m03 + m11 * m13) + m21 * m23),
+		m02, m12, m22, 0.0f - ((m02 * m03 + m12 * m13) + m22 * m23));
+#endif
+}
+
+Matrix3x4 Matrix3x4::InverseScaled() const
 {
-	translation.x = m03;
-	translation.y = m13;
-	translation.z = m23;
+#ifdef MATH_SSE
+	// As InverseRigid, with each column of the rotation divided by its squared length.
+	const __m128 xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	__m128 row0 = _mm_loadu_ps(&m00);
+	__m128 row1 = _mm_loadu_ps(&m10);
+	__m128 row2 = _mm_loadu_ps(&m20);
+	__m128 t = _mm_unpackhi_ps(_mm_unpackhi_ps(row0, row2), _mm_unpackhi_ps(row1, _mm_setzero_ps()));
+	__m128 lenSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(row0, row0), _mm_mul_ps(row1, row1)), _mm_mul_ps(row2, row2));
+	__m128 invLenSquared = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.f), lenSquared), xyz);
+	row0 = _mm_mul_ps(row0, invLenSquared);
+	row1 = _mm_mul_ps(row1, invLenSquared);
+	row2 = _mm_mul_ps(row2, invLenSquared);
+
+	__m128 nt = _mm_mul_ps(row0, _mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0)));
+	nt = _mm_add_ps(nt, _mm_mul_ps(row1, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1))));
+	nt = _mm_add_ps(nt, _mm_mul_ps(row2, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2))));
+	nt = _mm_sub_ps(_mm_setzero_ps(), nt);
 
-	scale.x = sqrtf(m00 * m00 + m10 * m10 + m20 * m20);
-	scale.y = sqrtf(m01 * m01 + m11 * m11 + m21 * m21);
-	scale.z = sqrtf(m02 * m02 + m12 * m12 + m22 * m22);
+	_MM_TRANSPOSE4_PS(row0, row1, row2, nt);
 
-	Vector3 invScale(1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z);
-	rotation = Quaternion(ToMatrix3().Scaled(invScale));
+	Matrix3x4 ret;
+	_mm_storeu_ps(&ret.m00, row0);
+	_mm_storeu_ps(&ret.m10, row1);
+	_mm_storeu_ps(&ret.m20, row2);
+	return ret;
+#else
+	float s0 = 1.0f / ((m00 * m00 + m10 * m10) + m20 * m20);
+	float s1 = 1.0f / ((m01 * m01 + m11 * m11) + m21 * m21);
+	float s2 = 1.0f / ((m02 * m02 + m12 * m12) + m22 * m22);
+	float i00 = m00 * s0, i01 = m10 * s0, i02 = m20 * s0;
+	float i10 = m01 * s1, i11 = m11 * s1, i12 = m21 * s1;
+	float i20 = m02 * s2, i21 = m12 * s2, i22 = m22 * s2;
+	return Matrix3x4(
+		i00, i01, i02, 0.0f - ((i00 * m03 + i01 * m13) + i02 * m23),
+		i10, i11, i12, 0.0f - ((i10 * m03 + i11 * m13) + i12 * m23),
+		i20, i21, i22, 0.0f - ((i20 * m03 + i21 * m13) + i22 * m23));
+#endif
+}
+
+Matrix3x4 Matrix3x4::Inverse(TransformClass cls) const
+{
+	switch (cls) {
+	case TransformClass::Rigid:
+		return InverseRigid();
+	case TransformClass::Scaled:
+		return InverseScaled();
+	default:
+		return Inverse();
+	}
+}
+
+Matrix3 Matrix3x4::InverseTransposed(TransformClass cls) const
+{
+	if (cls == TransformClass::Rigid)
+		return ToMatrix3();
+
+#ifdef MATH_SSE
+	__m128 row0 = _mm_loadu_ps(&m00);
+	__m128 row1 = _mm_loadu_ps(&m10);
+	__m128 row2 = _mm_loadu_ps(&m20);
+	if (cls == TransformClass::Scaled) {
+		// The rows of the rotation with each column divided by its squared length.
+		__m128 invLenSquared = _mm_div_ps(_mm_set1_ps(1.f),
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(row0, row0), _mm_mul_ps(row1, row1)), _mm_mul_ps(row2, row2)));
+		row0 = _mm_mul_ps(row0, invLenSquared);
+		row1 = _mm_mul_ps(row1, invLenSquared);
+		row2 = _mm_mul_ps(row2, invLenSquared);
+	}
+	else {
+		// The rows are the cofactors, the cross products of the other two rows, divided by the determinant.
+		__m128 c0 = Cross3(row1, row2);
+		__m128 c1 = Cross3(row2, row0);
+		__m128 c2 = Cross3(row0, row1);
+		__m128 det = _mm_mul_ps(row0, c0);
+		det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+		det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+		__m128 invDet = _mm_div_ps(_mm_set1_ps(1.f), det);
+		row0 = _mm_mul_ps(c0, invDet);
+		row1 = _mm_mul_ps(c1, invDet);
+		row2 = _mm_mul_ps(c2, invDet);
+	}
+
+	// Matrix3 rows are three floats apart. Pack the nine elements into two registers and a float instead of storing
+	// overlapping rows, which would keep the later loads of the result from forwarding the stores.
+	Matrix3 ret;
+	__m128 row0z1x = _mm_shuffle_ps(row0, row1, _MM_SHUFFLE(0, 0, 2, 2));
+	_mm_storeu_ps(&ret.m00, _mm_shuffle_ps(row0, row0z1x, _MM_SHUFFLE(2, 0, 1, 0)));
+	_mm_storeu_ps(&ret.m11, _mm_shuffle_ps(row1, row2, _MM_SHUFFLE(1, 0, 2, 1)));
+	_mm_store_ss(&ret.m22, _mm_movehl_ps(row2, row2));
+	return ret;
+#else
+	// The same expressions as the bulk kernel, so that single and bulk results agree.
+	if (cls == TransformClass::Scaled) {
+		float s0 = 1.0f / ((m00 * m00 + m10 * m10) + m20 * m20);
+		float s1 = 1.0f / ((m01 * m01 + m11 * m11) + m21 * m21);
+		float s2 = 1.0f / ((m02 * m02 + m12 * m12) + m22 * m22);
+		return Matrix3(
+			m00 * s0, m01 * s1, m02 * s2,
+			m10 * s0, m11 * s1, m12 * s2,
+			m20 * s0, m21 * s1, m22 * s2);
+	}
+
+	float c00 = m11 * m22 - m12 * m21;
+	float c01 = m12 * m20 - m10 * m22;
+	float c02 = m10 * m21 - m11 * m20;
+	float c10 = m21 * m02 - m22 * m01;
+	float c11 = m22 * m00 - m20 * m02;
+	float c12 = m20 * m01 - m21 * m00;
+	float c20 = m01 * m12 - m02 * m11;
+	float c21 = m02 * m10 - m00 * m12;
+	float c22 = m00 * m11 - m01 * m10;
+	float invDet = 1.0f / ((m00 * c00 + m01 * c01) + m02 * c02);
+	return Matrix3(
+		c00 * invDet, c01 * invDet, c02 * invDet,
+		c10 * invDet, c11 * invDet, c12 * invDet,
+		c20 * invDet, c21 * invDet, c22 * invDet);
+#endif
+}
+
+Matrix4 Matrix4::InverseAffine() const
+{
+	return Matrix3x4(*this).Inverse().ToMatrix4();
 }
 
 Matrix3x4 Matrix3x4::Inverse() const
 {
+#ifdef MATH_SSE
+	// The rows of the transposed inverse are the cross products of the other two rows divided by the determinant.
+	__m128 row0 = _mm_loadu_ps(&m00);
+	__m128 row1 = _mm_loadu_ps(&m10);
+	__m128 row2 = _mm_loadu_ps(&m20);
+
+	// Cross products leave the translation lane at zero.
+	__m128 c0 = Cross3(row1, row2);
+	__m128 c1 = Cross3(row2, row0);
+	__m128 c2 = Cross3(row0, row1);
+
+	__m128 det = _mm_mul_ps(row0, c0);
+	det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+	det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 invDet = _mm_div_ps(_mm_set1_ps(1.f), det);
+	c0 = _mm_mul_ps(c0, invDet);
+	c1 = _mm_mul_ps(c1, invDet);
+	c2 = _mm_mul_ps(c2, invDet);
+
+	// New translation is -(R^-1 * t), computed as a combination of the columns of R^-1.
+	__m128 t = _mm_unpackhi_ps(_mm_unpackhi_ps(row0, row2), _mm_unpackhi_ps(row1, _mm_setzero_ps()));
+	__m128 nt = _mm_mul_ps(c0, _mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0)));
+	nt = _mm_add_ps(nt, _mm_mul_ps(c1, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1))));
+	nt = _mm_add_ps(nt, _mm_mul_ps(c2, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2))));
+	nt = _mm_sub_ps(_mm_setzero_ps(), nt);
+
+	_MM_TRANSPOSE4_PS(c0, c1, c2, nt);
+
+	Matrix3x4 ret;
+	_mm_storeu_ps(&ret.m00, c0);
+	_mm_storeu_ps(&ret.m10, c1);
+	_mm_storeu_ps(&ret.m20, c2);
+	return ret;
+#else
 	float det = m00 * m11 * m22 +
 		m10 * m21 * m02 +
 		m20 * m01 * m12 -
@@ -161,4 +434,7 @@ Matrix3x4 Matrix3x4::Inverse() const
 	ret.m23 = -(m03 * ret.m20 + m13 * ret.m21 + m23 * ret.m22);
 
 	return ret;
-}
\ No newline at end of file
+#endif
+}
+
+MATH_CONTRACT_OFF_END
\ No newline at end of file
@@ -1,11 +1,13 @@
 #pragma once
 #include "Vector3.h"
 
+MATH_CONTRACT_OFF_BEGIN
+
 class  Matrix3
 {
 public:
 
-	Matrix3() :
+	constexpr Matrix3() :
 		m00(1.0f),
 		m01(0.0f),
 		m02(0.0f),
@@ -19,7 +21,7 @@ public:
 	}
 
 
-	Matrix3(const Matrix3& matrix) :
+	constexpr Matrix3(const Matrix3& matrix) :
 		m00(matrix.m00),
 		m01(matrix.m01),
 		m02(matrix.m02),
@@ -33,7 +35,7 @@ public:
 	}
 
 
-	Matrix3(float v00, float v01, float v02,
+	constexpr Matrix3(float v00, float v01, float v02,
 		float v10, float v11, float v12,
 		float v20, float v21, float v22) :
 		m00(v00),
@@ -49,7 +51,7 @@ public:
 	}
 
 
-	explicit Matrix3(const float* data) :
+	explicit constexpr Matrix3(const float* data) :
 		m00(data[0]),
 		m01(data[1]),
 		m02(data[2]),
@@ -63,7 +65,7 @@ public:
 	}
 
 
-	Matrix3& operator =(const Matrix3& rhs)
+	constexpr Matrix3& operator =(const Matrix3& rhs)
 	{
 		m00 = rhs.m00;
 		m01 = rhs.m01;
@@ -78,24 +80,18 @@ public:
 	}
 
 
-	bool operator ==(const Matrix3& rhs) const
+	constexpr bool operator ==(const Matrix3& rhs) const
 	{
-		const float* leftData = Data();
-		const float* rightData = rhs.Data();
-
-		for (unsigned i = 0; i < 9; ++i) {
-			if (leftData[i] != rightData[i])
-				return false;
-		}
-
-		return true;
+		return m00 == rhs.m00 && m01 == rhs.m01 && m02 == rhs.m02 &&
+			m10 == rhs.m10 && m11 == rhs.m11 && m12 == rhs.m12 &&
+			m20 == rhs.m20 && m21 == rhs.m21 && m22 == rhs.m22;
 	}
 
 
-	bool operator !=(const Matrix3& rhs) const { return !(*this == rhs); }
+	constexpr bool operator !=(const Matrix3& rhs) const { return !(*this == rhs); }
 
 
-	Vector3 operator *(const Vector3& rhs) const
+	constexpr Vector3 operator *(const Vector3& rhs) const
 	{
 		return Vector3(
 			m00 * rhs.x + m01 * rhs.y + m02 * rhs.z,
@@ -105,7 +101,7 @@ public:
 	}
 
 
-	Matrix3 operator +(const Matrix3& rhs) const
+	constexpr Matrix3 operator +(const Matrix3& rhs) const
 	{
 		return Matrix3(
 			m00 + rhs.m00,
@@ -121,7 +117,7 @@ public:
 	}
 
 
-	Matrix3 operator -(const Matrix3& rhs) const
+	constexpr Matrix3 operator -(const Matrix3& rhs) const
 	{
 		return Matrix3(
 			m00 - rhs.m00,
@@ -137,7 +133,7 @@ public:
 	}
 
 
-	Matrix3 operator *(float rhs) const
+	constexpr Matrix3 operator *(float rhs) const
 	{
 		return Matrix3(
 			m00 * rhs,
@@ -153,7 +149,7 @@ public:
 	}
 
 
-	Matrix3 operator *(const Matrix3& rhs) const
+	constexpr Matrix3 operator *(const Matrix3& rhs) const
 	{
 		return Matrix3(
 			m00 * rhs.m00 + m01 * rhs.m10 + m02 * rhs.m20,
@@ -169,7 +165,7 @@ public:
 	}
 
 
-	void SetScale(const Vector3& scale)
+	constexpr void SetScale(const Vector3& scale)
 	{
 		m00 = scale.x;
 		m11 = scale.y;
@@ -177,7 +173,7 @@ public:
 	}
 
 
-	void SetScale(float scale)
+	constexpr void SetScale(float scale)
 	{
 		m00 = scale;
 		m11 = scale;
@@ -195,7 +191,7 @@ public:
 	}
 
 
-	Matrix3 Transpose() const
+	constexpr Matrix3 Transpose() const
 	{
 		return Matrix3(
 			m00,
@@ -211,7 +207,7 @@ public:
 	}
 
 
-	Matrix3 Scaled(const Vector3& scale) const
+	constexpr Matrix3 Scaled(const Vector3& scale) const
 	{
 		return Matrix3(
 			m00 * scale.x,
@@ -287,5 +283,14 @@ public:
 	static const Matrix3 IDENTITY;
 };
 
+inline constexpr Matrix3 Matrix3::ZERO(
+	0.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 0.0f);
+
+inline constexpr Matrix3 Matrix3::IDENTITY;
+
+
+constexpr Matrix3 operator *(float lhs, const Matrix3& rhs) { return rhs * lhs; }
 
-inline Matrix3 operator *(float lhs, const Matrix3& rhs) { return rhs * lhs; }
\ No newline at end of file
+MATH_CONTRACT_OFF_END
\ No newline at end of file
@@ -6,14 +6,27 @@
 #include <emmintrin.h>
 #endif
 
+MATH_CONTRACT_OFF_BEGIN
+
+/// What is known about an affine transform, from the cheapest to invert to the most general. Code that builds a
+/// matrix from its parts knows the class and passes it along, so that the inverse can skip the general path.
+enum class TransformClass
+{
+    /// Rotation and translation.
+    Rigid,
+    /// Rotation, translation and scale along the local axes, uniform or not, without shear.
+    Scaled,
+    /// Any affine transform.
+    Affine,
+};
+
 /// 3x4 matrix for scene node transform calculations.
 class Matrix3x4
 {
 public:
     /// Construct an identity matrix.
-    Matrix3x4()
-#ifndef MATH_SSE
-       :m00(1.0f),
+    constexpr Matrix3x4() :
+        m00(1.0f),
         m01(0.0f),
         m02(0.0f),
         m03(0.0f),
@@ -25,19 +38,12 @@ public:
         m21(0.0f),
         m22(1.0f),
         m23(0.0f)
-#endif
     {
-#ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_set_ps(0.f, 0.f, 0.f, 1.f));
-        _mm_storeu_ps(&m10, _mm_set_ps(0.f, 0.f, 1.f, 0.f));
-        _mm_storeu_ps(&m20, _mm_set_ps(0.f, 1.f, 0.f, 0.f));
-#endif
     }
 
     /// Copy-construct from another matrix.
-    Matrix3x4(const Matrix3x4& matrix)
-#ifndef MATH_SSE
-       :m00(matrix.m00),
+    constexpr Matrix3x4(const Matrix3x4& matrix) :
+        m00(matrix.m00),
         m01(matrix.m01),
         m02(matrix.m02),
         m03(matrix.m03),
@@ -49,17 +55,11 @@ public:
         m21(matrix.m21),
         m22(matrix.m22),
         m23(matrix.m23)
-#endif
     {
-#ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_loadu_ps(&matrix.m00));
-        _mm_storeu_ps(&m10, _mm_loadu_ps(&matrix.m10));
-        _mm_storeu_ps(&m20, _mm_loadu_ps(&matrix.m20));
-#endif
     }
 
     /// Copy-construct from a 3x3 matrix and set the extra elements to identity.
-    Matrix3x4(const Matrix3& matrix) :
+    constexpr Matrix3x4(const Matrix3& matrix) :
         m00(matrix.m00),
         m01(matrix.m01),
         m02(matrix.m02),
@@ -76,9 +76,8 @@ public:
     }
 
     /// Copy-construct from a 4x4 matrix which is assumed to contain no projection.
-    Matrix3x4(const Matrix4& matrix)
-#ifndef MATH_SSE
-       :m00(matrix.m00),
+    constexpr Matrix3x4(const Matrix4& matrix) :
+        m00(matrix.m00),
         m01(matrix.m01),
         m02(matrix.m02),
         m03(matrix.m03),
@@ -90,19 +89,13 @@ public:
         m21(matrix.m21),
         m22(matrix.m22),
         m23(matrix.m23)
-#endif
     {
-#ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_loadu_ps(&matrix.m00));
-        _mm_storeu_ps(&m10, _mm_loadu_ps(&matrix.m10));
-        _mm_storeu_ps(&m20, _mm_loadu_ps(&matrix.m20));
-#endif
     }
 
     // Construct from values.
-    Matrix3x4(float v00, float v01, float v02, float v03,
-              float v10, float v11, float v12, float v13,
-              float v20, float v21, float v22, float v23) :
+    constexpr Matrix3x4(float v00, float v01, float v02, float v03,
+                        float v10, float v11, float v12, float v13,
+                        float v20, float v21, float v22, float v23) :
         m00(v00),
         m01(v01),
         m02(v02),
@@ -119,9 +112,8 @@ public:
     }
 
     /// Construct from a float array.
-    explicit Matrix3x4(const float* data)
-#ifndef MATH_SSE
-       :m00(data[0]),
+    explicit constexpr Matrix3x4(const float* data) :
+        m00(data[0]),
         m01(data[1]),
         m02(data[2]),
         m03(data[3]),
@@ -133,13 +125,7 @@ public:
         m21(data[9]),
         m22(data[10]),
         m23(data[11])
-#endif
     {
-#ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_loadu_ps(data));
-        _mm_storeu_ps(&m10, _mm_loadu_ps(data + 4));
-        _mm_storeu_ps(&m20, _mm_loadu_ps(data + 8));
-#endif
     }
 
     /// Construct from translation, rotation and uniform scale.
@@ -171,13 +157,17 @@ public:
     }
 
     /// Assign from another matrix.
-    Matrix3x4& operator =(const Matrix3x4& rhs)
+    constexpr Matrix3x4& operator =(const Matrix3x4& rhs)
     {
 #ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_loadu_ps(&rhs.m00));
-        _mm_storeu_ps(&m10, _mm_loadu_ps(&rhs.m10));
-        _mm_storeu_ps(&m20, _mm_loadu_ps(&rhs.m20));
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            _mm_storeu_ps(&m00, _mm_loadu_ps(&rhs.m00));
+            _mm_storeu_ps(&m10, _mm_loadu_ps(&rhs.m10));
+            _mm_storeu_ps(&m20, _mm_loadu_ps(&rhs.m20));
+            return *this;
+        }
+#endif
         m00 = rhs.m00;
         m01 = rhs.m01;
         m02 = rhs.m02;
@@ -190,12 +180,11 @@ public:
         m21 = rhs.m21;
         m22 = rhs.m22;
         m23 = rhs.m23;
-#endif
         return *this;
     }
 
     /// Assign from a 3x3 matrix and set the extra elements to identity.
-    Matrix3x4& operator =(const Matrix3& rhs)
+    constexpr Matrix3x4& operator =(const Matrix3& rhs)
     {
         m00 = rhs.m00;
         m01 = rhs.m01;
@@ -213,13 +202,17 @@ public:
     }
 
     /// Assign from a 4x4 matrix which is assumed to contain no projection.
-    Matrix3x4& operator =(const Matrix4& rhs)
+    constexpr Matrix3x4& operator =(const Matrix4& rhs)
     {
 #ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_loadu_ps(&rhs.m00));
-        _mm_storeu_ps(&m10, _mm_loadu_ps(&rhs.m10));
-        _mm_storeu_ps(&m20, _mm_loadu_ps(&rhs.m20));
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            _mm_storeu_ps(&m00, _mm_loadu_ps(&rhs.m00));
+            _mm_storeu_ps(&m10, _mm_loadu_ps(&rhs.m10));
+            _mm_storeu_ps(&m20, _mm_loadu_ps(&rhs.m20));
+            return *this;
+        }
+#endif
         m00 = rhs.m00;
         m01 = rhs.m01;
         m02 = rhs.m02;
@@ -232,111 +225,112 @@ public:
         m21 = rhs.m21;
         m22 = rhs.m22;
         m23 = rhs.m23;
-#endif
         return *this;
     }
 
     /// Test for equality with another matrix without epsilon.
-    bool operator ==(const Matrix3x4& rhs) const
+    constexpr bool operator ==(const Matrix3x4& rhs) const
     {
 #ifdef MATH_SSE
-        __m128 c0 = _mm_cmpeq_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00));
-        __m128 c1 = _mm_cmpeq_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10));
-        c0 = _mm_and_ps(c0, c1);
-        __m128 c2 = _mm_cmpeq_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20));
-        c0 = _mm_and_ps(c0, c2);
-        __m128 hi = _mm_movehl_ps(c0, c0);
-        c0 = _mm_and_ps(c0, hi);
-        hi = _mm_shuffle_ps(c0, c0, _MM_SHUFFLE(1, 1, 1, 1));
-        c0 = _mm_and_ps(c0, hi);
-        return !_mm_ucomige_ss(c0, c0);
-#else
-        const float* leftData = Data();
-        const float* rightData = rhs.Data();
-
-        for (unsigned i = 0; i < 12; ++i)
+        if (!Math::IsConstantEvaluated())
         {
-            if (leftData[i] != rightData[i])
-                return false;
+            __m128 c0 = _mm_cmpeq_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00));
+            __m128 c1 = _mm_cmpeq_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10));
+            c0 = _mm_and_ps(c0, c1);
+            __m128 c2 = _mm_cmpeq_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20));
+            c0 = _mm_and_ps(c0, c2);
+            __m128 hi = _mm_movehl_ps(c0, c0);
+            c0 = _mm_and_ps(c0, hi);
+            hi = _mm_shuffle_ps(c0, c0, _MM_SHUFFLE(1, 1, 1, 1));
+            c0 = _mm_and_ps(c0, hi);
+            return !_mm_ucomige_ss(c0, c0);
         }
-
-        return true;
 #endif
+        return m00 == rhs.m00 && m01 == rhs.m01 && m02 == rhs.m02 && m03 == rhs.m03 &&
+            m10 == rhs.m10 && m11 == rhs.m11 && m12 == rhs.m12 && m13 == rhs.m13 &&
+            m20 == rhs.m20 && m21 == rhs.m21 && m22 == rhs.m22 && m23 == rhs.m23;
     }
 
     /// Test for inequality with another matrix without epsilon.
-    bool operator !=(const Matrix3x4& rhs) const { return !(*this == rhs); }
+    constexpr bool operator !=(const Matrix3x4& rhs) const { return !(*this == rhs); }
 
     /// Multiply a Vector3 which is assumed to represent position.
-    Vector3 operator *(const Vector3& rhs) const
+    constexpr Vector3 operator *(const Vector3& rhs) const
     {
 #ifdef MATH_SSE
-        __m128 vec = _mm_set_ps(1.f, rhs.z, rhs.y, rhs.x);
-        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00), vec);
-        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10), vec);
-        __m128 t0 = _mm_unpacklo_ps(r0, r1);
-        __m128 t1 = _mm_unpackhi_ps(r0, r1);
-        t0 = _mm_add_ps(t0, t1);
-        __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20), vec);
-        __m128 r3 = _mm_setzero_ps();
-        __m128 t2 = _mm_unpacklo_ps(r2, r3);
-        __m128 t3 = _mm_unpackhi_ps(r2, r3);
-        t2 = _mm_add_ps(t2, t3);
-        vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
-
-        return Vector3(
-            _mm_cvtss_f32(vec),
-            _mm_cvtss_f32(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1))),
-            _mm_cvtss_f32(_mm_movehl_ps(vec, vec)));
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            __m128 vec = _mm_set_ps(1.f, rhs.z, rhs.y, rhs.x);
+            __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00), vec);
+            __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10), vec);
+            __m128 t0 = _mm_unpacklo_ps(r0, r1);
+            __m128 t1 = _mm_unpackhi_ps(r0, r1);
+            t0 = _mm_add_ps(t0, t1);
+            __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20), vec);
+            __m128 r3 = _mm_setzero_ps();
+            __m128 t2 = _mm_unpacklo_ps(r2, r3);
+            __m128 t3 = _mm_unpackhi_ps(r2, r3);
+            t2 = _mm_add_ps(t2, t3);
+            vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+
+            return Vector3(
+                _mm_cvtss_f32(vec),
+                _mm_cvtss_f32(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1))),
+                _mm_cvtss_f32(_mm_movehl_ps(vec, vec)));
+        }
+#endif
         return Vector3(
             (m00 * rhs.x + m01 * rhs.y + m02 * rhs.z + m03),
             (m10 * rhs.x + m11 * rhs.y + m12 * rhs.z + m13),
             (m20 * rhs.x + m21 * rhs.y + m22 * rhs.z + m23)
         );
-#endif
     }
 
     /// Multiply a Vector4.
-    Vector3 operator *(const Vector4& rhs) const
+    constexpr Vector3 operator *(const Vector4& rhs) const
     {
 #ifdef MATH_SSE
-        __m128 vec = _mm_loadu_ps(&rhs.x);
-        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00), vec);
-        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10), vec);
-        __m128 t0 = _mm_unpacklo_ps(r0, r1);
-        __m128 t1 = _mm_unpackhi_ps(r0, r1);
-        t0 = _mm_add_ps(t0, t1);
-        __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20), vec);
-        __m128 r3 = _mm_setzero_ps();
-        __m128 t2 = _mm_unpacklo_ps(r2, r3);
-        __m128 t3 = _mm_unpackhi_ps(r2, r3);
-        t2 = _mm_add_ps(t2, t3);
-        vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
-
-        return Vector3(
-            _mm_cvtss_f32(vec),
-            _mm_cvtss_f32(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1))),
-            _mm_cvtss_f32(_mm_movehl_ps(vec, vec)));
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            __m128 vec = _mm_loadu_ps(&rhs.x);
+            __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00), vec);
+            __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10), vec);
+            __m128 t0 = _mm_unpacklo_ps(r0, r1);
+            __m128 t1 = _mm_unpackhi_ps(r0, r1);
+            t0 = _mm_add_ps(t0, t1);
+            __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20), vec);
+            __m128 r3 = _mm_setzero_ps();
+            __m128 t2 = _mm_unpacklo_ps(r2, r3);
+            __m128 t3 = _mm_unpackhi_ps(r2, r3);
+            t2 = _mm_add_ps(t2, t3);
+            vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+
+            return Vector3(
+                _mm_cvtss_f32(vec),
+                _mm_cvtss_f32(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1))),
+                _mm_cvtss_f32(_mm_movehl_ps(vec, vec)));
+        }
+#endif
         return Vector3(
             (m00 * rhs.x + m01 * rhs.y + m02 * rhs.z + m03 * rhs.w),
             (m10 * rhs.x + m11 * rhs.y + m12 * rhs.z + m13 * rhs.w),
             (m20 * rhs.x + m21 * rhs.y + m22 * rhs.z + m23 * rhs.w)
         );
-#endif
     }
 
     /// Add a matrix.
-    Matrix3x4 operator +(const Matrix3x4& rhs) const
+    constexpr Matrix3x4 operator +(const Matrix3x4& rhs) const
     {
 #ifdef MATH_SSE
-        Matrix3x4 ret;
-        _mm_storeu_ps(&ret.m00, _mm_add_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00)));
-        _mm_storeu_ps(&ret.m10, _mm_add_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10)));
-        _mm_storeu_ps(&ret.m20, _mm_add_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20)));
-        return ret;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix3x4 ret;
+            _mm_storeu_ps(&ret.m00, _mm_add_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00)));
+            _mm_storeu_ps(&ret.m10, _mm_add_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10)));
+            _mm_storeu_ps(&ret.m20, _mm_add_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20)));
+            return ret;
+        }
+#endif
         return Matrix3x4(
             m00 + rhs.m00,
             m01 + rhs.m01,
@@ -351,19 +345,21 @@ public:
             m22 + rhs.m22,
             m23 + rhs.m23
         );
-#endif
     }
 
     /// Subtract a matrix.
-    Matrix3x4 operator -(const Matrix3x4& rhs) const
+    constexpr Matrix3x4 operator -(const Matrix3x4& rhs) const
     {
 #ifdef MATH_SSE
-        Matrix3x4 ret;
-        _mm_storeu_ps(&ret.m00, _mm_sub_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00)));
-        _mm_storeu_ps(&ret.m10, _mm_sub_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10)));
-        _mm_storeu_ps(&ret.m20, _mm_sub_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20)));
-        return ret;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix3x4 ret;
+            _mm_storeu_ps(&ret.m00, _mm_sub_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00)));
+            _mm_storeu_ps(&ret.m10, _mm_sub_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10)));
+            _mm_storeu_ps(&ret.m20, _mm_sub_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20)));
+            return ret;
+        }
+#endif
         return Matrix3x4(
             m00 - rhs.m00,
             m01 - rhs.m01,
@@ -378,20 +374,22 @@ public:
             m22 - rhs.m22,
             m23 - rhs.m23
         );
-#endif
     }
 
     /// Multiply with a scalar.
-    Matrix3x4 operator *(float rhs) const
+    constexpr Matrix3x4 operator *(float rhs) const
     {
 #ifdef MATH_SSE
-        Matrix3x4 ret;
-        const __m128 mul = _mm_set1_ps(rhs);
-        _mm_storeu_ps(&ret.m00, _mm_mul_ps(_mm_loadu_ps(&m00), mul));
-        _mm_storeu_ps(&ret.m10, _mm_mul_ps(_mm_loadu_ps(&m10), mul));
-        _mm_storeu_ps(&ret.m20, _mm_mul_ps(_mm_loadu_ps(&m20), mul));
-        return ret;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix3x4 ret;
+            const __m128 mul = _mm_set1_ps(rhs);
+            _mm_storeu_ps(&ret.m00, _mm_mul_ps(_mm_loadu_ps(&m00), mul));
+            _mm_storeu_ps(&ret.m10, _mm_mul_ps(_mm_loadu_ps(&m10), mul));
+            _mm_storeu_ps(&ret.m20, _mm_mul_ps(_mm_loadu_ps(&m20), mul));
+            return ret;
+        }
+#endif
         return Matrix3x4(
             m00 * rhs,
             m01 * rhs,
@@ -406,43 +404,45 @@ public:
             m22 * rhs,
             m23 * rhs
         );
-#endif
     }
 
     /// Multiply a matrix.
-    Matrix3x4 operator *(const Matrix3x4& rhs) const
+    constexpr Matrix3x4 operator *(const Matrix3x4& rhs) const
     {
 #ifdef MATH_SSE
-        Matrix3x4 out;
-
-        __m128 r0 = _mm_loadu_ps(&rhs.m00);
-        __m128 r1 = _mm_loadu_ps(&rhs.m10);
-        __m128 r2 = _mm_loadu_ps(&rhs.m20);
-        __m128 r3 = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
-
-        __m128 l = _mm_loadu_ps(&m00);
-        __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        __m128 t3 = _mm_mul_ps(l, r3);
-        _mm_storeu_ps(&out.m00, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m10);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(l, r3);
-        _mm_storeu_ps(&out.m10, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m20);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(l, r3);
-        _mm_storeu_ps(&out.m20, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        return out;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix3x4 out;
+
+            __m128 r0 = _mm_loadu_ps(&rhs.m00);
+            __m128 r1 = _mm_loadu_ps(&rhs.m10);
+            __m128 r2 = _mm_loadu_ps(&rhs.m20);
+            __m128 r3 = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
+
+            __m128 l = _mm_loadu_ps(&m00);
+            __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            __m128 t3 = _mm_mul_ps(l, r3);
+            _mm_storeu_ps(&out.m00, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            l = _mm_loadu_ps(&m10);
+            t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            t3 = _mm_mul_ps(l, r3);
+            _mm_storeu_ps(&out.m10, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            l = _mm_loadu_ps(&m20);
+            t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            t3 = _mm_mul_ps(l, r3);
+            _mm_storeu_ps(&out.m20, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            return out;
+        }
+#endif
         return Matrix3x4(
             m00 * rhs.m00 + m01 * rhs.m10 + m02 * rhs.m20,
             m00 * rhs.m01 + m01 * rhs.m11 + m02 * rhs.m21,
@@ -457,45 +457,47 @@ public:
             m20 * rhs.m02 + m21 * rhs.m12 + m22 * rhs.m22,
             m20 * rhs.m03 + m21 * rhs.m13 + m22 * rhs.m23 + m23
         );
-#endif
     }
 
     /// Multiply a 4x4 matrix.
-    Matrix4 operator *(const Matrix4& rhs) const
+    constexpr Matrix4 operator *(const Matrix4& rhs) const
     {
 #ifdef MATH_SSE
-        Matrix4 out;
-
-        __m128 r0 = _mm_loadu_ps(&rhs.m00);
-        __m128 r1 = _mm_loadu_ps(&rhs.m10);
-        __m128 r2 = _mm_loadu_ps(&rhs.m20);
-        __m128 r3 = _mm_loadu_ps(&rhs.m30);
-
-        __m128 l = _mm_loadu_ps(&m00);
-        __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        __m128 t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m00, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m10);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m10, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m20);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m20, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        _mm_storeu_ps(&out.m30, r3);
-
-        return out;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix4 out;
+
+            __m128 r0 = _mm_loadu_ps(&rhs.m00);
+            __m128 r1 = _mm_loadu_ps(&rhs.m10);
+            __m128 r2 = _mm_loadu_ps(&rhs.m20);
+            __m128 r3 = _mm_loadu_ps(&rhs.m30);
+
+            __m128 l = _mm_loadu_ps(&m00);
+            __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            __m128 t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
+            _mm_storeu_ps(&out.m00, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            l = _mm_loadu_ps(&m10);
+            t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
+            _mm_storeu_ps(&out.m10, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            l = _mm_loadu_ps(&m20);
+            t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
+            _mm_storeu_ps(&out.m20, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            _mm_storeu_ps(&out.m30, r3);
+
+            return out;
+        }
+#endif
         return Matrix4(
             m00 * rhs.m00 + m01 * rhs.m10 + m02 * rhs.m20 + m03 * rhs.m30,
             m00 * rhs.m01 + m01 * rhs.m11 + m02 * rhs.m21 + m03 * rhs.m31,
@@ -514,11 +516,10 @@ public:
             rhs.m32,
             rhs.m33
         );
-#endif
     }
 
     /// Set translation elements.
-    void SetTranslation(const Vector3& translation)
+    constexpr void SetTranslation(const Vector3& translation)
     {
         m03 = translation.x;
         m13 = translation.y;
@@ -526,7 +527,7 @@ public:
     }
 
     /// Set rotation elements from a 3x3 matrix.
-    void SetRotation(const Matrix3& rotation)
+    constexpr void SetRotation(const Matrix3& rotation)
     {
         m00 = rotation.m00;
         m01 = rotation.m01;
@@ -540,7 +541,7 @@ public:
     }
 
     /// Set scaling elements.
-    void SetScale(const Vector3& scale)
+    constexpr void SetScale(const Vector3& scale)
     {
         m00 = scale.x;
         m11 = scale.y;
@@ -548,7 +549,7 @@ public:
     }
 
     /// Set uniform scaling elements.
-    void SetScale(float scale)
+    constexpr void SetScale(float scale)
     {
         m00 = scale;
         m11 = scale;
@@ -556,7 +557,7 @@ public:
     }
 
     /// Return the combined rotation and scaling matrix.
-    Matrix3 ToMatrix3() const
+    constexpr Matrix3 ToMatrix3() const
     {
         return Matrix3(
             m00,
@@ -572,17 +573,19 @@ public:
     }
 
     /// Convert to a 4x4 matrix by filling in an identity last row.
-    Matrix4 ToMatrix4() const
+    constexpr Matrix4 ToMatrix4() const
     {
 #ifdef MATH_SSE
-        Matrix4 ret;
-        _mm_storeu_ps(&ret.m00, _mm_loadu_ps(&m00));
-        _mm_storeu_ps(&ret.m10, _mm_loadu_ps(&m10));
-        _mm_storeu_ps(&ret.m20, _mm_loadu_ps(&m20));
-        _mm_storeu_ps(&ret.m30, _mm_set_ps(1.f, 0.f, 0.f, 0.f));
-        return ret;
-#else
-
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix4 ret;
+            _mm_storeu_ps(&ret.m00, _mm_loadu_ps(&m00));
+            _mm_storeu_ps(&ret.m10, _mm_loadu_ps(&m10));
+            _mm_storeu_ps(&ret.m20, _mm_loadu_ps(&m20));
+            _mm_storeu_ps(&ret.m30, _mm_set_ps(1.f, 0.f, 0.f, 0.f));
+            return ret;
+        }
+#endif
         return Matrix4(
             m00,
             m01,
@@ -601,7 +604,6 @@ public:
             0.0f,
             1.0f
         );
-#endif
     }
 
     /// Return the rotation matrix with scaling removed.
@@ -617,7 +619,7 @@ public:
     }
 
     /// Return the translation part.
-    Vector3 Translation() const
+    constexpr Vector3 Translation() const
     {
         return Vector3(
             m03,
@@ -632,16 +634,35 @@ public:
     /// Return the scaling part.
     Vector3 Scale() const
     {
+#ifdef MATH_SSE
+        __m128 r0 = _mm_loadu_ps(&m00);
+        __m128 r1 = _mm_loadu_ps(&m10);
+        __m128 r2 = _mm_loadu_ps(&m20);
+        __m128 s = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, r0), _mm_mul_ps(r1, r1)), _mm_mul_ps(r2, r2)));
+        return Vector3(
+            _mm_cvtss_f32(s),
+            _mm_cvtss_f32(_mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1))),
+            _mm_cvtss_f32(_mm_movehl_ps(s, s)));
+#else
         return Vector3(
             sqrtf(m00 * m00 + m10 * m10 + m20 * m20),
             sqrtf(m01 * m01 + m11 * m11 + m21 * m21),
             sqrtf(m02 * m02 + m12 * m12 + m22 * m22)
         );
+#endif
     }
 
     /// Test for equality with another matrix with epsilon.
     bool Equals(const Matrix3x4& rhs) const
     {
+#ifdef MATH_SSE
+        const __m128 eps = _mm_set1_ps(Math::kLARGE_EPSILON);
+        int mask = 0xf;
+        mask &= Math::EqualsMask(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00), eps);
+        mask &= Math::EqualsMask(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10), eps);
+        mask &= Math::EqualsMask(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20), eps);
+        return mask == 0xf;
+#else
         const float* leftData = Data();
         const float* rightData = rhs.Data();
 
@@ -652,12 +673,45 @@ public:
         }
 
         return true;
+#endif
     }
 
-    /// Return decomposition to translation, rotation and scale.
+    /// Return decomposition to translation, rotation and scale. A mirroring matrix yields a proper rotation and a
+    /// negative scale on one axis. With shear the rotation is the closest one (the orthogonal factor of the polar
+    /// decomposition) and the scale the stretch along its axes, so recomposing drops the shear.
     void Decompose(Vector3& translation, Quaternion& rotation, Vector3& scale) const;
     /// Return inverse.
     Matrix3x4 Inverse() const;
+    /// Return inverse of a rigid transform: the transposed rotation and the rotated, negated translation.
+    Matrix3x4 InverseRigid() const;
+    /// Return inverse of a transform without shear: the columns are orthogonal, so each row of the inverse is a
+    /// column divided by its squared length.
+    Matrix3x4 InverseScaled() const;
+    /// Return inverse with the cheapest method that is exact for the class of the transform.
+    Matrix3x4 Inverse(TransformClass cls) const;
+    /// Return the inverse transpose of the rotation part, which transforms normals. It is built from cofactors
+    /// without computing the inverse first.
+    Matrix3 InverseTransposed(TransformClass cls = TransformClass::Affine) const;
+
+    /// Invert count matrices of the given class. dest may alias src.
+    static void BulkInverse(Matrix3x4* dest, const Matrix3x4* src, unsigned count,
+        TransformClass cls = TransformClass::Affine);
+    /// Compute the normal matrices of count matrices of the given class, as InverseTransposed does.
+    static void BulkInverseTransposed(Matrix3* dest, const Matrix3x4* src, unsigned count,
+        TransformClass cls = TransformClass::Affine);
+    /// Decompose count matrices as Decompose does, with the same results.
+    static void BulkDecompose(const Matrix3x4* src, Vector3* translations, Quaternion* rotations, Vector3* scales,
+        unsigned count);
+
+    /// Transform count positions stored as separate x, y and z arrays. Outputs may alias the inputs.
+    void BulkTransformPoints(float* outX, float* outY, float* outZ,
+        const float* x, const float* y, const float* z, unsigned count) const;
+    /// Transform count directions stored as separate x, y and z arrays, ignoring translation. Outputs may alias the inputs.
+    void BulkTransformDirections(float* outX, float* outY, float* outZ,
+        const float* x, const float* y, const float* z, unsigned count) const;
+    /// Transform count homogeneous vectors stored as separate x, y, z and w arrays. Outputs may alias the inputs.
+    void BulkTransform(float* outX, float* outY, float* outZ,
+        const float* x, const float* y, const float* z, const float* w, unsigned count) const;
 
     /// Return float data.
     const float* Data() const { return &m00; }
@@ -710,7 +764,14 @@ private:
 #endif
 };
 
-/// Multiply a 3x4 matrix with a scalar.
-inline Matrix3x4 operator *(float lhs, const Matrix3x4& rhs) { return rhs * lhs; }
+inline constexpr Matrix3x4 Matrix3x4::ZERO(
+    0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f);
 
+inline constexpr Matrix3x4 Matrix3x4::IDENTITY;
+
+/// Multiply a 3x4 matrix with a scalar.
+constexpr Matrix3x4 operator *(float lhs, const Matrix3x4& rhs) { return rhs * lhs; }
 
+MATH_CONTRACT_OFF_END
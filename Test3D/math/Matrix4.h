@@ -6,15 +6,27 @@
 
 #ifdef MATH_SSE
 #include <emmintrin.h>
+
+namespace Math
+{
+// Return a 4-bit mask of the lanes where lhs and rhs are equal within epsilon, with the same semantics as Math::Equals.
+inline int EqualsMask(__m128 lhs, __m128 rhs, __m128 epsilon)
+{
+    return _mm_movemask_ps(_mm_and_ps(
+        _mm_cmpge_ps(_mm_add_ps(lhs, epsilon), rhs),
+        _mm_cmple_ps(_mm_sub_ps(lhs, epsilon), rhs)));
+}
+}
 #endif
 
+MATH_CONTRACT_OFF_BEGIN
+
 class Matrix4
 {
 public:
     
-    Matrix4()
-#ifndef MATH_SSE
-       :m00(1.0f),
+    constexpr Matrix4() :
+        m00(1.0f),
         m01(0.0f),
         m02(0.0f),
         m03(0.0f),
@@ -30,20 +42,12 @@ public:
         m31(0.0f),
         m32(0.0f),
         m33(1.0f)
-#endif
     {
-#ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_set_ps(0.f, 0.f, 0.f, 1.f));
-        _mm_storeu_ps(&m10, _mm_set_ps(0.f, 0.f, 1.f, 0.f));
-        _mm_storeu_ps(&m20, _mm_set_ps(0.f, 1.f, 0.f, 0.f));
-        _mm_storeu_ps(&m30, _mm_set_ps(1.f, 0.f, 0.f, 0.f));
-#endif
     }
 
     
-    Matrix4(const Matrix4& matrix)
-#ifndef MATH_SSE
-       :m00(matrix.m00),
+    constexpr Matrix4(const Matrix4& matrix) :
+        m00(matrix.m00),
         m01(matrix.m01),
         m02(matrix.m02),
         m03(matrix.m03),
@@ -59,18 +63,11 @@ public:
         m31(matrix.m31),
         m32(matrix.m32),
         m33(matrix.m33)
-#endif
     {
-#ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_loadu_ps(&matrix.m00));
-        _mm_storeu_ps(&m10, _mm_loadu_ps(&matrix.m10));
-        _mm_storeu_ps(&m20, _mm_loadu_ps(&matrix.m20));
-        _mm_storeu_ps(&m30, _mm_loadu_ps(&matrix.m30));
-#endif
     }
 
     
-    Matrix4(const Matrix3& matrix) :
+    constexpr Matrix4(const Matrix3& matrix) :
         m00(matrix.m00),
         m01(matrix.m01),
         m02(matrix.m02),
@@ -91,10 +88,10 @@ public:
     }
 
     // Construct from values.
-    Matrix4(float v00, float v01, float v02, float v03,
-            float v10, float v11, float v12, float v13,
-            float v20, float v21, float v22, float v23,
-            float v30, float v31, float v32, float v33) :
+    constexpr Matrix4(float v00, float v01, float v02, float v03,
+                      float v10, float v11, float v12, float v13,
+                      float v20, float v21, float v22, float v23,
+                      float v30, float v31, float v32, float v33) :
         m00(v00),
         m01(v01),
         m02(v02),
@@ -115,9 +112,8 @@ public:
     }
 
     
-    explicit Matrix4(const float* data)
-#ifndef MATH_SSE
-       :m00(data[0]),
+    explicit constexpr Matrix4(const float* data) :
+        m00(data[0]),
         m01(data[1]),
         m02(data[2]),
         m03(data[3]),
@@ -133,25 +129,22 @@ public:
         m31(data[13]),
         m32(data[14]),
         m33(data[15])
-#endif
     {
-#ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_loadu_ps(data));
-        _mm_storeu_ps(&m10, _mm_loadu_ps(data + 4));
-        _mm_storeu_ps(&m20, _mm_loadu_ps(data + 8));
-        _mm_storeu_ps(&m30, _mm_loadu_ps(data + 12));
-#endif
     }
 
     
-    Matrix4& operator =(const Matrix4& rhs)
+    constexpr Matrix4& operator =(const Matrix4& rhs)
     {
 #ifdef MATH_SSE
-        _mm_storeu_ps(&m00, _mm_loadu_ps(&rhs.m00));
-        _mm_storeu_ps(&m10, _mm_loadu_ps(&rhs.m10));
-        _mm_storeu_ps(&m20, _mm_loadu_ps(&rhs.m20));
-        _mm_storeu_ps(&m30, _mm_loadu_ps(&rhs.m30));
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            _mm_storeu_ps(&m00, _mm_loadu_ps(&rhs.m00));
+            _mm_storeu_ps(&m10, _mm_loadu_ps(&rhs.m10));
+            _mm_storeu_ps(&m20, _mm_loadu_ps(&rhs.m20));
+            _mm_storeu_ps(&m30, _mm_loadu_ps(&rhs.m30));
+            return *this;
+        }
+#endif
         m00 = rhs.m00;
         m01 = rhs.m01;
         m02 = rhs.m02;
@@ -168,12 +161,11 @@ public:
         m31 = rhs.m31;
         m32 = rhs.m32;
         m33 = rhs.m33;
-#endif
         return *this;
     }
 
     
-    Matrix4& operator =(const Matrix3& rhs)
+    constexpr Matrix4& operator =(const Matrix3& rhs)
     {
         m00 = rhs.m00;
         m01 = rhs.m01;
@@ -195,60 +187,59 @@ public:
     }
 
     
-    bool operator ==(const Matrix4& rhs) const
+    constexpr bool operator ==(const Matrix4& rhs) const
     {
 #ifdef MATH_SSE
-        __m128 c0 = _mm_cmpeq_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00));
-        __m128 c1 = _mm_cmpeq_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10));
-        c0 = _mm_and_ps(c0, c1);
-        __m128 c2 = _mm_cmpeq_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20));
-        __m128 c3 = _mm_cmpeq_ps(_mm_loadu_ps(&m30), _mm_loadu_ps(&rhs.m30));
-        c2 = _mm_and_ps(c2, c3);
-        c0 = _mm_and_ps(c0, c2);
-        __m128 hi = _mm_movehl_ps(c0, c0);
-        c0 = _mm_and_ps(c0, hi);
-        hi = _mm_shuffle_ps(c0, c0, _MM_SHUFFLE(1, 1, 1, 1));
-        c0 = _mm_and_ps(c0, hi);
-        return !_mm_ucomige_ss(c0, c0);
-#else
-        const float* leftData = Data();
-        const float* rightData = rhs.Data();
-
-        for (unsigned i = 0; i < 16; ++i)
+        if (!Math::IsConstantEvaluated())
         {
-            if (leftData[i] != rightData[i])
-                return false;
+            __m128 c0 = _mm_cmpeq_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00));
+            __m128 c1 = _mm_cmpeq_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10));
+            c0 = _mm_and_ps(c0, c1);
+            __m128 c2 = _mm_cmpeq_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20));
+            __m128 c3 = _mm_cmpeq_ps(_mm_loadu_ps(&m30), _mm_loadu_ps(&rhs.m30));
+            c2 = _mm_and_ps(c2, c3);
+            c0 = _mm_and_ps(c0, c2);
+            __m128 hi = _mm_movehl_ps(c0, c0);
+            c0 = _mm_and_ps(c0, hi);
+            hi = _mm_shuffle_ps(c0, c0, _MM_SHUFFLE(1, 1, 1, 1));
+            c0 = _mm_and_ps(c0, hi);
+            return !_mm_ucomige_ss(c0, c0);
         }
-
-        return true;
 #endif
+        return m00 == rhs.m00 && m01 == rhs.m01 && m02 == rhs.m02 && m03 == rhs.m03 &&
+            m10 == rhs.m10 && m11 == rhs.m11 && m12 == rhs.m12 && m13 == rhs.m13 &&
+            m20 == rhs.m20 && m21 == rhs.m21 && m22 == rhs.m22 && m23 == rhs.m23 &&
+            m30 == rhs.m30 && m31 == rhs.m31 && m32 == rhs.m32 && m33 == rhs.m33;
     }
 
     
-    bool operator !=(const Matrix4& rhs) const { return !(*this == rhs); }
+    constexpr bool operator !=(const Matrix4& rhs) const { return !(*this == rhs); }
 
     
-    Vector3 operator *(const Vector3& rhs) const
+    constexpr Vector3 operator *(const Vector3& rhs) const
     {
 #ifdef MATH_SSE
-        __m128 vec = _mm_set_ps(1.f, rhs.z, rhs.y, rhs.x);
-        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00), vec);
-        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10), vec);
-        __m128 t0 = _mm_unpacklo_ps(r0, r1);
-        __m128 t1 = _mm_unpackhi_ps(r0, r1);
-        t0 = _mm_add_ps(t0, t1);
-        __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20), vec);
-        __m128 r3 = _mm_mul_ps(_mm_loadu_ps(&m30), vec);
-        __m128 t2 = _mm_unpacklo_ps(r2, r3);
-        __m128 t3 = _mm_unpackhi_ps(r2, r3);
-        t2 = _mm_add_ps(t2, t3);
-        vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
-        vec = _mm_div_ps(vec, _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(3, 3, 3, 3)));
-        return Vector3(
-            _mm_cvtss_f32(vec),
-            _mm_cvtss_f32(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1))),
-            _mm_cvtss_f32(_mm_movehl_ps(vec, vec)));
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            __m128 vec = _mm_set_ps(1.f, rhs.z, rhs.y, rhs.x);
+            __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00), vec);
+            __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10), vec);
+            __m128 t0 = _mm_unpacklo_ps(r0, r1);
+            __m128 t1 = _mm_unpackhi_ps(r0, r1);
+            t0 = _mm_add_ps(t0, t1);
+            __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20), vec);
+            __m128 r3 = _mm_mul_ps(_mm_loadu_ps(&m30), vec);
+            __m128 t2 = _mm_unpacklo_ps(r2, r3);
+            __m128 t3 = _mm_unpackhi_ps(r2, r3);
+            t2 = _mm_add_ps(t2, t3);
+            vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+            vec = _mm_div_ps(vec, _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(3, 3, 3, 3)));
+            return Vector3(
+                _mm_cvtss_f32(vec),
+                _mm_cvtss_f32(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1))),
+                _mm_cvtss_f32(_mm_movehl_ps(vec, vec)));
+        }
+#endif
         float invW = 1.0f / (m30 * rhs.x + m31 * rhs.y + m32 * rhs.z + m33);
 
         return Vector3(
@@ -256,50 +247,54 @@ public:
             (m10 * rhs.x + m11 * rhs.y + m12 * rhs.z + m13) * invW,
             (m20 * rhs.x + m21 * rhs.y + m22 * rhs.z + m23) * invW
         );
-#endif
     }
 
     
-    Vector4 operator *(const Vector4& rhs) const
+    constexpr Vector4 operator *(const Vector4& rhs) const
     {
 #ifdef MATH_SSE
-        __m128 vec = _mm_loadu_ps(&rhs.x);
-        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00), vec);
-        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10), vec);
-        __m128 t0 = _mm_unpacklo_ps(r0, r1);
-        __m128 t1 = _mm_unpackhi_ps(r0, r1);
-        t0 = _mm_add_ps(t0, t1);
-        __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20), vec);
-        __m128 r3 = _mm_mul_ps(_mm_loadu_ps(&m30), vec);
-        __m128 t2 = _mm_unpacklo_ps(r2, r3);
-        __m128 t3 = _mm_unpackhi_ps(r2, r3);
-        t2 = _mm_add_ps(t2, t3);
-        vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
-
-        Vector4 ret;
-        _mm_storeu_ps(&ret.x, vec);
-        return ret;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            __m128 vec = _mm_loadu_ps(&rhs.x);
+            __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00), vec);
+            __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10), vec);
+            __m128 t0 = _mm_unpacklo_ps(r0, r1);
+            __m128 t1 = _mm_unpackhi_ps(r0, r1);
+            t0 = _mm_add_ps(t0, t1);
+            __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20), vec);
+            __m128 r3 = _mm_mul_ps(_mm_loadu_ps(&m30), vec);
+            __m128 t2 = _mm_unpacklo_ps(r2, r3);
+            __m128 t3 = _mm_unpackhi_ps(r2, r3);
+            t2 = _mm_add_ps(t2, t3);
+            vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+
+            Vector4 ret;
+            _mm_storeu_ps(&ret.x, vec);
+            return ret;
+        }
+#endif
         return Vector4(
             m00 * rhs.x + m01 * rhs.y + m02 * rhs.z + m03 * rhs.w,
             m10 * rhs.x + m11 * rhs.y + m12 * rhs.z + m13 * rhs.w,
             m20 * rhs.x + m21 * rhs.y + m22 * rhs.z + m23 * rhs.w,
             m30 * rhs.x + m31 * rhs.y + m32 * rhs.z + m33 * rhs.w
         );
-#endif
     }
 
     
-    Matrix4 operator +(const Matrix4& rhs) const
+    constexpr Matrix4 operator +(const Matrix4& rhs) const
     {
 #ifdef MATH_SSE
-        Matrix4 ret;
-        _mm_storeu_ps(&ret.m00, _mm_add_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00)));
-        _mm_storeu_ps(&ret.m10, _mm_add_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10)));
-        _mm_storeu_ps(&ret.m20, _mm_add_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20)));
-        _mm_storeu_ps(&ret.m30, _mm_add_ps(_mm_loadu_ps(&m30), _mm_loadu_ps(&rhs.m30)));
-        return ret;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix4 ret;
+            _mm_storeu_ps(&ret.m00, _mm_add_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00)));
+            _mm_storeu_ps(&ret.m10, _mm_add_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10)));
+            _mm_storeu_ps(&ret.m20, _mm_add_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20)));
+            _mm_storeu_ps(&ret.m30, _mm_add_ps(_mm_loadu_ps(&m30), _mm_loadu_ps(&rhs.m30)));
+            return ret;
+        }
+#endif
         return Matrix4(
             m00 + rhs.m00,
             m01 + rhs.m01,
@@ -318,20 +313,22 @@ public:
             m32 + rhs.m32,
             m33 + rhs.m33
         );
-#endif
     }
 
     
-    Matrix4 operator -(const Matrix4& rhs) const
+    constexpr Matrix4 operator -(const Matrix4& rhs) const
     {
 #ifdef MATH_SSE
-        Matrix4 ret;
-        _mm_storeu_ps(&ret.m00, _mm_sub_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00)));
-        _mm_storeu_ps(&ret.m10, _mm_sub_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10)));
-        _mm_storeu_ps(&ret.m20, _mm_sub_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20)));
-        _mm_storeu_ps(&ret.m30, _mm_sub_ps(_mm_loadu_ps(&m30), _mm_loadu_ps(&rhs.m30)));
-        return ret;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix4 ret;
+            _mm_storeu_ps(&ret.m00, _mm_sub_ps(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00)));
+            _mm_storeu_ps(&ret.m10, _mm_sub_ps(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10)));
+            _mm_storeu_ps(&ret.m20, _mm_sub_ps(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20)));
+            _mm_storeu_ps(&ret.m30, _mm_sub_ps(_mm_loadu_ps(&m30), _mm_loadu_ps(&rhs.m30)));
+            return ret;
+        }
+#endif
         return Matrix4(
             m00 - rhs.m00,
             m01 - rhs.m01,
@@ -350,21 +347,23 @@ public:
             m32 - rhs.m32,
             m33 - rhs.m33
         );
-#endif
     }
 
     
-    Matrix4 operator *(float rhs) const
+    constexpr Matrix4 operator *(float rhs) const
     {
 #ifdef MATH_SSE
-        Matrix4 ret;
-        const __m128 mul = _mm_set1_ps(rhs);
-        _mm_storeu_ps(&ret.m00, _mm_mul_ps(_mm_loadu_ps(&m00), mul));
-        _mm_storeu_ps(&ret.m10, _mm_mul_ps(_mm_loadu_ps(&m10), mul));
-        _mm_storeu_ps(&ret.m20, _mm_mul_ps(_mm_loadu_ps(&m20), mul));
-        _mm_storeu_ps(&ret.m30, _mm_mul_ps(_mm_loadu_ps(&m30), mul));
-        return ret;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix4 ret;
+            const __m128 mul = _mm_set1_ps(rhs);
+            _mm_storeu_ps(&ret.m00, _mm_mul_ps(_mm_loadu_ps(&m00), mul));
+            _mm_storeu_ps(&ret.m10, _mm_mul_ps(_mm_loadu_ps(&m10), mul));
+            _mm_storeu_ps(&ret.m20, _mm_mul_ps(_mm_loadu_ps(&m20), mul));
+            _mm_storeu_ps(&ret.m30, _mm_mul_ps(_mm_loadu_ps(&m30), mul));
+            return ret;
+        }
+#endif
         return Matrix4(
             m00 * rhs,
             m01 * rhs,
@@ -383,50 +382,52 @@ public:
             m32 * rhs,
             m33 * rhs
         );
-#endif
     }
 
     
-    Matrix4 operator *(const Matrix4& rhs) const
+    constexpr Matrix4 operator *(const Matrix4& rhs) const
     {
 #ifdef MATH_SSE
-        Matrix4 out;
-
-        __m128 r0 = _mm_loadu_ps(&rhs.m00);
-        __m128 r1 = _mm_loadu_ps(&rhs.m10);
-        __m128 r2 = _mm_loadu_ps(&rhs.m20);
-        __m128 r3 = _mm_loadu_ps(&rhs.m30);
-
-        __m128 l = _mm_loadu_ps(&m00);
-        __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        __m128 t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m00, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m10);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m10, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m20);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m20, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        l = _mm_loadu_ps(&m30);
-        t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
-        t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
-        t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
-        t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
-        _mm_storeu_ps(&out.m30, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
-
-        return out;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            Matrix4 out;
+
+            __m128 r0 = _mm_loadu_ps(&rhs.m00);
+            __m128 r1 = _mm_loadu_ps(&rhs.m10);
+            __m128 r2 = _mm_loadu_ps(&rhs.m20);
+            __m128 r3 = _mm_loadu_ps(&rhs.m30);
+
+            __m128 l = _mm_loadu_ps(&m00);
+            __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            __m128 t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
+            _mm_storeu_ps(&out.m00, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            l = _mm_loadu_ps(&m10);
+            t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
+            _mm_storeu_ps(&out.m10, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            l = _mm_loadu_ps(&m20);
+            t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
+            _mm_storeu_ps(&out.m20, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            l = _mm_loadu_ps(&m30);
+            t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+            t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+            t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
+            _mm_storeu_ps(&out.m30, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+
+            return out;
+        }
+#endif
         return Matrix4(
             m00 * rhs.m00 + m01 * rhs.m10 + m02 * rhs.m20 + m03 * rhs.m30,
             m00 * rhs.m01 + m01 * rhs.m11 + m02 * rhs.m21 + m03 * rhs.m31,
@@ -445,10 +446,9 @@ public:
             m30 * rhs.m02 + m31 * rhs.m12 + m32 * rhs.m22 + m33 * rhs.m32,
             m30 * rhs.m03 + m31 * rhs.m13 + m32 * rhs.m23 + m33 * rhs.m33
         );
-#endif
     }
 
-    void SetTranslation(const Vector3& translation)
+    constexpr void SetTranslation(const Vector3& translation)
     {
         m03 = translation.x;
         m13 = translation.y;
@@ -456,7 +456,7 @@ public:
     }
 
     
-    void SetRotation(const Matrix3& rotation)
+    constexpr void SetRotation(const Matrix3& rotation)
     {
         m00 = rotation.m00;
         m01 = rotation.m01;
@@ -470,7 +470,7 @@ public:
     }
 
     // Set scaling elements.
-    void SetScale(const Vector3& scale)
+    constexpr void SetScale(const Vector3& scale)
     {
         m00 = scale.x;
         m11 = scale.y;
@@ -478,7 +478,7 @@ public:
     }
 
     // Set uniform scaling elements.
-    void SetScale(float scale)
+    constexpr void SetScale(float scale)
     {
         m00 = scale;
         m11 = scale;
@@ -486,7 +486,7 @@ public:
     }
 
     
-    Matrix3 ToMatrix3() const
+    constexpr Matrix3 ToMatrix3() const
     {
         return Matrix3(
             m00,
@@ -514,7 +514,7 @@ public:
     }
 
     
-    Vector3 Translation() const
+    constexpr Vector3 Translation() const
     {
         return Vector3(
             m03,
@@ -529,29 +529,43 @@ public:
     
     Vector3 Scale() const
     {
+#ifdef MATH_SSE
+        __m128 r0 = _mm_loadu_ps(&m00);
+        __m128 r1 = _mm_loadu_ps(&m10);
+        __m128 r2 = _mm_loadu_ps(&m20);
+        __m128 s = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, r0), _mm_mul_ps(r1, r1)), _mm_mul_ps(r2, r2)));
+        return Vector3(
+            _mm_cvtss_f32(s),
+            _mm_cvtss_f32(_mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1))),
+            _mm_cvtss_f32(_mm_movehl_ps(s, s)));
+#else
         return Vector3(
             sqrtf(m00 * m00 + m10 * m10 + m20 * m20),
             sqrtf(m01 * m01 + m11 * m11 + m21 * m21),
             sqrtf(m02 * m02 + m12 * m12 + m22 * m22)
         );
+#endif
     }
 
     
-    Matrix4 Transpose() const
+    constexpr Matrix4 Transpose() const
     {
 #ifdef MATH_SSE
-        __m128 m0 = _mm_loadu_ps(&m00);
-        __m128 m1 = _mm_loadu_ps(&m10);
-        __m128 m2 = _mm_loadu_ps(&m20);
-        __m128 m3 = _mm_loadu_ps(&m30);
-        _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
-        Matrix4 out;
-        _mm_storeu_ps(&out.m00, m0);
-        _mm_storeu_ps(&out.m10, m1);
-        _mm_storeu_ps(&out.m20, m2);
-        _mm_storeu_ps(&out.m30, m3);
-        return out;
-#else
+        if (!Math::IsConstantEvaluated())
+        {
+            __m128 m0 = _mm_loadu_ps(&m00);
+            __m128 m1 = _mm_loadu_ps(&m10);
+            __m128 m2 = _mm_loadu_ps(&m20);
+            __m128 m3 = _mm_loadu_ps(&m30);
+            _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+            Matrix4 out;
+            _mm_storeu_ps(&out.m00, m0);
+            _mm_storeu_ps(&out.m10, m1);
+            _mm_storeu_ps(&out.m20, m2);
+            _mm_storeu_ps(&out.m30, m3);
+            return out;
+        }
+#endif
         return Matrix4(
             m00,
             m10,
@@ -570,12 +584,20 @@ public:
             m23,
             m33
         );
-#endif
     }
 
     
     bool Equals(const Matrix4& rhs) const
     {
+#ifdef MATH_SSE
+        const __m128 eps = _mm_set1_ps(Math::kLARGE_EPSILON);
+        int mask = 0xf;
+        mask &= Math::EqualsMask(_mm_loadu_ps(&m00), _mm_loadu_ps(&rhs.m00), eps);
+        mask &= Math::EqualsMask(_mm_loadu_ps(&m10), _mm_loadu_ps(&rhs.m10), eps);
+        mask &= Math::EqualsMask(_mm_loadu_ps(&m20), _mm_loadu_ps(&rhs.m20), eps);
+        mask &= Math::EqualsMask(_mm_loadu_ps(&m30), _mm_loadu_ps(&rhs.m30), eps);
+        return mask == 0xf;
+#else
         const float* leftData = Data();
         const float* rightData = rhs.Data();
 
@@ -586,12 +608,25 @@ public:
         }
 
         return true;
+#endif
     }
 
-    
+    // Return decomposition of the affine part to translation, rotation and scale, as Matrix3x4::Decompose does.
     void Decompose(Vector3& translation, Quaternion& rotation, Vector3& scale) const;
     
     Matrix4 Inverse() const;
+    // Return inverse of a matrix whose last row is (0, 0, 0, 1), through the 3x4 inverse.
+    Matrix4 InverseAffine() const;
+
+    // Transform count positions stored as separate x, y and z arrays, dividing by the resulting w. Outputs may alias the inputs.
+    void BulkTransformPoints(float* outX, float* outY, float* outZ,
+        const float* x, const float* y, const float* z, unsigned count) const;
+    // Transform count directions stored as separate x, y and z arrays using the upper 3x3 part. Outputs may alias the inputs.
+    void BulkTransformDirections(float* outX, float* outY, float* outZ,
+        const float* x, const float* y, const float* z, unsigned count) const;
+    // Transform count homogeneous vectors stored as separate x, y, z and w arrays. Outputs may alias the inputs.
+    void BulkTransform(float* outX, float* outY, float* outZ, float* outW,
+        const float* x, const float* y, const float* z, const float* w, unsigned count) const;
 
     
     const float* Data() const { return &m00; }
@@ -658,5 +693,15 @@ public:
     static const Matrix4 IDENTITY;
 };
 
+inline constexpr Matrix4 Matrix4::ZERO(
+    0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f);
+
+inline constexpr Matrix4 Matrix4::IDENTITY;
+
+
+constexpr Matrix4 operator *(float lhs, const Matrix4& rhs) { return rhs * lhs; }
 
-inline Matrix4 operator *(float lhs, const Matrix4& rhs) { return rhs * lhs; }
+MATH_CONTRACT_OFF_END
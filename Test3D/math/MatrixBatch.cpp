@@ -0,0 +1,727 @@
+#include "Matrix3x4.h"
+#include "SimdLane.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+// Bulk transforms over structure-of-arrays streams, and bulk inverses and decompositions of arrays of matrices.
+//
+// Every kernel is written once against the lane types in SimdLane.h. Each output is evaluated as
+// ((m0 * x + m1 * y) + m2 * z) + m3 in the same order for every width, so the SIMD loops, the scalar tail
+// and the non-SSE build agree bit for bit as long as the compiler is not allowed to contract the scalar
+// expressions into FMA instructions.
+//
+// The inverse and decomposition kernels treat every lane as one matrix: the rows of Width matrices are gathered
+// and transposed into one register per element.
+
+namespace
+{
+
+/// Broadcast copy of one matrix row.
+template <class L>
+struct Row
+{
+	Row(const float* row) : c0(L::Set(row[0])), c1(L::Set(row[1])), c2(L::Set(row[2])), c3(L::Set(row[3])) {}
+
+	typename L::Type Dot3(typename L::Type x, typename L::Type y, typename L::Type z) const
+	{
+		return L::Add(L::Add(L::Mul(c0, x), L::Mul(c1, y)), L::Mul(c2, z));
+	}
+	typename L::Type Dot3Translate(typename L::Type x, typename L::Type y, typename L::Type z) const
+	{
+		return L::Add(Dot3(x, y, z), c3);
+	}
+	typename L::Type Dot4(typename L::Type x, typename L::Type y, typename L::Type z, typename L::Type w) const
+	{
+		return L::Add(Dot3(x, y, z), L::Mul(c3, w));
+	}
+
+	typename L::Type c0, c1, c2, c3;
+};
+
+// m points at row-major matrix data with four floats per row. Each kernel starts at element i and returns the
+// first element it did not process, so the wider kernels hand their remainder down to the narrower ones.
+
+template <class L, bool Project>
+unsigned TransformPoints(const float* m, float* outX, float* outY, float* outZ,
+	const float* x, const float* y, const float* z, unsigned i, unsigned count)
+{
+	const Row<L> r0(m), r1(m + 4), r2(m + 8);
+	const Row<L> r3(Project ? m + 12 : m);
+	const typename L::Type one = L::Set(1.0f);
+
+	for (; i + L::Width <= count; i += L::Width) {
+		typename L::Type vx = L::Load(x + i);
+		typename L::Type vy = L::Load(y + i);
+		typename L::Type vz = L::Load(z + i);
+
+		typename L::Type rx = r0.Dot3Translate(vx, vy, vz);
+		typename L::Type ry = r1.Dot3Translate(vx, vy, vz);
+		typename L::Type rz = r2.Dot3Translate(vx, vy, vz);
+		if (Project) {
+			typename L::Type invW = L::Div(one, r3.Dot3Translate(vx, vy, vz));
+			rx = L::Mul(rx, invW);
+			ry = L::Mul(ry, invW);
+			rz = L::Mul(rz, invW);
+		}
+
+		L::Store(outX + i, rx);
+		L::Store(outY + i, ry);
+		L::Store(outZ + i, rz);
+	}
+	return i;
+}
+
+template <class L>
+unsigned TransformDirections(const float* m, float* outX, float* outY, float* outZ,
+	const float* x, const float* y, const float* z, unsigned i, unsigned count)
+{
+	const Row<L> r0(m), r1(m + 4), r2(m + 8);
+
+	for (; i + L::Width <= count; i += L::Width) {
+		typename L::Type vx = L::Load(x + i);
+		typename L::Type vy = L::Load(y + i);
+		typename L::Type vz = L::Load(z + i);
+
+		typename L::Type rx = r0.Dot3(vx, vy, vz);
+		typename L::Type ry = r1.Dot3(vx, vy, vz);
+		typename L::Type rz = r2.Dot3(vx, vy, vz);
+
+		L::Store(outX + i, rx);
+		L::Store(outY + i, ry);
+		L::Store(outZ + i, rz);
+	}
+	return i;
+}
+
+/// Transform homogeneous vectors. outW may be null, in which case only the first three rows are evaluated.
+template <class L>
+unsigned TransformHomogeneous(const float* m, float* outX, float* outY, float* outZ, float* outW,
+	const float* x, const float* y, const float* z, const float* w, unsigned i, unsigned count)
+{
+	const Row<L> r0(m), r1(m + 4), r2(m + 8);
+	const Row<L> r3(outW ? m + 12 : m);
+
+	for (; i + L::Width <= count; i += L::Width) {
+		typename L::Type vx = L::Load(x + i);
+		typename L::Type vy = L::Load(y + i);
+		typename L::Type vz = L::Load(z + i);
+		typename L::Type vw = L::Load(w + i);
+
+		typename L::Type rx = r0.Dot4(vx, vy, vz, vw);
+		typename L::Type ry = r1.Dot4(vx, vy, vz, vw);
+		typename L::Type rz = r2.Dot4(vx, vy, vz, vw);
+		if (outW)
+			L::Store(outW + i, r3.Dot4(vx, vy, vz, vw));
+
+		L::Store(outX + i, rx);
+		L::Store(outY + i, ry);
+		L::Store(outZ + i, rz);
+	}
+	return i;
+}
+
+/// Load Width matrices into m, one register per element in row-major order.
+template <class L>
+void GatherMatrices(const Matrix3x4* src, typename L::Type* m)
+{
+	const float* rows[L::Width];
+	for (unsigned j = 0; j < L::Width; ++j)
+		rows[j] = src[j].Data();
+	for (unsigned r = 0; r < 3; ++r) {
+		L::GatherAoS4(rows, m[r * 4], m[r * 4 + 1], m[r * 4 + 2], m[r * 4 + 3]);
+		for (unsigned j = 0; j < L::Width; ++j)
+			rows[j] += 4;
+	}
+}
+
+/// Inverse of the rotation part of Width matrices m into inv, with the same layout; the translation elements of
+/// inv are left alone.
+template <class L, TransformClass Class>
+void InverseRotation(const typename L::Type* m, typename L::Type* inv)
+{
+	typedef typename L::Type T;
+	const T one = L::Set(1.0f);
+
+	if (Class == TransformClass::Rigid) {
+		for (unsigned r = 0; r < 3; ++r) {
+			for (unsigned c = 0; c < 3; ++c)
+				inv[r * 4 + c] = m[c * 4 + r];
+		}
+	}
+	else if (Class == TransformClass::Scaled) {
+		for (unsigned c = 0; c < 3; ++c) {
+			T invLenSquared = L::Div(one, L::Add(L::Add(L::Mul(m[c], m[c]), L::Mul(m[4 + c], m[4 + c])), L::Mul(m[8 + c], m[8 + c])));
+			for (unsigned r = 0; r < 3; ++r)
+				inv[c * 4 + r] = L::Mul(m[r * 4 + c], invLenSquared);
+		}
+	}
+	else {
+		// Column c of the inverse is the cross product of the other two rows divided by the determinant.
+		T cofactors[9] = {
+			L::Sub(L::Mul(m[5], m[10]), L::Mul(m[6], m[9])),
+			L::Sub(L::Mul(m[6], m[8]), L::Mul(m[4], m[10])),
+			L::Sub(L::Mul(m[4], m[9]), L::Mul(m[5], m[8])),
+			L::Sub(L::Mul(m[9], m[2]), L::Mul(m[10], m[1])),
+			L::Sub(L::Mul(m[10], m[0]), L::Mul(m[8], m[2])),
+			L::Sub(L::Mul(m[8], m[1]), L::Mul(m[9], m[0])),
+			L::Sub(L::Mul(m[1], m[6]), L::Mul(m[2], m[5])),
+			L::Sub(L::Mul(m[2], m[4]), L::Mul(m[0], m[6])),
+			L::Sub(L::Mul(m[0], m[5]), L::Mul(m[1], m[4])),
+		};
+		T det = L::Add(L::Add(L::Mul(m[0], cofactors[0]), L::Mul(m[1], cofactors[1])), L::Mul(m[2], cofactors[2]));
+		T invDet = L::Div(one, det);
+		for (unsigned r = 0; r < 3; ++r) {
+			for (unsigned c = 0; c < 3; ++c)
+				inv[r * 4 + c] = L::Mul(cofactors[c * 3 + r], invDet);
+		}
+	}
+}
+
+template <class L, TransformClass Class>
+unsigned InverseKernel(Matrix3x4* dest, const Matrix3x4* src, unsigned i, unsigned count)
+{
+	typedef typename L::Type T;
+	const T zero = L::Set(0.0f);
+
+	for (; i + L::Width <= count; i += L::Width) {
+		T m[12];
+		GatherMatrices<L>(src + i, m);
+		T inv[12];
+		InverseRotation<L, Class>(m, inv);
+		// The new translation is -(R^-1 * t).
+		for (unsigned r = 0; r < 3; ++r) {
+			const T* row = inv + r * 4;
+			inv[r * 4 + 3] = L::Sub(zero, L::Add(L::Add(L::Mul(row[0], m[3]), L::Mul(row[1], m[7])), L::Mul(row[2], m[11])));
+		}
+
+		float* rows[L::Width];
+		for (unsigned j = 0; j < L::Width; ++j)
+			rows[j] = &dest[i + j].m00;
+		for (unsigned r = 0; r < 3; ++r) {
+			L::ScatterAoS4(rows, inv[r * 4], inv[r * 4 + 1], inv[r * 4 + 2], inv[r * 4 + 3]);
+			for (unsigned j = 0; j < L::Width; ++j)
+				rows[j] += 4;
+		}
+	}
+	return i;
+}
+
+template <class L, TransformClass Class>
+unsigned InverseTransposedKernel(Matrix3* dest, const Matrix3x4* src, unsigned i, unsigned count)
+{
+	typedef typename L::Type T;
+
+	for (; i + L::Width <= count; i += L::Width) {
+		T m[12];
+		GatherMatrices<L>(src + i, m);
+		T inv[12];
+		InverseRotation<L, Class>(m, inv);
+
+		// Matrix3 rows are three floats apart, so go through memory instead of scattering records of four.
+		float lanes[9][L::Width];
+		for (unsigned r = 0; r < 3; ++r) {
+			for (unsigned c = 0; c < 3; ++c)
+				L::Store(lanes[r * 3 + c], inv[c * 4 + r]);
+		}
+		for (unsigned j = 0; j < L::Width; ++j) {
+			float* out = &dest[i + j].m00;
+			for (unsigned e = 0; e < 9; ++e)
+				out[e] = lanes[e][j];
+		}
+	}
+	return i;
+}
+
+// A kernel instantiated for LaneScalar keeps its element arrays on the stack and is slower than the single matrix
+// functions, whose scalar paths evaluate the same expressions in the same order. The remainder of the bulk inverses
+// goes through those instead.
+
+/// Invert matrices i to count one at a time, as InverseKernel does.
+template <TransformClass Class>
+void InverseTail(Matrix3x4* dest, const Matrix3x4* src, unsigned i, unsigned count)
+{
+	for (; i < count; ++i) {
+		// The rows of the inverse rotation are the columns of the normal matrix. The new translation is -(R^-1 * t).
+		Matrix3 n = src[i].InverseTransposed(Class);
+		float t0 = src[i].m03, t1 = src[i].m13, t2 = src[i].m23;
+		dest[i] = Matrix3x4(
+			n.m00, n.m10, n.m20, 0.0f - ((n.m00 * t0 + n.m10 * t1) + n.m20 * t2),
+			n.m01, n.m11, n.m21, 0.0f - ((n.m01 * t0 + n.m11 * t1) + n.m21 * t2),
+			n.m02, n.m12, n.m22, 0.0f - ((n.m02 * t0 + n.m12 * t1) + n.m22 * t2));
+	}
+}
+
+/// Compute the normal matrices of matrices i to count one at a time, as InverseTransposedKernel does.
+template <TransformClass Class>
+void InverseTransposedTail(Matrix3* dest, const Matrix3x4* src, unsigned i, unsigned count)
+{
+	for (; i < count; ++i)
+		dest[i] = src[i].InverseTransposed(Class);
+}
+
+/// Largest cosine between two columns that Decompose still treats as orthogonal. Products of float rotations and
+/// scales stay far below it; anything above is shear and goes through the polar decomposition.
+const float kORTHOGONAL_EPSILON = 1e-5f;
+/// Smallest squared column length, and smallest determinant relative to the product of the column lengths, of a
+/// matrix the polar iteration runs on. Below them the matrix has lost a dimension.
+const float kDEGENERATE_EPSILON = 1e-12f;
+/// Iteration limit and squared convergence threshold of the polar iteration. It converges quadratically, so a step
+/// below 1e-5 leaves an error below float precision.
+const unsigned kPOLAR_ITERATIONS = 20;
+const float kPOLAR_TOLERANCE = 1e-10f;
+
+/// Index of the axis whose column is flipped to turn a reflection into a rotation: the one pointing furthest away
+/// from its own axis, which leaves the smallest rotation. d holds the diagonal of the normalized columns.
+inline unsigned ReflectionAxis(const float* d)
+{
+	if (d[0] <= d[1] && d[0] <= d[2])
+		return 0;
+	return d[1] <= d[2] ? 1 : 2;
+}
+
+/// Orthonormal columns q from the columns c of a matrix that has lost a dimension: the longest column, the part
+/// of the next one perpendicular to it, and their cross product for the shortest, so that the basis stays
+/// right-handed.
+void DecomposeDegenerate(const Vector3* c, const float* lengthsSquared, Vector3* q)
+{
+	static const Vector3 kAXES[3] = { Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f) };
+
+	unsigned shortest = 0;
+	if (lengthsSquared[1] < lengthsSquared[shortest])
+		shortest = 1;
+	if (lengthsSquared[2] < lengthsSquared[shortest])
+		shortest = 2;
+	unsigned first = (shortest + 1) % 3, second = (shortest + 2) % 3;
+	if (lengthsSquared[second] > lengthsSquared[first]) {
+		first = second;
+		second = (shortest + 1) % 3;
+	}
+
+	q[first] = lengthsSquared[first] > kDEGENERATE_EPSILON ? c[first] / sqrtf(lengthsSquared[first]) : kAXES[first];
+	q[second] = c[second] - q[first] * q[first].Dot(c[second]);
+	if (q[second].LengthSquared() <= kDEGENERATE_EPSILON * Math::Max(lengthsSquared[second], 1.0f)) {
+		// Any direction perpendicular to q[first] will do. Prefer the own axis of the column, so that a zero
+		// matrix decomposes to the identity rotation.
+		q[second] = kAXES[second] - q[first] * q[first].Dot(kAXES[second]);
+		if (q[second].LengthSquared() < 0.5f)
+			q[second] = kAXES[shortest] - q[first] * q[first].Dot(kAXES[shortest]);
+	}
+	q[second].Normalize();
+	q[shortest] = q[(shortest + 1) % 3].Cross(q[(shortest + 2) % 3]);
+}
+
+/// Decompose the rotation part of a matrix with shear or without full rank. The rotation is the orthogonal factor
+/// of the polar decomposition M = Q * S, found with the scaled Newton iteration Q' = (g * Q + Q^-T / g) / 2, which
+/// converges quadratically for any non-singular matrix. The scale is the diagonal of S = Q^T * M, the stretch along
+/// the rotated axes; the off-diagonal elements of S are the shear, which a translation, rotation and scale cannot
+/// represent. A reflection flips one column before the iteration and shows up as a negative scale on that axis.
+void DecomposeGeneral(const Matrix3x4& m, Quaternion& rotation, Vector3& scale)
+{
+	const Vector3 c[3] = {
+		Vector3(m.m00, m.m10, m.m20),
+		Vector3(m.m01, m.m11, m.m21),
+		Vector3(m.m02, m.m12, m.m22),
+	};
+	const float lengthsSquared[3] = { c[0].LengthSquared(), c[1].LengthSquared(), c[2].LengthSquared() };
+	float det = c[0].Dot(c[1].Cross(c[2]));
+
+	Vector3 q[3];
+	float volume = sqrtf(lengthsSquared[0] * lengthsSquared[1] * lengthsSquared[2]);
+	if (!(Math::Abs(det) > kDEGENERATE_EPSILON * volume) || lengthsSquared[0] <= kDEGENERATE_EPSILON ||
+		lengthsSquared[1] <= kDEGENERATE_EPSILON || lengthsSquared[2] <= kDEGENERATE_EPSILON)
+		DecomposeDegenerate(c, lengthsSquared, q);
+	else {
+		q[0] = c[0];
+		q[1] = c[1];
+		q[2] = c[2];
+		if (det < 0.0f) {
+			const float d[3] = {
+				c[0].x / sqrtf(lengthsSquared[0]),
+				c[1].y / sqrtf(lengthsSquared[1]),
+				c[2].z / sqrtf(lengthsSquared[2]),
+			};
+			unsigned k = ReflectionAxis(d);
+			q[k] = -q[k];
+			det = -det;
+		}
+
+		for (unsigned iteration = 0; iteration < kPOLAR_ITERATIONS; ++iteration) {
+			// The columns of the inverse transpose are the cross products of the other two columns divided by
+			// the determinant.
+			const Vector3 cofactors[3] = { q[1].Cross(q[2]), q[2].Cross(q[0]), q[0].Cross(q[1]) };
+			if (iteration)
+				det = q[0].Dot(cofactors[0]);
+			// g = sqrt(|Q^-1| / |Q|) in the Frobenius norm balances the two terms, which makes the first steps
+			// as long as they can be.
+			float normSquared = q[0].LengthSquared() + q[1].LengthSquared() + q[2].LengthSquared();
+			float cofactorNormSquared = cofactors[0].LengthSquared() + cofactors[1].LengthSquared() +
+				cofactors[2].LengthSquared();
+			float g = sqrtf(sqrtf(cofactorNormSquared / normSquared) / det);
+			float a = 0.5f * g;
+			float b = 0.5f / (g * det);
+
+			float step = 0.0f;
+			for (unsigned i = 0; i < 3; ++i) {
+				Vector3 next = q[i] * a + cofactors[i] * b;
+				step += (next - q[i]).LengthSquared();
+				q[i] = next;
+			}
+			if (step < kPOLAR_TOLERANCE)
+				break;
+		}
+	}
+
+	rotation.FromAxes(q[0], q[1], q[2]);
+	scale = Vector3(q[0].Dot(c[0]), q[1].Dot(c[1]), q[2].Dot(c[2]));
+}
+
+/// Decompose Width matrices whose columns are orthogonal, and return the lanes that are not: those get their
+/// results from DecomposeGeneral afterwards. The rotation matrix is the columns divided by their lengths, and it
+/// becomes a quaternion through all four branches of Quaternion::FromRotationMatrix evaluated and selected per
+/// lane with the same operations, so every width agrees with DecomposeOne bit for bit.
+template <class L>
+int DecomposeOrthogonal(const Matrix3x4* src, Vector3* translations, Quaternion* rotations, Vector3* scales)
+{
+	typedef typename L::Type T;
+	const T zero = L::Set(0.0f);
+	const T one = L::Set(1.0f);
+	const T minusOne = L::Set(-1.0f);
+	const T half = L::Set(0.5f);
+	const T quarter = L::Set(0.25f);
+
+	T m[12];
+	GatherMatrices<L>(src, m);
+
+	T lengthsSquared[3], s[3], r[9];
+	for (unsigned c = 0; c < 3; ++c) {
+		lengthsSquared[c] = L::Add(L::Add(L::Mul(m[c], m[c]), L::Mul(m[4 + c], m[4 + c])), L::Mul(m[8 + c], m[8 + c]));
+		s[c] = L::Sqrt(lengthsSquared[c]);
+		T invLength = L::Div(one, s[c]);
+		for (unsigned row = 0; row < 3; ++row)
+			r[row * 3 + c] = L::Mul(m[row * 4 + c], invLength);
+	}
+
+	// Shear: cos^2 of the angle between two columns above the epsilon. Near-zero columns take the general path too.
+	const T epsilon = L::Set(kORTHOGONAL_EPSILON * kORTHOGONAL_EPSILON);
+	const T degenerate = L::Set(kDEGENERATE_EPSILON);
+	typename L::Mask general = L::Or(L::Or(L::CmpLe(lengthsSquared[0], degenerate), L::CmpLe(lengthsSquared[1], degenerate)),
+		L::CmpLe(lengthsSquared[2], degenerate));
+	for (unsigned c = 0; c < 3; ++c) {
+		unsigned d = (c + 1) % 3;
+		T dot = L::Add(L::Add(L::Mul(m[c], m[d]), L::Mul(m[4 + c], m[4 + d])), L::Mul(m[8 + c], m[8 + d]));
+		general = L::Or(general, L::CmpGt(L::Mul(dot, dot), L::Mul(epsilon, L::Mul(lengthsSquared[c], lengthsSquared[d]))));
+	}
+
+	// A negative determinant flips the column picked by ReflectionAxis, and the sign of its scale.
+	T det = L::Add(L::Add(
+		L::Mul(r[0], L::Sub(L::Mul(r[4], r[8]), L::Mul(r[7], r[5]))),
+		L::Mul(r[3], L::Sub(L::Mul(r[7], r[2]), L::Mul(r[1], r[8])))),
+		L::Mul(r[6], L::Sub(L::Mul(r[1], r[5]), L::Mul(r[4], r[2]))));
+	typename L::Mask reflect = L::CmpLt(det, zero);
+	typename L::Mask flipX = L::And(L::CmpLe(r[0], r[4]), L::CmpLe(r[0], r[8]));
+	typename L::Mask flipY = L::CmpLe(r[4], r[8]);
+	const T sign[3] = {
+		L::Select(reflect, L::Select(flipX, minusOne, one), one),
+		L::Select(reflect, L::Select(flipX, one, L::Select(flipY, minusOne, one)), one),
+		L::Select(reflect, L::Select(flipX, one, L::Select(flipY, one, minusOne)), one),
+	};
+	for (unsigned c = 0; c < 3; ++c) {
+		s[c] = L::Mul(s[c], sign[c]);
+		for (unsigned row = 0; row < 3; ++row)
+			r[row * 3 + c] = L::Mul(r[row * 3 + c], sign[c]);
+	}
+
+	// Quaternion::FromRotationMatrix, one branch per case.
+	const T& m00 = r[0], & m01 = r[1], & m02 = r[2];
+	const T& m10 = r[3], & m11 = r[4], & m12 = r[5];
+	const T& m20 = r[6], & m21 = r[7], & m22 = r[8];
+	T trace = L::Add(L::Add(m00, m11), m22);
+	typename L::Mask caseW = L::CmpGt(trace, zero);
+	typename L::Mask caseX = L::And(L::CmpGt(m00, m11), L::CmpGt(m00, m22));
+	typename L::Mask caseY = L::CmpGt(m11, m22);
+	T tW = L::Add(one, trace);
+	T tX = L::Sub(L::Sub(L::Add(one, m00), m11), m22);
+	T tY = L::Sub(L::Sub(L::Add(one, m11), m00), m22);
+	T tZ = L::Sub(L::Sub(L::Add(one, m22), m00), m11);
+	T t = L::Select(caseW, tW, L::Select(caseX, tX, L::Select(caseY, tY, tZ)));
+	T invS = L::Div(half, L::Sqrt(t));
+	T big = L::Div(quarter, invS);
+	T a = L::Mul(L::Sub(m21, m12), invS);
+	T b = L::Mul(L::Sub(m02, m20), invS);
+	T c = L::Mul(L::Sub(m10, m01), invS);
+	T d = L::Mul(L::Add(m01, m10), invS);
+	T e = L::Mul(L::Add(m20, m02), invS);
+	T f = L::Mul(L::Add(m12, m21), invS);
+	T qw = L::Select(caseW, big, L::Select(caseX, a, L::Select(caseY, b, c)));
+	T qx = L::Select(caseW, a, L::Select(caseX, big, L::Select(caseY, d, e)));
+	T qy = L::Select(caseW, b, L::Select(caseX, d, L::Select(caseY, big, f)));
+	T qz = L::Select(caseW, c, L::Select(caseX, e, L::Select(caseY, f, big)));
+
+	float* quaternions[L::Width];
+	for (unsigned j = 0; j < L::Width; ++j)
+		quaternions[j] = &rotations[j].w;
+	L::ScatterAoS4(quaternions, qw, qx, qy, qz);
+
+	// Vector3 records are three floats, so go through memory.
+	float lanes[6][L::Width];
+	L::Store(lanes[0], m[3]);
+	L::Store(lanes[1], m[7]);
+	L::Store(lanes[2], m[11]);
+	for (unsigned c = 0; c < 3; ++c)
+		L::Store(lanes[3 + c], s[c]);
+	for (unsigned j = 0; j < L::Width; ++j) {
+		translations[j] = Vector3(lanes[0][j], lanes[1][j], lanes[2][j]);
+		scales[j] = Vector3(lanes[3][j], lanes[4][j], lanes[5][j]);
+	}
+	return L::MoveMask(general);
+}
+
+/// Decompose one matrix: DecomposeOrthogonal with branches instead of selects, and the same operations, or
+/// DecomposeGeneral. With SSE the three columns are the lanes of the rows.
+void DecomposeOne(const Matrix3x4& m, Vector3& translation, Quaternion& rotation, Vector3& scale)
+{
+	const float epsilon = kORTHOGONAL_EPSILON * kORTHOGONAL_EPSILON;
+	float r[12], s[4];
+#ifdef MATH_SSE
+	__m128 row0 = _mm_loadu_ps(&m.m00);
+	__m128 row1 = _mm_loadu_ps(&m.m10);
+	__m128 row2 = _mm_loadu_ps(&m.m20);
+	__m128 lengthsSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(row0, row0), _mm_mul_ps(row1, row1)), _mm_mul_ps(row2, row2));
+	__m128 length = _mm_sqrt_ps(lengthsSquared);
+	__m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), length);
+
+	// Lane c holds the dot product of columns c and c + 1.
+	__m128 next0 = _mm_shuffle_ps(row0, row0, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 next1 = _mm_shuffle_ps(row1, row1, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 next2 = _mm_shuffle_ps(row2, row2, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(row0, next0), _mm_mul_ps(row1, next1)), _mm_mul_ps(row2, next2));
+	__m128 bound = _mm_mul_ps(_mm_set1_ps(epsilon),
+		_mm_mul_ps(lengthsSquared, _mm_shuffle_ps(lengthsSquared, lengthsSquared, _MM_SHUFFLE(3, 0, 2, 1))));
+	__m128 general = _mm_or_ps(_mm_cmpgt_ps(_mm_mul_ps(dot, dot), bound),
+		_mm_cmple_ps(lengthsSquared, _mm_set1_ps(kDEGENERATE_EPSILON)));
+	translation = Vector3(m.m03, m.m13, m.m23);
+	if (_mm_movemask_ps(general) & 7) {
+		DecomposeGeneral(m, rotation, scale);
+		return;
+	}
+	_mm_storeu_ps(r, _mm_mul_ps(row0, invLength));
+	_mm_storeu_ps(r + 4, _mm_mul_ps(row1, invLength));
+	_mm_storeu_ps(r + 8, _mm_mul_ps(row2, invLength));
+	_mm_storeu_ps(s, length);
+#else
+	const float* data = m.Data();
+	const float lengthsSquared[3] = {
+		data[0] * data[0] + data[4] * data[4] + data[8] * data[8],
+		data[1] * data[1] + data[5] * data[5] + data[9] * data[9],
+		data[2] * data[2] + data[6] * data[6] + data[10] * data[10],
+	};
+	const float dot[3] = {
+		data[0] * data[1] + data[4] * data[5] + data[8] * data[9],
+		data[1] * data[2] + data[5] * data[6] + data[9] * data[10],
+		data[2] * data[0] + data[6] * data[4] + data[10] * data[8],
+	};
+	translation = Vector3(m.m03, m.m13, m.m23);
+	if (lengthsSquared[0] <= kDEGENERATE_EPSILON || lengthsSquared[1] <= kDEGENERATE_EPSILON ||
+		lengthsSquared[2] <= kDEGENERATE_EPSILON || dot[0] * dot[0] > epsilon * (lengthsSquared[0] * lengthsSquared[1]) ||
+		dot[1] * dot[1] > epsilon * (lengthsSquared[1] * lengthsSquared[2]) ||
+		dot[2] * dot[2] > epsilon * (lengthsSquared[2] * lengthsSquared[0])) {
+		DecomposeGeneral(m, rotation, scale);
+		return;
+	}
+	for (unsigned c = 0; c < 3; ++c) {
+		s[c] = sqrtf(lengthsSquared[c]);
+		float invLength = 1.0f / s[c];
+		r[c] = data[c] * invLength;
+		r[4 + c] = data[4 + c] * invLength;
+		r[8 + c] = data[8 + c] * invLength;
+	}
+#endif
+
+	// r has the rows of the rotation four floats apart.
+	float det = r[0] * (r[5] * r[10] - r[9] * r[6]) + r[4] * (r[9] * r[2] - r[1] * r[10]) + r[8] * (r[1] * r[6] - r[5] * r[2]);
+	if (det < 0.0f) {
+		const float d[3] = { r[0], r[5], r[10] };
+		unsigned k = ReflectionAxis(d);
+		s[k] = -s[k];
+		r[k] = -r[k];
+		r[4 + k] = -r[4 + k];
+		r[8 + k] = -r[8 + k];
+	}
+
+	rotation.FromRotationMatrix(Matrix3(r[0], r[1], r[2], r[4], r[5], r[6], r[8], r[9], r[10]));
+	scale = Vector3(s[0], s[1], s[2]);
+}
+
+template <class L>
+unsigned DecomposeKernel(const Matrix3x4* src, Vector3* translations, Quaternion* rotations, Vector3* scales,
+	unsigned i, unsigned count)
+{
+	for (; i + L::Width <= count; i += L::Width) {
+		int general = DecomposeOrthogonal<L>(src + i, translations + i, rotations + i, scales + i);
+		for (unsigned j = 0; general; ++j, general >>= 1) {
+			if (general & 1)
+				DecomposeGeneral(src[i + j], rotations[i + j], scales[i + j]);
+		}
+	}
+	return i;
+}
+
+template <TransformClass Class>
+void BulkInverse(Matrix3x4* dest, const Matrix3x4* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = InverseKernel<LaneAVX, Class>(dest, src, i, count);
+#endif
+#ifdef MATH_SSE
+	i = InverseKernel<LaneSSE, Class>(dest, src, i, count);
+#endif
+	InverseTail<Class>(dest, src, i, count);
+}
+
+template <TransformClass Class>
+void BulkInverseTransposed(Matrix3* dest, const Matrix3x4* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = InverseTransposedKernel<LaneAVX, Class>(dest, src, i, count);
+#endif
+#ifdef MATH_SSE
+	i = InverseTransposedKernel<LaneSSE, Class>(dest, src, i, count);
+#endif
+	InverseTransposedTail<Class>(dest, src, i, count);
+}
+
+void BulkDecompose(const Matrix3x4* src, Vector3* translations, Quaternion* rotations, Vector3* scales, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = DecomposeKernel<LaneAVX>(src, translations, rotations, scales, i, count);
+#endif
+#ifdef MATH_SSE
+	i = DecomposeKernel<LaneSSE>(src, translations, rotations, scales, i, count);
+#endif
+	for (; i < count; ++i)
+		DecomposeOne(src[i], translations[i], rotations[i], scales[i]);
+}
+
+template <bool Project>
+void BulkTransformPoints(const float* m, float* outX, float* outY, float* outZ,
+	const float* x, const float* y, const float* z, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = TransformPoints<LaneAVX, Project>(m, outX, outY, outZ, x, y, z, i, count);
+#endif
+#ifdef MATH_SSE
+	i = TransformPoints<LaneSSE, Project>(m, outX, outY, outZ, x, y, z, i, count);
+#endif
+	TransformPoints<LaneScalar, Project>(m, outX, outY, outZ, x, y, z, i, count);
+}
+
+void BulkTransformDirections(const float* m, float* outX, float* outY, float* outZ,
+	const float* x, const float* y, const float* z, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = TransformDirections<LaneAVX>(m, outX, outY, outZ, x, y, z, i, count);
+#endif
+#ifdef MATH_SSE
+	i = TransformDirections<LaneSSE>(m, outX, outY, outZ, x, y, z, i, count);
+#endif
+	TransformDirections<LaneScalar>(m, outX, outY, outZ, x, y, z, i, count);
+}
+
+void BulkTransformHomogeneous(const float* m, float* outX, float* outY, float* outZ, float* outW,
+	const float* x, const float* y, const float* z, const float* w, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = TransformHomogeneous<LaneAVX>(m, outX, outY, outZ, outW, x, y, z, w, i, count);
+#endif
+#ifdef MATH_SSE
+	i = TransformHomogeneous<LaneSSE>(m, outX, outY, outZ, outW, x, y, z, w, i, count);
+#endif
+	TransformHomogeneous<LaneScalar>(m, outX, outY, outZ, outW, x, y, z, w, i, count);
+}
+
+}
+
+void Matrix3x4::BulkTransformPoints(float* outX, float* outY, float* outZ,
+	const float* x, const float* y, const float* z, unsigned count) const
+{
+	::BulkTransformPoints<false>(Data(), outX, outY, outZ, x, y, z, count);
+}
+
+void Matrix3x4::BulkTransformDirections(float* outX, float* outY, float* outZ,
+	const float* x, const float* y, const float* z, unsigned count) const
+{
+	::BulkTransformDirections(Data(), outX, outY, outZ, x, y, z, count);
+}
+
+void Matrix3x4::BulkTransform(float* outX, float* outY, float* outZ,
+	const float* x, const float* y, const float* z, const float* w, unsigned count) const
+{
+	::BulkTransformHomogeneous(Data(), outX, outY, outZ, nullptr, x, y, z, w, count);
+}
+
+void Matrix3x4::BulkInverse(Matrix3x4* dest, const Matrix3x4* src, unsigned count, TransformClass cls)
+{
+	switch (cls) {
+	case TransformClass::Rigid:
+		::BulkInverse<TransformClass::Rigid>(dest, src, count);
+		break;
+	case TransformClass::Scaled:
+		::BulkInverse<TransformClass::Scaled>(dest, src, count);
+		break;
+	default:
+		::BulkInverse<TransformClass::Affine>(dest, src, count);
+		break;
+	}
+}
+
+void Matrix3x4::BulkInverseTransposed(Matrix3* dest, const Matrix3x4* src, unsigned count, TransformClass cls)
+{
+	switch (cls) {
+	case TransformClass::Rigid:
+		::BulkInverseTransposed<TransformClass::Rigid>(dest, src, count);
+		break;
+	case TransformClass::Scaled:
+		::BulkInverseTransposed<TransformClass::Scaled>(dest, src, count);
+		break;
+	default:
+		::BulkInverseTransposed<TransformClass::Affine>(dest, src, count);
+		break;
+	}
+}
+
+void Matrix3x4::Decompose(Vector3& translation, Quaternion& rotation, Vector3& scale) const
+{
+	DecomposeOne(*this, translation, rotation, scale);
+}
+
+void Matrix3x4::BulkDecompose(const Matrix3x4* src, Vector3* translations, Quaternion* rotations, Vector3* scales,
+	unsigned count)
+{
+	::BulkDecompose(src, translations, rotations, scales, count);
+}
+
+void Matrix4::BulkTransformPoints(float* outX, float* outY, float* outZ,
+	const float* x, const float* y, const float* z, unsigned count) const
+{
+	::BulkTransformPoints<true>(Data(), outX, outY, outZ, x, y, z, count);
+}
+
+void Matrix4::BulkTransformDirections(float* outX, float* outY, float* outZ,
+	const float* x, const float* y, const float* z, unsigned count) const
+{
+	::BulkTransformDirections(Data(), outX, outY, outZ, x, y, z, count);
+}
+
+void Matrix4::BulkTransform(float* outX, float* outY, float* outZ, float* outW,
+	const float* x, const float* y, const float* z, const float* w, unsigned count) const
+{
+	::BulkTransformHomogeneous(Data(), outX, outY, outZ, outW, x, y, z, w, count);
+}
+
+MATH_CONTRACT_OFF_END
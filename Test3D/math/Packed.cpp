@@ -0,0 +1,557 @@
+#include "Packed.h"
+#include "SimdLane.h"
+
+// Pack and unpack for the compact storage formats.
+//
+// The half and snorm16 formats convert every float on its own, so arrays of vectors are converted as flat float
+// arrays. The octahedral and quaternion formats need all components of a value at once: four values are loaded
+// and transposed to one register per component, converted without branches, and interleaved again for the store.
+// Every SIMD loop is followed by the scalar conversion for the remainder, and both round to nearest even, so the
+// result does not depend on the array length or the build.
+
+#if defined(MATH_SSE) && (defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__)))
+// Hardware half conversion; Visual Studio has no separate switch for it and enables it with /arch:AVX2.
+#define PACKED_F16C
+#include <immintrin.h>
+#endif
+
+MATH_CONTRACT_OFF_BEGIN
+
+static_assert(sizeof(Vector3) == 3 * sizeof(float) && sizeof(Vector4) == 4 * sizeof(float), "Vectors must be packed");
+static_assert(sizeof(HalfVector3) == 6 && sizeof(HalfVector4) == 8 && sizeof(Snorm16Vector3) == 6, "Unexpected padding");
+static_assert(sizeof(OctahedralVector3) == 4 && sizeof(PackedQuaternion) == 6, "Unexpected padding");
+
+namespace
+{
+
+union FloatBits
+{
+	float    f;
+	unsigned u;
+};
+
+/// Quantization scale of the three smallest quaternion components, which lie in [-1 / sqrt(2), 1 / sqrt(2)].
+/// Zero maps to the middle code exactly, so the identity survives a round trip unchanged.
+const float kQUAT_SCALE = 16383.0f * 1.41421356f;
+const float kQUAT_INV_SCALE = 1.0f / kQUAT_SCALE;
+const int   kQUAT_BIAS = 16383;
+
+inline short ToSnorm16(float v)
+{
+	return (short)lrintf(Math::Clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+inline float FromSnorm16(short v)
+{
+	// -32768 is not produced by ToSnorm16 and decodes to -1 like every other snorm format.
+	return Math::Max(v * (1.0f / 32767.0f), -1.0f);
+}
+
+inline int QuantizeQuatComponent(float v)
+{
+	return (int)lrintf(Math::Clamp(v * kQUAT_SCALE, -16383.0f, 16383.0f)) + kQUAT_BIAS;
+}
+
+inline float DequantizeQuatComponent(int v)
+{
+	return (float)(v - kQUAT_BIAS) * kQUAT_INV_SCALE;
+}
+
+#ifdef MATH_SSE
+inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// Transpose three registers holding four records of three 32-bit values each to one register per value.
+inline void DeinterleaveAoS3(__m128 r0, __m128 r1, __m128 r2, __m128& a, __m128& b, __m128& c)
+{
+	// r0 = a0 b0 c0 a1, r1 = b1 c1 a2 b2, r2 = c2 a3 b3 c3
+	a = _mm_shuffle_ps(r0, _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	b = _mm_shuffle_ps(_mm_shuffle_ps(r0, r1, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(2, 2, 3, 3)),
+		_MM_SHUFFLE(2, 0, 2, 0));
+	c = _mm_shuffle_ps(_mm_shuffle_ps(r0, r1, _MM_SHUFFLE(1, 1, 2, 2)), r2, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+/// Inverse of DeinterleaveAoS3.
+inline void InterleaveAoS3(__m128 a, __m128 b, __m128 c, __m128& r0, __m128& r1, __m128& r2)
+{
+	r0 = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(c, a, _MM_SHUFFLE(1, 1, 0, 0)),
+		_MM_SHUFFLE(2, 0, 2, 0));
+	r1 = _mm_shuffle_ps(_mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 2, 2, 2)),
+		_MM_SHUFFLE(2, 0, 2, 0));
+	r2 = _mm_shuffle_ps(_mm_shuffle_ps(c, a, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(3, 3, 3, 3)),
+		_MM_SHUFFLE(2, 0, 2, 0));
+}
+
+/// Narrow four 32-bit lanes to their low 16 bits. _mm_packs_epi32 saturates, so sign extend the low half first.
+inline __m128i Narrow16(__m128i lo, __m128i hi)
+{
+	return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16), _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+}
+
+/// Four floats to half precision bits in the low 16 bits of each lane, sign extended. Same rounding and special
+/// cases as Math::FloatToHalf (F. Giesen, "float->half variants").
+inline __m128i FloatToHalfSSE(__m128 f)
+{
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+
+	__m128 sign = _mm_and_ps(f, signMask);
+	__m128 absF = _mm_xor_ps(f, sign);
+	__m128i absBits = _mm_castps_si128(absF);
+
+	// Below the smallest normal half the float addition shifts the mantissa into place with correct rounding.
+	__m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absF, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+	// Otherwise rebias the exponent and round the mantissa to nearest even.
+	__m128i odd = _mm_and_si128(_mm_srli_epi32(absBits, 13), _mm_set1_epi32(1));
+	__m128i normal = _mm_add_epi32(_mm_add_epi32(absBits, _mm_set1_epi32(0xfff - ((127 - 15) << 23))), odd);
+	normal = _mm_srli_epi32(normal, 13);
+
+	__m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), absBits);
+	__m128i isFinite = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), absBits);
+	__m128i nanBit = _mm_and_si128(_mm_castps_si128(_mm_cmpunord_ps(absF, absF)), _mm_set1_epi32(0x200));
+	__m128i infOrNaN = _mm_or_si128(nanBit, _mm_set1_epi32(0x7c00));
+
+	__m128i bits = Select(isFinite, Select(isSubnormal, subnormal, normal), infOrNaN);
+	return _mm_or_si128(bits, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+/// Four half precision values in the low 16 bits of each lane to floats.
+inline __m128 HalfToFloatSSE(__m128i h)
+{
+	const __m128i expMant = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+	const __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expMant), 16);
+
+	// Multiplying by 2^112 rebiases the exponent and normalizes denormals in one step.
+	__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+	__m128i infNaNExp = _mm_and_si128(_mm_cmpgt_epi32(expMant, _mm_set1_epi32(0x7bff)), _mm_set1_epi32(255 << 23));
+	return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNaNExp)));
+}
+
+inline __m128i ToSnorm16SSE(__m128 v)
+{
+	return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f)), _mm_set1_ps(32767.0f)));
+}
+
+inline __m128 FromSnorm16SSE(__m128i v)
+{
+	return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / 32767.0f)), _mm_set1_ps(-1.0f));
+}
+
+/// Sign extend the eight 16-bit lanes of v to two registers of 32-bit lanes.
+inline void Widen16(__m128i v, __m128i& lo, __m128i& hi)
+{
+	lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+	hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
+#endif
+
+void FloatsToHalves(unsigned short* dest, const float* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef PACKED_F16C
+	for (; i + 8 <= count; i += 8)
+		_mm_storeu_si128((__m128i*)(dest + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+#ifdef MATH_SSE
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = FloatToHalfSSE(_mm_loadu_ps(src + i));
+		__m128i hi = FloatToHalfSSE(_mm_loadu_ps(src + i + 4));
+		_mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(lo, hi));
+	}
+#endif
+	for (; i < count; ++i)
+		dest[i] = Math::FloatToHalf(src[i]);
+}
+
+void HalvesToFloats(float* dest, const unsigned short* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef PACKED_F16C
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(dest + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+#endif
+#ifdef MATH_SSE
+	for (; i + 8 <= count; i += 8) {
+		__m128i h = _mm_loadu_si128((const __m128i*)(src + i));
+		_mm_storeu_ps(dest + i, HalfToFloatSSE(_mm_unpacklo_epi16(h, _mm_setzero_si128())));
+		_mm_storeu_ps(dest + i + 4, HalfToFloatSSE(_mm_unpackhi_epi16(h, _mm_setzero_si128())));
+	}
+#endif
+	for (; i < count; ++i)
+		dest[i] = Math::HalfToFloat(src[i]);
+}
+
+void FloatsToSnorm16(short* dest, const float* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_SSE
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = ToSnorm16SSE(_mm_loadu_ps(src + i));
+		__m128i hi = ToSnorm16SSE(_mm_loadu_ps(src + i + 4));
+		_mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(lo, hi));
+	}
+#endif
+	for (; i < count; ++i)
+		dest[i] = ToSnorm16(src[i]);
+}
+
+void Snorm16ToFloats(float* dest, const short* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_SSE
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo, hi;
+		Widen16(_mm_loadu_si128((const __m128i*)(src + i)), lo, hi);
+		_mm_storeu_ps(dest + i, FromSnorm16SSE(lo));
+		_mm_storeu_ps(dest + i + 4, FromSnorm16SSE(hi));
+	}
+#endif
+	for (; i < count; ++i)
+		dest[i] = FromSnorm16(src[i]);
+}
+
+}
+
+namespace Math
+{
+
+unsigned short FloatToHalf(float value)
+{
+	FloatBits bits;
+	bits.f = value;
+	unsigned sign = bits.u & 0x80000000u;
+	bits.u ^= sign;
+
+	unsigned half;
+	if (bits.u >= (127u + 16u) << 23)
+		half = bits.u > 0x7f800000u ? 0x7e00u : 0x7c00u;
+	else if (bits.u < (127u - 14u) << 23) {
+		// Denormal or zero: adding 0.5 shifts the mantissa into place and the float addition rounds it.
+		FloatBits magic;
+		magic.u = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+		bits.f += magic.f;
+		half = bits.u - magic.u;
+	}
+	else {
+		unsigned odd = (bits.u >> 13) & 1u;
+		bits.u += 0xfffu - ((127u - 15u) << 23) + odd;
+		half = bits.u >> 13;
+	}
+	return (unsigned short)(half | (sign >> 16));
+}
+
+float HalfToFloat(unsigned short value)
+{
+	const unsigned shiftedExp = 0x7c00u << 13;
+
+	FloatBits bits;
+	bits.u = (value & 0x7fffu) << 13;
+	unsigned exp = bits.u & shiftedExp;
+	bits.u += (127u - 15u) << 23;
+	if (exp == shiftedExp)
+		bits.u += (128u - 16u) << 23;
+	else if (exp == 0) {
+		FloatBits magic;
+		magic.u = 113u << 23;
+		bits.u += 1u << 23;
+		bits.f -= magic.f;
+	}
+	bits.u |= (value & 0x8000u) << 16;
+	return bits.f;
+}
+
+}
+
+void HalfVector3::BulkPack(HalfVector3* dest, const Vector3* src, unsigned count)
+{
+	FloatsToHalves(&dest->x, &src->x, count * 3);
+}
+
+void HalfVector3::BulkUnpack(Vector3* dest, const HalfVector3* src, unsigned count)
+{
+	HalvesToFloats(&dest->x, &src->x, count * 3);
+}
+
+void HalfVector4::BulkPack(HalfVector4* dest, const Vector4* src, unsigned count)
+{
+	FloatsToHalves(&dest->x, &src->x, count * 4);
+}
+
+void HalfVector4::BulkUnpack(Vector4* dest, const HalfVector4* src, unsigned count)
+{
+	HalvesToFloats(&dest->x, &src->x, count * 4);
+}
+
+Snorm16Vector3::Snorm16Vector3(const Vector3& vector) :
+	x(ToSnorm16(vector.x)),
+	y(ToSnorm16(vector.y)),
+	z(ToSnorm16(vector.z))
+{
+}
+
+Vector3 Snorm16Vector3::ToVector3() const
+{
+	return Vector3(FromSnorm16(x), FromSnorm16(y), FromSnorm16(z));
+}
+
+void Snorm16Vector3::BulkPack(Snorm16Vector3* dest, const Vector3* src, unsigned count)
+{
+	FloatsToSnorm16(&dest->x, &src->x, count * 3);
+}
+
+void Snorm16Vector3::BulkUnpack(Vector3* dest, const Snorm16Vector3* src, unsigned count)
+{
+	Snorm16ToFloats(&dest->x, &src->x, count * 3);
+}
+
+// Octahedral mapping (Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors").
+// The vector is scaled to unit L1 norm, which puts it on the octahedron |x| + |y| + |z| = 1; the lower half is
+// folded over the diagonals of the xy square.
+
+OctahedralVector3::OctahedralVector3(const Vector3& vector)
+{
+	// The lower bound keeps a zero vector finite; it packs to (0, 0), which unpacks to Vector3::UP.
+	float invL1 = 1.0f / Math::Max(fabsf(vector.x) + fabsf(vector.y) + fabsf(vector.z), 1e-30f);
+	float px = vector.x * invL1;
+	float py = vector.y * invL1;
+	if (vector.z < 0.0f) {
+		float fx = (1.0f - fabsf(py)) * copysignf(1.0f, px);
+		float fy = (1.0f - fabsf(px)) * copysignf(1.0f, py);
+		px = fx;
+		py = fy;
+	}
+	x = ToSnorm16(px);
+	y = ToSnorm16(py);
+}
+
+Vector3 OctahedralVector3::ToVector3() const
+{
+	float vx = FromSnorm16(x);
+	float vy = FromSnorm16(y);
+	float vz = (1.0f - fabsf(vx)) - fabsf(vy);
+	float fold = Math::Max(-vz, 0.0f);
+	vx -= copysignf(fold, vx);
+	vy -= copysignf(fold, vy);
+	float invLength = 1.0f / sqrtf((vx * vx + vy * vy) + vz * vz);
+	return Vector3(vx * invLength, vy * invLength, vz * invLength);
+}
+
+void OctahedralVector3::BulkPack(OctahedralVector3* dest, const Vector3* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_SSE
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		const float* p = &src[i].x;
+		__m128 x, y, z;
+		DeinterleaveAoS3(_mm_loadu_ps(p), _mm_loadu_ps(p + 4), _mm_loadu_ps(p + 8), x, y, z);
+
+		__m128 l1 = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(signMask, x), _mm_andnot_ps(signMask, y)), _mm_andnot_ps(signMask, z));
+		__m128 invL1 = _mm_div_ps(one, _mm_max_ps(l1, _mm_set1_ps(1e-30f)));
+		__m128 px = _mm_mul_ps(x, invL1);
+		__m128 py = _mm_mul_ps(y, invL1);
+		__m128 fx = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, py)), _mm_or_ps(_mm_and_ps(px, signMask), one));
+		__m128 fy = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, px)), _mm_or_ps(_mm_and_ps(py, signMask), one));
+		__m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+		__m128i ox = ToSnorm16SSE(Select(lower, fx, px));
+		__m128i oy = ToSnorm16SSE(Select(lower, fy, py));
+
+		// x0 y0 x1 y1 x2 y2 x3 y3
+		_mm_storeu_si128((__m128i*)&dest[i], _mm_packs_epi32(_mm_unpacklo_epi32(ox, oy), _mm_unpackhi_epi32(ox, oy)));
+	}
+#endif
+	for (; i < count; ++i)
+		dest[i] = OctahedralVector3(src[i]);
+}
+
+void OctahedralVector3::BulkUnpack(Vector3* dest, const OctahedralVector3* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_SSE
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		__m128i lo, hi;
+		Widen16(_mm_loadu_si128((const __m128i*)&src[i]), lo, hi);
+		__m128 xy01 = FromSnorm16SSE(lo);
+		__m128 xy23 = FromSnorm16SSE(hi);
+		__m128 x = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 y = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 1, 3, 1));
+
+		__m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, x)), _mm_andnot_ps(signMask, y));
+		__m128 fold = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+		x = _mm_sub_ps(x, _mm_or_ps(fold, _mm_and_ps(x, signMask)));
+		y = _mm_sub_ps(y, _mm_or_ps(fold, _mm_and_ps(y, signMask)));
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		__m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+
+		__m128 r0, r1, r2;
+		InterleaveAoS3(_mm_mul_ps(x, invLength), _mm_mul_ps(y, invLength), _mm_mul_ps(z, invLength), r0, r1, r2);
+		float* p = &dest[i].x;
+		_mm_storeu_ps(p, r0);
+		_mm_storeu_ps(p + 4, r1);
+		_mm_storeu_ps(p + 8, r2);
+	}
+#endif
+	for (; i < count; ++i)
+		dest[i] = src[i].ToVector3();
+}
+
+// The 48 bits hold the three smallest components a, b and c in bits 0-14, 15-29 and 30-44 and the index of the
+// largest component (0 = w, 1 = x, 2 = y, 3 = z) in bits 45-46, spread over the three 16-bit words in little
+// endian order.
+
+PackedQuaternion::PackedQuaternion(const Quaternion& quat)
+{
+	const float* c = quat.Data();
+	unsigned largest = 0;
+	for (unsigned j = 1; j < 4; ++j) {
+		if (fabsf(c[j]) > fabsf(c[largest]))
+			largest = j;
+	}
+	float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+	int q[3];
+	for (unsigned j = 0, k = 0; j < 4; ++j) {
+		if (j != largest)
+			q[k++] = QuantizeQuatComponent(c[j] * sign);
+	}
+	data[0] = (unsigned short)(q[0] | (q[1] << 15));
+	data[1] = (unsigned short)((q[1] >> 1) | (q[2] << 14));
+	data[2] = (unsigned short)((q[2] >> 2) | (largest << 13));
+}
+
+Quaternion PackedQuaternion::ToQuaternion() const
+{
+	int a = data[0] & 0x7fff;
+	int b = (data[0] >> 15) | ((data[1] & 0x3fff) << 1);
+	int c = (data[1] >> 14) | ((data[2] & 0x1fff) << 2);
+	unsigned largest = (data[2] >> 13) & 3u;
+
+	float fa = DequantizeQuatComponent(a);
+	float fb = DequantizeQuatComponent(b);
+	float fc = DequantizeQuatComponent(c);
+	float small[3] = { fa, fb, fc };
+	float result[4];
+	for (unsigned j = 0, k = 0; j < 4; ++j)
+		result[j] = j == largest ? sqrtf(Math::Max(((1.0f - fa * fa) - fb * fb) - fc * fc, 0.0f)) : small[k++];
+	return Quaternion(result[0], result[1], result[2], result[3]);
+}
+
+void PackedQuaternion::BulkPack(PackedQuaternion* dest, const Quaternion* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_SSE
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 scale = _mm_set1_ps(kQUAT_SCALE);
+	const __m128 lowest = _mm_set1_ps(-16383.0f);
+	const __m128 highest = _mm_set1_ps(16383.0f);
+	const __m128i bias = _mm_set1_epi32(kQUAT_BIAS);
+	const __m128i lowWord = _mm_set1_epi32(0xffff);
+	for (; i + 4 <= count; i += 4) {
+		__m128 w, x, y, z;
+		LaneSSE::LoadAoS4(src[i].Data(), w, x, y, z);
+
+		// Index of the largest magnitude; on ties the earlier component wins, as in the scalar loop.
+		__m128 absW = _mm_andnot_ps(signMask, w);
+		__m128 absX = _mm_andnot_ps(signMask, x);
+		__m128 absY = _mm_andnot_ps(signMask, y);
+		__m128 absZ = _mm_andnot_ps(signMask, z);
+		__m128 largestAbs = _mm_max_ps(_mm_max_ps(absW, absX), _mm_max_ps(absY, absZ));
+		__m128 isW = _mm_cmpeq_ps(absW, largestAbs);
+		__m128 isX = _mm_cmpeq_ps(absX, largestAbs);
+		__m128 isY = _mm_cmpeq_ps(absY, largestAbs);
+		__m128i largest = _mm_set1_epi32(3);
+		largest = Select(_mm_castps_si128(isY), _mm_set1_epi32(2), largest);
+		largest = Select(_mm_castps_si128(isX), _mm_set1_epi32(1), largest);
+		largest = Select(_mm_castps_si128(isW), _mm_setzero_si128(), largest);
+		__m128 largestValue = Select(isW, w, Select(isX, x, Select(isY, y, z)));
+
+		__m128 flip = _mm_and_ps(_mm_cmplt_ps(largestValue, _mm_setzero_ps()), signMask);
+		w = _mm_xor_ps(w, flip);
+		x = _mm_xor_ps(x, flip);
+		y = _mm_xor_ps(y, flip);
+		z = _mm_xor_ps(z, flip);
+
+		// The remaining components in order: a skips w only when w is largest, b is y unless y or z is, and so on.
+		__m128 isFirst = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_setzero_si128()));
+		__m128 belowY = _mm_castsi128_ps(_mm_cmplt_epi32(largest, _mm_set1_epi32(2)));
+		__m128 belowZ = _mm_castsi128_ps(_mm_cmplt_epi32(largest, _mm_set1_epi32(3)));
+		__m128 a = Select(isFirst, x, w);
+		__m128 b = Select(belowY, y, x);
+		__m128 c = Select(belowZ, z, y);
+		__m128i qa = _mm_add_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(a, scale), lowest), highest)), bias);
+		__m128i qb = _mm_add_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(b, scale), lowest), highest)), bias);
+		__m128i qc = _mm_add_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(c, scale), lowest), highest)), bias);
+
+		__m128i word0 = _mm_and_si128(_mm_or_si128(qa, _mm_slli_epi32(qb, 15)), lowWord);
+		__m128i word1 = _mm_and_si128(_mm_or_si128(_mm_srli_epi32(qb, 1), _mm_slli_epi32(qc, 14)), lowWord);
+		__m128i word2 = _mm_or_si128(_mm_srli_epi32(qc, 2), _mm_slli_epi32(largest, 13));
+
+		__m128 r0, r1, r2;
+		InterleaveAoS3(_mm_castsi128_ps(word0), _mm_castsi128_ps(word1), _mm_castsi128_ps(word2), r0, r1, r2);
+		__m128i tail = _mm_castps_si128(r2);
+		_mm_storeu_si128((__m128i*)dest[i].data, Narrow16(_mm_castps_si128(r0), _mm_castps_si128(r1)));
+		_mm_storel_epi64((__m128i*)(dest[i].data + 8), Narrow16(tail, tail));
+	}
+#endif
+	for (; i < count; ++i)
+		dest[i] = PackedQuaternion(src[i]);
+}
+
+void PackedQuaternion::BulkUnpack(Quaternion* dest, const PackedQuaternion* src, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_SSE
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi32(kQUAT_BIAS);
+	const __m128 invScale = _mm_set1_ps(kQUAT_INV_SCALE);
+	for (; i + 4 <= count; i += 4) {
+		const unsigned short* p = src[i].data;
+		__m128i head = _mm_loadu_si128((const __m128i*)p);
+		__m128i tail = _mm_loadl_epi64((const __m128i*)(p + 8));
+		__m128 r0 = _mm_castsi128_ps(_mm_unpacklo_epi16(head, zero));
+		__m128 r1 = _mm_castsi128_ps(_mm_unpackhi_epi16(head, zero));
+		__m128 r2 = _mm_castsi128_ps(_mm_unpacklo_epi16(tail, zero));
+		__m128 w0, w1, w2;
+		DeinterleaveAoS3(r0, r1, r2, w0, w1, w2);
+		__m128i word0 = _mm_castps_si128(w0);
+		__m128i word1 = _mm_castps_si128(w1);
+		__m128i word2 = _mm_castps_si128(w2);
+
+		__m128i qa = _mm_and_si128(word0, _mm_set1_epi32(0x7fff));
+		__m128i qb = _mm_or_si128(_mm_srli_epi32(word0, 15), _mm_slli_epi32(_mm_and_si128(word1, _mm_set1_epi32(0x3fff)), 1));
+		__m128i qc = _mm_or_si128(_mm_srli_epi32(word1, 14), _mm_slli_epi32(_mm_and_si128(word2, _mm_set1_epi32(0x1fff)), 2));
+		__m128i largest = _mm_and_si128(_mm_srli_epi32(word2, 13), _mm_set1_epi32(3));
+
+		__m128 a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(qa, bias)), invScale);
+		__m128 b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(qb, bias)), invScale);
+		__m128 c = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(qc, bias)), invScale);
+		__m128 rest = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(a, a)), _mm_mul_ps(b, b)), _mm_mul_ps(c, c));
+		__m128 d = _mm_sqrt_ps(_mm_max_ps(rest, _mm_setzero_ps()));
+
+		__m128 isW = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, zero));
+		__m128 isX = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(1)));
+		__m128 isY = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(2)));
+		__m128 isZ = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(3)));
+		__m128 belowY = _mm_or_ps(isW, isX);
+		__m128 w = Select(isW, d, a);
+		__m128 x = Select(isW, a, Select(isX, d, b));
+		__m128 y = Select(belowY, b, Select(isY, d, c));
+		__m128 z = Select(isZ, d, c);
+		LaneSSE::StoreAoS4(&dest[i].w, w, x, y, z);
+	}
+#endif
+	for (; i < count; ++i)
+		dest[i] = src[i].ToQuaternion();
+}
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Quaternion.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+// Compact storage formats for vertex streams, animation tracks and anything else that is read far more often than
+// it is written. Each type converts one value at a time through its constructor and To* function, and whole
+// arrays at a time through BulkPack and BulkUnpack, which use SSE2 with MATH_SSE (and F16C for the half formats
+// when the compiler targets AVX2). The bulk functions give the same results as the per-value conversions.
+//
+//   format              bytes (float)   error after a round trip
+//   HalfVector3         6 (12)          relative 2^-11, |x| up to 65504
+//   HalfVector4         8 (16)          relative 2^-11, |x| up to 65504
+//   Snorm16Vector3      6 (12)          absolute 1.6e-5, components clamped to [-1, 1]
+//   OctahedralVector3   4 (12)          unit vectors only, direction within 7e-5 radians
+//   PackedQuaternion    6 (16)          unit quaternions only, components within 1e-4
+
+namespace Math
+{
+
+/// Convert to IEEE 754 half precision bits, rounding to nearest even. Overflow gives infinity; NaN stays NaN.
+unsigned short FloatToHalf(float value);
+/// Convert IEEE 754 half precision bits to float. Exact, including denormals, infinities and NaN.
+float HalfToFloat(unsigned short value);
+
+}
+
+/// Three-dimensional vector of half precision floats.
+class HalfVector3
+{
+public:
+	HalfVector3() : x(0), y(0), z(0) {}
+	explicit HalfVector3(const Vector3& vector) :
+		x(Math::FloatToHalf(vector.x)),
+		y(Math::FloatToHalf(vector.y)),
+		z(Math::FloatToHalf(vector.z))
+	{
+	}
+
+	Vector3 ToVector3() const { return Vector3(Math::HalfToFloat(x), Math::HalfToFloat(y), Math::HalfToFloat(z)); }
+
+	static void BulkPack(HalfVector3* dest, const Vector3* src, unsigned count);
+	static void BulkUnpack(Vector3* dest, const HalfVector3* src, unsigned count);
+
+	unsigned short x, y, z;
+};
+
+/// Four-dimensional vector of half precision floats.
+class HalfVector4
+{
+public:
+	HalfVector4() : x(0), y(0), z(0), w(0) {}
+	explicit HalfVector4(const Vector4& vector) :
+		x(Math::FloatToHalf(vector.x)),
+		y(Math::FloatToHalf(vector.y)),
+		z(Math::FloatToHalf(vector.z)),
+		w(Math::FloatToHalf(vector.w))
+	{
+	}
+
+	Vector4 ToVector4() const
+	{
+		return Vector4(Math::HalfToFloat(x), Math::HalfToFloat(y), Math::HalfToFloat(z), Math::HalfToFloat(w));
+	}
+
+	static void BulkPack(HalfVector4* dest, const Vector4* src, unsigned count);
+	static void BulkUnpack(Vector4* dest, const HalfVector4* src, unsigned count);
+
+	unsigned short x, y, z, w;
+};
+
+/// Three-dimensional vector with components in [-1, 1] stored as signed 16-bit fractions of 32767, the layout
+/// of DXGI_FORMAT_R16G16B16A16_SNORM without the fourth component.
+class Snorm16Vector3
+{
+public:
+	Snorm16Vector3() : x(0), y(0), z(0) {}
+	explicit Snorm16Vector3(const Vector3& vector);
+
+	Vector3 ToVector3() const;
+
+	static void BulkPack(Snorm16Vector3* dest, const Vector3* src, unsigned count);
+	static void BulkUnpack(Vector3* dest, const Snorm16Vector3* src, unsigned count);
+
+	short x, y, z;
+};
+
+/// Unit vector projected onto an octahedron and unfolded into a square, stored as two snorm16 coordinates.
+/// The error is spread evenly over the sphere, unlike a snorm encoding of the components, at a third less size.
+/// The vector does not need to be normalized before packing; zero vectors unpack to Vector3::UP.
+class OctahedralVector3
+{
+public:
+	OctahedralVector3() : x(0), y(0) {}
+	explicit OctahedralVector3(const Vector3& vector);
+
+	/// Return the unit vector.
+	Vector3 ToVector3() const;
+
+	static void BulkPack(OctahedralVector3* dest, const Vector3* src, unsigned count);
+	static void BulkUnpack(Vector3* dest, const OctahedralVector3* src, unsigned count);
+
+	short x, y;
+};
+
+/// Unit quaternion in 48 bits: the index of the largest component in 2 bits, and the other three components,
+/// which lie in [-1 / sqrt(2), 1 / sqrt(2)], in 15 bits each. The largest component is rebuilt from the unit
+/// length. q and -q are the same rotation, so the sign is chosen to make the largest component positive.
+class PackedQuaternion
+{
+public:
+	/// Construct the identity.
+	PackedQuaternion()
+	{
+		data[0] = 0xbfff;
+		data[1] = 0xdfff;
+		data[2] = 0x0fff;
+	}
+	explicit PackedQuaternion(const Quaternion& quat);
+
+	Quaternion ToQuaternion() const;
+
+	static void BulkPack(PackedQuaternion* dest, const Quaternion* src, unsigned count);
+	static void BulkUnpack(Quaternion* dest, const PackedQuaternion* src, unsigned count);
+
+	unsigned short data[3];
+};
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+
+namespace Math
+{
+
+/// Split [0, count) into one contiguous range per thread and call func(begin, end) for each, running the first
+/// range on the calling thread and returning when all are done. Range boundaries are multiples of grain, so the
+/// bulk kernels run at full SIMD width and no two threads write the same cache line of an output stream.
+/// threadCount 0 means one thread per hardware thread. The threads are created for the call; code with a job
+/// system of its own should hand the ranges to it instead.
+template <class F>
+void ParallelFor(unsigned count, unsigned grain, unsigned threadCount, F func)
+{
+	if (!threadCount)
+		threadCount = std::thread::hardware_concurrency();
+	unsigned blocks = (count + grain - 1) / grain;
+	if (threadCount > blocks)
+		threadCount = blocks;
+	if (threadCount <= 1) {
+		func(0u, count);
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(threadCount - 1);
+	for (unsigned t = 1; t < threadCount; ++t) {
+		unsigned begin = (unsigned)((unsigned long long)blocks * t / threadCount) * grain;
+		unsigned end = t + 1 < threadCount ? (unsigned)((unsigned long long)blocks * (t + 1) / threadCount) * grain : count;
+		workers.emplace_back(func, begin, end);
+	}
+	func(0u, (unsigned)((unsigned long long)blocks / threadCount) * grain);
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Vector3.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+/// Plane defined by a normal and the signed distance of the origin, n.p + d = 0. Points on the side the normal
+/// points to have a positive distance.
+class Plane
+{
+public:
+	Plane() : normal(0.0f, 0.0f, 1.0f), d(0.0f) {}
+	Plane(const Vector3& _normal, float _d) : normal(_normal), d(_d) {}
+	Plane(const Vector3& _normal, const Vector3& point) { Define(_normal, point); }
+	Plane(const Vector3& v0, const Vector3& v1, const Vector3& v2) { Define(v0, v1, v2); }
+
+	void Define(const Vector3& _normal, const Vector3& point)
+	{
+		normal = _normal.Normalized();
+		d = -normal.Dot(point);
+	}
+
+	/// Define from three points in counter-clockwise order when seen from the positive side.
+	void Define(const Vector3& v0, const Vector3& v1, const Vector3& v2)
+	{
+		Define((v1 - v0).Cross(v2 - v0), v0);
+	}
+
+	/// Define from (a, b, c, d) plane equation coefficients and normalize them.
+	void Define(float a, float b, float c, float _d)
+	{
+		float invLen = 1.0f / sqrtf(a * a + b * b + c * c);
+		normal = Vector3(a * invLen, b * invLen, c * invLen);
+		d = _d * invLen;
+	}
+
+	float Distance(const Vector3& point) const { return normal.Dot(point) + d; }
+
+	Vector3 Project(const Vector3& point) const { return point - normal * Distance(point); }
+
+	Vector3 normal;
+	float   d;
+};
+
+MATH_CONTRACT_OFF_END
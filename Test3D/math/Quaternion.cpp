@@ -1,13 +1,20 @@
 #include "Quaternion.h"
 
-const Quaternion Quaternion::IDENTITY;
+MATH_CONTRACT_OFF_BEGIN
+
+#if !defined(MATH_SSE) || defined(MATH_HAS_CONSTANT_EVALUATED)
+// Half turn around UP, exact in float.
+static_assert(Quaternion(0.0f, 0.0f, 0.0f, 1.0f) * Vector3::RIGHT == Vector3::LEFT, "Quaternion rotation");
+static_assert(Quaternion(0.0f, 0.0f, 0.0f, 1.0f) * Quaternion(0.0f, 0.0f, 0.0f, 1.0f) == -Quaternion::IDENTITY, "Quaternion product");
+static_assert(Quaternion(0.0f, 0.0f, 0.0f, 1.0f).Inverse() == Quaternion(0.0f, 0.0f, 0.0f, 1.0f).Conjugate() &&
+	Quaternion::IDENTITY.Dot(Quaternion::IDENTITY) == 1.0f, "Quaternion inverse");
+#endif
 
 void Quaternion::FromAngleAxis(float angle, const Vector3& axis)
 {
 	Vector3 normAxis = axis.Normalized();
-	angle *= Math::kDEG2RAD_2;
-	float sinAngle = sinf(angle);
-	float cosAngle = cosf(angle);
+	float sinAngle, cosAngle;
+	Math::Policy::SinCos(angle * Math::kDEG2RAD_2, sinAngle, cosAngle);
 
 	w = cosAngle;
 	x = normAxis.x * sinAngle;
@@ -18,20 +25,15 @@ void Quaternion::FromAngleAxis(float angle, const Vector3& axis)
 void Quaternion::FromEulerAngles(float x, float y, float z)
 {
 	// Order of rotations: Z first, then X, then Y (mimics typical FPS camera with gimbal lock at top/bottom)
-	x *= Math::kDEG2RAD_2;
-	y *= Math::kDEG2RAD_2;
-	z *= Math::kDEG2RAD_2;
-	float sinX = sinf(x);
-	float cosX = cosf(x);
-	float sinY = sinf(y);
-	float cosY = cosf(y);
-	float sinZ = sinf(z);
-	float cosZ = cosf(z);
+	float sinX, cosX, sinY, cosY, sinZ, cosZ;
+	Math::Policy::SinCos(x * Math::kDEG2RAD_2, sinX, cosX);
+	Math::Policy::SinCos(y * Math::kDEG2RAD_2, sinY, cosY);
+	Math::Policy::SinCos(z * Math::kDEG2RAD_2, sinZ, cosZ);
 
 	w = cosY * cosX * cosZ + sinY * sinX * sinZ;
-	x = cosY * sinX * cosZ + sinY * cosX * sinZ;
-	y = sinY * cosX * cosZ - cosY * sinX * sinZ;
-	z = cosY * cosX * sinZ - sinY * sinX * cosZ;
+	this->x = cosY * sinX * cosZ + sinY * cosX * sinZ;
+	this->y = sinY * cosX * cosZ - cosY * sinX * sinZ;
+	this->z = cosY * cosX * sinZ - sinY * sinX * cosZ;
 }
 
 void Quaternion::FromRotationTo(const Vector3& start, const Vector3& end)
@@ -144,21 +146,21 @@ Vector3 Quaternion::EulerAngles() const
 		return Vector3(
 			-90.0f,
 			0.0f,
-			-atan2f(2.0f * (x * z - w * y), 1.0f - 2.0f * (y * y + z * z)) * Math::kRAD2DEG
+			-Math::Policy::Atan2(2.0f * (x * z - w * y), 1.0f - 2.0f * (y * y + z * z)) * Math::kRAD2DEG
 			);
 	}
 	else if (check > 0.995f) {
 		return Vector3(
 			90.0f,
 			0.0f,
-			atan2f(2.0f * (x * z - w * y), 1.0f - 2.0f * (y * y + z * z)) * Math::kRAD2DEG
+			Math::Policy::Atan2(2.0f * (x * z - w * y), 1.0f - 2.0f * (y * y + z * z)) * Math::kRAD2DEG
 			);
 	}
 	else {
 		return Vector3(
-			asinf(check) * Math::kRAD2DEG,
-			atan2f(2.0f * (x * z + w * y), 1.0f - 2.0f * (x * x + y * y)) * Math::kRAD2DEG,
-			atan2f(2.0f * (x * y + w * z), 1.0f - 2.0f * (x * x + z * z)) * Math::kRAD2DEG
+			Math::Policy::Asin(check) * Math::kRAD2DEG,
+			Math::Policy::Atan2(2.0f * (x * z + w * y), 1.0f - 2.0f * (x * x + y * y)) * Math::kRAD2DEG,
+			Math::Policy::Atan2(2.0f * (x * y + w * z), 1.0f - 2.0f * (x * x + z * z)) * Math::kRAD2DEG
 			);
 	}
 }
@@ -234,14 +236,14 @@ Quaternion Quaternion::Slerp(Quaternion rhs, float t) const
 		rhs = -rhs;
 	}
 
-	float angle = acosf(cosAngle);
-	float sinAngle = sinf(angle);
+	float angle = Math::Policy::Acos(cosAngle);
+	float sinAngle = Math::Policy::Sin(angle);
 	float t1, t2;
 
 	if (sinAngle > 0.001f) {
 		float invSinAngle = 1.0f / sinAngle;
-		t1 = sinf((1.0f - t) * angle) * invSinAngle;
-		t2 = sinf(t * angle) * invSinAngle;
+		t1 = Math::Policy::Sin((1.0f - t) * angle) * invSinAngle;
+		t2 = Math::Policy::Sin(t * angle) * invSinAngle;
 	}
 	else {
 		t1 = 1.0f - t;
@@ -263,3 +265,5 @@ Quaternion Quaternion::Nlerp(Quaternion rhs, float t, bool shortestPath) const
 	result.Normalize();
 	return result;
 }
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,170 @@
+#include "Quaternion.h"
+#include "SimdLane.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+// Bulk quaternion blending.
+//
+// The quaternions are loaded four (SSE) or eight (AVX2) at a time and transposed to one register per component,
+// so every pair is blended without a branch: the shortest-arc flip and the small-angle fallback of Slerp are
+// both lane selects.
+
+namespace
+{
+
+enum BlendMode
+{
+	BLEND_SLERP,
+	BLEND_SLERP_FAST,
+	BLEND_NLERP,
+};
+
+/// acos(x) for x in [0, 1]. Abramowitz & Stegun 4.4.46, absolute error below 2e-8.
+template <class L>
+typename L::Type AcosPositive(typename L::Type x)
+{
+	typename L::Type p = L::Set(-0.0012624911f);
+	p = L::Add(L::Mul(p, x), L::Set(0.0066700901f));
+	p = L::Add(L::Mul(p, x), L::Set(-0.0170881256f));
+	p = L::Add(L::Mul(p, x), L::Set(0.0308918810f));
+	p = L::Add(L::Mul(p, x), L::Set(-0.0501743046f));
+	p = L::Add(L::Mul(p, x), L::Set(0.0889789874f));
+	p = L::Add(L::Mul(p, x), L::Set(-0.2145988016f));
+	p = L::Add(L::Mul(p, x), L::Set(1.5707963050f));
+	return L::Mul(p, L::Sqrt(L::Sub(L::Set(1.0f), x)));
+}
+
+/// sin(x) for x in [0, pi/2]. Taylor series to x^11, absolute error below 6e-8.
+template <class L>
+typename L::Type SinHalfPi(typename L::Type x)
+{
+	typename L::Type x2 = L::Mul(x, x);
+	typename L::Type p = L::Set(-2.5052108e-8f);
+	p = L::Add(L::Mul(p, x2), L::Set(2.7557319e-6f));
+	p = L::Add(L::Mul(p, x2), L::Set(-1.9841270e-4f));
+	p = L::Add(L::Mul(p, x2), L::Set(8.3333333e-3f));
+	p = L::Add(L::Mul(p, x2), L::Set(-1.6666667e-1f));
+	return L::Add(x, L::Mul(L::Mul(p, x2), x));
+}
+
+template <class L, BlendMode Mode, bool SharedT>
+unsigned Blend(float* dest, const float* lhs, const float* rhs, const float* weights, unsigned i, unsigned count)
+{
+	typedef typename L::Type V;
+	const V zero = L::Set(0.0f);
+	const V one = L::Set(1.0f);
+	const V half = L::Set(0.5f);
+	const V shared = SharedT ? L::Set(*weights) : zero;
+
+	for (; i + L::Width <= count; i += L::Width) {
+		V aw, ax, ay, az;
+		V bw, bx, by, bz;
+		L::LoadAoS4(lhs + i * 4, aw, ax, ay, az);
+		L::LoadAoS4(rhs + i * 4, bw, bx, by, bz);
+		V t = SharedT ? shared : L::Load(weights + i);
+
+		V d = L::Add(L::Add(L::Mul(aw, bw), L::Mul(ax, bx)), L::Add(L::Mul(ay, by), L::Mul(az, bz)));
+		typename L::Mask flip = L::CmpLt(d, zero);
+		V cosAngle = L::Min(L::Abs(d), one);
+
+		V w0, w1;
+		if (Mode == BLEND_SLERP) {
+			V angle = AcosPositive<L>(cosAngle);
+			V sinAngle = L::Sqrt(L::Sub(one, L::Mul(cosAngle, cosAngle)));
+			// Same threshold as Quaternion::Slerp: fall back to a plain lerp when the angle is tiny.
+			typename L::Mask small = L::CmpLe(sinAngle, L::Set(0.001f));
+			V invSin = L::Div(one, L::Select(small, one, sinAngle));
+			w0 = L::Mul(SinHalfPi<L>(L::Mul(L::Sub(one, t), angle)), invSin);
+			w1 = L::Mul(SinHalfPi<L>(L::Mul(t, angle)), invSin);
+			w0 = L::Select(small, L::Sub(one, t), w0);
+			w1 = L::Select(small, t, w1);
+		}
+		else if (Mode == BLEND_SLERP_FAST) {
+			// Correct t so that the nlerp follows the arc at constant speed. The cubic in t vanishes at
+			// 0, 0.5 and 1; its strength is a polynomial fit over the cosine of the angle.
+			V a = L::Add(L::Set(3.55645f), L::Mul(cosAngle, L::Set(-1.43519f)));
+			a = L::Add(L::Set(-3.2452f), L::Mul(cosAngle, a));
+			a = L::Add(L::Set(1.0904f), L::Mul(cosAngle, a));
+			V b = L::Add(L::Set(-1.06021f), L::Mul(cosAngle, L::Set(0.215638f)));
+			b = L::Add(L::Set(0.848013f), L::Mul(cosAngle, b));
+			V tc = L::Sub(t, half);
+			V k = L::Add(L::Mul(L::Mul(a, tc), tc), b);
+			V ot = L::Add(t, L::Mul(L::Mul(L::Mul(t, tc), L::Sub(t, one)), k));
+			w0 = L::Sub(one, ot);
+			w1 = ot;
+		}
+		else {
+			w0 = L::Sub(one, t);
+			w1 = t;
+		}
+		w1 = L::Select(flip, L::Sub(zero, w1), w1);
+
+		V rw = L::Add(L::Mul(aw, w0), L::Mul(bw, w1));
+		V rx = L::Add(L::Mul(ax, w0), L::Mul(bx, w1));
+		V ry = L::Add(L::Mul(ay, w0), L::Mul(by, w1));
+		V rz = L::Add(L::Mul(az, w0), L::Mul(bz, w1));
+
+		if (Mode != BLEND_SLERP) {
+			V len = L::Add(L::Add(L::Mul(rw, rw), L::Mul(rx, rx)), L::Add(L::Mul(ry, ry), L::Mul(rz, rz)));
+			V invLen = L::RSqrt(len);
+			rw = L::Mul(rw, invLen);
+			rx = L::Mul(rx, invLen);
+			ry = L::Mul(ry, invLen);
+			rz = L::Mul(rz, invLen);
+		}
+
+		L::StoreAoS4(dest + i * 4, rw, rx, ry, rz);
+	}
+	return i;
+}
+
+template <BlendMode Mode, bool SharedT>
+void BulkBlend(Quaternion* dest, const Quaternion* lhs, const Quaternion* rhs, const float* weights, unsigned count)
+{
+	float* d = &dest->w;
+	const float* a = lhs->Data();
+	const float* b = rhs->Data();
+
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = Blend<LaneAVX, Mode, SharedT>(d, a, b, weights, i, count);
+#endif
+#ifdef MATH_SSE
+	i = Blend<LaneSSE, Mode, SharedT>(d, a, b, weights, i, count);
+#endif
+	Blend<LaneScalar, Mode, SharedT>(d, a, b, weights, i, count);
+}
+
+}
+
+void Quaternion::BulkSlerp(Quaternion* dest, const Quaternion* lhs, const Quaternion* rhs, const float* t, unsigned count)
+{
+	BulkBlend<BLEND_SLERP, false>(dest, lhs, rhs, t, count);
+}
+
+void Quaternion::BulkSlerp(Quaternion* dest, const Quaternion* lhs, const Quaternion* rhs, float t, unsigned count)
+{
+	BulkBlend<BLEND_SLERP, true>(dest, lhs, rhs, &t, count);
+}
+
+void Quaternion::BulkSlerpFast(Quaternion* dest, const Quaternion* lhs, const Quaternion* rhs, const float* t, unsigned count)
+{
+	BulkBlend<BLEND_SLERP_FAST, false>(dest, lhs, rhs, t, count);
+}
+
+void Quaternion::BulkSlerpFast(Quaternion* dest, const Quaternion* lhs, const Quaternion* rhs, float t, unsigned count)
+{
+	BulkBlend<BLEND_SLERP_FAST, true>(dest, lhs, rhs, &t, count);
+}
+
+void Quaternion::BulkNlerp(Quaternion* dest, const Quaternion* lhs, const Quaternion* rhs, const float* t, unsigned count)
+{
+	BulkBlend<BLEND_NLERP, false>(dest, lhs, rhs, t, count);
+}
+
+void Quaternion::BulkNlerp(Quaternion* dest, const Quaternion* lhs, const Quaternion* rhs, float t, unsigned count)
+{
+	BulkBlend<BLEND_NLERP, true>(dest, lhs, rhs, &t, count);
+}
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,235 @@
+#include "Ray.h"
+#include "SimdLane.h"
+
+#include <assert.h>
+
+MATH_CONTRACT_OFF_BEGIN
+
+// Packet ray casting kernels.
+//
+// Every lane is a ray of the packet; the box or triangle is broadcast to all of them. The kernels evaluate the
+// same expressions in the same order as the single ray functions in Ray.h, so the SIMD loops, the scalar tail and
+// Ray::HitDistance agree bit for bit as long as the compiler does not contract the scalar code into FMA.
+
+namespace
+{
+
+/// Entry and exit distances of the rays through the slab [lo, hi] along one axis.
+template <class L>
+void Slab(typename L::Type origin, typename L::Type invDirection, float lo, float hi, typename L::Type& tNear,
+	typename L::Type& tFar)
+{
+	typename L::Type t1 = L::Mul(L::Sub(L::Set(lo), origin), invDirection);
+	typename L::Type t2 = L::Mul(L::Sub(L::Set(hi), origin), invDirection);
+	tNear = L::Min(t1, t2);
+	tFar = L::Max(t1, t2);
+}
+
+template <class L>
+unsigned HitBoxKernel(const RayPacket& rays, const BoundingBox& box, float maxDistance, float* distances,
+	unsigned& hits, unsigned i, unsigned end)
+{
+	typedef typename L::Type T;
+	const T zero = L::Set(0.0f);
+	const T noHit = L::Set(FLT_MAX);
+	const T maxDist = L::Set(maxDistance);
+
+	for (; i + L::Width <= end; i += L::Width) {
+		T tMin, tMax, tNear, tFar;
+		Slab<L>(L::Load(rays.originX + i), L::Load(rays.invDirectionX + i), box.minimum.x, box.maximum.x, tMin, tMax);
+		Slab<L>(L::Load(rays.originY + i), L::Load(rays.invDirectionY + i), box.minimum.y, box.maximum.y, tNear, tFar);
+		tMin = L::Max(tMin, tNear);
+		tMax = L::Min(tMax, tFar);
+		Slab<L>(L::Load(rays.originZ + i), L::Load(rays.invDirectionZ + i), box.minimum.z, box.maximum.z, tNear, tFar);
+		tMin = L::Max(tMin, tNear);
+		tMax = L::Min(tMax, tFar);
+
+		T distance = L::Max(tMin, zero);
+		typename L::Mask hit = L::And(L::And(L::CmpGe(tMax, zero), L::CmpLe(tMin, tMax)), L::CmpLe(distance, maxDist));
+		L::Store(distances + i, L::Select(hit, distance, noHit));
+		hits |= (unsigned)L::MoveMask(hit) << i;
+	}
+	return i;
+}
+
+/// One triangle broadcast to every lane.
+template <class L>
+struct TriangleLanes
+{
+	typedef typename L::Type T;
+
+	TriangleLanes(const Vector3& v0, const Vector3& v1, const Vector3& v2)
+	{
+		Vector3 edge1 = v1 - v0;
+		Vector3 edge2 = v2 - v0;
+		x0 = L::Set(v0.x);
+		y0 = L::Set(v0.y);
+		z0 = L::Set(v0.z);
+		e1x = L::Set(edge1.x);
+		e1y = L::Set(edge1.y);
+		e1z = L::Set(edge1.z);
+		e2x = L::Set(edge2.x);
+		e2y = L::Set(edge2.y);
+		e2z = L::Set(edge2.z);
+	}
+
+	/// Moller-Trumbore for the rays starting at element i: return the hit mask and the distances in t.
+	typename L::Mask Hit(const RayPacket& rays, unsigned i, T& t) const
+	{
+		const T zero = L::Set(0.0f);
+		const T one = L::Set(1.0f);
+		T dx = L::Load(rays.directionX + i);
+		T dy = L::Load(rays.directionY + i);
+		T dz = L::Load(rays.directionZ + i);
+
+		// p = direction x edge2
+		T px = L::Sub(L::Mul(dy, e2z), L::Mul(dz, e2y));
+		T py = L::Sub(L::Mul(dz, e2x), L::Mul(dx, e2z));
+		T pz = L::Sub(L::Mul(dx, e2y), L::Mul(dy, e2x));
+		T invDet = L::Div(one, L::Add(L::Add(L::Mul(e1x, px), L::Mul(e1y, py)), L::Mul(e1z, pz)));
+
+		T sx = L::Sub(L::Load(rays.originX + i), x0);
+		T sy = L::Sub(L::Load(rays.originY + i), y0);
+		T sz = L::Sub(L::Load(rays.originZ + i), z0);
+		T u = L::Mul(L::Add(L::Add(L::Mul(sx, px), L::Mul(sy, py)), L::Mul(sz, pz)), invDet);
+
+		// q = s x edge1
+		T qx = L::Sub(L::Mul(sy, e1z), L::Mul(sz, e1y));
+		T qy = L::Sub(L::Mul(sz, e1x), L::Mul(sx, e1z));
+		T qz = L::Sub(L::Mul(sx, e1y), L::Mul(sy, e1x));
+		T v = L::Mul(L::Add(L::Add(L::Mul(dx, qx), L::Mul(dy, qy)), L::Mul(dz, qz)), invDet);
+		t = L::Mul(L::Add(L::Add(L::Mul(e2x, qx), L::Mul(e2y, qy)), L::Mul(e2z, qz)), invDet);
+
+		return L::And(L::And(L::CmpGe(u, zero), L::CmpGe(v, zero)), L::And(L::CmpLe(L::Add(u, v), one), L::CmpGe(t, zero)));
+	}
+
+	T x0, y0, z0;
+	T e1x, e1y, e1z;
+	T e2x, e2y, e2z;
+};
+
+template <class L>
+unsigned HitTriangleKernel(const RayPacket& rays, const TriangleLanes<L>& triangle, float* distances, unsigned& hits,
+	unsigned i, unsigned end)
+{
+	const typename L::Type noHit = L::Set(FLT_MAX);
+
+	for (; i + L::Width <= end; i += L::Width) {
+		typename L::Type t;
+		typename L::Mask hit = triangle.Hit(rays, i, t);
+		L::Store(distances + i, L::Select(hit, t, noHit));
+		hits |= (unsigned)L::MoveMask(hit) << i;
+	}
+	return i;
+}
+
+template <class L>
+unsigned HitMeshKernel(const RayPacket& rays, const Vector3* vertices, const unsigned* indices, unsigned triangleCount,
+	float* distances, unsigned* triangles, unsigned& hits, unsigned i, unsigned end)
+{
+	typedef typename L::Type T;
+
+	for (; i + L::Width <= end; i += L::Width) {
+		T closest = L::Load(distances + i);
+		unsigned closer = 0;
+		for (unsigned k = 0; k < triangleCount; ++k) {
+			TriangleLanes<L> triangle(vertices[indices[k * 3]], vertices[indices[k * 3 + 1]], vertices[indices[k * 3 + 2]]);
+			T t;
+			typename L::Mask hit = triangle.Hit(rays, i, t);
+			hit = L::And(hit, L::CmpLt(t, closest));
+			int mask = L::MoveMask(hit);
+			if (!mask)
+				continue;
+
+			// Hits are rare next to the tests, so the triangle indices are updated one ray at a time.
+			closest = L::Select(hit, t, closest);
+			for (unsigned j = 0; j < L::Width; ++j) {
+				if (mask & (1 << j))
+					triangles[i + j] = k;
+			}
+			closer |= mask;
+		}
+		L::Store(distances + i, closest);
+		hits |= closer << i;
+	}
+	return i;
+}
+
+}
+
+float Ray::HitDistance(const Vector3* vertices, const unsigned* indices, unsigned triangleCount, unsigned* triangle) const
+{
+	float closest = FLT_MAX;
+	for (unsigned k = 0; k < triangleCount; ++k) {
+		float distance = HitDistance(vertices[indices[k * 3]], vertices[indices[k * 3 + 1]], vertices[indices[k * 3 + 2]]);
+		if (distance < closest) {
+			closest = distance;
+			if (triangle)
+				*triangle = k;
+		}
+	}
+	return closest;
+}
+
+void RayPacket::Define(const Ray* rays, unsigned _count)
+{
+	assert(_count <= MAX_RAYS);
+	count = _count;
+	for (unsigned i = 0; i < count; ++i) {
+		const Ray& ray = rays[i];
+		originX[i] = ray.origin.x;
+		originY[i] = ray.origin.y;
+		originZ[i] = ray.origin.z;
+		directionX[i] = ray.direction.x;
+		directionY[i] = ray.direction.y;
+		directionZ[i] = ray.direction.z;
+		invDirectionX[i] = 1.0f / ray.direction.x;
+		invDirectionY[i] = 1.0f / ray.direction.y;
+		invDirectionZ[i] = 1.0f / ray.direction.z;
+	}
+}
+
+unsigned RayPacket::HitDistance(const BoundingBox& box, float* distances, float maxDistance) const
+{
+	unsigned hits = 0;
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = HitBoxKernel<LaneAVX>(*this, box, maxDistance, distances, hits, i, count);
+#endif
+#ifdef MATH_SSE
+	i = HitBoxKernel<LaneSSE>(*this, box, maxDistance, distances, hits, i, count);
+#endif
+	HitBoxKernel<LaneScalar>(*this, box, maxDistance, distances, hits, i, count);
+	return hits;
+}
+
+unsigned RayPacket::HitDistance(const Vector3& v0, const Vector3& v1, const Vector3& v2, float* distances) const
+{
+	unsigned hits = 0;
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = HitTriangleKernel<LaneAVX>(*this, TriangleLanes<LaneAVX>(v0, v1, v2), distances, hits, i, count);
+#endif
+#ifdef MATH_SSE
+	i = HitTriangleKernel<LaneSSE>(*this, TriangleLanes<LaneSSE>(v0, v1, v2), distances, hits, i, count);
+#endif
+	HitTriangleKernel<LaneScalar>(*this, TriangleLanes<LaneScalar>(v0, v1, v2), distances, hits, i, count);
+	return hits;
+}
+
+unsigned RayPacket::HitDistance(const Vector3* vertices, const unsigned* indices, unsigned triangleCount,
+	float* distances, unsigned* triangles) const
+{
+	unsigned hits = 0;
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = HitMeshKernel<LaneAVX>(*this, vertices, indices, triangleCount, distances, triangles, hits, i, count);
+#endif
+#ifdef MATH_SSE
+	i = HitMeshKernel<LaneSSE>(*this, vertices, indices, triangleCount, distances, triangles, hits, i, count);
+#endif
+	HitMeshKernel<LaneScalar>(*this, vertices, indices, triangleCount, distances, triangles, hits, i, count);
+	return hits;
+}
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "BoundingBox.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+/// Infinite straight line in one direction.
+class Ray
+{
+public:
+	Ray() : origin(Vector3::ZERO), direction(Vector3::FORWARD) {}
+	/// Construct from an origin and a direction, which is normalized.
+	Ray(const Vector3& _origin, const Vector3& _direction) : origin(_origin), direction(_direction.Normalized()) {}
+
+	Vector3 Point(float distance) const { return origin + direction * distance; }
+
+	/// Return the distance along the ray at which it enters the box, 0 if the origin is inside, or FLT_MAX on a miss.
+	float HitDistance(const BoundingBox& box) const
+	{
+		// Slab test. Division by a zero direction component gives +-infinity, which the min/max handle.
+		Vector3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+		float t1 = (box.minimum.x - origin.x) * invDir.x;
+		float t2 = (box.maximum.x - origin.x) * invDir.x;
+		float tMin = Math::Min(t1, t2);
+		float tMax = Math::Max(t1, t2);
+		t1 = (box.minimum.y - origin.y) * invDir.y;
+		t2 = (box.maximum.y - origin.y) * invDir.y;
+		tMin = Math::Max(tMin, Math::Min(t1, t2));
+		tMax = Math::Min(tMax, Math::Max(t1, t2));
+		t1 = (box.minimum.z - origin.z) * invDir.z;
+		t2 = (box.maximum.z - origin.z) * invDir.z;
+		tMin = Math::Max(tMin, Math::Min(t1, t2));
+		tMax = Math::Min(tMax, Math::Max(t1, t2));
+
+		if (tMax < 0.0f || tMin > tMax)
+			return FLT_MAX;
+		return Math::Max(tMin, 0.0f);
+	}
+
+	/// Return the distance along the ray to the triangle, hit from either side, or FLT_MAX on a miss.
+	float HitDistance(const Vector3& v0, const Vector3& v1, const Vector3& v2) const
+	{
+		// Moller-Trumbore: solve origin + t * direction = v0 + u * edge1 + v * edge2 by Cramer's rule. A ray parallel
+		// to the triangle divides by a zero determinant, and the infinite or NaN coordinates fail the tests below.
+		Vector3 edge1 = v1 - v0;
+		Vector3 edge2 = v2 - v0;
+		Vector3 p = direction.Cross(edge2);
+		float invDet = 1.0f / edge1.Dot(p);
+		Vector3 s = origin - v0;
+		float u = s.Dot(p) * invDet;
+		Vector3 q = s.Cross(edge1);
+		float v = direction.Dot(q) * invDet;
+		float t = edge2.Dot(q) * invDet;
+
+		if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f)
+			return t;
+		return FLT_MAX;
+	}
+
+	/// Return the distance to the closest of triangleCount triangles given as three vertex indices each, or FLT_MAX
+	/// on a miss. The index of the triangle hit is written to triangle when given.
+	float HitDistance(const Vector3* vertices, const unsigned* indices, unsigned triangleCount, unsigned* triangle = nullptr) const;
+
+	Vector3 origin;
+	Vector3 direction;
+};
+
+/// Up to MAX_RAYS rays in structure-of-arrays form, cast together.
+///
+/// A packet loads each box or triangle once for all of its rays and tests them four (SSE) or eight (AVX2) at a
+/// time; packets of fewer rays, or the rays left over by the SIMD width, take the scalar path. The results match
+/// casting every ray on its own with Ray::HitDistance. Coherent rays, such as neighbouring pixels or the rays of
+/// one occlusion probe, make the best packets because they tend to hit the same things.
+class RayPacket
+{
+public:
+	static const unsigned MAX_RAYS = 8;
+
+	RayPacket() : count(0) {}
+	/// Define from count rays, at most MAX_RAYS.
+	void Define(const Ray* rays, unsigned count);
+
+	/// Write the distance at which each ray enters the box to distances, 0 if its origin is inside, or FLT_MAX on
+	/// a miss or beyond maxDistance. Return a mask with bit i set if ray i hits.
+	unsigned HitDistance(const BoundingBox& box, float* distances, float maxDistance = FLT_MAX) const;
+	/// Write the distance along each ray to the triangle, hit from either side, to distances, or FLT_MAX on a
+	/// miss. Return a mask with bit i set if ray i hits.
+	unsigned HitDistance(const Vector3& v0, const Vector3& v1, const Vector3& v2, float* distances) const;
+	/// Find the closest of triangleCount triangles given as three vertex indices each along every ray. distances
+	/// holds the maximum distance of each ray on input and the closest hit distance on output; the index of the
+	/// triangle hit is written to triangles, which is left alone for rays that hit nothing. Return a mask with
+	/// bit i set if ray i hits.
+	unsigned HitDistance(const Vector3* vertices, const unsigned* indices, unsigned triangleCount, float* distances,
+		unsigned* triangles) const;
+
+	float    originX[MAX_RAYS];
+	float    originY[MAX_RAYS];
+	float    originZ[MAX_RAYS];
+	float    directionX[MAX_RAYS];
+	float    directionY[MAX_RAYS];
+	float    directionZ[MAX_RAYS];
+	/// Reciprocals of the direction components for the slab test.
+	float    invDirectionX[MAX_RAYS];
+	float    invDirectionY[MAX_RAYS];
+	float    invDirectionZ[MAX_RAYS];
+	unsigned count;
+};
+
+MATH_CONTRACT_OFF_END
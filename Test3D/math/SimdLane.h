@@ -0,0 +1,245 @@
+#pragma once
+
+#include "Math.h"
+
+#ifdef MATH_SSE
+#include <emmintrin.h>
+#endif
+#ifdef MATH_AVX2
+#include <immintrin.h>
+#endif
+
+MATH_CONTRACT_OFF_BEGIN
+
+// Lane abstractions for the bulk kernels in math/.
+//
+// A kernel is written once as a template over a lane type and instantiated for AVX2 (8 floats), SSE2 (4 floats)
+// and plain floats. Every lane type exposes the same operations, evaluated in the same order, so the narrower
+// instantiations can process the remainder of a stream left over by the wider ones.
+// Mask is the result of a comparison and is only consumed by And/Or/Select/MoveMask.
+
+struct LaneScalar
+{
+	typedef float Type;
+	typedef bool  Mask;
+	static const unsigned Width = 1;
+
+	static Type Set(float v)                        { return v; }
+	static Type Load(const float* p)                { return *p; }
+	static void Store(float* p, Type v)             { *p = v; }
+
+	static Type Add(Type lhs, Type rhs)             { return lhs + rhs; }
+	static Type Sub(Type lhs, Type rhs)             { return lhs - rhs; }
+	static Type Mul(Type lhs, Type rhs)             { return lhs * rhs; }
+	static Type Div(Type lhs, Type rhs)             { return lhs / rhs; }
+	static Type Min(Type lhs, Type rhs)             { return lhs < rhs ? lhs : rhs; }
+	static Type Max(Type lhs, Type rhs)             { return lhs > rhs ? lhs : rhs; }
+	static Type Abs(Type v)                         { return fabsf(v); }
+	static Type Sqrt(Type v)                        { return sqrtf(v); }
+	static Type RSqrt(Type v)
+	{
+#if defined(MATH_SSE) && !defined(MATH_DETERMINISTIC)
+		// The estimate and Newton-Raphson step of the SIMD lanes, so that the remainder of a stream matches them.
+		float e = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(v)));
+		float e3 = (e * e) * e;
+		return e + 0.5f * (e - v * e3);
+#else
+		return 1.0f / sqrtf(v);
+#endif
+	}
+
+	static Mask CmpLt(Type lhs, Type rhs)           { return lhs < rhs; }
+	static Mask CmpLe(Type lhs, Type rhs)           { return lhs <= rhs; }
+	static Mask CmpGt(Type lhs, Type rhs)           { return lhs > rhs; }
+	static Mask CmpGe(Type lhs, Type rhs)           { return lhs >= rhs; }
+	static Mask And(Mask lhs, Mask rhs)             { return lhs && rhs; }
+	static Mask Or(Mask lhs, Mask rhs)              { return lhs || rhs; }
+	/// Return onTrue where mask is set, otherwise onFalse.
+	static Type Select(Mask mask, Type onTrue, Type onFalse) { return mask ? onTrue : onFalse; }
+	/// Return one bit per lane, lane 0 in the lowest bit.
+	static int  MoveMask(Mask mask)                 { return mask ? 1 : 0; }
+
+	/// Load Width records of four floats and return them component-wise.
+	static void LoadAoS4(const float* p, Type& a, Type& b, Type& c, Type& d)
+	{
+		a = p[0];
+		b = p[1];
+		c = p[2];
+		d = p[3];
+	}
+	/// Store component-wise values as Width records of four floats.
+	static void StoreAoS4(float* p, Type a, Type b, Type c, Type d)
+	{
+		p[0] = a;
+		p[1] = b;
+		p[2] = c;
+		p[3] = d;
+	}
+	/// Load one record of four floats from each of Width addresses and return them component-wise.
+	static void GatherAoS4(const float* const* p, Type& a, Type& b, Type& c, Type& d)
+	{
+		LoadAoS4(p[0], a, b, c, d);
+	}
+	/// Store component-wise values as one record of four floats to each of Width addresses.
+	static void ScatterAoS4(float* const* p, Type a, Type b, Type c, Type d)
+	{
+		StoreAoS4(p[0], a, b, c, d);
+	}
+};
+
+#ifdef MATH_SSE
+struct LaneSSE
+{
+	typedef __m128 Type;
+	typedef __m128 Mask;
+	static const unsigned Width = 4;
+
+	static Type Set(float v)                        { return _mm_set1_ps(v); }
+	static Type Load(const float* p)                { return _mm_loadu_ps(p); }
+	static void Store(float* p, Type v)             { _mm_storeu_ps(p, v); }
+
+	static Type Add(Type lhs, Type rhs)             { return _mm_add_ps(lhs, rhs); }
+	static Type Sub(Type lhs, Type rhs)             { return _mm_sub_ps(lhs, rhs); }
+	static Type Mul(Type lhs, Type rhs)             { return _mm_mul_ps(lhs, rhs); }
+	static Type Div(Type lhs, Type rhs)             { return _mm_div_ps(lhs, rhs); }
+	static Type Min(Type lhs, Type rhs)             { return _mm_min_ps(lhs, rhs); }
+	static Type Max(Type lhs, Type rhs)             { return _mm_max_ps(lhs, rhs); }
+	static Type Abs(Type v)                         { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+	static Type Sqrt(Type v)                        { return _mm_sqrt_ps(v); }
+	static Type RSqrt(Type v)
+	{
+#ifdef MATH_DETERMINISTIC
+		// The hardware estimate differs between processor vendors.
+		return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(v));
+#else
+		// Hardware estimate refined with one Newton-Raphson step.
+		__m128 e = _mm_rsqrt_ps(v);
+		__m128 e3 = _mm_mul_ps(_mm_mul_ps(e, e), e);
+		return _mm_add_ps(e, _mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(e, _mm_mul_ps(v, e3))));
+#endif
+	}
+
+	static Mask CmpLt(Type lhs, Type rhs)           { return _mm_cmplt_ps(lhs, rhs); }
+	static Mask CmpLe(Type lhs, Type rhs)           { return _mm_cmple_ps(lhs, rhs); }
+	static Mask CmpGt(Type lhs, Type rhs)           { return _mm_cmpgt_ps(lhs, rhs); }
+	static Mask CmpGe(Type lhs, Type rhs)           { return _mm_cmpge_ps(lhs, rhs); }
+	static Mask And(Mask lhs, Mask rhs)             { return _mm_and_ps(lhs, rhs); }
+	static Mask Or(Mask lhs, Mask rhs)              { return _mm_or_ps(lhs, rhs); }
+	static Type Select(Mask mask, Type onTrue, Type onFalse)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, onTrue), _mm_andnot_ps(mask, onFalse));
+	}
+	static int  MoveMask(Mask mask)                 { return _mm_movemask_ps(mask); }
+
+	static void LoadAoS4(const float* p, Type& a, Type& b, Type& c, Type& d)
+	{
+		a = _mm_loadu_ps(p);
+		b = _mm_loadu_ps(p + 4);
+		c = _mm_loadu_ps(p + 8);
+		d = _mm_loadu_ps(p + 12);
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+	}
+	static void StoreAoS4(float* p, Type a, Type b, Type c, Type d)
+	{
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_storeu_ps(p, a);
+		_mm_storeu_ps(p + 4, b);
+		_mm_storeu_ps(p + 8, c);
+		_mm_storeu_ps(p + 12, d);
+	}
+	static void GatherAoS4(const float* const* p, Type& a, Type& b, Type& c, Type& d)
+	{
+		a = _mm_loadu_ps(p[0]);
+		b = _mm_loadu_ps(p[1]);
+		c = _mm_loadu_ps(p[2]);
+		d = _mm_loadu_ps(p[3]);
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+	}
+	static void ScatterAoS4(float* const* p, Type a, Type b, Type c, Type d)
+	{
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_storeu_ps(p[0], a);
+		_mm_storeu_ps(p[1], b);
+		_mm_storeu_ps(p[2], c);
+		_mm_storeu_ps(p[3], d);
+	}
+};
+#endif
+
+#ifdef MATH_AVX2
+struct LaneAVX
+{
+	typedef __m256 Type;
+	typedef __m256 Mask;
+	static const unsigned Width = 8;
+
+	static Type Set(float v)                        { return _mm256_set1_ps(v); }
+	static Type Load(const float* p)                { return _mm256_loadu_ps(p); }
+	static void Store(float* p, Type v)             { _mm256_storeu_ps(p, v); }
+
+	static Type Add(Type lhs, Type rhs)             { return _mm256_add_ps(lhs, rhs); }
+	static Type Sub(Type lhs, Type rhs)             { return _mm256_sub_ps(lhs, rhs); }
+	static Type Mul(Type lhs, Type rhs)             { return _mm256_mul_ps(lhs, rhs); }
+	static Type Div(Type lhs, Type rhs)             { return _mm256_div_ps(lhs, rhs); }
+	static Type Min(Type lhs, Type rhs)             { return _mm256_min_ps(lhs, rhs); }
+	static Type Max(Type lhs, Type rhs)             { return _mm256_max_ps(lhs, rhs); }
+	static Type Abs(Type v)                         { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+	static Type Sqrt(Type v)                        { return _mm256_sqrt_ps(v); }
+	static Type RSqrt(Type v)
+	{
+#ifdef MATH_DETERMINISTIC
+		return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(v));
+#else
+		__m256 e = _mm256_rsqrt_ps(v);
+		__m256 e3 = _mm256_mul_ps(_mm256_mul_ps(e, e), e);
+		return _mm256_add_ps(e, _mm256_mul_ps(_mm256_set1_ps(0.5f), _mm256_sub_ps(e, _mm256_mul_ps(v, e3))));
+#endif
+	}
+
+	static Mask CmpLt(Type lhs, Type rhs)           { return _mm256_cmp_ps(lhs, rhs, _CMP_LT_OQ); }
+	static Mask CmpLe(Type lhs, Type rhs)           { return _mm256_cmp_ps(lhs, rhs, _CMP_LE_OQ); }
+	static Mask CmpGt(Type lhs, Type rhs)           { return _mm256_cmp_ps(lhs, rhs, _CMP_GT_OQ); }
+	static Mask CmpGe(Type lhs, Type rhs)           { return _mm256_cmp_ps(lhs, rhs, _CMP_GE_OQ); }
+	static Mask And(Mask lhs, Mask rhs)             { return _mm256_and_ps(lhs, rhs); }
+	static Mask Or(Mask lhs, Mask rhs)              { return _mm256_or_ps(lhs, rhs); }
+	static Type Select(Mask mask, Type onTrue, Type onFalse) { return _mm256_blendv_ps(onFalse, onTrue, mask); }
+	static int  MoveMask(Mask mask)                 { return _mm256_movemask_ps(mask); }
+
+	static void LoadAoS4(const float* p, Type& a, Type& b, Type& c, Type& d)
+	{
+		__m128 a0, b0, c0, d0, a1, b1, c1, d1;
+		LaneSSE::LoadAoS4(p, a0, b0, c0, d0);
+		LaneSSE::LoadAoS4(p + 16, a1, b1, c1, d1);
+		a = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a1, 1);
+		b = _mm256_insertf128_ps(_mm256_castps128_ps256(b0), b1, 1);
+		c = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c1, 1);
+		d = _mm256_insertf128_ps(_mm256_castps128_ps256(d0), d1, 1);
+	}
+	static void StoreAoS4(float* p, Type a, Type b, Type c, Type d)
+	{
+		LaneSSE::StoreAoS4(p, _mm256_castps256_ps128(a), _mm256_castps256_ps128(b),
+			_mm256_castps256_ps128(c), _mm256_castps256_ps128(d));
+		LaneSSE::StoreAoS4(p + 16, _mm256_extractf128_ps(a, 1), _mm256_extractf128_ps(b, 1),
+			_mm256_extractf128_ps(c, 1), _mm256_extractf128_ps(d, 1));
+	}
+	static void GatherAoS4(const float* const* p, Type& a, Type& b, Type& c, Type& d)
+	{
+		__m128 a0, b0, c0, d0, a1, b1, c1, d1;
+		LaneSSE::GatherAoS4(p, a0, b0, c0, d0);
+		LaneSSE::GatherAoS4(p + 4, a1, b1, c1, d1);
+		a = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a1, 1);
+		b = _mm256_insertf128_ps(_mm256_castps128_ps256(b0), b1, 1);
+		c = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c1, 1);
+		d = _mm256_insertf128_ps(_mm256_castps128_ps256(d0), d1, 1);
+	}
+	static void ScatterAoS4(float* const* p, Type a, Type b, Type c, Type d)
+	{
+		LaneSSE::ScatterAoS4(p, _mm256_castps256_ps128(a), _mm256_castps256_ps128(b),
+			_mm256_castps256_ps128(c), _mm256_castps256_ps128(d));
+		LaneSSE::ScatterAoS4(p + 4, _mm256_extractf128_ps(a, 1), _mm256_extractf128_ps(b, 1),
+			_mm256_extractf128_ps(c, 1), _mm256_extractf128_ps(d, 1));
+	}
+};
+#endif
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,243 @@
+#include "Skinning.h"
+#include "Parallel.h"
+#include "SimdLane.h"
+
+#include <assert.h>
+
+MATH_CONTRACT_OFF_BEGIN
+
+// Skinning kernels.
+//
+// Every lane is a vertex. The bones of the lanes are gathered one influence at a time: each lane loads the rows
+// of its own bone and a transpose turns them into one register per bone element, so the blend is a plain
+// multiply-add per element. The kernels are written against the lane types in SimdLane.h like the other bulk
+// operations and evaluate every lane in the same order, so the scalar tail matches the SIMD loops bit for bit.
+
+namespace
+{
+
+/// Vertices per thread range: 16 floats, one cache line of each output stream.
+const unsigned kPARALLEL_GRAIN = 16;
+
+/// The 12 row-major elements of the bone matrices of influence k of the lanes at i.
+template <class L>
+void GatherMatrices(const SkinSource& src, const Matrix3x4* bones, unsigned k, unsigned i, typename L::Type* b)
+{
+	const float* rows[L::Width];
+	for (unsigned j = 0; j < L::Width; ++j)
+		rows[j] = bones[src.boneIndices[k][i + j]].Data();
+	for (unsigned r = 0; r < 3; ++r) {
+		L::GatherAoS4(rows, b[r * 4], b[r * 4 + 1], b[r * 4 + 2], b[r * 4 + 3]);
+		for (unsigned j = 0; j < L::Width; ++j)
+			rows[j] += 4;
+	}
+}
+
+template <class L, bool Normals>
+unsigned LinearBlendKernel(const SkinTarget& dest, const SkinSource& src, const Matrix3x4* bones, unsigned i, unsigned end)
+{
+	typedef typename L::Type T;
+
+	for (; i + L::Width <= end; i += L::Width) {
+		// Weighted sum of the bone matrices, 12 row-major elements, starting from the first influence.
+		T m[12];
+		GatherMatrices<L>(src, bones, 0, i, m);
+		T w0 = L::Load(src.boneWeights[0] + i);
+		for (unsigned e = 0; e < 12; ++e)
+			m[e] = L::Mul(w0, m[e]);
+		for (unsigned k = 1; k < src.influences; ++k) {
+			T b[12];
+			GatherMatrices<L>(src, bones, k, i, b);
+			T w = L::Load(src.boneWeights[k] + i);
+			for (unsigned e = 0; e < 12; ++e)
+				m[e] = L::Add(m[e], L::Mul(w, b[e]));
+		}
+
+		T x = L::Load(src.x + i);
+		T y = L::Load(src.y + i);
+		T z = L::Load(src.z + i);
+		L::Store(dest.x + i, L::Add(L::Add(L::Add(L::Mul(m[0], x), L::Mul(m[1], y)), L::Mul(m[2], z)), m[3]));
+		L::Store(dest.y + i, L::Add(L::Add(L::Add(L::Mul(m[4], x), L::Mul(m[5], y)), L::Mul(m[6], z)), m[7]));
+		L::Store(dest.z + i, L::Add(L::Add(L::Add(L::Mul(m[8], x), L::Mul(m[9], y)), L::Mul(m[10], z)), m[11]));
+
+		if (Normals) {
+			T nx = L::Load(src.nx + i);
+			T ny = L::Load(src.ny + i);
+			T nz = L::Load(src.nz + i);
+			T rx = L::Add(L::Add(L::Mul(m[0], nx), L::Mul(m[1], ny)), L::Mul(m[2], nz));
+			T ry = L::Add(L::Add(L::Mul(m[4], nx), L::Mul(m[5], ny)), L::Mul(m[6], nz));
+			T rz = L::Add(L::Add(L::Mul(m[8], nx), L::Mul(m[9], ny)), L::Mul(m[10], nz));
+			T invLen = L::Div(L::Set(1.0f), L::Sqrt(L::Add(L::Add(L::Mul(rx, rx), L::Mul(ry, ry)), L::Mul(rz, rz))));
+			L::Store(dest.nx + i, L::Mul(rx, invLen));
+			L::Store(dest.ny + i, L::Mul(ry, invLen));
+			L::Store(dest.nz + i, L::Mul(rz, invLen));
+		}
+	}
+	return i;
+}
+
+/// v + 2 * r x (r x v + w * v), the rotation of v by the unit quaternion (w, r).
+template <class L>
+void Rotate(typename L::Type w, const typename L::Type* r, typename L::Type& x, typename L::Type& y, typename L::Type& z)
+{
+	typedef typename L::Type T;
+
+	T cx = L::Add(L::Sub(L::Mul(r[1], z), L::Mul(r[2], y)), L::Mul(w, x));
+	T cy = L::Add(L::Sub(L::Mul(r[2], x), L::Mul(r[0], z)), L::Mul(w, y));
+	T cz = L::Add(L::Sub(L::Mul(r[0], y), L::Mul(r[1], x)), L::Mul(w, z));
+	T two = L::Set(2.0f);
+	x = L::Add(x, L::Mul(two, L::Sub(L::Mul(r[1], cz), L::Mul(r[2], cy))));
+	y = L::Add(y, L::Mul(two, L::Sub(L::Mul(r[2], cx), L::Mul(r[0], cz))));
+	z = L::Add(z, L::Mul(two, L::Sub(L::Mul(r[0], cy), L::Mul(r[1], cx))));
+}
+
+/// The 8 elements of the dual quaternions of influence k of the lanes at i: real w, x, y, z, then dual w, x, y, z.
+template <class L>
+void GatherDualQuaternions(const SkinSource& src, const DualQuaternion* bones, unsigned k, unsigned i, typename L::Type* b)
+{
+	const float* parts[L::Width];
+	for (unsigned j = 0; j < L::Width; ++j)
+		parts[j] = bones[src.boneIndices[k][i + j]].Data();
+	L::GatherAoS4(parts, b[0], b[1], b[2], b[3]);
+	for (unsigned j = 0; j < L::Width; ++j)
+		parts[j] += 4;
+	L::GatherAoS4(parts, b[4], b[5], b[6], b[7]);
+}
+
+template <class L, bool Normals>
+unsigned DualQuaternionBlendKernel(const SkinTarget& dest, const SkinSource& src, const DualQuaternion* bones, unsigned i,
+	unsigned end)
+{
+	typedef typename L::Type T;
+	const T zero = L::Set(0.0f);
+
+	for (; i + L::Width <= end; i += L::Width) {
+		// Weighted sum of the dual quaternions, starting from the first influence.
+		T q[8];
+		T first[4];
+		GatherDualQuaternions<L>(src, bones, 0, i, q);
+		for (unsigned e = 0; e < 4; ++e)
+			first[e] = q[e];
+		T w0 = L::Load(src.boneWeights[0] + i);
+		for (unsigned e = 0; e < 8; ++e)
+			q[e] = L::Mul(w0, q[e]);
+		for (unsigned k = 1; k < src.influences; ++k) {
+			T b[8];
+			GatherDualQuaternions<L>(src, bones, k, i, b);
+
+			// q and -q are the same rotation; blend along the shorter arc from the first influence.
+			T w = L::Load(src.boneWeights[k] + i);
+			T dot = L::Add(L::Add(L::Add(L::Mul(first[0], b[0]), L::Mul(first[1], b[1])), L::Mul(first[2], b[2])),
+				L::Mul(first[3], b[3]));
+			w = L::Select(L::CmpLt(dot, zero), L::Sub(zero, w), w);
+			for (unsigned e = 0; e < 8; ++e)
+				q[e] = L::Add(q[e], L::Mul(w, b[e]));
+		}
+
+		// Normalize by the real part. The component of the dual part along the real part does not affect the
+		// translation, so it is not removed.
+		T invLen = L::Div(L::Set(1.0f), L::Sqrt(L::Add(L::Add(L::Add(L::Mul(q[0], q[0]), L::Mul(q[1], q[1])),
+			L::Mul(q[2], q[2])), L::Mul(q[3], q[3]))));
+		for (unsigned e = 0; e < 8; ++e)
+			q[e] = L::Mul(q[e], invLen);
+		const T* r = q + 1;
+		const T* d = q + 5;
+
+		// Translation 2 * (w_r * d - w_d * r + r x d) from the vector parts r and d.
+		T two = L::Set(2.0f);
+		T tx = L::Mul(two, L::Add(L::Sub(L::Mul(q[0], d[0]), L::Mul(q[4], r[0])), L::Sub(L::Mul(r[1], d[2]), L::Mul(r[2], d[1]))));
+		T ty = L::Mul(two, L::Add(L::Sub(L::Mul(q[0], d[1]), L::Mul(q[4], r[1])), L::Sub(L::Mul(r[2], d[0]), L::Mul(r[0], d[2]))));
+		T tz = L::Mul(two, L::Add(L::Sub(L::Mul(q[0], d[2]), L::Mul(q[4], r[2])), L::Sub(L::Mul(r[0], d[1]), L::Mul(r[1], d[0]))));
+
+		T x = L::Load(src.x + i);
+		T y = L::Load(src.y + i);
+		T z = L::Load(src.z + i);
+		Rotate<L>(q[0], r, x, y, z);
+		L::Store(dest.x + i, L::Add(x, tx));
+		L::Store(dest.y + i, L::Add(y, ty));
+		L::Store(dest.z + i, L::Add(z, tz));
+
+		if (Normals) {
+			T nx = L::Load(src.nx + i);
+			T ny = L::Load(src.ny + i);
+			T nz = L::Load(src.nz + i);
+			Rotate<L>(q[0], r, nx, ny, nz);
+			L::Store(dest.nx + i, nx);
+			L::Store(dest.ny + i, ny);
+			L::Store(dest.nz + i, nz);
+		}
+	}
+	return i;
+}
+
+template <bool Normals>
+void LinearBlendRange(const SkinTarget& dest, const SkinSource& src, const Matrix3x4* bones, unsigned i, unsigned end)
+{
+#ifdef MATH_AVX2
+	i = LinearBlendKernel<LaneAVX, Normals>(dest, src, bones, i, end);
+#endif
+#ifdef MATH_SSE
+	i = LinearBlendKernel<LaneSSE, Normals>(dest, src, bones, i, end);
+#endif
+	LinearBlendKernel<LaneScalar, Normals>(dest, src, bones, i, end);
+}
+
+template <bool Normals>
+void DualQuaternionBlendRange(const SkinTarget& dest, const SkinSource& src, const DualQuaternion* bones, unsigned i,
+	unsigned end)
+{
+#ifdef MATH_AVX2
+	i = DualQuaternionBlendKernel<LaneAVX, Normals>(dest, src, bones, i, end);
+#endif
+#ifdef MATH_SSE
+	i = DualQuaternionBlendKernel<LaneSSE, Normals>(dest, src, bones, i, end);
+#endif
+	DualQuaternionBlendKernel<LaneScalar, Normals>(dest, src, bones, i, end);
+}
+
+}
+
+namespace Skinning
+{
+
+void LinearBlend(const SkinTarget& dest, const SkinSource& src, const Matrix3x4* bones, unsigned begin, unsigned end)
+{
+	assert(src.influences <= SkinSource::MAX_INFLUENCES);
+	if (!src.influences)
+		return;
+	if (src.nx)
+		LinearBlendRange<true>(dest, src, bones, begin, end);
+	else
+		LinearBlendRange<false>(dest, src, bones, begin, end);
+}
+
+void DualQuaternionBlend(const SkinTarget& dest, const SkinSource& src, const DualQuaternion* bones, unsigned begin, unsigned end)
+{
+	assert(src.influences <= SkinSource::MAX_INFLUENCES);
+	if (!src.influences)
+		return;
+	if (src.nx)
+		DualQuaternionBlendRange<true>(dest, src, bones, begin, end);
+	else
+		DualQuaternionBlendRange<false>(dest, src, bones, begin, end);
+}
+
+void LinearBlendParallel(const SkinTarget& dest, const SkinSource& src, const Matrix3x4* bones, unsigned count,
+	unsigned threadCount)
+{
+	Math::ParallelFor(count, kPARALLEL_GRAIN, threadCount, [&](unsigned begin, unsigned end) {
+		LinearBlend(dest, src, bones, begin, end);
+	});
+}
+
+void DualQuaternionBlendParallel(const SkinTarget& dest, const SkinSource& src, const DualQuaternion* bones, unsigned count,
+	unsigned threadCount)
+{
+	Math::ParallelFor(count, kPARALLEL_GRAIN, threadCount, [&](unsigned begin, unsigned end) {
+		DualQuaternionBlend(dest, src, bones, begin, end);
+	});
+}
+
+}
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "DualQuaternion.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+// CPU skinning over structure-of-arrays vertex streams, for validating GPU skinning and as a fallback where it is
+// unavailable. Linear blend skinning sums the bone matrices by weight; dual-quaternion skinning blends rigid bone
+// transforms without the volume loss of the matrix sum at twisted joints, but ignores bone scale.
+//
+// The range functions skin vertices [begin, end) and can be called from any number of threads on disjoint ranges.
+// The Parallel functions split the whole stream over threads with Math::ParallelFor. Results do not depend on
+// the range split or the math mode, as long as the compiler does not contract the scalar code into FMA.
+
+/// Source streams of a skinned mesh in structure-of-arrays layout. Vertex i is influenced by bone
+/// boneIndices[k][i] with weight boneWeights[k][i] for every k < influences; the weights of a vertex should sum
+/// to 1 and unused influences have weight 0. Without influences the skinning functions write nothing. The normal
+/// streams are optional.
+struct SkinSource
+{
+	static const unsigned MAX_INFLUENCES = 4;
+
+	SkinSource() : x(nullptr), y(nullptr), z(nullptr), nx(nullptr), ny(nullptr), nz(nullptr), influences(0)
+	{
+		for (unsigned k = 0; k < MAX_INFLUENCES; ++k) {
+			boneIndices[k] = nullptr;
+			boneWeights[k] = nullptr;
+		}
+	}
+
+	const float*          x;
+	const float*          y;
+	const float*          z;
+	const float*          nx;
+	const float*          ny;
+	const float*          nz;
+	const unsigned short* boneIndices[MAX_INFLUENCES];
+	const float*          boneWeights[MAX_INFLUENCES];
+	unsigned              influences;
+};
+
+/// Destination streams of skinning. The normal streams are written when the source has normals.
+struct SkinTarget
+{
+	SkinTarget() : x(nullptr), y(nullptr), z(nullptr), nx(nullptr), ny(nullptr), nz(nullptr) {}
+
+	float* x;
+	float* y;
+	float* z;
+	float* nx;
+	float* ny;
+	float* nz;
+};
+
+namespace Skinning
+{
+
+/// Linear blend skinning with bone matrices that include the inverse bind pose. Normals are transformed by the
+/// blended matrix and renormalized, which is exact for rotation and uniform scale.
+void LinearBlend(const SkinTarget& dest, const SkinSource& src, const Matrix3x4* bones, unsigned begin, unsigned end);
+/// Dual-quaternion skinning with rigid bone transforms that include the inverse bind pose. Each influence is
+/// flipped into the hemisphere of the first before blending, so it should be the heaviest.
+void DualQuaternionBlend(const SkinTarget& dest, const SkinSource& src, const DualQuaternion* bones, unsigned begin, unsigned end);
+
+/// LinearBlend of vertices [0, count) over threadCount threads, 0 for one per hardware thread.
+void LinearBlendParallel(const SkinTarget& dest, const SkinSource& src, const Matrix3x4* bones, unsigned count,
+	unsigned threadCount = 0);
+/// DualQuaternionBlend of vertices [0, count) over threadCount threads, 0 for one per hardware thread.
+void DualQuaternionBlendParallel(const SkinTarget& dest, const SkinSource& src, const DualQuaternion* bones, unsigned count,
+	unsigned threadCount = 0);
+
+}
+
+MATH_CONTRACT_OFF_END
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Math.h"
+#include "Vector3.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
+/// Bounding sphere.
+class Sphere
+{
+public:
+	Sphere() : center(Vector3::ZERO), radius(0.0f) {}
+	Sphere(const Vector3& _center, float _radius) : center(_center), radius(_radius) {}
+
+	/// Grow to enclose a point.
+	void Merge(const Vector3& point)
+	{
+		Vector3 offset = point - center;
+		float dist = offset.Length();
+		if (dist > radius) {
+			float half = (dist - radius) * 0.5f;
+			radius += half;
+			center += offset * (half / dist);
+		}
+	}
+
+	/// Grow to enclose another sphere.
+	void Merge(const Sphere& sphere)
+	{
+		Vector3 offset = sphere.center - center;
+		float dist = offset.Length();
+		if (dist + sphere.radius <= radius)
+			return;
+		if (dist + radius <= sphere.radius) {
+			*this = sphere;
+			return;
+		}
+		float newRadius = (dist + radius + sphere.radius) * 0.5f;
+		center += offset * ((newRadius - radius) / dist);
+		radius = newRadius;
+	}
+
+	bool IsInside(const Vector3& point) const { return (point - center).LengthSquared() <= radius * radius; }
+
+	bool Intersects(const Sphere& sphere) const
+	{
+		float r = radius + sphere.radius;
+		return (sphere.center - center).LengthSquared() <= r * r;
+	}
+
+	Vector3 center;
+	float   radius;
+};
+
+MATH_CONTRACT_OFF_END
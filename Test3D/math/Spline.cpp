@@ -0,0 +1,474 @@
+#include "Spline.h"
+#include "SimdLane.h"
+
+#include <assert.h>
+#include <float.h>
+
+MATH_CONTRACT_OFF_BEGIN
+
+namespace
+{
+
+/// Nodes and weights of the five-point Gauss-Legendre rule on [-1, 1], exact for polynomials up to degree nine.
+const float kGAUSS_NODES[5] = { -0.9061798459f, -0.5384693101f, 0.0f, 0.5384693101f, 0.9061798459f };
+const float kGAUSS_WEIGHTS[5] = { 0.2369268851f, 0.4786286705f, 0.5688888889f, 0.4786286705f, 0.2369268851f };
+
+/// Newton steps that place each arc-length table entry within its sampled interval.
+const unsigned kTABLE_NEWTON_STEPS = 3;
+/// Speed below which the curve is taken to stop, and dt/ds to be unbounded.
+const float kMIN_SPEED = 1e-6f;
+
+static_assert(sizeof(Spline::Segment) == 12 * sizeof(float), "EvaluateKernel reads segments as 12 floats");
+
+Spline::Segment MakeSegment(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d)
+{
+	Spline::Segment segment;
+	segment.a = a;
+	segment.b = b;
+	segment.c = c;
+	segment.d = d;
+	return segment;
+}
+
+/// Cubic through p0 and p1 with the tangents m0 and m1.
+Spline::Segment HermiteSegment(const Vector3& p0, const Vector3& m0, const Vector3& p1, const Vector3& m1)
+{
+	return MakeSegment(p0, m0, p0 * -3.0f - m0 * 2.0f + p1 * 3.0f - m1, p0 * 2.0f + m0 - p1 * 2.0f + m1);
+}
+
+/// Evaluate Width curve points. Each lane looks up its own segment, whose 12 coefficients are gathered as three
+/// records of four floats; the polynomials are evaluated in the order GetPoint uses, so every width gives the same
+/// bits.
+template <class L>
+unsigned EvaluateKernel(float* outX, float* outY, float* outZ, const Spline* spline, const Spline* const* splines,
+	const float* t, unsigned i, unsigned count)
+{
+	typedef typename L::Type T;
+
+	for (; i + L::Width <= count; i += L::Width) {
+		const float* records[3][L::Width];
+		float u[L::Width];
+		for (unsigned j = 0; j < L::Width; ++j) {
+			const float* data = (spline ? spline : splines[i + j])->GetSegment(t[i + j], u[j]).a.Data();
+			records[0][j] = data;
+			records[1][j] = data + 4;
+			records[2][j] = data + 8;
+		}
+
+		// a.x a.y a.z b.x, b.y b.z c.x c.y, c.z d.x d.y d.z
+		T coefficients[12];
+		for (unsigned k = 0; k < 3; ++k)
+			L::GatherAoS4(records[k], coefficients[4 * k], coefficients[4 * k + 1], coefficients[4 * k + 2],
+				coefficients[4 * k + 3]);
+
+		T vu = L::Load(u);
+		T result[3];
+		for (unsigned axis = 0; axis < 3; ++axis) {
+			T p = coefficients[9 + axis];
+			p = L::Add(L::Mul(p, vu), coefficients[6 + axis]);
+			p = L::Add(L::Mul(p, vu), coefficients[3 + axis]);
+			result[axis] = L::Add(L::Mul(p, vu), coefficients[axis]);
+		}
+		L::Store(outX + i, result[0]);
+		L::Store(outY + i, result[1]);
+		L::Store(outZ + i, result[2]);
+	}
+	return i;
+}
+
+void BulkEvaluate(float* outX, float* outY, float* outZ, const Spline* spline, const Spline* const* splines,
+	const float* t, unsigned count)
+{
+	unsigned i = 0;
+#ifdef MATH_AVX2
+	i = EvaluateKernel<LaneAVX>(outX, outY, outZ, spline, splines, t, i, count);
+#endif
+#ifdef MATH_SSE
+	i = EvaluateKernel<LaneSSE>(outX, outY, outZ, spline, splines, t, i, count);
+#endif
+	EvaluateKernel<LaneScalar>(outX, outY, outZ, spline, splines, t, i, count);
+}
+
+/// Logarithm of a unit quaternion: the rotation axis times half the angle.
+Vector3 Log(const Quaternion& q)
+{
+	Vector3 v(q.x, q.y, q.z);
+	float sinAngle = v.Length();
+	if (sinAngle < Math::kSMALL_EPSILON)
+		return v;
+	return v * (Math::Policy::Atan2(sinAngle, q.w) / sinAngle);
+}
+
+/// Exponential of a pure quaternion, the inverse of Log.
+Quaternion Exp(const Vector3& v)
+{
+	float angle = v.Length();
+	if (angle < Math::kSMALL_EPSILON)
+		return Quaternion(1.0f, v.x, v.y, v.z).Normalized();
+	float s, c;
+	Math::Policy::SinCos(angle, s, c);
+	Vector3 axis = v * (s / angle);
+	return Quaternion(c, axis.x, axis.y, axis.z);
+}
+
+/// Squad of one segment between the keys q0 and q1 with their inner controls s0 and s1. Goes through BulkSlerp
+/// rather than Quaternion::Slerp, which loses precision between the nearly parallel keys and controls, so that
+/// QuaternionSpline::BulkEvaluate returns the same results.
+Quaternion Squad(const Quaternion& q0, const Quaternion& q1, const Quaternion& s0, const Quaternion& s1, float u)
+{
+	Quaternion keys, controls, result;
+	Quaternion::BulkSlerp(&keys, &q0, &q1, &u, 1);
+	Quaternion::BulkSlerp(&controls, &s0, &s1, &u, 1);
+	float blend = 2.0f * u * (1.0f - u);
+	Quaternion::BulkSlerp(&result, &keys, &controls, &blend, 1);
+	return result;
+}
+
+}
+
+Spline::Spline() :
+	m_Type(SplineType::CatmullRom),
+	m_ArcLengthResolution(DEFAULT_ARC_LENGTH_RESOLUTION),
+	m_Length(0.0f),
+	m_BucketStep(0.0f)
+{
+	m_Constant = MakeSegment(Vector3::ZERO, Vector3::ZERO, Vector3::ZERO, Vector3::ZERO);
+}
+
+void Spline::SetPoints(SplineType type, const Vector3* points, unsigned count, const Vector3* tangents)
+{
+	assert(type != SplineType::Hermite || tangents || !count);
+	m_Type = type;
+	m_Points.assign(points, points + count);
+	if (type != SplineType::Hermite)
+		m_Tangents.clear();
+	else if (tangents)
+		m_Tangents.assign(tangents, tangents + count);
+	else
+		m_Tangents.assign(count, Vector3::ZERO);
+	BuildSegments();
+	BuildArcLengthTable();
+}
+
+void Spline::SetPoints(SplineType type, const std::vector<Vector3>& points)
+{
+	SetPoints(type, points.data(), (unsigned)points.size());
+}
+
+void Spline::SetPoints(SplineType type, const std::vector<Vector3>& points, const std::vector<Vector3>& tangents)
+{
+	assert(type != SplineType::Hermite || tangents.size() == points.size());
+	SetPoints(type, points.data(), (unsigned)points.size(), tangents.size() >= points.size() ? tangents.data() : nullptr);
+}
+
+void Spline::SetArcLengthResolution(unsigned resolution)
+{
+	assert(resolution > 0);
+	m_ArcLengthResolution = resolution;
+	BuildArcLengthTable();
+}
+
+void Spline::Clear()
+{
+	m_Points.clear();
+	m_Tangents.clear();
+	BuildSegments();
+	BuildArcLengthTable();
+}
+
+void Spline::BuildSegments()
+{
+	m_Segments.clear();
+	const std::vector<Vector3>& p = m_Points;
+	unsigned count = (unsigned)p.size();
+	m_Constant = MakeSegment(count ? p[0] : Vector3::ZERO, Vector3::ZERO, Vector3::ZERO, Vector3::ZERO);
+
+	switch (m_Type) {
+	case SplineType::Bezier:
+		for (unsigned i = 0; i + 3 < count; i += 3) {
+			m_Segments.push_back(MakeSegment(p[i], (p[i + 1] - p[i]) * 3.0f, (p[i] - p[i + 1] * 2.0f + p[i + 2]) * 3.0f,
+				p[i + 3] - p[i] + (p[i + 1] - p[i + 2]) * 3.0f));
+		}
+		break;
+
+	case SplineType::CatmullRom:
+		for (unsigned i = 0; i + 1 < count; ++i) {
+			Vector3 before = i > 0 ? p[i - 1] : p[0] * 2.0f - p[1];
+			Vector3 after = i + 2 < count ? p[i + 2] : p[i + 1] * 2.0f - p[i];
+			m_Segments.push_back(HermiteSegment(p[i], (p[i + 1] - before) * 0.5f, p[i + 1], (after - p[i]) * 0.5f));
+		}
+		break;
+
+	case SplineType::Hermite:
+		for (unsigned i = 0; i + 1 < count; ++i)
+			m_Segments.push_back(HermiteSegment(p[i], m_Tangents[i], p[i + 1], m_Tangents[i + 1]));
+		break;
+
+	case SplineType::BSpline:
+		for (unsigned i = 0; i + 3 < count; ++i) {
+			m_Segments.push_back(MakeSegment(
+				(p[i] + p[i + 1] * 4.0f + p[i + 2]) * (1.0f / 6.0f),
+				(p[i + 2] - p[i]) * 0.5f,
+				(p[i] - p[i + 1] * 2.0f + p[i + 2]) * 0.5f,
+				(p[i + 3] - p[i] + (p[i + 1] - p[i + 2]) * 3.0f) * (1.0f / 6.0f)));
+		}
+		break;
+	}
+}
+
+const Spline::Segment& Spline::GetSegment(float t, float& u) const
+{
+	unsigned count = (unsigned)m_Segments.size();
+	if (!count) {
+		u = 0.0f;
+		return m_Constant;
+	}
+	float scaled = Math::Clamp(t, 0.0f, 1.0f) * (float)count;
+	unsigned index = (unsigned)scaled;
+	if (index >= count)
+		index = count - 1;
+	u = scaled - (float)index;
+	return m_Segments[index];
+}
+
+Vector3 Spline::GetPoint(float t) const
+{
+	float u;
+	const Segment& s = GetSegment(t, u);
+	return ((s.d * u + s.c) * u + s.b) * u + s.a;
+}
+
+Vector3 Spline::GetDerivative(float t) const
+{
+	float u;
+	const Segment& s = GetSegment(t, u);
+	return ((s.d * (3.0f * u) + s.c * 2.0f) * u + s.b) * (float)m_Segments.size();
+}
+
+float Spline::SegmentSpeed(unsigned segment, float u) const
+{
+	const Segment& s = m_Segments[segment];
+	return ((s.d * (3.0f * u) + s.c * 2.0f) * u + s.b).Length();
+}
+
+float Spline::SegmentLength(unsigned segment, float u0, float u1) const
+{
+	float halfWidth = 0.5f * (u1 - u0);
+	float center = 0.5f * (u0 + u1);
+	float sum = 0.0f;
+	for (unsigned i = 0; i < 5; ++i)
+		sum += kGAUSS_WEIGHTS[i] * SegmentSpeed(segment, center + halfWidth * kGAUSS_NODES[i]);
+	return sum * halfWidth;
+}
+
+void Spline::BuildArcLengthTable()
+{
+	m_SegmentStarts.clear();
+	m_TableParameters.clear();
+	m_TableSlopes.clear();
+	m_Buckets.clear();
+	m_Length = 0.0f;
+	m_BucketStep = 0.0f;
+
+	unsigned segments = (unsigned)m_Segments.size();
+	if (!segments)
+		return;
+
+	// Every segment gets resolution + 1 entries of u and du/ds at equal distances along it. Entries stay within
+	// their segment, so the interpolation never crosses the corners where the speed of the curve may jump.
+	unsigned resolution = m_ArcLengthResolution;
+	float du = 1.0f / (float)resolution;
+	std::vector<double> cumulative(resolution + 1);
+	m_SegmentStarts.resize(segments + 1);
+	m_TableParameters.resize(segments * (resolution + 1));
+	m_TableSlopes.resize(segments * (resolution + 1));
+	double start = 0.0;
+	for (unsigned segment = 0; segment < segments; ++segment) {
+		m_SegmentStarts[segment] = (float)start;
+
+		// Length at equal steps of u, summed in double so that long segments keep the precision of short steps.
+		cumulative[0] = 0.0;
+		for (unsigned j = 0; j < resolution; ++j)
+			cumulative[j + 1] = cumulative[j] + SegmentLength(segment, (float)j * du, (float)(j + 1) * du);
+		double length = cumulative[resolution];
+
+		// Place each entry with Newton steps on the length within its step of u, starting from linear
+		// interpolation of the cumulative lengths.
+		float* parameters = &m_TableParameters[segment * (resolution + 1)];
+		float* slopes = &m_TableSlopes[segment * (resolution + 1)];
+		unsigned j = 0;
+		for (unsigned k = 0; k <= resolution; ++k) {
+			double distance = length * k / resolution;
+			while (j + 1 < resolution && cumulative[j + 1] < distance)
+				++j;
+
+			float u0 = (float)j * du;
+			double stepLength = cumulative[j + 1] - cumulative[j];
+			float remaining = (float)(distance - cumulative[j]);
+			float u = u0 + (stepLength > 0.0 ? (float)((distance - cumulative[j]) / stepLength) : 0.0f) * du;
+			for (unsigned step = 0; step < kTABLE_NEWTON_STEPS; ++step) {
+				float speed = SegmentSpeed(segment, u);
+				if (speed <= kMIN_SPEED)
+					break;
+				u = Math::Clamp(u - (SegmentLength(segment, u0, u) - remaining) / speed, u0, u0 + du);
+			}
+			if (k == 0 || k == resolution)
+				u = (float)k * du;
+
+			float speed = SegmentSpeed(segment, u);
+			parameters[k] = u;
+			slopes[k] = speed > kMIN_SPEED ? 1.0f / speed : FLT_MAX;
+		}
+		start += length;
+	}
+	m_SegmentStarts[segments] = (float)start;
+	m_Length = (float)start;
+	if (m_Length <= 0.0f)
+		return;
+
+	// Buckets of equal length, as many as table intervals, each holding the segment at its start. A query
+	// starts there and steps over the segments shorter than a bucket, if any.
+	unsigned buckets = segments * resolution;
+	m_BucketStep = m_Length / (float)buckets;
+	m_Buckets.resize(buckets);
+	unsigned segment = 0;
+	for (unsigned b = 0; b < buckets; ++b) {
+		float distance = (float)b * m_BucketStep;
+		while (segment + 1 < segments && m_SegmentStarts[segment + 1] <= distance)
+			++segment;
+		m_Buckets[b] = segment;
+	}
+}
+
+float Spline::GetParameter(float distance) const
+{
+	if (m_Buckets.empty())
+		return 0.0f;
+
+	distance = Math::Clamp(distance, 0.0f, m_Length);
+	unsigned segments = (unsigned)m_Segments.size();
+	unsigned bucket = (unsigned)(distance / m_BucketStep);
+	if (bucket >= m_Buckets.size())
+		bucket = (unsigned)m_Buckets.size() - 1;
+	unsigned segment = m_Buckets[bucket];
+	while (segment + 1 < segments && distance >= m_SegmentStarts[segment + 1])
+		++segment;
+
+	float length = m_SegmentStarts[segment + 1] - m_SegmentStarts[segment];
+	if (length <= 0.0f)
+		return (float)segment / (float)segments;
+	unsigned resolution = m_ArcLengthResolution;
+	float scaled = Math::Min((distance - m_SegmentStarts[segment]) / length, 1.0f) * (float)resolution;
+	unsigned k = (unsigned)scaled;
+	if (k >= resolution)
+		k = resolution - 1;
+	float f = scaled - (float)k;
+
+	// Cubic Hermite between entries k and k + 1, with the slopes scaled to the step and limited to three times
+	// the secant, which keeps the interpolation monotonic where the curve nearly stops.
+	const float* parameters = &m_TableParameters[segment * (resolution + 1) + k];
+	const float* slopes = &m_TableSlopes[segment * (resolution + 1) + k];
+	float step = length / (float)resolution;
+	float limit = 3.0f * (parameters[1] - parameters[0]);
+	float m0 = Math::Min(slopes[0] * step, limit);
+	float m1 = Math::Min(slopes[1] * step, limit);
+	float f2 = f * f;
+	float f3 = f2 * f;
+	float u = (2.0f * f3 - 3.0f * f2 + 1.0f) * parameters[0] + (f3 - 2.0f * f2 + f) * m0 +
+		(3.0f * f2 - 2.0f * f3) * parameters[1] + (f3 - f2) * m1;
+	return ((float)segment + u) / (float)segments;
+}
+
+void Spline::BulkEvaluate(float* outX, float* outY, float* outZ, const float* t, unsigned count) const
+{
+	::BulkEvaluate(outX, outY, outZ, this, nullptr, t, count);
+}
+
+void Spline::BulkGetParameter(float* t, const float* distances, unsigned count) const
+{
+	for (unsigned i = 0; i < count; ++i)
+		t[i] = GetParameter(distances[i]);
+}
+
+void Spline::BulkEvaluate(float* outX, float* outY, float* outZ, const Spline* const* splines, const float* t,
+	unsigned count)
+{
+	::BulkEvaluate(outX, outY, outZ, nullptr, splines, t, count);
+}
+
+void QuaternionSpline::SetRotations(const Quaternion* rotations, unsigned count)
+{
+	m_Keys.resize(count);
+	for (unsigned i = 0; i < count; ++i) {
+		m_Keys[i] = rotations[i].Normalized();
+		if (i > 0 && m_Keys[i].Dot(m_Keys[i - 1]) < 0.0f)
+			m_Keys[i] = -m_Keys[i];
+	}
+
+	// s_i = q_i * exp(-(log(q_i^-1 * q_i+1) + log(q_i^-1 * q_i-1)) / 4) makes the tangents of neighbouring
+	// segments meet at every key. The end keys are their own controls.
+	m_Controls = m_Keys;
+	for (unsigned i = 1; i + 1 < count; ++i) {
+		Quaternion inverse = m_Keys[i].Conjugate();
+		Vector3 tangent = (Log(inverse * m_Keys[i + 1]) + Log(inverse * m_Keys[i - 1])) * -0.25f;
+		m_Controls[i] = (m_Keys[i] * Exp(tangent)).Normalized();
+	}
+}
+
+void QuaternionSpline::Clear()
+{
+	m_Keys.clear();
+	m_Controls.clear();
+}
+
+void QuaternionSpline::Locate(float t, unsigned& segment, float& u) const
+{
+	unsigned count = GetSegmentCount();
+	float scaled = Math::Clamp(t, 0.0f, 1.0f) * (float)count;
+	segment = (unsigned)scaled;
+	if (segment >= count)
+		segment = count - 1;
+	u = scaled - (float)segment;
+}
+
+Quaternion QuaternionSpline::GetRotation(float t) const
+{
+	if (m_Keys.size() < 2)
+		return m_Keys.empty() ? Quaternion::IDENTITY : m_Keys[0];
+
+	unsigned segment;
+	float u;
+	Locate(t, segment, u);
+	return Squad(m_Keys[segment], m_Keys[segment + 1], m_Controls[segment], m_Controls[segment + 1], u);
+}
+
+void QuaternionSpline::BulkEvaluate(Quaternion* dest, const float* t, unsigned count) const
+{
+	if (m_Keys.size() < 2) {
+		for (unsigned i = 0; i < count; ++i)
+			dest[i] = GetRotation(0.0f);
+		return;
+	}
+
+	// Gather the keys and controls of a block of queries, then run the three slerps of squad over the block.
+	const unsigned kBLOCK = 64;
+	Quaternion q0[kBLOCK], q1[kBLOCK], s0[kBLOCK], s1[kBLOCK];
+	float u[kBLOCK], blend[kBLOCK];
+	for (unsigned begin = 0; begin < count; begin += kBLOCK) {
+		unsigned size = count - begin < kBLOCK ? count - begin : kBLOCK;
+		for (unsigned i = 0; i < size; ++i) {
+			unsigned segment;
+			Locate(t[begin + i], segment, u[i]);
+			q0[i] = m_Keys[segment];
+			q1[i] = m_Keys[segment + 1];
+			s0[i] = m_Controls[segment];
+			s1[i] = m_Controls[segment + 1];
+			blend[i] = 2.0f * u[i] * (1.0f - u[i]);
+		}
+		Quaternion::BulkSlerp(q0, q0, q1, u, size);
+		Quaternion::BulkSlerp(s0, s0, s1, u, size);
+		Quaternion::BulkSlerp(dest + begin, q0, s0, blend, size);
+	}
+}
+
+MATH_CONTRACT_OFF_END
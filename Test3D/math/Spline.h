@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Quaternion.h"
+
+#include <vector>
+
+MATH_CONTRACT_OFF_BEGIN
+
+// Piecewise cubic curves for camera paths, animation curves and tweens.
+//
+// A Spline turns its control points into one cubic polynomial per segment when they are set, so evaluation is a
+// segment lookup and three Horner polynomials whatever the curve type. The curve parameter t runs from 0 to 1 over
+// the whole curve, every segment taking an equal share. Curves with unevenly spaced points are not traversed at
+// constant speed in t; the arc-length table maps a distance along the curve to t in constant time for that.
+//
+// All queries are const and may run from several threads once the points are set.
+
+enum class SplineType
+{
+	/// Piecewise cubic Bezier: segment i runs from point 3i to point 3i + 3 with points 3i + 1 and 3i + 2 as handles.
+	Bezier,
+	/// Uniform Catmull-Rom through every point. The ends use mirrored phantom points.
+	CatmullRom,
+	/// Cubic Hermite through every point with one tangent per point.
+	Hermite,
+	/// Uniform cubic B-spline: C2 continuous, approximating the points. Segment i is shaped by points i to i + 3;
+	/// repeat the end points to pull the curve onto them.
+	BSpline,
+};
+
+class Spline
+{
+public:
+	/// Arc-length table entries per segment unless set otherwise.
+	static const unsigned DEFAULT_ARC_LENGTH_RESOLUTION = 16;
+
+	Spline();
+
+	/// Set the points, and for Hermite curves one tangent per point, and rebuild the segments and the arc-length
+	/// table. Tangents are with respect to the parameter of their segment. A Hermite curve without them is a
+	/// programming error; release builds give it zero tangents.
+	void SetPoints(SplineType type, const Vector3* points, unsigned count, const Vector3* tangents = nullptr);
+	void SetPoints(SplineType type, const std::vector<Vector3>& points);
+	void SetPoints(SplineType type, const std::vector<Vector3>& points, const std::vector<Vector3>& tangents);
+	/// Set the arc-length table entries per segment and rebuild the table. More entries cost memory and build time
+	/// but no query time.
+	void SetArcLengthResolution(unsigned resolution);
+	void Clear();
+
+	SplineType                  GetType() const         { return m_Type; }
+	const std::vector<Vector3>& GetPoints() const       { return m_Points; }
+	const std::vector<Vector3>& GetTangents() const     { return m_Tangents; }
+	unsigned                    GetSegmentCount() const { return (unsigned)m_Segments.size(); }
+
+	/// Return the point at t in [0, 1]. Without a segment the first point, or zero without points.
+	Vector3 GetPoint(float t) const;
+	/// Return the derivative with respect to t.
+	Vector3 GetDerivative(float t) const;
+
+	/// Return the length of the curve.
+	float   GetLength() const { return m_Length; }
+	/// Return the t at the given distance along the curve, clamped to the curve, in constant time: a bucket lookup
+	/// finds the segment, and its table is interpolated with cubic Hermite steps that use the speed of the curve
+	/// as the slope.
+	float   GetParameter(float distance) const;
+	/// Return the point at the given distance along the curve.
+	Vector3 GetPointAtDistance(float distance) const { return GetPoint(GetParameter(distance)); }
+
+	/// Evaluate the curve at count values of t into separate x, y and z arrays, with the same results as GetPoint.
+	void BulkEvaluate(float* outX, float* outY, float* outZ, const float* t, unsigned count) const;
+	/// Compute GetParameter for count distances. t may alias distances.
+	void BulkGetParameter(float* t, const float* distances, unsigned count) const;
+	/// Evaluate curve splines[i] at t[i] for count curves, with the same results as GetPoint.
+	static void BulkEvaluate(float* outX, float* outY, float* outZ, const Spline* const* splines, const float* t,
+		unsigned count);
+
+	/// Power-basis coefficients of a segment, p(u) = ((d * u + c) * u + b) * u + a for u in [0, 1].
+	struct Segment
+	{
+		Vector3 a;
+		Vector3 b;
+		Vector3 c;
+		Vector3 d;
+	};
+
+	/// Return the segment t falls in and the parameter u within it. Without a segment, a constant one at the
+	/// first point.
+	const Segment& GetSegment(float t, float& u) const;
+
+private:
+	void BuildSegments();
+	void BuildArcLengthTable();
+	/// Length of segment between u0 and u1.
+	float SegmentLength(unsigned segment, float u0, float u1) const;
+	/// Speed |dp/du| within a segment.
+	float SegmentSpeed(unsigned segment, float u) const;
+
+	SplineType            m_Type;
+	std::vector<Vector3>  m_Points;
+	std::vector<Vector3>  m_Tangents;
+	std::vector<Segment>  m_Segments;
+	/// Segment returned when there is none.
+	Segment               m_Constant;
+
+	/// Distance along the curve at the start of every segment, plus the length.
+	std::vector<float>    m_SegmentStarts;
+	/// u and du/ds at equal distances along every segment, m_ArcLengthResolution + 1 entries per segment.
+	std::vector<float>    m_TableParameters;
+	std::vector<float>    m_TableSlopes;
+	/// Segment at the start of every bucket of m_BucketStep length.
+	std::vector<unsigned> m_Buckets;
+	unsigned              m_ArcLengthResolution;
+	float                 m_Length;
+	float                 m_BucketStep;
+};
+
+/// Rotation curve through key rotations with spherical quadrangle interpolation (squad), which is C1 continuous
+/// where a chain of slerps has corners. Every key is moved into the hemisphere of the previous one, so each
+/// segment takes the shorter arc.
+class QuaternionSpline
+{
+public:
+	QuaternionSpline() {}
+
+	/// Set the key rotations and rebuild the inner control rotations.
+	void SetRotations(const Quaternion* rotations, unsigned count);
+	void SetRotations(const std::vector<Quaternion>& rotations) { SetRotations(rotations.data(), (unsigned)rotations.size()); }
+	void Clear();
+
+	const std::vector<Quaternion>& GetRotations() const    { return m_Keys; }
+	unsigned                       GetSegmentCount() const { return m_Keys.empty() ? 0 : (unsigned)m_Keys.size() - 1; }
+
+	/// Return the rotation at t in [0, 1], every key interval taking an equal share.
+	Quaternion GetRotation(float t) const;
+	/// Evaluate count values of t, with the same results as GetRotation.
+	void BulkEvaluate(Quaternion* dest, const float* t, unsigned count) const;
+
+private:
+	void Locate(float t, unsigned& segment, float& u) const;
+
+	std::vector<Quaternion> m_Keys;
+	/// Inner control rotation of every key.
+	std::vector<Quaternion> m_Controls;
+};
+
+MATH_CONTRACT_OFF_END
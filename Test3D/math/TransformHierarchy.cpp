@@ -0,0 +1,226 @@
+#include "TransformHierarchy.h"
+#include "Parallel.h"
+
+#include <assert.h>
+#include <condition_variable>
+#include <mutex>
+#include <string.h>
+
+MATH_CONTRACT_OFF_BEGIN
+
+namespace
+{
+
+/// Nodes per thread range within a level: one cache line of dirty flags.
+const unsigned kPARALLEL_GRAIN = 64;
+
+/// Reusable barrier for a fixed number of threads.
+class Barrier
+{
+public:
+	explicit Barrier(unsigned count) : m_Count(count), m_Waiting(0), m_Generation(0) {}
+
+	void Wait()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		unsigned generation = m_Generation;
+		if (++m_Waiting == m_Count) {
+			m_Waiting = 0;
+			++m_Generation;
+			m_Condition.notify_all();
+		}
+		else
+			m_Condition.wait(lock, [&]() { return generation != m_Generation; });
+	}
+
+private:
+	std::mutex              m_Mutex;
+	std::condition_variable m_Condition;
+	unsigned                m_Count;
+	unsigned                m_Waiting;
+	unsigned                m_Generation;
+};
+
+template <class T>
+void Permute(std::vector<T>& values, const std::vector<unsigned>& newSlots)
+{
+	std::vector<T> sorted(values.size());
+	for (unsigned slot = 0; slot < values.size(); ++slot)
+		sorted[newSlots[slot]] = values[slot];
+	values.swap(sorted);
+}
+
+}
+
+TransformHierarchy::TransformHierarchy() :
+	m_Sorted(true),
+	m_AnyDirty(false)
+{
+}
+
+unsigned TransformHierarchy::AddNode(unsigned parent, const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+{
+	assert(parent == NO_PARENT || parent < GetNodeCount());
+
+	// New nodes go to the end and are sorted into their level by the next Update.
+	unsigned handle = GetNodeCount();
+	unsigned parentSlot = parent == NO_PARENT ? NO_PARENT : m_Slots[parent];
+	m_Slots.push_back(handle);
+	m_ParentHandles.push_back(parent);
+	m_Parents.push_back(parentSlot);
+	m_Depths.push_back(parent == NO_PARENT ? 0 : m_Depths[parentSlot] + 1);
+	m_Positions.push_back(position);
+	m_Rotations.push_back(rotation);
+	m_Scales.push_back(scale);
+	m_World.push_back(Matrix3x4::IDENTITY);
+	m_Dirty.push_back(1);
+	m_Sorted = false;
+	m_AnyDirty = true;
+	return handle;
+}
+
+void TransformHierarchy::Reserve(unsigned count)
+{
+	m_Slots.reserve(count);
+	m_ParentHandles.reserve(count);
+	m_Parents.reserve(count);
+	m_Depths.reserve(count);
+	m_Positions.reserve(count);
+	m_Rotations.reserve(count);
+	m_Scales.reserve(count);
+	m_World.reserve(count);
+	m_Dirty.reserve(count);
+}
+
+void TransformHierarchy::Clear()
+{
+	m_Slots.clear();
+	m_ParentHandles.clear();
+	m_Parents.clear();
+	m_Depths.clear();
+	m_Positions.clear();
+	m_Rotations.clear();
+	m_Scales.clear();
+	m_World.clear();
+	m_Dirty.clear();
+	m_LevelStarts.clear();
+	m_Sorted = true;
+	m_AnyDirty = false;
+}
+
+void TransformHierarchy::SetPosition(unsigned node, const Vector3& position)
+{
+	unsigned slot = m_Slots[node];
+	m_Positions[slot] = position;
+	MarkDirty(slot);
+}
+
+void TransformHierarchy::SetRotation(unsigned node, const Quaternion& rotation)
+{
+	unsigned slot = m_Slots[node];
+	m_Rotations[slot] = rotation;
+	MarkDirty(slot);
+}
+
+void TransformHierarchy::SetScale(unsigned node, const Vector3& scale)
+{
+	unsigned slot = m_Slots[node];
+	m_Scales[slot] = scale;
+	MarkDirty(slot);
+}
+
+void TransformHierarchy::SetTransform(unsigned node, const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+{
+	unsigned slot = m_Slots[node];
+	m_Positions[slot] = position;
+	m_Rotations[slot] = rotation;
+	m_Scales[slot] = scale;
+	MarkDirty(slot);
+}
+
+void TransformHierarchy::Update(unsigned threadCount)
+{
+	if (!m_Sorted)
+		SortByDepth();
+	if (!m_AnyDirty)
+		return;
+
+	unsigned count = GetNodeCount();
+	unsigned levels = GetDepthCount();
+	if (!threadCount)
+		threadCount = std::thread::hardware_concurrency();
+
+	if (threadCount <= 1 || count < threadCount * kPARALLEL_GRAIN)
+		UpdateRange(0, count);
+	else {
+		// One range of every level per thread, with a barrier between levels so that the parents are done.
+		Barrier barrier(threadCount);
+		Math::ParallelFor(threadCount, 1, threadCount, [&](unsigned thread, unsigned) {
+			for (unsigned level = 0; level < levels; ++level) {
+				unsigned begin = m_LevelStarts[level];
+				unsigned size = m_LevelStarts[level + 1] - begin;
+				unsigned blocks = (size + kPARALLEL_GRAIN - 1) / kPARALLEL_GRAIN;
+				unsigned first = blocks * thread / threadCount * kPARALLEL_GRAIN;
+				unsigned last = blocks * (thread + 1) / threadCount * kPARALLEL_GRAIN;
+				UpdateRange(begin + (first < size ? first : size), begin + (last < size ? last : size));
+				if (level + 1 < levels)
+					barrier.Wait();
+			}
+		});
+	}
+
+	memset(&m_Dirty[0], 0, count);
+	m_AnyDirty = false;
+}
+
+void TransformHierarchy::SortByDepth()
+{
+	unsigned count = GetNodeCount();
+	unsigned levels = 0;
+	for (unsigned slot = 0; slot < count; ++slot) {
+		if (m_Depths[slot] >= levels)
+			levels = m_Depths[slot] + 1;
+	}
+
+	m_LevelStarts.assign(levels + 1, 0);
+	for (unsigned slot = 0; slot < count; ++slot)
+		++m_LevelStarts[m_Depths[slot] + 1];
+	for (unsigned level = 0; level < levels; ++level)
+		m_LevelStarts[level + 1] += m_LevelStarts[level];
+
+	// Stable, so nodes already in order keep their slots.
+	std::vector<unsigned> next(m_LevelStarts.begin(), m_LevelStarts.end() - 1);
+	std::vector<unsigned> newSlots(count);
+	for (unsigned slot = 0; slot < count; ++slot)
+		newSlots[slot] = next[m_Depths[slot]]++;
+
+	for (unsigned slot = 0; slot < count; ++slot) {
+		if (m_Parents[slot] != NO_PARENT)
+			m_Parents[slot] = newSlots[m_Parents[slot]];
+	}
+	Permute(m_Parents, newSlots);
+	Permute(m_Depths, newSlots);
+	Permute(m_Positions, newSlots);
+	Permute(m_Rotations, newSlots);
+	Permute(m_Scales, newSlots);
+	Permute(m_World, newSlots);
+	Permute(m_Dirty, newSlots);
+	for (unsigned handle = 0; handle < count; ++handle)
+		m_Slots[handle] = newSlots[m_Slots[handle]];
+	m_Sorted = true;
+}
+
+void TransformHierarchy::UpdateRange(unsigned begin, unsigned end)
+{
+	for (unsigned i = begin; i < end; ++i) {
+		unsigned parent = m_Parents[i];
+		if (parent != NO_PARENT)
+			m_Dirty[i] |= m_Dirty[parent];
+		if (m_Dirty[i]) {
+			Matrix3x4 local(m_Positions[i], m_Rotations[i], m_Scales[i]);
+			m_World[i] = parent == NO_PARENT ? local : m_World[parent] * local;
+		}
+	}
+}
+
+MATH_CONTRACT_OFF_END
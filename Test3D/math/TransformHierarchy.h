@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Matrix3x4.h"
+
+#include <vector>
+
+MATH_CONTRACT_OFF_BEGIN
+
+/// Parent-child transform hierarchy updated in one linear pass.
+///
+/// Nodes are kept in structure-of-arrays form sorted by depth, so every parent precedes its children and each
+/// depth level is one contiguous range. Update walks the arrays once, propagating dirty flags from parent to child
+/// and recomputing the world transform only below nodes whose local transform changed. Within a level no node
+/// depends on another, so the pass splits across threads level by level.
+///
+/// A node is referred to by the handle AddNode returns, which stays valid until Clear. Nodes added since the last
+/// Update are sorted into place by the next one.
+class TransformHierarchy
+{
+public:
+	/// Parent of root nodes.
+	static const unsigned NO_PARENT = 0xffffffffu;
+
+	TransformHierarchy();
+
+	/// Add a node under an existing node or NO_PARENT and return its handle.
+	unsigned AddNode(unsigned parent, const Vector3& position = Vector3::ZERO,
+		const Quaternion& rotation = Quaternion::IDENTITY, const Vector3& scale = Vector3::ONE);
+	void     Reserve(unsigned count);
+	void     Clear();
+
+	void SetPosition(unsigned node, const Vector3& position);
+	void SetRotation(unsigned node, const Quaternion& rotation);
+	void SetScale(unsigned node, const Vector3& scale);
+	void SetTransform(unsigned node, const Vector3& position, const Quaternion& rotation, const Vector3& scale);
+
+	const Vector3&    GetPosition(unsigned node) const { return m_Positions[m_Slots[node]]; }
+	const Quaternion& GetRotation(unsigned node) const { return m_Rotations[m_Slots[node]]; }
+	const Vector3&    GetScale(unsigned node) const    { return m_Scales[m_Slots[node]]; }
+	unsigned          GetParent(unsigned node) const   { return m_ParentHandles[node]; }
+	/// Return the local-to-world transform as of the last Update.
+	const Matrix3x4&  GetWorldTransform(unsigned node) const { return m_World[m_Slots[node]]; }
+	unsigned          GetNodeCount() const { return (unsigned)m_Slots.size(); }
+	unsigned          GetDepthCount() const { return m_LevelStarts.empty() ? 0 : (unsigned)m_LevelStarts.size() - 1; }
+
+	/// Recompute the world transforms of changed nodes and their descendants. threadCount 1 runs on the calling
+	/// thread only, 0 uses one thread per hardware thread. The result does not depend on the thread count.
+	void Update(unsigned threadCount = 1);
+
+private:
+	void MarkDirty(unsigned slot)
+	{
+		m_Dirty[slot] = 1;
+		m_AnyDirty = true;
+	}
+	/// Stable counting sort of the slots by depth.
+	void SortByDepth();
+	void UpdateRange(unsigned begin, unsigned end);
+
+	/// Slot of each handle.
+	std::vector<unsigned>      m_Slots;
+	/// Parent handle of each handle.
+	std::vector<unsigned>      m_ParentHandles;
+
+	// Per slot, in depth order once sorted.
+	std::vector<unsigned>      m_Parents;
+	std::vector<unsigned>      m_Depths;
+	std::vector<Vector3>       m_Positions;
+	std::vector<Quaternion>    m_Rotations;
+	std::vector<Vector3>       m_Scales;
+	std::vector<Matrix3x4>     m_World;
+	std::vector<unsigned char> m_Dirty;
+
+	/// First slot of every depth level, plus the slot count.
+	std::vector<unsigned>      m_LevelStarts;
+	bool                       m_Sorted;
+	bool                       m_AnyDirty;
+};
+
+MATH_CONTRACT_OFF_END
@@ -2,22 +2,19 @@
 #include "Vector3.h"
 #include "Vector4.h"
 
-const Vector2 Vector2::ZERO;
-const Vector2 Vector2::LEFT(-1.0f, 0.0f);
-const Vector2 Vector2::RIGHT(1.0f, 0.0f);
-const Vector2 Vector2::UP(0.0f, 1.0f);
-const Vector2 Vector2::DOWN(0.0f, -1.0f);
-const Vector2 Vector2::ONE(1.0f, 1.0f);
+MATH_CONTRACT_OFF_BEGIN
 
+// The constants are inline constexpr in the headers. These checks run at compile time and cost nothing at runtime.
 
-const Vector3 Vector3::ZERO;
-const Vector3 Vector3::LEFT(-1.0f, 0.0f, 0.0f);
-const Vector3 Vector3::RIGHT(1.0f, 0.0f, 0.0f);
-const Vector3 Vector3::UP(0.0f, 0.0f, 1.0f);
-const Vector3 Vector3::DOWN(0.0f, 0.0f, -1.0f);
-const Vector3 Vector3::FORWARD(0.0f, 1.0f, 0.0f);
-const Vector3 Vector3::BACK(0.0f, -1.0f, 0.0f);
-const Vector3 Vector3::ONE(1.0f, 1.0f, 1.0f);
+static_assert(Vector2::LEFT == -Vector2::RIGHT && Vector2::DOWN == -Vector2::UP, "Vector2 axes");
+static_assert(Vector2::ONE.Dot(Vector2::UP) == 1.0f && (Vector2::ONE * 2.0f - Vector2::ONE) == Vector2::ONE, "Vector2 arithmetic");
 
-const Vector4 Vector4::ZERO;
-const Vector4 Vector4::ONE(1.0f, 1.0f, 1.0f, 1.0f);
\ No newline at end of file
+static_assert(Vector3::LEFT == -Vector3::RIGHT && Vector3::DOWN == -Vector3::UP && Vector3::BACK == -Vector3::FORWARD, "Vector3 axes");
+static_assert(Vector3::RIGHT.Cross(Vector3::FORWARD) == Vector3::UP, "Vector3 basis is right-handed");
+static_assert(Vector3::FORWARD.Cross(Vector3::UP) == Vector3::RIGHT && Vector3::UP.Cross(Vector3::RIGHT) == Vector3::FORWARD, "Vector3 cross");
+static_assert(Vector3::RIGHT + Vector3::FORWARD + Vector3::UP == Vector3::ONE && Vector3::ONE.LengthSquared() == 3.0f, "Vector3 arithmetic");
+static_assert(Vector3::UP.Lerp(Vector3::DOWN, 0.5f) == Vector3::ZERO && Vector3(Vector2::ONE, 1.0f) == Vector3::ONE, "Vector3 lerp");
+
+static_assert(Vector4(Vector3::ONE, 1.0f) == Vector4::ONE && Vector4::ONE.Dot(Vector4::ONE) == 4.0f, "Vector4 arithmetic");
+
+MATH_CONTRACT_OFF_END
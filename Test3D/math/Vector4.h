@@ -1,10 +1,13 @@
 #pragma once
 
 #include "Vector3.h"
+
+MATH_CONTRACT_OFF_BEGIN
+
 class Vector4
 {
 public:
-	Vector4() :
+	constexpr Vector4() :
 		x(0.0f),
 		y(0.0f),
 		z(0.0f),
@@ -12,7 +15,7 @@ public:
 	{
 	}
 
-	Vector4(const Vector4& vector) :
+	constexpr Vector4(const Vector4& vector) :
 		x(vector.x),
 		y(vector.y),
 		z(vector.z),
@@ -20,7 +23,7 @@ public:
 	{
 	}
 
-	Vector4(const Vector3& vector, float _w) :
+	constexpr Vector4(const Vector3& vector, float _w) :
 		x(vector.x),
 		y(vector.y),
 		z(vector.z),
@@ -28,7 +31,7 @@ public:
 	{
 	}
 
-	Vector4(float _x, float _y, float _z, float _w) :
+	constexpr Vector4(float _x, float _y, float _z, float _w) :
 		x(_x),
 		y(_y),
 		z(_z),
@@ -36,7 +39,7 @@ public:
 	{
 	}
 
-	explicit Vector4(const float* data) :
+	explicit constexpr Vector4(const float* data) :
 		x(data[0]),
 		y(data[1]),
 		z(data[2]),
@@ -44,7 +47,7 @@ public:
 	{
 	}
 
-	Vector4& operator =(const Vector4& rhs)
+	constexpr Vector4& operator =(const Vector4& rhs)
 	{
 		x = rhs.x;
 		y = rhs.y;
@@ -53,17 +56,17 @@ public:
 		return *this;
 	}
 
-	bool operator ==(const Vector4& rhs) const { return x == rhs.x && y == rhs.y && z == rhs.z && w == rhs.w; }
-	bool operator !=(const Vector4& rhs) const { return x != rhs.x || y != rhs.y || z != rhs.z || w != rhs.w; }
-
-	Vector4 operator +(const Vector4& rhs) const { return Vector4(x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w); }
-	Vector4 operator -() const { return Vector4(-x, -y, -z, -w); }
-	Vector4 operator -(const Vector4& rhs) const { return Vector4(x - rhs.x, y - rhs.y, z - rhs.z, w - rhs.w); }
-	Vector4 operator *(float rhs) const { return Vector4(x * rhs, y * rhs, z * rhs, w * rhs); }
-	Vector4 operator *(const Vector4& rhs) const { return Vector4(x * rhs.x, y * rhs.y, z * rhs.z, w * rhs.w); }
-	Vector4 operator /(float rhs) const { return Vector4(x / rhs, y / rhs, z / rhs, w / rhs); }
-	Vector4 operator /(const Vector4& rhs) const { return Vector4(x / rhs.x, y / rhs.y, z / rhs.z, w / rhs.w); }
-	Vector4& operator +=(const Vector4& rhs)
+	constexpr bool operator ==(const Vector4& rhs) const { return x == rhs.x && y == rhs.y && z == rhs.z && w == rhs.w; }
+	constexpr bool operator !=(const Vector4& rhs) const { return x != rhs.x || y != rhs.y || z != rhs.z || w != rhs.w; }
+
+	constexpr Vector4 operator +(const Vector4& rhs) const { return Vector4(x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w); }
+	constexpr Vector4 operator -() const { return Vector4(-x, -y, -z, -w); }
+	constexpr Vector4 operator -(const Vector4& rhs) const { return Vector4(x - rhs.x, y - rhs.y, z - rhs.z, w - rhs.w); }
+	constexpr Vector4 operator *(float rhs) const { return Vector4(x * rhs, y * rhs, z * rhs, w * rhs); }
+	constexpr Vector4 operator *(const Vector4& rhs) const { return Vector4(x * rhs.x, y * rhs.y, z * rhs.z, w * rhs.w); }
+	constexpr Vector4 operator /(float rhs) const { return Vector4(x / rhs, y / rhs, z / rhs, w / rhs); }
+	constexpr Vector4 operator /(const Vector4& rhs) const { return Vector4(x / rhs.x, y / rhs.y, z / rhs.z, w / rhs.w); }
+	constexpr Vector4& operator +=(const Vector4& rhs)
 	{
 		x += rhs.x;
 		y += rhs.y;
@@ -71,7 +74,7 @@ public:
 		w += rhs.w;
 		return *this;
 	}
-	Vector4& operator -=(const Vector4& rhs)
+	constexpr Vector4& operator -=(const Vector4& rhs)
 	{
 		x -= rhs.x;
 		y -= rhs.y;
@@ -79,7 +82,7 @@ public:
 		w -= rhs.w;
 		return *this;
 	}
-	Vector4& operator *=(float rhs)
+	constexpr Vector4& operator *=(float rhs)
 	{
 		x *= rhs;
 		y *= rhs;
@@ -87,7 +90,7 @@ public:
 		w *= rhs;
 		return *this;
 	}
-	Vector4& operator *=(const Vector4& rhs)
+	constexpr Vector4& operator *=(const Vector4& rhs)
 	{
 		x *= rhs.x;
 		y *= rhs.y;
@@ -95,7 +98,7 @@ public:
 		w *= rhs.w;
 		return *this;
 	}
-	Vector4& operator /=(float rhs)
+	constexpr Vector4& operator /=(float rhs)
 	{
 		float invRhs = 1.0f / rhs;
 		x *= invRhs;
@@ -104,7 +107,7 @@ public:
 		w *= invRhs;
 		return *this;
 	}
-	Vector4& operator /=(const Vector4& rhs)
+	constexpr Vector4& operator /=(const Vector4& rhs)
 	{
 		x /= rhs.x;
 		y /= rhs.y;
@@ -112,18 +115,18 @@ public:
 		w /= rhs.w;
 		return *this;
 	}
-	float Dot(const Vector4& rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z + w * rhs.w; }
+	constexpr float Dot(const Vector4& rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z + w * rhs.w; }
 
-	float AbsDot(const Vector4& rhs) const
+	constexpr float AbsDot(const Vector4& rhs) const
 	{
 		return Math::Abs(x * rhs.x) + Math::Abs(y * rhs.y) + Math::Abs(z * rhs.z) + Math::Abs(w * rhs.w);
 	}
 
-	Vector4 Abs() const { return Vector4(Math::Abs(x), Math::Abs(y), Math::Abs(z), Math::Abs(w)); }
+	constexpr Vector4 Abs() const { return Vector4(Math::Abs(x), Math::Abs(y), Math::Abs(z), Math::Abs(w)); }
 
-	Vector4 Lerp(const Vector4& rhs, float t) const { return *this * (1.0f - t) + rhs * t; }
+	constexpr Vector4 Lerp(const Vector4& rhs, float t) const { return *this * (1.0f - t) + rhs * t; }
 
-	bool Equals(const Vector4& rhs, float epsilon=Math::kLARGE_EPSILON) const
+	constexpr bool Equals(const Vector4& rhs, float epsilon=Math::kLARGE_EPSILON) const
 	{
 		return Math::Equals(x, rhs.x, epsilon) && Math::Equals(y, rhs.y, epsilon) && 
 			Math::Equals(z, rhs.z, epsilon) && Math::Equals(w, rhs.w, epsilon);
@@ -144,4 +147,9 @@ public:
 	static const Vector4 ONE;
 };
 
-inline Vector4 operator *(float lhs, const Vector4& rhs) { return rhs * lhs; }
\ No newline at end of file
+inline constexpr Vector4 Vector4::ZERO;
+inline constexpr Vector4 Vector4::ONE(1.0f, 1.0f, 1.0f, 1.0f);
+
+constexpr Vector4 operator *(float lhs, const Vector4& rhs) { return rhs * lhs; }
+
+MATH_CONTRACT_OFF_END
\ No newline at end of file
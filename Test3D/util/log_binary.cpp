@@ -0,0 +1,218 @@
+#include "log_binary.h"
+#include "log_format.h"
+
+#include <chrono>
+#include <string.h>
+
+static const char LOG_BINARY_MAGIC[8] = { 'T', '3', 'D', 'B', 'L', 'O', 'G', 2 };
+/// Size of the file buffer, so that a batch of messages reaches the file in few writes.
+static const unsigned LOG_BINARY_BUFFER_SIZE = 1 << 16;
+
+/// Append value as an unsigned LEB128 varint and return the end.
+static unsigned char* util_log_put_varint(unsigned char* out, unsigned long long value)
+{
+	while (value >= 0x80) {
+		*out++ = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (unsigned char)value;
+	return out;
+}
+
+static unsigned long long util_log_zigzag(long long value)
+{
+	return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+}
+
+BinaryLogSink::BinaryLogSink(const char* path) :
+	m_File(fopen(path, "wb")),
+	m_Time(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+{
+	if (!m_File)
+		return;
+	setvbuf(m_File, nullptr, _IOFBF, LOG_BINARY_BUFFER_SIZE);
+
+	long long wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	fwrite(LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC), 1, m_File);
+	fwrite(&m_Time, sizeof(m_Time), 1, m_File);
+	fwrite(&wall, sizeof(wall), 1, m_File);
+}
+
+BinaryLogSink::~BinaryLogSink()
+{
+	if (m_File)
+		fclose(m_File);
+}
+
+void BinaryLogSink::WriteSite(const LogSite& site)
+{
+	unsigned id = site.id.load(std::memory_order_relaxed);
+	if (id >= m_Written.size())
+		m_Written.resize(id + 64);
+	m_Written[id] = true;
+
+	unsigned char head[32];
+	unsigned char* out = head;
+	*out++ = 'S';
+	out = util_log_put_varint(out, id);
+	out = util_log_put_varint(out, (unsigned)site.category);
+	out = util_log_put_varint(out, (unsigned)site.level);
+	out = util_log_put_varint(out, (unsigned)site.line);
+	fwrite(head, out - head, 1, m_File);
+	const char* strings[] = { site.fmt, site.types, site.file, site.func };
+	for (const char* text : strings)
+		fwrite(text ? text : "", text ? strlen(text) + 1 : 1, 1, m_File);
+}
+
+void BinaryLogSink::Write(const LogRecord& record)
+{
+	if (!m_File)
+		return;
+
+	unsigned char head[64];
+	unsigned char* out = head;
+	if (record.site) {
+		unsigned id = record.site->id.load(std::memory_order_relaxed);
+		if (id >= m_Written.size() || !m_Written[id])
+			WriteSite(*record.site);
+		*out++ = 'M';
+		out = util_log_put_varint(out, util_log_zigzag(record.time - m_Time));
+		out = util_log_put_varint(out, record.thread);
+		out = util_log_put_varint(out, id);
+		out = util_log_put_varint(out, record.args_size);
+		fwrite(head, out - head, 1, m_File);
+		fwrite(record.args, record.args_size, 1, m_File);
+	}
+	else {
+		*out++ = 'T';
+		out = util_log_put_varint(out, util_log_zigzag(record.time - m_Time));
+		out = util_log_put_varint(out, record.thread);
+		out = util_log_put_varint(out, (unsigned)record.category);
+		out = util_log_put_varint(out, (unsigned)record.level);
+		out = util_log_put_varint(out, (unsigned)record.line);
+		fwrite(head, out - head, 1, m_File);
+		fwrite(record.text, record.length, 1, m_File);
+		fputc(0, m_File);
+		const char* strings[] = { record.file, record.func };
+		for (const char* text : strings)
+			fwrite(text ? text : "", text ? strlen(text) + 1 : 1, 1, m_File);
+	}
+	m_Time = record.time;
+}
+
+void BinaryLogSink::Flush()
+{
+	if (m_File)
+		fflush(m_File);
+}
+
+BinaryLogReader::BinaryLogReader(const void* data, size_t size) :
+	m_Data(static_cast<const unsigned char*>(data)),
+	m_End(static_cast<const unsigned char*>(data) + size),
+	m_Valid(false),
+	m_StartTime(0),
+	m_StartWall(0),
+	m_Time(0)
+{
+	m_Text[0] = 0;
+	if (size < sizeof(LOG_BINARY_MAGIC) + 2 * sizeof(long long) || memcmp(m_Data, LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC)))
+		return;
+	m_Data += sizeof(LOG_BINARY_MAGIC);
+	memcpy(&m_StartTime, m_Data, sizeof(m_StartTime));
+	memcpy(&m_StartWall, m_Data + sizeof(m_StartTime), sizeof(m_StartWall));
+	m_Data += 2 * sizeof(long long);
+	m_Time = m_StartTime;
+	m_Valid = true;
+}
+
+bool BinaryLogReader::ReadVarint(unsigned long long& value)
+{
+	value = 0;
+	for (unsigned shift = 0; shift < 64 && m_Data < m_End; shift += 7) {
+		unsigned char byte = *m_Data++;
+		value |= (unsigned long long)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+bool BinaryLogReader::ReadString(const char*& text)
+{
+	const unsigned char* end = static_cast<const unsigned char*>(memchr(m_Data, 0, m_End - m_Data));
+	if (!end)
+		return false;
+	text = reinterpret_cast<const char*>(m_Data);
+	m_Data = end + 1;
+	return true;
+}
+
+bool BinaryLogReader::Next(LogRecord& record)
+{
+	while (m_Valid && m_Data < m_End) {
+		unsigned char type = *m_Data++;
+		unsigned long long id, category, level, line, time, thread, size;
+
+		if (type == 'S') {
+			Site site;
+			if (!ReadVarint(id) || !ReadVarint(category) || !ReadVarint(level) || !ReadVarint(line) || !ReadString(site.fmt) ||
+				!ReadString(site.types) || !ReadString(site.file) || !ReadString(site.func) || id > 0xffffff)
+				break;
+			site.category = (int)category;
+			site.level = (int)level;
+			site.line = (int)line;
+			if (id >= m_Sites.size())
+				m_Sites.resize((size_t)id + 1, Site());
+			m_Sites[(size_t)id] = site;
+			continue;
+		}
+		if (type != 'M' && type != 'T')
+			break;
+		if (!ReadVarint(time) || !ReadVarint(thread))
+			break;
+		m_Time += (long long)(time >> 1) ^ -(long long)(time & 1);
+
+		record = LogRecord();
+		record.time = m_Time;
+		record.thread = (unsigned)thread;
+		if (type == 'M') {
+			if (!ReadVarint(id) || !ReadVarint(size) || id >= m_Sites.size() || !m_Sites[(size_t)id].fmt ||
+				size > (unsigned long long)(m_End - m_Data))
+				break;
+			const Site& site = m_Sites[(size_t)id];
+			record.category = site.category;
+			record.level = site.level;
+			record.file = site.file;
+			record.func = site.func;
+			record.line = site.line;
+			record.args = m_Data;
+			record.args_size = (unsigned)size;
+			record.length = util_log_format_args(m_Text, sizeof(m_Text), site.fmt, site.types, m_Data, (unsigned)size);
+			record.text = m_Text;
+			m_Data += size;
+		}
+		else {
+			const char* text;
+			const char* file;
+			const char* func;
+			if (!ReadVarint(category) || !ReadVarint(level) || !ReadVarint(line) || !ReadString(text) ||
+				!ReadString(file) || !ReadString(func))
+				break;
+			record.category = (int)category;
+			record.level = (int)level;
+			record.line = (int)line;
+			record.text = text;
+			record.length = (unsigned)strlen(text);
+			record.file = *file ? file : nullptr;
+			record.func = *func ? func : nullptr;
+		}
+		return true;
+	}
+	m_Data = m_End;
+	return false;
+}
+
+time_t BinaryLogReader::WallTime(const LogRecord& record) const
+{
+	return (time_t)((m_StartWall + (record.time - m_StartTime)) / 1000000000);
+}
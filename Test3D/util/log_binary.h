@@ -0,0 +1,84 @@
+#pragma once
+
+#include "log_format.h"
+#include "logger.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+// Binary log files: the arguments of binary messages as they were logged, and the format strings of their call
+// sites once per file. Much smaller than text and cheap to write; tools/log_decode turns a file back into the
+// console's lines.
+//
+// A file starts with a header: the magic "T3DBLOG", a version byte, and the steady and wall clocks in nanoseconds
+// when the file was opened. Records follow, each a type byte and unsigned LEB128 varints:
+//
+//   'S' site     id, category, level, line, then fmt, types, file and func null-terminated; precedes the site's
+//                first message
+//   'M' message  time, thread, site id, argument size, then the arguments as log_format.h describes them
+//   'T' text     time, thread, category, level, line, then text, file and func null-terminated, empty for none
+//
+// Times are zigzag-encoded differences from the previous record's time.
+
+/// Sink that writes a binary log file. Text messages are stored as text.
+class BinaryLogSink : public LogSink
+{
+public:
+	explicit BinaryLogSink(const char* path);
+	~BinaryLogSink();
+
+	bool IsOpen() const { return m_File != nullptr; }
+
+	void Write(const LogRecord& record) override;
+	void Flush() override;
+	bool WantsText() const override { return false; }
+
+private:
+	void WriteSite(const LogSite& site);
+
+	FILE*             m_File;
+	long long         m_Time;
+	std::vector<bool> m_Written; ///< by site id, whether the site record is in the file
+};
+
+/// Reads a binary log file from memory, which has to outlive the reader.
+class BinaryLogReader
+{
+public:
+	BinaryLogReader(const void* data, size_t size);
+
+	/// Whether the data starts with the header of a binary log file of a known version.
+	bool IsValid() const { return m_Valid; }
+
+	/// Decode the next message and format its text into a buffer of the reader, valid until the next call. Returns
+	/// false at the end of the file, or at a damaged or truncated record.
+	bool Next(LogRecord& record);
+
+	/// Wall clock time of a record, in seconds.
+	time_t WallTime(const LogRecord& record) const;
+
+private:
+	struct Site
+	{
+		int         category;
+		int         level;
+		int         line;
+		const char* fmt;
+		const char* types;
+		const char* file;
+		const char* func;
+	};
+
+	bool ReadVarint(unsigned long long& value);
+	bool ReadString(const char*& text);
+
+	const unsigned char* m_Data;
+	const unsigned char* m_End;
+	bool                 m_Valid;
+	long long            m_StartTime;
+	long long            m_StartWall;
+	long long            m_Time;
+	std::vector<Site>    m_Sites;
+	char                 m_Text[LOG_MESSAGE_SIZE];
+};
@@ -0,0 +1,171 @@
+#include "log_file.h"
+#include "log_format.h"
+
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Smallest segment, so that the longest line always fits in an empty file.
+static const unsigned LOG_FILE_MIN_SEGMENT = 1 << 16;
+
+FileLogSink::FileLogSink(const char* path, unsigned segmentSize, unsigned segmentCount) :
+	m_Path(path),
+	m_SegmentSize(segmentSize < LOG_FILE_MIN_SEGMENT ? LOG_FILE_MIN_SEGMENT : segmentSize),
+	m_SegmentCount(segmentCount ? segmentCount : 1),
+	m_View(nullptr),
+	m_Size(0),
+	m_Used(0),
+#ifdef _WIN32
+	m_File(INVALID_HANDLE_VALUE),
+	m_Mapping(nullptr),
+#else
+	m_File(-1),
+#endif
+	m_Start(time(0)),
+	m_StartTime(util_log_time())
+{
+	Open();
+}
+
+FileLogSink::~FileLogSink()
+{
+	Close();
+}
+
+/// Open the file at m_Path, extend it to the segment size and map it, then find where the last run stopped.
+bool FileLogSink::Open()
+{
+	unsigned existing = 0;
+#ifdef _WIN32
+	HANDLE file = CreateFileA(m_Path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart < 0xffffffffLL)
+		existing = (unsigned)fileSize.QuadPart;
+	m_Size = existing > m_SegmentSize ? existing : m_SegmentSize;
+
+	// A mapping larger than the file extends the file.
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, m_Size, nullptr);
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, m_Size) : nullptr;
+	if (!view) {
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	m_File = file;
+	m_Mapping = mapping;
+#else
+	int file = open(m_Path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (file < 0)
+		return false;
+	struct stat fileStat;
+	if (!fstat(file, &fileStat) && fileStat.st_size < 0xffffffffLL)
+		existing = (unsigned)fileStat.st_size;
+	m_Size = existing > m_SegmentSize ? existing : m_SegmentSize;
+
+	// Allocate the blocks up front where the system can, so that a full disk fails here and not in a write to
+	// the mapping.
+#ifdef __linux__
+	bool allocated = !posix_fallocate(file, 0, m_Size);
+#else
+	bool allocated = !ftruncate(file, m_Size);
+#endif
+	// Mapping the pages in up front saves a page fault per page in the writes.
+#ifdef MAP_POPULATE
+	const int populate = MAP_POPULATE;
+#else
+	const int populate = 0;
+#endif
+	void* view = allocated ? mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_SHARED | populate, file, 0) : MAP_FAILED;
+	if (view == MAP_FAILED) {
+		close(file);
+		return false;
+	}
+	m_File = file;
+#endif
+	m_View = static_cast<char*>(view);
+
+	// Keep everything up to the last complete line, and clear a line cut short.
+	m_Used = existing;
+	while (m_Used && m_View[m_Used - 1] != '\n')
+		--m_Used;
+	memset(m_View + m_Used, 0, existing - m_Used);
+	return true;
+}
+
+/// Unmap the file and cut it to the bytes written.
+void FileLogSink::Close()
+{
+	if (!m_View)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(m_View);
+	CloseHandle(m_Mapping);
+	LARGE_INTEGER end;
+	end.QuadPart = m_Used;
+	if (SetFilePointerEx(m_File, end, nullptr, FILE_BEGIN))
+		SetEndOfFile(m_File);
+	CloseHandle(m_File);
+	m_File = INVALID_HANDLE_VALUE;
+	m_Mapping = nullptr;
+#else
+	munmap(m_View, m_Size);
+	// Should this fail, the file keeps its zeros, which the next Open skips.
+	int truncated = ftruncate(m_File, m_Used);
+	(void)truncated;
+	close(m_File);
+	m_File = -1;
+#endif
+	m_View = nullptr;
+	m_Size = 0;
+	m_Used = 0;
+}
+
+void FileLogSink::Rotate()
+{
+	Close();
+
+	char from[1024], to[1024];
+	snprintf(to, sizeof(to), "%s.%u", m_Path.c_str(), m_SegmentCount - 1);
+	remove(m_SegmentCount > 1 ? to : m_Path.c_str());
+	for (unsigned i = m_SegmentCount - 1; i > 1; --i) {
+		snprintf(from, sizeof(from), "%s.%u", m_Path.c_str(), i - 1);
+		snprintf(to, sizeof(to), "%s.%u", m_Path.c_str(), i);
+		rename(from, to);
+	}
+	if (m_SegmentCount > 1) {
+		snprintf(to, sizeof(to), "%s.1", m_Path.c_str());
+		rename(m_Path.c_str(), to);
+	}
+
+	Open();
+}
+
+void FileLogSink::Write(const LogRecord& record)
+{
+	if (!m_View)
+		return;
+
+	char line[LOG_LINE_SIZE];
+	time_t wall = (time_t)(m_Start + (record.time - m_StartTime) / 1000000000);
+	unsigned length = util_log_format_line(line, sizeof(line) - 1, record, m_Clock.Text(wall));
+	line[length++] = '\n';
+
+	if (m_Used + length > m_Size) {
+		Rotate();
+		if (!m_View)
+			return;
+	}
+	memcpy(m_View + m_Used, line, length);
+	m_Used += length;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "log_format.h"
+#include "logger.h"
+
+#include <string>
+#include <time.h>
+
+// Log files written through a memory mapping.
+//
+// The current file is extended to its full segment size when it is opened and mapped, so that a message is one
+// memcpy of its console line into the mapping, without a system call. The mapping belongs to the operating system,
+// which writes it back even when the process crashes. When a line no longer fits, the file is cut to the size
+// written and rotated: path becomes path.1, path.1 becomes path.2 and so on, and the oldest of count files is
+// deleted.
+//
+// A file a crash left behind keeps its pre-allocated size, with zeros, or a line cut short, after the last complete
+// line. Opening it again finds the end of that line and goes on writing from there.
+
+/// Sink that writes the console's lines into rotating memory-mapped files.
+class FileLogSink : public LogSink
+{
+public:
+	/// Write to path, in files of segmentSize bytes, at least 64 KB, keeping segmentCount of them.
+	FileLogSink(const char* path, unsigned segmentSize, unsigned segmentCount);
+	~FileLogSink();
+
+	bool IsOpen() const { return m_View != nullptr; }
+	/// Bytes in the current file.
+	unsigned Size() const { return m_Used; }
+
+	void Write(const LogRecord& record) override;
+
+private:
+	bool Open();
+	void Close();
+	void Rotate();
+
+	std::string m_Path;
+	unsigned    m_SegmentSize;
+	unsigned    m_SegmentCount;
+	char*       m_View;
+	unsigned    m_Size; ///< bytes mapped
+	unsigned    m_Used; ///< bytes written
+#ifdef _WIN32
+	void*       m_File;
+	void*       m_Mapping;
+#else
+	int         m_File;
+#endif
+	/// Wall clock and steady clock when the sink was created, to date records without a clock call per message.
+	time_t      m_Start;
+	long long   m_StartTime;
+	LogClock    m_Clock;
+};
@@ -0,0 +1,336 @@
+#include "log_format.h"
+#include "logger.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char* LogLevelText[LogLevel_Max] = {
+	"", "DBG", "INF", "SYS", "WRN", "ERR",
+};
+
+static const char* LogCategoryText[LogCategory_Max] = {
+	"general", "script", "imgui", "d3d", "input", "camera", "graphic",
+};
+
+/// Longest conversion specification kept, longer ones are copied as text.
+static const unsigned LOG_SPEC_SIZE = 32;
+/// Longest string argument formatted through a specification.
+static const unsigned LOG_STRING_SIZE = 1024;
+
+/// Reads serialized arguments in order of their tags.
+struct LogArgReader
+{
+	const char*          types;
+	const unsigned char* data;
+	const unsigned char* end;
+
+	/// Tag of the next argument, 0 when there is none.
+	char Peek() const { return *types && data < end ? *types : 0; }
+
+	bool Read(void* value, unsigned bytes)
+	{
+		if ((unsigned)(end - data) < bytes)
+			return false;
+		memcpy(value, data, bytes);
+		data += bytes;
+		++types;
+		return true;
+	}
+
+	/// Next argument as an integer, whatever its tag.
+	bool Integer(long long& value)
+	{
+		switch (Peek()) {
+		case 'i': { int v; if (!Read(&v, 4)) return false; value = v; return true; }
+		case 'u': { unsigned v; if (!Read(&v, 4)) return false; value = v; return true; }
+		case 'l':
+		case 'L':
+		case 'p': return Read(&value, 8);
+		case 'd': { double v; if (!Read(&v, 8)) return false; value = (long long)v; return true; }
+		default: return false;
+		}
+	}
+
+	/// Next argument as a string; numbers are not converted.
+	bool String(const char*& text, unsigned& length)
+	{
+		unsigned short bytes;
+		if (Peek() != 's' || (unsigned)(end - data) < 2)
+			return false;
+		memcpy(&bytes, data, 2);
+		if ((unsigned)(end - data) < 2u + bytes)
+			return false;
+		text = reinterpret_cast<const char*>(data + 2);
+		length = bytes;
+		data += 2 + bytes;
+		++types;
+		return true;
+	}
+};
+
+/// Append text to out, keeping the terminator within capacity.
+static void util_log_append(char* out, unsigned capacity, unsigned& length, const char* text, unsigned count)
+{
+	if (length + 1 >= capacity)
+		return;
+	if (count > capacity - 1 - length)
+		count = capacity - 1 - length;
+	memcpy(out + length, text, count);
+	length += count;
+	out[length] = 0;
+}
+
+/// Append the output of snprintf for one conversion. Returns false if snprintf rejects the specification, a width
+/// beyond int for one.
+template <class T>
+static bool util_log_append_spec(char* out, unsigned capacity, unsigned& length, const char* spec, T value)
+{
+	if (length + 1 >= capacity)
+		return true;
+	int written = snprintf(out + length, capacity - length, spec, value);
+	if (written < 0) {
+		out[length] = 0;
+		return false;
+	}
+	length += (unsigned)written < capacity - length ? (unsigned)written : capacity - 1 - length;
+	return true;
+}
+
+/// Append count characters to a specification, keeping room for "ll", the conversion and the terminator. Returns
+/// false, and appends nothing, if they do not fit.
+static bool util_log_spec_append(char* spec, unsigned& specLength, const char* text, unsigned count)
+{
+	if (specLength + count > LOG_SPEC_SIZE - 4)
+		return false;
+	memcpy(spec + specLength, text, count);
+	specLength += count;
+	return true;
+}
+
+unsigned util_log_format_args(char* out, unsigned capacity, const char* fmt, const char* types, const void* args,
+	unsigned size)
+{
+	LogArgReader reader = { types, static_cast<const unsigned char*>(args), static_cast<const unsigned char*>(args) + size };
+	unsigned length = 0;
+	if (capacity)
+		out[0] = 0;
+
+	const char* p = fmt;
+	while (*p) {
+		const char* percent = strchr(p, '%');
+		if (!percent) {
+			util_log_append(out, capacity, length, p, (unsigned)strlen(p));
+			break;
+		}
+		util_log_append(out, capacity, length, p, (unsigned)(percent - p));
+		if (percent[1] == '%') {
+			util_log_append(out, capacity, length, "%", 1);
+			p = percent + 2;
+			continue;
+		}
+
+		// Rebuild the specification without its length modifier, resolving * from the arguments. A specification
+		// that does not fit, with room left for a length modifier, the conversion and the terminator, is copied as
+		// text.
+		char spec[LOG_SPEC_SIZE];
+		unsigned specLength = 0;
+		bool valid = true;
+		bool fits = true;
+		const char* c = percent + 1;
+		spec[specLength++] = '%';
+		while (*c && strchr("-+ #0", *c))
+			fits = util_log_spec_append(spec, specLength, c++, 1) && fits;
+		for (int part = 0; part < 2 && valid; ++part) {
+			if (part == 1) {
+				if (*c != '.')
+					break;
+				fits = util_log_spec_append(spec, specLength, c++, 1) && fits;
+			}
+			if (*c == '*') {
+				long long value = 0;
+				valid = reader.Integer(value);
+				if (value > (long long)LOG_MESSAGE_SIZE)
+					value = LOG_MESSAGE_SIZE;
+				else if (value < -(long long)LOG_MESSAGE_SIZE)
+					value = -(long long)LOG_MESSAGE_SIZE;
+				char number[16];
+				int digits = snprintf(number, sizeof(number), "%d", (int)value);
+				fits = digits > 0 && util_log_spec_append(spec, specLength, number, (unsigned)digits) && fits;
+				++c;
+			}
+			else {
+				while (*c >= '0' && *c <= '9')
+					fits = util_log_spec_append(spec, specLength, c++, 1) && fits;
+			}
+		}
+		while (*c && strchr("hlLqjztI0123456789", *c))
+			++c;
+		char conversion = *c;
+		if (!conversion || !valid) {
+			util_log_append(out, capacity, length, percent, (unsigned)strlen(percent));
+			break;
+		}
+		p = c + 1;
+		if (!fits) {
+			util_log_append(out, capacity, length, percent, (unsigned)(p - percent));
+			continue;
+		}
+
+		long long integer = 0;
+		switch (conversion) {
+		case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+			if (!reader.Peek() || reader.Peek() == 's') {
+				valid = false;
+				break;
+			}
+			if (reader.Peek() == 'i' || reader.Peek() == 'u') {
+				if (!(valid = reader.Integer(integer)))
+					break;
+				spec[specLength++] = conversion;
+				spec[specLength] = 0;
+				valid = util_log_append_spec(out, capacity, length, spec, (int)integer);
+			}
+			else {
+				if (!(valid = reader.Integer(integer)))
+					break;
+				spec[specLength++] = 'l';
+				spec[specLength++] = 'l';
+				spec[specLength++] = conversion == 'c' ? 'd' : conversion;
+				spec[specLength] = 0;
+				valid = util_log_append_spec(out, capacity, length, spec, integer);
+			}
+			break;
+
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			{
+				double value = 0.0;
+				if (reader.Peek() == 'd')
+					valid = reader.Read(&value, 8);
+				else if ((valid = reader.Integer(integer)) != false)
+					value = (double)integer;
+				if (!valid)
+					break;
+				spec[specLength++] = conversion;
+				spec[specLength] = 0;
+				valid = util_log_append_spec(out, capacity, length, spec, value);
+			}
+			break;
+
+		case 's':
+			{
+				const char* text;
+				unsigned textLength;
+				if (!(valid = reader.String(text, textLength)))
+					break;
+				char copy[LOG_STRING_SIZE];
+				textLength = textLength < LOG_STRING_SIZE - 1 ? textLength : LOG_STRING_SIZE - 1;
+				memcpy(copy, text, textLength);
+				copy[textLength] = 0;
+				spec[specLength++] = 's';
+				spec[specLength] = 0;
+				valid = util_log_append_spec(out, capacity, length, spec, (const char*)copy);
+			}
+			break;
+
+		case 'p':
+			if (!(valid = reader.Integer(integer)))
+				break;
+			spec[specLength++] = 'p';
+			spec[specLength] = 0;
+			valid = util_log_append_spec(out, capacity, length, spec, (void*)(size_t)integer);
+			break;
+
+		default:
+			valid = false;
+			break;
+		}
+
+		if (!valid)
+			util_log_append(out, capacity, length, percent, (unsigned)(p - percent));
+	}
+	return length;
+}
+
+const char* util_log_level_name(int level)
+{
+	return level > 0 && level < LogLevel_Max ? LogLevelText[level] : LogLevelText[0];
+}
+
+const char* util_log_category_name(int category)
+{
+	return category >= 0 && category < LogCategory_Max ? LogCategoryText[category] : "?";
+}
+
+int util_log_find_category(const char* name)
+{
+	for (int category = 0; category < LogCategory_Max; ++category) {
+		if (!strcmp(LogCategoryText[category], name))
+			return category;
+	}
+	return LogCategory_Max;
+}
+
+const char* LogClock::Text(time_t wall)
+{
+	if (wall != m_Wall) {
+		tm ts;
+#ifdef _WIN32
+		localtime_s(&ts, &wall);
+#else
+		localtime_r(&wall, &ts);
+#endif
+		strftime(m_Text, sizeof(m_Text), "%X", &ts);
+		m_Wall = wall;
+	}
+	return m_Text;
+}
+
+/// Append a null-terminated string.
+static void util_log_append(char* out, unsigned capacity, unsigned& length, const char* text)
+{
+	util_log_append(out, capacity, length, text, (unsigned)strlen(text));
+}
+
+unsigned util_log_format_line(char* out, unsigned capacity, const LogRecord& record, const char* clock)
+{
+	// Copied piece by piece, which takes a fraction of the time of snprintf.
+	unsigned length = 0;
+	if (!capacity)
+		return 0;
+	out[0] = 0;
+	util_log_append(out, capacity, length, "[");
+	util_log_append(out, capacity, length, clock);
+	util_log_append(out, capacity, length, "]  [");
+	util_log_append(out, capacity, length, util_log_level_name(record.level));
+	// General, the category of most lines, is not shown.
+	if (record.category != LogCategory_General) {
+		util_log_append(out, capacity, length, "]  [");
+		util_log_append(out, capacity, length, util_log_category_name(record.category));
+	}
+	util_log_append(out, capacity, length, "]  ");
+	util_log_append(out, capacity, length, record.text, record.length);
+
+	if (record.file) {
+		const char* file = record.file;
+		for (const char* c = record.file; *c; ++c) {
+			if (*c == '/' || *c == '\\')
+				file = c + 1;
+		}
+		char line[16];
+		char* digits = line + sizeof(line) - 1;
+		*digits = 0;
+		*--digits = ' ';
+		unsigned number = record.line > 0 ? (unsigned)record.line : 0;
+		do {
+			*--digits = (char)('0' + number % 10);
+			number /= 10;
+		} while (number);
+		*--digits = ':';
+		util_log_append(out, capacity, length, "  (");
+		util_log_append(out, capacity, length, file);
+		util_log_append(out, capacity, length, digits);
+		util_log_append(out, capacity, length, record.func ? record.func : "");
+		util_log_append(out, capacity, length, ")");
+	}
+	return length;
+}
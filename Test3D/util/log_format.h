@@ -0,0 +1,48 @@
+#pragma once
+
+#include <time.h>
+
+struct LogRecord;
+
+// Formatting shared by the logger, the binary log sink and the log decoder.
+//
+// Binary messages carry their arguments serialized by type instead of formatted text. Each argument has a type
+// tag, and the tags of a call site form its type string:
+//
+//   i  int, 4 bytes        u  unsigned, 4 bytes     l  long long, 8 bytes     L  unsigned long long, 8 bytes
+//   d  double, 8 bytes     p  pointer, 8 bytes      s  string, 2-byte length then the bytes
+//
+// The formatter follows the printf format of the call site but takes every conversion's argument by its tag, so a
+// length modifier that disagrees with the argument's type cannot misread the data.
+
+/// Longest formatted message, and longest console line: the message with its time, level, category and location.
+static const unsigned LOG_MESSAGE_SIZE = 2048;
+static const unsigned LOG_LINE_SIZE = LOG_MESSAGE_SIZE + 512;
+
+/// Format fmt with the arguments serialized in args into out, truncating to capacity - 1 characters, and return
+/// the length written. Conversions without an argument left are copied as they are.
+unsigned util_log_format_args(char* out, unsigned capacity, const char* fmt, const char* types, const void* args,
+	unsigned size);
+
+/// Name of a level as the console shows it, "DBG" to "ERR"; empty for an unknown level.
+const char* util_log_level_name(int level);
+/// Name of a category, "general", "script" and so on; "?" for an unknown category.
+const char* util_log_category_name(int category);
+/// Category of a name, LogCategory_Max for an unknown name.
+int util_log_find_category(const char* name);
+
+/// Wall clock time of records as the console shows it. Converting a time is slow, so it is done once per second.
+class LogClock
+{
+public:
+	/// The time of day of wall, a time in seconds.
+	const char* Text(time_t wall);
+
+private:
+	time_t m_Wall = (time_t)-1;
+	char   m_Text[16] = {};
+};
+
+/// Format a record as one console line without the newline: time, level, category unless it is General, message
+/// and location if it has one. clock is the wall clock time of the record, see LogClock.
+unsigned util_log_format_line(char* out, unsigned capacity, const LogRecord& record, const char* clock);
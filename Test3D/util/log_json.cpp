@@ -0,0 +1,164 @@
+#include "log_json.h"
+#include "log_format.h"
+
+#include <chrono>
+#include <string.h>
+#include <time.h>
+
+/// Buffer of the file, and room for a line: the message with every character escaped as \uXXXX at worst.
+static const unsigned LOG_JSON_BUFFER_SIZE = 1 << 16;
+static const unsigned LOG_JSON_LINE_SIZE = LOG_LINE_SIZE + LOG_MESSAGE_SIZE;
+
+/// Level names, from LogLevel_Debug.
+static const char* const LOG_JSON_LEVELS[] = { "debug", "info", "sys", "warn", "err" };
+
+/// Append count bytes of text if they fit in capacity.
+static void util_log_json_append(char* out, unsigned capacity, unsigned& length, const char* text, unsigned count)
+{
+	if (count > capacity - length)
+		return;
+	memcpy(out + length, text, count);
+	length += count;
+}
+
+static void util_log_json_append(char* out, unsigned capacity, unsigned& length, const char* text)
+{
+	util_log_json_append(out, capacity, length, text, (unsigned)strlen(text));
+}
+
+/// Append a number in decimal, with at least width digits.
+static void util_log_json_append(char* out, unsigned capacity, unsigned& length, unsigned long long number,
+	int width = 1)
+{
+	char text[24];
+	char* digits = text + sizeof(text);
+	int count = 0;
+	do {
+		*--digits = (char)('0' + number % 10);
+		number /= 10;
+		++count;
+	} while (number || count < width);
+	util_log_json_append(out, capacity, length, digits, (unsigned)(text + sizeof(text) - digits));
+}
+
+/// Append text as a JSON string, quotes included. A string that does not fit is cut before the first character
+/// that does not, leaving room for the closing quote.
+static void util_log_json_append_string(char* out, unsigned capacity, unsigned& length, const char* text,
+	unsigned count)
+{
+	static const char hex[] = "0123456789abcdef";
+	if (length + 2 > capacity)
+		return;
+	out[length++] = '"';
+	unsigned end = capacity - 1;
+	unsigned i = 0;
+	while (i < count) {
+		// Runs of characters that need no escape are copied at once.
+		unsigned run = i;
+		while (run < count && (unsigned char)text[run] >= 0x20 && text[run] != '"' && text[run] != '\\')
+			++run;
+		unsigned copy = run - i < end - length ? run - i : end - length;
+		memcpy(out + length, text + i, copy);
+		length += copy;
+		if (copy < run - i || run == count)
+			break;
+		i = run;
+
+		unsigned char c = (unsigned char)text[i];
+		char escape[6] = { '\\', 0 };
+		unsigned size = 2;
+		switch (c) {
+		case '"': escape[1] = '"'; break;
+		case '\\': escape[1] = '\\'; break;
+		case '\n': escape[1] = 'n'; break;
+		case '\r': escape[1] = 'r'; break;
+		case '\t': escape[1] = 't'; break;
+		default:
+			memcpy(escape + 1, "u00", 3);
+			escape[4] = hex[c >> 4];
+			escape[5] = hex[c & 15];
+			size = 6;
+			break;
+		}
+		if (length + size > end)
+			break;
+		memcpy(out + length, escape, size);
+		length += size;
+		++i;
+	}
+	out[length++] = '"';
+}
+
+JsonLogSink::JsonLogSink(const char* path) :
+	m_File(fopen(path, "wb")),
+	m_StartTime(util_log_time()),
+	m_StartWall(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()),
+	m_Second(-1)
+{
+	m_Date[0] = 0;
+	if (m_File)
+		setvbuf(m_File, nullptr, _IOFBF, LOG_JSON_BUFFER_SIZE);
+}
+
+JsonLogSink::~JsonLogSink()
+{
+	if (m_File)
+		fclose(m_File);
+}
+
+void JsonLogSink::Write(const LogRecord& record)
+{
+	if (!m_File)
+		return;
+
+	long long wall = m_StartWall + (record.time - m_StartTime);
+	long long second = wall / 1000000000;
+	if (second != m_Second) {
+		time_t seconds = (time_t)second;
+		tm ts;
+#ifdef _WIN32
+		gmtime_s(&ts, &seconds);
+#else
+		gmtime_r(&seconds, &ts);
+#endif
+		strftime(m_Date, sizeof(m_Date), "%Y-%m-%dT%H:%M:%S.", &ts);
+		m_Second = second;
+	}
+
+	char line[LOG_JSON_LINE_SIZE];
+	const unsigned capacity = sizeof(line) - 2;
+	unsigned length = 0;
+	util_log_json_append(line, capacity, length, "{\"ns\":");
+	util_log_json_append(line, capacity, length, (unsigned long long)record.time);
+	util_log_json_append(line, capacity, length, ",\"time\":\"");
+	util_log_json_append(line, capacity, length, m_Date);
+	util_log_json_append(line, capacity, length, (unsigned long long)(wall - second * 1000000000) / 1000, 6);
+	util_log_json_append(line, capacity, length, "Z\",\"thread\":");
+	util_log_json_append(line, capacity, length, record.thread);
+	util_log_json_append(line, capacity, length, ",\"level\":\"");
+	bool known = record.level >= LogLevel_Debug && record.level < LogLevel_Max;
+	util_log_json_append(line, capacity, length, known ? LOG_JSON_LEVELS[record.level - LogLevel_Debug] : "");
+	util_log_json_append(line, capacity, length, "\",\"category\":\"");
+	util_log_json_append(line, capacity, length, util_log_category_name(record.category));
+	util_log_json_append(line, capacity, length, "\"");
+	if (record.file) {
+		util_log_json_append(line, capacity, length, ",\"file\":");
+		util_log_json_append_string(line, capacity, length, record.file, (unsigned)strlen(record.file));
+		util_log_json_append(line, capacity, length, ",\"func\":");
+		const char* func = record.func ? record.func : "";
+		util_log_json_append_string(line, capacity, length, func, (unsigned)strlen(func));
+		util_log_json_append(line, capacity, length, ",\"line\":");
+		util_log_json_append(line, capacity, length, (unsigned long long)(record.line > 0 ? record.line : 0));
+	}
+	util_log_json_append(line, capacity, length, ",\"msg\":");
+	util_log_json_append_string(line, capacity, length, record.text, record.length);
+	line[length++] = '}';
+	line[length++] = '\n';
+	fwrite(line, length, 1, m_File);
+}
+
+void JsonLogSink::Flush()
+{
+	if (m_File)
+		fflush(m_File);
+}
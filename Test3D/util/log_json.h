@@ -0,0 +1,36 @@
+#pragma once
+
+#include "logger.h"
+
+#include <stdio.h>
+
+// Log files of JSON lines, one object per message, for tools rather than people:
+//
+//   {"ns":1234567890,"time":"2026-10-17T21:41:56.123456Z","thread":1,"level":"err","category":"script",
+//    "file":"lua/script_system.cpp","func":"script_system_invoke","line":125,"msg":"..."}
+//
+// ns is the steady clock of the record in nanoseconds, which only ever increases; time is the wall clock in UTC,
+// derived from ns and the clocks when the sink was created. file, func and line are left out for messages without
+// a location. Levels are named as in the scripts, "debug", "info", "sys", "warn" and "err".
+
+/// Sink that writes a JSON lines log file.
+class JsonLogSink : public LogSink
+{
+public:
+	explicit JsonLogSink(const char* path);
+	~JsonLogSink();
+
+	bool IsOpen() const { return m_File != nullptr; }
+
+	void Write(const LogRecord& record) override;
+	void Flush() override;
+
+private:
+	FILE*     m_File;
+	/// Steady clock and wall clock in nanoseconds when the sink was created.
+	long long m_StartTime;
+	long long m_StartWall;
+	/// The wall clock second of the last record and its date and time, converted once per second.
+	long long m_Second;
+	char      m_Date[24];
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <string.h>
+
+// Bounded multi-producer single-consumer ring of variable-length records for the asynchronous logger.
+//
+// The ring is an array of fixed-size cells with a sequence number each, after Dmitry Vyukov's bounded queue: the
+// cell of position p is free when its sequence is p and holds a written record cell when it is p + 1. A record
+// takes consecutive positions. The consumer frees cells in order, so a producer may claim all positions of a record
+// with one compare-and-swap of the push position as soon as the last of them is free. It publishes the first cell
+// last, so the consumer sees a record only once all of it is written.
+
+class LogRing
+{
+public:
+	/// Bytes of a cell: a sequence number and the payload.
+	static const unsigned CELL_SIZE = 128;
+	static const unsigned CELL_PAYLOAD = CELL_SIZE - sizeof(unsigned long long);
+
+	/// Create a ring of cellCount cells, a power of two.
+	explicit LogRing(unsigned cellCount) :
+		m_Cells(new Cell[cellCount]),
+		m_Mask(cellCount - 1),
+		m_Push(0),
+		m_Pop(0)
+	{
+		for (unsigned i = 0; i < cellCount; ++i)
+			m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	~LogRing() { delete[] m_Cells; }
+
+	/// Largest record the ring holds, in bytes.
+	unsigned MaxRecordSize() const { return (m_Mask + 1) * CELL_PAYLOAD - sizeof(unsigned); }
+
+	/// Append a record made of head and tail, which may be null when tailSize is 0. Returns false when the ring has
+	/// no room for it; a record larger than MaxRecordSize never fits.
+	bool TryPush(const void* head, unsigned headSize, const void* tail, unsigned tailSize)
+	{
+		unsigned size = headSize + tailSize;
+		unsigned long long cells = (sizeof(unsigned) + size + CELL_PAYLOAD - 1) / CELL_PAYLOAD;
+		if (cells > m_Mask + 1)
+			return false;
+
+		unsigned long long position = m_Push.load(std::memory_order_relaxed);
+		for (;;) {
+			unsigned long long last = position + cells - 1;
+			long long state = (long long)(m_Cells[last & m_Mask].sequence.load(std::memory_order_acquire) - last);
+			if (state == 0) {
+				if (m_Push.compare_exchange_weak(position, position + cells, std::memory_order_relaxed))
+					break;
+			}
+			else if (state < 0)
+				return false;
+			else
+				position = m_Push.load(std::memory_order_relaxed);
+		}
+
+		Writer writer(this, position);
+		writer.Write(&size, sizeof(size));
+		writer.Write(head, headSize);
+		writer.Write(tail, tailSize);
+		for (unsigned long long p = position + cells; p-- > position;)
+			m_Cells[p & m_Mask].sequence.store(p + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// Copy the next record into buffer, which has room for MaxRecordSize bytes, and return its size. Returns 0
+	/// when no record is ready. Only one thread may pop at a time.
+	unsigned Pop(void* buffer)
+	{
+		unsigned long long position = m_Pop.load(std::memory_order_relaxed);
+		Cell& first = m_Cells[position & m_Mask];
+		if (first.sequence.load(std::memory_order_acquire) != position + 1)
+			return 0;
+
+		unsigned size;
+		memcpy(&size, first.payload, sizeof(size));
+		unsigned long long cells = (sizeof(unsigned) + size + CELL_PAYLOAD - 1) / CELL_PAYLOAD;
+		unsigned char* out = static_cast<unsigned char*>(buffer);
+		unsigned offset = sizeof(unsigned);
+		unsigned left = size;
+		for (unsigned long long p = position; p < position + cells; ++p) {
+			Cell& cell = m_Cells[p & m_Mask];
+			unsigned bytes = CELL_PAYLOAD - offset < left ? CELL_PAYLOAD - offset : left;
+			memcpy(out, cell.payload + offset, bytes);
+			out += bytes;
+			left -= bytes;
+			offset = 0;
+			cell.sequence.store(p + m_Mask + 1, std::memory_order_release);
+		}
+		m_Pop.store(position + cells, std::memory_order_release);
+		return size;
+	}
+
+	/// Positions claimed and consumed so far. The ring is drained up to a push position once the pop position
+	/// reaches it.
+	unsigned long long PushPosition() const { return m_Push.load(std::memory_order_acquire); }
+	unsigned long long PopPosition() const  { return m_Pop.load(std::memory_order_acquire); }
+
+private:
+	struct alignas(64) Cell
+	{
+		std::atomic<unsigned long long> sequence;
+		unsigned char                   payload[CELL_PAYLOAD];
+	};
+
+	/// Copies a record into consecutive cells, wrapping at the end of the array.
+	struct Writer
+	{
+		Writer(LogRing* ring, unsigned long long position) : ring(ring), position(position), offset(0) {}
+
+		void Write(const void* data, unsigned size)
+		{
+			const unsigned char* in = static_cast<const unsigned char*>(data);
+			while (size) {
+				unsigned bytes = CELL_PAYLOAD - offset < size ? CELL_PAYLOAD - offset : size;
+				memcpy(ring->m_Cells[position & ring->m_Mask].payload + offset, in, bytes);
+				in += bytes;
+				size -= bytes;
+				offset += bytes;
+				if (offset == CELL_PAYLOAD) {
+					++position;
+					offset = 0;
+				}
+			}
+		}
+
+		LogRing*           ring;
+		unsigned long long position;
+		unsigned           offset;
+	};
+
+	Cell*                           m_Cells;
+	unsigned long long              m_Mask;
+	alignas(64) std::atomic<unsigned long long> m_Push;
+	alignas(64) std::atomic<unsigned long long> m_Pop;
+};
@@ -1,89 +1,671 @@
 #include "logger.h"
+#include "log_format.h"
+#include "log_ring.h"
 
+#include <atomic>
+#include <climits>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <signal.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
-static const char* LogLevelText[LogLevel_Max] = {
-	"", "DBG", "INF", "SYS", "WRN", "ERR", 
-};
-
+#ifdef _WIN32
 static int LogLevelColor[LogLevel_Max] = {
-	FOREGROUND_INTENSITY, 
+	FOREGROUND_INTENSITY,
 	FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
 	FOREGROUND_INTENSITY | FOREGROUND_GREEN | FOREGROUND_BLUE,
 	FOREGROUND_INTENSITY | FOREGROUND_GREEN,
 	FOREGROUND_INTENSITY | FOREGROUND_GREEN | FOREGROUND_RED,
 	FOREGROUND_INTENSITY | FOREGROUND_RED,
 };
+#endif
+
+std::atomic<int> util_log_levels[LogCategory_Max] = {
+	LogLevel_Debug, LogLevel_Debug, LogLevel_Debug, LogLevel_Debug, LogLevel_Debug, LogLevel_Debug, LogLevel_Debug,
+};
+
+static const unsigned LOG_MAX_SINKS = 8;
+/// How long the sink thread sleeps when the ring is empty and nobody wakes it.
+static const int LOG_IDLE_WAIT_MS = 10;
+/// How long a crashing thread waits for the sink thread to finish its batch before giving up on the ring.
+static const int LOG_CRASH_WAIT_MS = 500;
+/// Messages the dedup window remembers, the default window, and how much of a message a repeat notice quotes.
+static const unsigned LOG_DEDUP_ENTRIES = 8;
+static const unsigned LOG_DEDUP_WINDOW_MS = 1000;
+static const unsigned LOG_DEDUP_TEXT = 160;
+/// Window of the rate limits of call sites.
+static const long long LOG_RATE_WINDOW_NS = 1000000000LL;
+
+/// What a caller stores in the ring ahead of the message text.
+struct LogHeader
+{
+	long long      time;
+	const char*    file;
+	const char*    func;
+	const LogSite* site; ///< call site of a binary message, whose arguments follow instead of the text
+	unsigned       thread;
+	int            line;
+	int            level;
+	int            category;
+};
+
+/// Writes to stderr, in the level's color on a Windows console. The console handle and its original attributes
+/// are looked up once.
+class ConsoleSink : public LogSink
+{
+public:
+	ConsoleSink()
+	{
+#ifdef _WIN32
+		m_Handle = GetStdHandle(STD_ERROR_HANDLE);
+		m_Attributes = 0;
+		CONSOLE_SCREEN_BUFFER_INFO info;
+		if (m_Handle != INVALID_HANDLE_VALUE && GetConsoleScreenBufferInfo(m_Handle, &info))
+			m_Attributes = info.wAttributes;
+#endif
+	}
+
+	void Write(const LogRecord& record) override
+	{
+#ifdef _WIN32
+		if (m_Attributes)
+			SetConsoleTextAttribute(m_Handle, (WORD)LogLevelColor[record.level]);
+#endif
+		char line[LOG_LINE_SIZE];
+		time_t wall = (time_t)(m_Start + (record.time - m_StartTime) / 1000000000);
+		util_log_format_line(line, sizeof(line), record, m_Clock.Text(wall));
+		fprintf(stderr, "%s\n", line);
+
+#ifdef _WIN32
+		if (m_Attributes)
+			SetConsoleTextAttribute(m_Handle, m_Attributes);
+#endif
+	}
+
+	void Flush() override { fflush(stderr); }
+
+private:
+	/// Wall clock and steady clock when the logger started, to date records without a clock call per message.
+	time_t    m_Start = time(0);
+	long long m_StartTime = util_log_time();
+	LogClock  m_Clock;
+#ifdef _WIN32
+	HANDLE    m_Handle;
+	WORD      m_Attributes;
+#endif
+};
+
+/// Spin lock of the single consumer of the ring. The sink thread holds it while it writes a batch; a crashing
+/// thread takes it over to write what is left.
+class ConsumerLock
+{
+public:
+	void Lock()    { while (m_Flag.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+	bool TryLock() { return !m_Flag.test_and_set(std::memory_order_acquire); }
+	void Unlock()  { m_Flag.clear(std::memory_order_release); }
+
+private:
+	std::atomic_flag m_Flag = ATOMIC_FLAG_INIT;
+};
+
+/// A message the dedup window has written, and how many times it came again since.
+struct LogRepeat
+{
+	unsigned long long hash;  ///< 0 for a free entry
+	long long          first; ///< time of the message that was written
+	unsigned           count;
+	int                level;
+	int                category;
+	const char*        file;
+	const char*        func;
+	int                line;
+	char               text[LOG_DEDUP_TEXT];
+};
+
+struct LogState
+{
+	std::mutex                      sinks_mutex;
+	LogSink*                        sinks[LOG_MAX_SINKS] = {};
+	unsigned                        sink_count = 0;
+	ConsoleSink                     console;
+	bool                            console_enabled = true;
+	/// Whether any sink reads the text of binary messages, and the buffer they are formatted into.
+	bool                            wants_text = true;
+	char                            text_buffer[LOG_MESSAGE_SIZE];
+	std::mutex                      sites_mutex;
+	unsigned                        site_count = 0;
+	/// Dedup window in nanoseconds, 0 when it is off, and the messages it holds.
+	long long                       dedup_window = LOG_DEDUP_WINDOW_MS * 1000000LL;
+	LogRepeat                       repeats[LOG_DEDUP_ENTRIES] = {};
+	unsigned                        next_repeat = 0;
+
+	std::atomic<LogRing*>           ring{ nullptr };
+	std::atomic<LogRing*>           retired_ring{ nullptr };
+	ELogOverflow                    overflow = LogOverflow_Drop;
+	std::thread                     thread;
+	std::thread::id                 thread_id;
+	std::atomic<bool>               running{ false };
+	std::atomic<bool>               sleeping{ false };
+	std::mutex                      wake_mutex;
+	std::condition_variable         wake;
+	ConsumerLock                    consumer;
+	char*                           record_buffer = nullptr;
+
+	/// Ring position up to which the records are written and the sinks flushed.
+	std::atomic<unsigned long long> written_position{ 0 };
+	std::atomic<unsigned long long> written{ 0 };
+	std::atomic<unsigned long long> dropped{ 0 };
+	std::atomic<unsigned long long> blocked{ 0 };
+	std::atomic<unsigned long long> suppressed{ 0 };
+	std::atomic<unsigned long long> repeated{ 0 };
+	unsigned long long              reported_dropped = 0;
+};
+
+static void util_log_at_exit();
 
-static int current_log_level = LogLevel_Debug;
+static LogState& util_log_state()
+{
+	static LogState state;
+	// Registered once the state is constructed, so that it runs before the state is destroyed.
+	static bool exit_registered = atexit(util_log_at_exit) == 0;
+	(void)exit_registered;
+	return state;
+}
 
-const char* _util_current_time() {
-	static char  buf[80];
-	time_t       now = time(0);
-	tm           ts;
-	
-	localtime_s(&ts, &now);
-	// Visit http://en.cppreference.com/w/cpp/chrono/c/strftime
-	// for more information about date/time format
-	strftime(buf, sizeof(buf), "%X", &ts);
-	return buf;
+long long util_log_time()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-static void util_log_message(int level, const char* fmt, va_list args)
+static unsigned util_log_thread()
 {
-	if (current_log_level > level)
-		return;
+	static std::atomic<unsigned> next_thread{ 1 };
+	thread_local unsigned thread = next_thread.fetch_add(1, std::memory_order_relaxed);
+	return thread;
+}
+
+/// Hand a record to the console and the sinks, with the sinks mutex held.
+static void util_log_emit(LogState& state, const LogRecord& record)
+{
+	if (state.console_enabled)
+		state.console.Write(record);
+	for (unsigned i = 0; i < state.sink_count; ++i)
+		state.sinks[i]->Write(record);
+	state.written.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// FNV-1a hash of what makes two messages the same: the text, or the call site and arguments of a binary message,
+/// and the level, category and location.
+static unsigned long long util_log_hash(const LogRecord& record)
+{
+	const unsigned long long prime = 1099511628211ULL;
+	const unsigned char* data = static_cast<const unsigned char*>(record.site ? record.args : record.text);
+	unsigned size = record.site ? record.args_size : record.length;
+	unsigned long long hash = 14695981039346656037ULL;
+	for (unsigned i = 0; i < size; ++i)
+		hash = (hash ^ data[i]) * prime;
+	const unsigned long long fields[] = { (unsigned long long)(size_t)record.site, (unsigned long long)(size_t)record.file,
+		(unsigned)record.line, (unsigned)record.level, (unsigned)record.category };
+	for (unsigned long long field : fields)
+		hash = (hash ^ field) * prime;
+	return hash ? hash : 1;
+}
+
+/// Write how many times a message repeated, if it did, and free its entry.
+static void util_log_report_repeat(LogState& state, LogRepeat& repeat)
+{
+	if (repeat.count) {
+		char text[LOG_DEDUP_TEXT + 48];
+		LogRecord record = { util_log_time(), util_log_thread(), repeat.level, repeat.category, repeat.file, repeat.func,
+			repeat.line, text, 0, nullptr, nullptr, 0 };
+		record.length = (unsigned)snprintf(text, sizeof(text), "repeated %u times: %s", repeat.count, repeat.text);
+		if (record.length >= sizeof(text))
+			record.length = sizeof(text) - 1;
+		util_log_emit(state, record);
+	}
+	repeat.hash = 0;
+}
+
+/// Report the messages whose window has passed at time now, all of them for LLONG_MAX. Returns whether any notice was written.
+static bool util_log_expire_repeats(LogState& state, long long now)
+{
+	bool wrote = false;
+	for (LogRepeat& repeat : state.repeats) {
+		if (repeat.hash && now - repeat.first >= state.dedup_window) {
+			wrote = wrote || repeat.count;
+			util_log_report_repeat(state, repeat);
+		}
+	}
+	return wrote;
+}
+
+/// Write a record with the sinks mutex held, unless the dedup window has seen it. Formats a binary message first
+/// if a sink wants its text.
+static void util_log_write(LogState& state, LogRecord& record)
+{
+	if (record.site) {
+		record.text = state.text_buffer;
+		record.length = 0;
+		state.text_buffer[0] = 0;
+		if (state.wants_text)
+			record.length = util_log_format_args(state.text_buffer, LOG_MESSAGE_SIZE, record.site->fmt,
+				record.site->types, record.args, record.args_size);
+	}
+
+	// Messages the window has seen are counted; the first of them, and the count when the window passes, are
+	// written. The entries are reused round robin.
+	if (state.dedup_window) {
+		util_log_expire_repeats(state, record.time);
+		unsigned long long hash = util_log_hash(record);
+		for (LogRepeat& repeat : state.repeats) {
+			if (repeat.hash == hash) {
+				++repeat.count;
+				state.repeated.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+		}
+		LogRepeat& repeat = state.repeats[state.next_repeat++ % LOG_DEDUP_ENTRIES];
+		if (repeat.hash)
+			util_log_report_repeat(state, repeat);
+		repeat.hash = hash;
+		repeat.first = record.time;
+		repeat.count = 0;
+		repeat.level = record.level;
+		repeat.category = record.category;
+		repeat.file = record.file;
+		repeat.func = record.func;
+		repeat.line = record.line;
+		unsigned length = record.length < LOG_DEDUP_TEXT - 1 ? record.length : LOG_DEDUP_TEXT - 1;
+		memcpy(repeat.text, record.text, length);
+		repeat.text[length] = 0;
+	}
+	util_log_emit(state, record);
+}
+
+/// Note whether a sink reads the text of binary messages, with the sinks mutex held.
+static void util_log_update_wants_text(LogState& state)
+{
+	state.wants_text = state.console_enabled;
+	for (unsigned i = 0; i < state.sink_count; ++i)
+		state.wants_text = state.wants_text || state.sinks[i]->WantsText();
+}
+
+static void util_log_flush_sinks(LogState& state)
+{
+	if (state.console_enabled)
+		state.console.Flush();
+	for (unsigned i = 0; i < state.sink_count; ++i)
+		state.sinks[i]->Flush();
+}
+
+/// Write every record in the ring, with the consumer lock held. Returns whether there was any. A crashing thread
+/// may hold the sinks mutex already, in a sink that faulted; then it does not wait for it and writes nothing.
+static bool util_log_drain(LogState& state, LogRing& ring, bool crashing = false)
+{
+	std::unique_lock<std::mutex> lock(state.sinks_mutex, std::defer_lock);
+	if (!crashing)
+		lock.lock();
+	else if (!lock.try_lock())
+		return false;
+
+	unsigned size = ring.Pop(state.record_buffer);
+	if (!size)
+		return false;
+
+	do {
+		LogHeader header;
+		memcpy(&header, state.record_buffer, sizeof(header));
+		state.record_buffer[size] = 0;
+
+		LogRecord record;
+		record.time = header.time;
+		record.thread = header.thread;
+		record.level = header.level;
+		record.category = header.category;
+		record.file = header.file;
+		record.func = header.func;
+		record.line = header.line;
+		record.text = state.record_buffer + sizeof(header);
+		record.length = size - sizeof(header);
+		record.site = header.site;
+		record.args = record.text;
+		record.args_size = record.length;
+		util_log_write(state, record);
+	} while ((size = ring.Pop(state.record_buffer)) != 0);
+
+	unsigned long long dropped = state.dropped.load(std::memory_order_relaxed);
+	if (state.overflow == LogOverflow_Count && dropped != state.reported_dropped) {
+		char text[64];
+		LogRecord record = { util_log_time(), util_log_thread(), LogLevel_Warn, LogCategory_General, nullptr, nullptr, 0, text, 0,
+			nullptr, nullptr, 0 };
+		record.length = (unsigned)snprintf(text, sizeof(text), "%llu log messages dropped", dropped - state.reported_dropped);
+		state.reported_dropped = dropped;
+		util_log_write(state, record);
+	}
+
+	util_log_flush_sinks(state);
+	state.written_position.store(ring.PopPosition(), std::memory_order_release);
+	return true;
+}
 
-	WORD wOldColorAttrs = 0;
-	CONSOLE_SCREEN_BUFFER_INFO csbiInfo;
-	HANDLE hStderr = GetStdHandle(STD_ERROR_HANDLE);
-	if (hStderr == INVALID_HANDLE_VALUE) {
+/// Write what callers pushed into the ring util_log_stop_async retired after its last drain, which they loaded
+/// before the switch. The consumer lock keeps util_log_start_async from freeing the ring meanwhile.
+static void util_log_drain_retired(LogState& state)
+{
+	if (!state.retired_ring.load(std::memory_order_acquire))
 		return;
+	state.consumer.Lock();
+	LogRing* ring = state.retired_ring.load(std::memory_order_acquire);
+	if (ring && ring->PopPosition() != ring->PushPosition())
+		util_log_drain(state, *ring);
+	state.consumer.Unlock();
+}
+
+static void util_log_sink_thread()
+{
+	LogState& state = util_log_state();
+	LogRing& ring = *state.ring.load(std::memory_order_relaxed);
+
+	for (;;) {
+		state.consumer.Lock();
+		bool wrote = util_log_drain(state, ring);
+		state.consumer.Unlock();
+		if (wrote)
+			continue;
+		if (!state.running.load(std::memory_order_acquire))
+			break;
+
+		// A message that stopped repeating gets its count once its window has passed.
+		{
+			std::lock_guard<std::mutex> lock(state.sinks_mutex);
+			if (state.dedup_window && util_log_expire_repeats(state, util_log_time()))
+				util_log_flush_sinks(state);
+		}
+
+		// Producers wake the thread only when it says it sleeps; the timeout covers a wake-up that raced with
+		// the last check.
+		std::unique_lock<std::mutex> lock(state.wake_mutex);
+		state.sleeping.store(true, std::memory_order_seq_cst);
+		if (ring.PopPosition() == ring.PushPosition() && state.running.load(std::memory_order_acquire))
+			state.wake.wait_for(lock, std::chrono::milliseconds(LOG_IDLE_WAIT_MS));
+		state.sleeping.store(false, std::memory_order_relaxed);
 	}
-	if (GetConsoleScreenBufferInfo(hStderr, &csbiInfo)) {
-		wOldColorAttrs = csbiInfo.wAttributes;
+}
+
+static void util_log_wake(LogState& state)
+{
+	if (state.sleeping.load(std::memory_order_seq_cst))
+		state.wake.notify_one();
+}
+
+/// Write the rest of the ring from a crashing thread. Waits for the sink thread to finish its batch, unless the
+/// crash is on the sink thread itself, whose batch is then lost.
+static void util_log_crash_flush()
+{
+	LogState& state = util_log_state();
+	LogRing* ring = state.ring.load(std::memory_order_acquire);
+	if (!ring || std::this_thread::get_id() == state.thread_id)
+		return;
+
+	long long deadline = util_log_time() + LOG_CRASH_WAIT_MS * 1000000LL;
+	while (!state.consumer.TryLock()) {
+		if (util_log_time() > deadline)
+			return;
+		std::this_thread::yield();
 	}
-	SetConsoleTextAttribute(hStderr, LogLevelColor[level]);
+	util_log_drain(state, *ring, true);
+}
 
-	char buf[2048];
-	vsnprintf_s(buf, _countof(buf), _TRUNCATE, fmt, args);
-	const char* level_text = LogLevelText[level];
-	fprintf(stderr, "[%s]  [%s]  %s\n", _util_current_time(), level_text, buf);
+/// Signals of a crash, and the handlers they had before the logger's, which it passes them on to.
+static const int LOG_CRASH_SIGNALS[] = { SIGSEGV, SIGILL, SIGFPE, SIGABRT };
+static const unsigned LOG_CRASH_SIGNAL_COUNT = sizeof(LOG_CRASH_SIGNALS) / sizeof(LOG_CRASH_SIGNALS[0]);
+#ifdef _WIN32
+static void (*previous_signal_handlers[LOG_CRASH_SIGNAL_COUNT])(int);
+#else
+static struct sigaction previous_signal_actions[LOG_CRASH_SIGNAL_COUNT];
+#endif
 
-	if (wOldColorAttrs > 0) {
-		SetConsoleTextAttribute(hStderr, wOldColorAttrs);
+/// Flush the ring, then put the previous handler back and raise the signal again for it. The signal is blocked
+/// while the handler runs, so the previous handler receives it when this one returns, or on the fault again.
+static void util_log_signal_handler(int signal_number)
+{
+	util_log_crash_flush();
+	for (unsigned i = 0; i < LOG_CRASH_SIGNAL_COUNT; ++i) {
+		if (LOG_CRASH_SIGNALS[i] != signal_number)
+			continue;
+#ifdef _WIN32
+		signal(signal_number, previous_signal_handlers[i] != SIG_ERR ? previous_signal_handlers[i] : SIG_DFL);
+#else
+		sigaction(signal_number, &previous_signal_actions[i], nullptr);
+#endif
 	}
+	raise(signal_number);
+}
+
+#ifdef _WIN32
+static LPTOP_LEVEL_EXCEPTION_FILTER previous_exception_filter = nullptr;
+
+static LONG WINAPI util_log_exception_filter(EXCEPTION_POINTERS* exception)
+{
+	util_log_crash_flush();
+	return previous_exception_filter ? previous_exception_filter(exception) : EXCEPTION_CONTINUE_SEARCH;
 }
+#endif
 
-static void util_log_message(int level, const char* filename, const char* funcname, int line_num, const char* fmt, va_list args)
+static void util_log_install_handlers()
 {
-	if (current_log_level > level)
+	static bool installed = false;
+	if (installed)
 		return;
+	installed = true;
+
+	for (unsigned i = 0; i < LOG_CRASH_SIGNAL_COUNT; ++i) {
+#ifdef _WIN32
+		previous_signal_handlers[i] = signal(LOG_CRASH_SIGNALS[i], util_log_signal_handler);
+#else
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = util_log_signal_handler;
+		sigemptyset(&action.sa_mask);
+		sigaction(LOG_CRASH_SIGNALS[i], &action, &previous_signal_actions[i]);
+#endif
+	}
+#ifdef _WIN32
+	previous_exception_filter = SetUnhandledExceptionFilter(util_log_exception_filter);
+#endif
+}
+
+bool util_log_start_async(unsigned ring_size, ELogOverflow overflow)
+{
+	LogState& state = util_log_state();
+	if (state.running.load(std::memory_order_acquire))
+		return false;
+
+	unsigned cells = ring_size / LogRing::CELL_SIZE;
+	if (cells < 32 || (cells & (cells - 1)))
+		return false;
+
+	// A stopped ring is only freed when the next one starts, so that a caller racing with the stop never pushes
+	// into freed memory. What such callers pushed is written first.
+	state.consumer.Lock();
+	LogRing* retired = state.retired_ring.exchange(nullptr, std::memory_order_acq_rel);
+	if (retired)
+		util_log_drain(state, *retired);
+	state.consumer.Unlock();
+	delete retired;
+	LogRing* ring = new LogRing(cells);
+	delete[] state.record_buffer;
+	state.record_buffer = new char[ring->MaxRecordSize() + 1];
+
+	state.overflow = overflow;
+	state.reported_dropped = state.dropped.load(std::memory_order_relaxed);
+	state.written_position.store(0, std::memory_order_relaxed);
+	state.running.store(true, std::memory_order_release);
+	state.ring.store(ring, std::memory_order_release);
+	state.thread = std::thread(util_log_sink_thread);
+	state.thread_id = state.thread.get_id();
+	util_log_install_handlers();
+	return true;
+}
 
-	WORD wOldColorAttrs = 0;
-	CONSOLE_SCREEN_BUFFER_INFO csbiInfo;
-	HANDLE hStderr = GetStdHandle(STD_ERROR_HANDLE);
-	if (hStderr == INVALID_HANDLE_VALUE) {
+void util_log_stop_async()
+{
+	LogState& state = util_log_state();
+	if (!state.running.exchange(false, std::memory_order_acq_rel))
 		return;
+
+	LogRing* ring = state.ring.load(std::memory_order_relaxed);
+	state.wake.notify_one();
+	state.thread.join();
+	state.thread_id = std::thread::id();
+	state.ring.store(nullptr, std::memory_order_release);
+
+	// Records pushed between the last drain of the thread and the switch back to synchronous mode. Callers that
+	// loaded the ring before the switch may still push into it; later synchronous messages, util_log_flush and the
+	// exit write those.
+	state.consumer.Lock();
+	util_log_drain(state, *ring);
+	state.consumer.Unlock();
+	state.retired_ring.store(ring, std::memory_order_release);
+
+	std::lock_guard<std::mutex> lock(state.sinks_mutex);
+	if (util_log_expire_repeats(state, LLONG_MAX))
+		util_log_flush_sinks(state);
+}
+
+void util_log_flush()
+{
+	LogState& state = util_log_state();
+	LogRing* ring = state.ring.load(std::memory_order_acquire);
+	if (ring) {
+		unsigned long long target = ring->PushPosition();
+		while (state.written_position.load(std::memory_order_acquire) < target && state.running.load(std::memory_order_acquire)) {
+			state.wake.notify_one();
+			std::this_thread::yield();
+		}
 	}
-	if (GetConsoleScreenBufferInfo(hStderr, &csbiInfo)) {
-		wOldColorAttrs = csbiInfo.wAttributes;
+	util_log_drain_retired(state);
+
+	std::lock_guard<std::mutex> lock(state.sinks_mutex);
+	util_log_expire_repeats(state, LLONG_MAX);
+	util_log_flush_sinks(state);
+}
+
+/// Write what is still pending when the process exits, in either mode: the ring of asynchronous mode, and the
+/// counts of the messages the dedup window holds.
+static void util_log_at_exit()
+{
+	util_log_stop_async();
+	util_log_flush();
+}
+
+void util_log_get_stats(LogStats* stats)
+{
+	LogState& state = util_log_state();
+	stats->written = state.written.load(std::memory_order_relaxed);
+	stats->dropped = state.dropped.load(std::memory_order_relaxed);
+	stats->blocked = state.blocked.load(std::memory_order_relaxed);
+	stats->suppressed = state.suppressed.load(std::memory_order_relaxed);
+	stats->repeated = state.repeated.load(std::memory_order_relaxed);
+}
+
+void util_log_add_sink(LogSink* sink)
+{
+	LogState& state = util_log_state();
+	std::lock_guard<std::mutex> lock(state.sinks_mutex);
+	if (state.sink_count < LOG_MAX_SINKS)
+		state.sinks[state.sink_count++] = sink;
+	util_log_update_wants_text(state);
+}
+
+void util_log_remove_sink(LogSink* sink)
+{
+	LogState& state = util_log_state();
+	std::lock_guard<std::mutex> lock(state.sinks_mutex);
+	for (unsigned i = 0; i < state.sink_count; ++i) {
+		if (state.sinks[i] == sink) {
+			state.sinks[i] = state.sinks[--state.sink_count];
+			break;
+		}
 	}
-	SetConsoleTextAttribute(hStderr, LogLevelColor[level]);
+	util_log_update_wants_text(state);
+}
 
-	char buf[2048];
-	vsnprintf_s(buf, _countof(buf), _TRUNCATE, fmt, args);
+void util_log_set_dedup(unsigned window_ms)
+{
+	LogState& state = util_log_state();
+	std::lock_guard<std::mutex> lock(state.sinks_mutex);
+	util_log_expire_repeats(state, LLONG_MAX);
+	state.dedup_window = window_ms * 1000000LL;
+}
+
+void util_log_set_console(bool enabled)
+{
+	LogState& state = util_log_state();
+	std::lock_guard<std::mutex> lock(state.sinks_mutex);
+	state.console_enabled = enabled;
+	util_log_update_wants_text(state);
+}
 
-	const char* level_text = LogLevelText[level];
-	fprintf(stderr, "[%s]  [%s]  %s\n", _util_current_time(), filename, funcname, line_num, buf);
+/// Push a message into the ring, or write it right away in synchronous mode. The data is the text of the message,
+/// or the arguments of a binary one.
+static void util_log_dispatch(int category, int level, const char* filename, const char* funcname, int line_num,
+	const LogSite* site, const char* text, unsigned length)
+{
+	LogState& state = util_log_state();
+	LogHeader header = { util_log_time(), filename, funcname, site, util_log_thread(), line_num, level, category };
 
-	if (wOldColorAttrs > 0) {
-		SetConsoleTextAttribute(hStderr, wOldColorAttrs);
+	LogRing* ring = state.ring.load(std::memory_order_acquire);
+	if (ring) {
+		if (!ring->TryPush(&header, sizeof(header), text, length)) {
+			// A record larger than the ring never fits, so even a blocking caller drops it.
+			if (state.overflow != LogOverflow_Block || sizeof(header) + length > ring->MaxRecordSize()) {
+				state.dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			state.blocked.fetch_add(1, std::memory_order_relaxed);
+			do {
+				state.wake.notify_one();
+				std::this_thread::yield();
+				// Once util_log_stop_async has retired the ring, no sink thread empties it any more.
+				if (state.ring.load(std::memory_order_acquire) != ring)
+					util_log_drain_retired(state);
+			} while (!ring->TryPush(&header, sizeof(header), text, length));
+		}
+		util_log_wake(state);
+		return;
 	}
+
+	LogRecord record = { header.time, header.thread, level, category, filename, funcname, line_num, text, length, site, text,
+		length };
+	util_log_drain_retired(state);
+	std::lock_guard<std::mutex> lock(state.sinks_mutex);
+	util_log_write(state, record);
+	util_log_flush_sinks(state);
+}
+
+static void util_log_message(int category, int level, const char* filename, const char* funcname, int line_num,
+	const char* fmt, va_list args)
+{
+	if (!util_log_enabled(category, level))
+		return;
+
+	char buf[LOG_MESSAGE_SIZE];
+	int length = vsnprintf(buf, sizeof(buf), fmt, args);
+	if (length < 0)
+		length = 0;
+	else if (length >= (int)sizeof(buf))
+		length = sizeof(buf) - 1;
+	util_log_dispatch(category, level, filename, funcname, line_num, nullptr, buf, (unsigned)length);
 }
 
 void util_log_message(int level, const char* fmt, ...)
@@ -91,7 +673,7 @@ void util_log_message(int level, const char* fmt, ...)
 	va_list args;
 
 	va_start(args, fmt);
-	util_log_message(level, fmt, args);
+	util_log_message(LogCategory_General, level, nullptr, nullptr, 0, fmt, args);
 	va_end(args);
 }
 
@@ -100,6 +682,70 @@ void util_log_message(int level, const char* filename, const char* funcname, int
 	va_list args;
 
 	va_start(args, fmt);
-	util_log_message(level, filename, funcname, line_num, fmt, args);
+	util_log_message(LogCategory_General, level, filename, funcname, line_num, fmt, args);
 	va_end(args);
 }
+
+void util_log_category_message(int category, int level, const char* filename, const char* funcname, int line_num,
+	const char* fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	util_log_message(category, level, filename, funcname, line_num, fmt, args);
+	va_end(args);
+}
+
+void util_log_set_level(int category, int level)
+{
+	if (category == LogCategory_Max) {
+		for (std::atomic<int>& category_level : util_log_levels)
+			category_level.store(level, std::memory_order_relaxed);
+	}
+	else if (category >= 0 && category < LogCategory_Max)
+		util_log_levels[category].store(level, std::memory_order_relaxed);
+}
+
+int util_log_get_level(int category)
+{
+	if (category < 0 || category >= LogCategory_Max)
+		return LogLevel_Max;
+	return util_log_levels[category].load(std::memory_order_relaxed);
+}
+
+bool util_log_rate_allow(LogRateLimit& limit, int category, int level)
+{
+	// Racing threads may let a message more or less through, which does not matter for a limit.
+	long long now = util_log_time();
+	long long window = limit.window.load(std::memory_order_relaxed);
+	if (now - window >= LOG_RATE_WINDOW_NS && limit.window.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+		limit.count.store(0, std::memory_order_relaxed);
+		unsigned suppressed = limit.suppressed.exchange(0, std::memory_order_relaxed);
+		if (suppressed)
+			util_log_category_message(category, level, nullptr, nullptr, 0, "%u messages suppressed like \"%s\"",
+				suppressed, limit.fmt ? limit.fmt : "");
+	}
+	if (limit.count.fetch_add(1, std::memory_order_relaxed) < limit.per_second)
+		return true;
+	limit.suppressed.fetch_add(1, std::memory_order_relaxed);
+	util_log_state().suppressed.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+unsigned util_log_register_site(LogSite& site, const char* types)
+{
+	LogState& state = util_log_state();
+	std::lock_guard<std::mutex> lock(state.sites_mutex);
+	unsigned id = site.id.load(std::memory_order_relaxed);
+	if (!id) {
+		id = ++state.site_count;
+		site.types = types;
+		site.id.store(id, std::memory_order_release);
+	}
+	return id;
+}
+
+void util_log_binary_push(LogSite& site, const void* args, unsigned size)
+{
+	util_log_dispatch(site.category, site.level, site.file, site.func, site.line, &site, static_cast<const char*>(args), size);
+}
@@ -1,5 +1,32 @@
 #pragma once
 
+#include <atomic>
+#include <string.h>
+#include <type_traits>
+
+// Logging to the console and to registered sinks.
+//
+// By default a message is formatted and written on the calling thread. util_log_start_async moves the writing to
+// a background thread: callers format the message and push it into a lock-free ring, and the sink thread adds the
+// time and level, writes it to every sink and flushes them. What a full ring does to a caller depends on the
+// overflow policy. Both modes flush at exit, counts of repeated messages included, and asynchronous mode also, best
+// effort, when the process crashes.
+//
+// The util_log_binary macros defer the formatting: a call site registers its format string once, and every call
+// only copies its arguments, tagged by type, behind the id of the site. The text is formatted on the sink thread,
+// and only if a sink asks for it; BinaryLogSink in log_binary.h stores the arguments as they are, for the
+// log_decode tool to format offline. See log_format.h for the argument encoding.
+//
+// Every message belongs to a category, the subsystem that logs it, and each category has its own least level,
+// which util_log_set_level changes at run time. The macros check it before they evaluate their arguments, so a
+// disabled message costs a load and a compare. UTIL_LOG_MIN_LEVEL removes the statements of lower levels at compile
+// time, format strings included: define it to 2 to compile out the debug messages, 6 to compile out all of them.
+// The level given to a macro has to be a constant for that.
+//
+// A message that fails every frame is kept from flooding the sinks twice: util_log_limited caps what its call site
+// logs a second, and the dedup window writes a message that comes again only once, followed by how many times it
+// repeated. util_log_get_stats counts what both held back.
+
 enum ELogLevel
 {
 	LogLevel_Debug = 1,
@@ -10,10 +37,171 @@ enum ELogLevel
 	LogLevel_Max
 };
 
+/// Subsystem a message comes from. The util_log_* macros without a category log to General.
+enum ELogCategory
+{
+	LogCategory_General,
+	LogCategory_Script,  ///< Lua scripts and the script system
+	LogCategory_ImGui,
+	LogCategory_D3D,
+	LogCategory_Input,
+	LogCategory_Camera,
+	LogCategory_Graphic,
+	LogCategory_Max
+};
+
+#ifndef UTIL_LOG_MIN_LEVEL
+#define UTIL_LOG_MIN_LEVEL 1
+#endif
+
+/// What a caller does when the ring of the asynchronous mode is full.
+enum ELogOverflow
+{
+	LogOverflow_Drop,  ///< discard the message; only util_log_get_stats counts it
+	LogOverflow_Block, ///< wait until the sink thread has made room; a message larger than the ring is dropped
+	LogOverflow_Count, ///< discard the message, and have the sink thread log how many were lost
+};
+
+/// Call site of a binary message, defined by the util_log_binary macros. The format, types and location stay valid
+/// for the life of the program.
+struct LogSite
+{
+	int                   category;
+	int                   level;
+	const char*           fmt;
+	const char*           file;
+	const char*           func;
+	int                   line;
+	const char*           types; ///< type tags of the arguments, set when the site registers
+	std::atomic<unsigned> id;    ///< 0 until the site registers
+};
+
+/// Rate limit of a call site, defined by util_log_limited: at most per_second messages a second.
+struct LogRateLimit
+{
+	unsigned               per_second;
+	const char*            fmt;        ///< quoted when the site reports what it suppressed
+	std::atomic<long long> window;     ///< start of the current second
+	std::atomic<unsigned>  count;
+	std::atomic<unsigned>  suppressed;
+};
+
+/// One message as the sinks receive it.
+struct LogRecord
+{
+	long long      time;      ///< steady clock time of the call in nanoseconds, see util_log_time
+	unsigned       thread;    ///< number of the calling thread, 1 for the first thread that logs
+	int            level;
+	int            category;
+	const char*    file;      ///< source location, null for messages logged without one
+	const char*    func;
+	int            line;
+	const char*    text;      ///< formatted message, null-terminated; empty for a binary message no sink formats
+	unsigned       length;
+	const LogSite* site;      ///< call site of a binary message, null for a text message
+	const void*    args;      ///< serialized arguments of a binary message
+	unsigned       args_size;
+};
+
+/// Destination of log records. Write and Flush are called by one thread at a time: the logging thread in
+/// synchronous mode and the sink thread in asynchronous mode.
+class LogSink
+{
+public:
+	virtual ~LogSink() {}
+
+	virtual void Write(const LogRecord& record) = 0;
+	/// Called after a batch of writes, and by util_log_flush.
+	virtual void Flush() {}
+	/// Whether the sink reads LogRecord::text of binary messages. Binary messages are only formatted when a sink
+	/// does.
+	virtual bool WantsText() const { return true; }
+};
+
+struct LogStats
+{
+	unsigned long long written;    ///< messages written to the sinks
+	unsigned long long dropped;    ///< messages discarded on a full ring
+	unsigned long long blocked;    ///< messages that waited for room in the ring
+	unsigned long long suppressed; ///< messages the rate limits of their call sites discarded
+	unsigned long long repeated;   ///< messages the dedup window counted instead of writing them
+};
+
+/// Least level logged, by category. Read through util_log_enabled.
+extern std::atomic<int> util_log_levels[LogCategory_Max];
+
+/// Whether messages of a category and level are logged. The util_log_* macros check this before they evaluate
+/// their arguments.
+inline bool util_log_enabled(int category, int level)
+{
+	return level >= UTIL_LOG_MIN_LEVEL && level >= util_log_levels[category].load(std::memory_order_relaxed);
+}
+
+/// Log the messages of a category from level up; LogLevel_Max turns the category off. LogCategory_Max sets every
+/// category.
+void util_log_set_level(int category, int level);
+int util_log_get_level(int category);
+
 void util_log_message(int level, const char* fmt, ...);
 void util_log_message(int level, const char* filename, const char* funcname, int line_num, const char* fmt, ...);
+/// Log a message of a category; filename, funcname and line_num are null and 0 for a message without a location.
+void util_log_category_message(int category, int level, const char* filename, const char* funcname, int line_num,
+	const char* fmt, ...);
+
+/// Give a binary call site its id and argument types, once, and return the id. Ids count up from 1.
+unsigned util_log_register_site(LogSite& site, const char* types);
+/// Log the serialized arguments of a binary message, whose level the caller has checked; see util_log_binary.
+void util_log_binary_push(LogSite& site, const void* args, unsigned size);
+
+/// Whether a rate-limited call site may log now; util_log_limited checks it before it evaluates its arguments.
+/// The first message of a new second reports first how many the second before suppressed.
+bool util_log_rate_allow(LogRateLimit& limit, int category, int level);
+/// Collapse a message that comes again within window_ms of its first time: it is written once, then as "repeated N
+/// times" when the window has passed. The last 8 distinct messages are remembered. 0 turns it off; 1000 by default.
+void util_log_set_dedup(unsigned window_ms);
+
+/// Add a sink that receives every message from now on, or remove it. The console is a built-in sink.
+void util_log_add_sink(LogSink* sink);
+void util_log_remove_sink(LogSink* sink);
+void util_log_set_console(bool enabled);
 
-#define util_log_full(level, fmt, ...) util_log_message(level, __FILE__, __FUNCTION__, __LINE__, fmt,##__VA_ARGS__)
+/// Write messages on a background thread through a ring of ring_size bytes, a power of two of at least 4 KB.
+/// Returns false if asynchronous mode is already running.
+bool util_log_start_async(unsigned ring_size, ELogOverflow overflow);
+/// Write out the messages in the ring and go back to synchronous mode.
+void util_log_stop_async();
+/// Wait until every message logged before the call is written, then flush the sinks.
+void util_log_flush();
+void util_log_get_stats(LogStats* stats);
+/// Steady clock time in nanoseconds, the clock of LogRecord::time.
+long long util_log_time();
+
+#define util_log_cat(category, level, fmt, ...) \
+	do { \
+		if constexpr ((level) >= UTIL_LOG_MIN_LEVEL) \
+			if (util_log_enabled(category, level)) \
+				util_log_category_message(category, level, nullptr, nullptr, 0, fmt,##__VA_ARGS__); \
+	} while (0)
+
+#define util_log_full_cat(category, level, fmt, ...) \
+	do { \
+		if constexpr ((level) >= UTIL_LOG_MIN_LEVEL) \
+			if (util_log_enabled(category, level)) \
+				util_log_category_message(category, level, __FILE__, __FUNCTION__, __LINE__, fmt,##__VA_ARGS__); \
+	} while (0)
+
+/// Log at most per_second messages a second from this call site.
+#define util_log_limited(category, level, per_second, fmt, ...) \
+	do { \
+		if constexpr ((level) >= UTIL_LOG_MIN_LEVEL) \
+			if (util_log_enabled(category, level)) { \
+				static LogRateLimit util_log_limit_ = { per_second, fmt, { 0 }, { 0 }, { 0 } }; \
+				if (util_log_rate_allow(util_log_limit_, category, level)) \
+					util_log_category_message(category, level, nullptr, nullptr, 0, fmt,##__VA_ARGS__); \
+			} \
+	} while (0)
+
+#define util_log_full(level, fmt, ...) util_log_full_cat(LogCategory_General, level, fmt,##__VA_ARGS__)
 
 #define util_log_full_debug(fmt, ...) util_log_full(LogLevel_Debug, fmt,##__VA_ARGS__)
 #define util_log_full_info(fmt, ...)  util_log_full(LogLevel_Info,  fmt,##__VA_ARGS__)
@@ -21,8 +209,116 @@ void util_log_message(int level, const char* filename, const char* funcname, int
 #define util_log_full_warn(fmt, ...)  util_log_full(LogLevel_Warn,  fmt,##__VA_ARGS__)
 #define util_log_full_err(fmt, ...)   util_log_full(LogLevel_Error, fmt,##__VA_ARGS__)
 
-#define util_log_debug(fmt, ...)      util_log_message(LogLevel_Debug, fmt,##__VA_ARGS__)
-#define util_log_info(fmt, ...)       util_log_message(LogLevel_Info,  fmt,##__VA_ARGS__)
-#define util_log_sys(fmt, ...)        util_log_message(LogLevel_Sys,   fmt,##__VA_ARGS__)
-#define util_log_warn(fmt, ...)       util_log_message(LogLevel_Warn,  fmt,##__VA_ARGS__)
-#define util_log_err(fmt, ...)        util_log_message(LogLevel_Error, fmt,##__VA_ARGS__)
\ No newline at end of file
+/// Longest string argument of a binary message; longer ones are truncated.
+static const unsigned LOG_BINARY_STRING_SIZE = 256;
+
+/// Type tag of an argument of a binary message, see log_format.h.
+template <class T>
+constexpr char util_log_arg_tag()
+{
+	typedef typename std::decay<T>::type D;
+	if constexpr (std::is_same<D, char*>::value || std::is_same<D, const char*>::value)
+		return 's';
+	else if constexpr (std::is_pointer<D>::value)
+		return 'p';
+	else if constexpr (std::is_floating_point<D>::value)
+		return 'd';
+	else if constexpr (std::is_enum<D>::value)
+		return 'i';
+	else if constexpr (std::is_integral<D>::value) {
+		if (sizeof(D) > 4)
+			return std::is_signed<D>::value ? 'l' : 'L';
+		return std::is_signed<D>::value || sizeof(D) < 4 ? 'i' : 'u';
+	}
+	else {
+		static_assert(sizeof(D) == 0, "binary log arguments are numbers, enums, pointers and C strings");
+		return 0;
+	}
+}
+
+/// Most bytes an argument takes serialized.
+template <class T>
+constexpr unsigned util_log_arg_size()
+{
+	constexpr char tag = util_log_arg_tag<T>();
+	return tag == 's' ? 2 + LOG_BINARY_STRING_SIZE : tag == 'i' || tag == 'u' ? 4 : 8;
+}
+
+template <class T>
+inline char* util_log_write_arg(char* out, const T& value)
+{
+	constexpr char tag = util_log_arg_tag<T>();
+	if constexpr (tag == 's') {
+		// Decayed first, so that a char array is not compared to null.
+		const char* text = value;
+		if (!text)
+			text = "(null)";
+		unsigned short length = (unsigned short)strnlen(text, LOG_BINARY_STRING_SIZE);
+		memcpy(out, &length, 2);
+		memcpy(out + 2, text, length);
+		return out + 2 + length;
+	}
+	else if constexpr (tag == 'p') {
+		unsigned long long bits = (unsigned long long)(size_t)value;
+		memcpy(out, &bits, 8);
+		return out + 8;
+	}
+	else if constexpr (tag == 'd') {
+		double number = (double)value;
+		memcpy(out, &number, 8);
+		return out + 8;
+	}
+	else if constexpr (tag == 'i' || tag == 'u') {
+		int number = (int)value;
+		memcpy(out, &number, 4);
+		return out + 4;
+	}
+	else {
+		long long number = (long long)value;
+		memcpy(out, &number, 8);
+		return out + 8;
+	}
+}
+
+/// Serialize the arguments of a binary message on the stack and log them.
+template <class... Args>
+inline void util_log_binary_message(LogSite& site, const Args&... args)
+{
+	static const char types[] = { util_log_arg_tag<Args>()..., 0 };
+	if (!site.id.load(std::memory_order_acquire))
+		util_log_register_site(site, types);
+
+	char buffer[(util_log_arg_size<Args>() + ... + 1)];
+	char* out = buffer;
+	((out = util_log_write_arg(out, args)), ...);
+	util_log_binary_push(site, buffer, (unsigned)(out - buffer));
+}
+
+#define util_log_binary_cat(category, level, fmt, ...) \
+	do { \
+		if constexpr ((level) >= UTIL_LOG_MIN_LEVEL) \
+			if (util_log_enabled(category, level)) { \
+				static LogSite util_log_site_ = { category, level, fmt, __FILE__, __FUNCTION__, __LINE__, nullptr, { 0 } }; \
+				util_log_binary_message(util_log_site_,##__VA_ARGS__); \
+			} \
+	} while (0)
+
+#define util_log_binary(level, fmt, ...) util_log_binary_cat(LogCategory_General, level, fmt,##__VA_ARGS__)
+
+#define util_log_binary_debug(fmt, ...) util_log_binary(LogLevel_Debug, fmt,##__VA_ARGS__)
+#define util_log_binary_info(fmt, ...)  util_log_binary(LogLevel_Info,  fmt,##__VA_ARGS__)
+#define util_log_binary_sys(fmt, ...)   util_log_binary(LogLevel_Sys,   fmt,##__VA_ARGS__)
+#define util_log_binary_warn(fmt, ...)  util_log_binary(LogLevel_Warn,  fmt,##__VA_ARGS__)
+#define util_log_binary_err(fmt, ...)   util_log_binary(LogLevel_Error, fmt,##__VA_ARGS__)
+
+#define util_log_debug(fmt, ...)      util_log_cat(LogCategory_General, LogLevel_Debug, fmt,##__VA_ARGS__)
+#define util_log_info(fmt, ...)       util_log_cat(LogCategory_General, LogLevel_Info,  fmt,##__VA_ARGS__)
+#define util_log_sys(fmt, ...)        util_log_cat(LogCategory_General, LogLevel_Sys,   fmt,##__VA_ARGS__)
+#define util_log_warn(fmt, ...)       util_log_cat(LogCategory_General, LogLevel_Warn,  fmt,##__VA_ARGS__)
+#define util_log_err(fmt, ...)        util_log_cat(LogCategory_General, LogLevel_Error, fmt,##__VA_ARGS__)
+
+#define util_log_cat_debug(category, fmt, ...) util_log_cat(category, LogLevel_Debug, fmt,##__VA_ARGS__)
+#define util_log_cat_info(category, fmt, ...)  util_log_cat(category, LogLevel_Info,  fmt,##__VA_ARGS__)
+#define util_log_cat_sys(category, fmt, ...)   util_log_cat(category, LogLevel_Sys,   fmt,##__VA_ARGS__)
+#define util_log_cat_warn(category, fmt, ...)  util_log_cat(category, LogLevel_Warn,  fmt,##__VA_ARGS__)
+#define util_log_cat_err(category, fmt, ...)   util_log_cat(category, LogLevel_Error, fmt,##__VA_ARGS__)
\ No newline at end of file
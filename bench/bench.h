@@ -0,0 +1,160 @@
+#pragma once
+
+#include "math/Math.h"
+
+#include <chrono>
+#include <float.h>
+#include <math.h>
+
+// Shared helpers of the math benchmark cases.
+
+namespace Bench
+{
+
+extern double      g_MinTimeMs;
+extern const char* g_Filter;
+
+/// Name of the math mode this executable was built with.
+const char* Mode();
+/// Return whether the case passes the --filter option.
+bool        Enabled(const char* name);
+
+/// Elements in the working set of the per-element cases, small enough to stay in the L1 cache.
+static const unsigned kCOUNT = 1024;
+
+/// Largest error of a case against its double precision reference.
+struct Accuracy
+{
+	Accuracy() : maxUlp(0.0), maxAbs(0.0), measured(false) {}
+
+	/// Compare one result of count elements with its reference. The ulp is taken at magnitude, or at the largest
+	/// reference element when magnitude is 0; dot products pass the sum of the absolute terms so that cancellation
+	/// is not reported as error.
+	void Add(const float* result, const double* reference, unsigned count, double magnitude = 0.0);
+
+	double maxUlp;
+	double maxAbs;
+	bool   measured;
+};
+
+/// Print one result line. ulpLimit <= 0 means the case has no accuracy limit; correct reports the outcome of
+/// checks that are not about rounding, such as a culling result matching the brute force answer. detail is an
+/// optional note printed after the result.
+void Report(const char* name, double nsPerOp, const Accuracy& accuracy, double ulpLimit, bool correct = true,
+	const char* detail = nullptr);
+
+/// Call body, which performs opsPerCall operations, until at least the minimum time has passed and return the
+/// average time of one operation in nanoseconds.
+template <class F>
+double Measure(unsigned opsPerCall, F body)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	body();
+	unsigned long long calls = 0;
+	unsigned long long batch = 1;
+	Clock::time_point start = Clock::now();
+	double elapsedMs = 0.0;
+	while (elapsedMs < g_MinTimeMs) {
+		for (unsigned long long i = 0; i < batch; ++i)
+			body();
+		calls += batch;
+		batch *= 2;
+		elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+	return elapsedMs * 1e6 / ((double)calls * opsPerCall);
+}
+
+/// Keep a value alive so the optimizer cannot drop the computation producing it.
+template <class T>
+void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
+
+/// Time op(i) over i in [0, kCOUNT), where op stores its result in out[i], then compare every result with the
+/// floats elements ref(i, expected) writes. ref returns the magnitude for Accuracy::Add, usually 0.
+template <class T, class Op, class Ref>
+void ElementCase(const char* name, double ulpLimit, unsigned floats, T* out, Op op, Ref ref)
+{
+	if (!Enabled(name))
+		return;
+
+	double ns = Measure(kCOUNT, [&]() {
+		for (unsigned i = 0; i < kCOUNT; ++i)
+			op(i);
+		DoNotOptimize(out[0]);
+	});
+
+	Accuracy accuracy;
+	double expected[16];
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		op(i);
+		double magnitude = ref(i, expected);
+		accuracy.Add(reinterpret_cast<const float*>(&out[i]), expected, floats, magnitude);
+	}
+	Report(name, ns, accuracy, ulpLimit);
+}
+
+/// Time op(), which processes count elements at once, then compare every element result(i, got) gathers with the
+/// floats elements ref(i, expected) writes. ref returns the magnitude for Accuracy::Add, usually 0.
+template <class Op, class Result, class Ref>
+void BulkCase(const char* name, double ulpLimit, unsigned count, unsigned floats, Op op, Result result, Ref ref)
+{
+	if (!Enabled(name))
+		return;
+
+	double ns = Measure(count, op);
+
+	Accuracy accuracy;
+	float got[16];
+	double expected[16];
+	op();
+	for (unsigned i = 0; i < count; ++i) {
+		result(i, got);
+		double magnitude = ref(i, expected);
+		accuracy.Add(got, expected, floats, magnitude);
+	}
+	Report(name, ns, accuracy, ulpLimit);
+}
+
+/// Small deterministic generator, so every mode and platform benchmarks the same data.
+class Random
+{
+public:
+	explicit Random(unsigned seed = 12345u) : m_State(seed) {}
+
+	/// Return a float in [0, 1).
+	float Next()
+	{
+		m_State = m_State * 1664525u + 1013904223u;
+		return (m_State >> 8) * (1.0f / 16777216.0f);
+	}
+	float Range(float lo, float hi) { return lo + (hi - lo) * Next(); }
+
+private:
+	unsigned m_State;
+};
+
+void RunScalarCases();
+void RunVectorCases();
+void RunMatrixCases();
+void RunQuaternionCases();
+void RunBulkCases();
+void RunCullingCases();
+void RunPackedCases();
+void RunSkinningCases();
+void RunHierarchyCases();
+void RunRayCases();
+void RunSplineCases();
+void RunMeshCases();
+void RunLogCases();
+void RunDeterminismCases();
+void RunLuaCases();
+
+}
@@ -0,0 +1,120 @@
+#include "reference.h"
+
+#include <string.h>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+template <class M>
+void TransformCases(const char* pointsName, const char* directionsName, const M& m)
+{
+	Random random(4);
+	std::vector<float> x(kCOUNT), y(kCOUNT), z(kCOUNT), outX(kCOUNT), outY(kCOUNT), outZ(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		x[i] = random.Range(-10.0f, 10.0f);
+		y[i] = random.Range(-10.0f, 10.0f);
+		z[i] = random.Range(-10.0f, 10.0f);
+	}
+	DMat4 dm(m);
+
+	BulkCase(pointsName, 8.0, kCOUNT, 3,
+		[&]() { m.BulkTransformPoints(&outX[0], &outY[0], &outZ[0], &x[0], &y[0], &z[0], kCOUNT); DoNotOptimize(outX[0]); },
+		[&](unsigned i, float* got) { got[0] = outX[i]; got[1] = outY[i]; got[2] = outZ[i]; },
+		[&](unsigned i, double* e) {
+			double in[4] = { x[i], y[i], z[i], 1.0 };
+			double r[4];
+			dm.Transform(in, r);
+			for (unsigned k = 0; k < 3; ++k)
+				e[k] = r[k] / r[3];
+			return 0.0;
+		});
+
+	BulkCase(directionsName, 8.0, kCOUNT, 3,
+		[&]() { m.BulkTransformDirections(&outX[0], &outY[0], &outZ[0], &x[0], &y[0], &z[0], kCOUNT); DoNotOptimize(outX[0]); },
+		[&](unsigned i, float* got) { got[0] = outX[i]; got[1] = outY[i]; got[2] = outZ[i]; },
+		[&](unsigned i, double* e) {
+			double in[4] = { x[i], y[i], z[i], 0.0 };
+			double r[4];
+			dm.Transform(in, r);
+			for (unsigned k = 0; k < 3; ++k)
+				e[k] = r[k];
+			return 0.0;
+		});
+}
+
+template <class Blend>
+void BlendCase(const char* name, double ulpLimit, const std::vector<Quaternion>& a, const std::vector<Quaternion>& b,
+	const std::vector<float>& t, bool slerp, Blend blend)
+{
+	std::vector<Quaternion> out(kCOUNT);
+	BulkCase(name, ulpLimit, kCOUNT, 4,
+		[&]() { blend(&out[0], &a[0], &b[0], &t[0], kCOUNT); DoNotOptimize(out[0]); },
+		[&](unsigned i, float* got) { memcpy(got, out[i].Data(), sizeof(Quaternion)); },
+		[&](unsigned i, double* e) {
+			DQuat lhs(a[i]), rhs(b[i]);
+			if (lhs.Dot(rhs) < 0.0)
+				rhs = rhs * -1.0;
+			DQuat expected = slerp ? Slerp(lhs, rhs, t[i]) : (lhs * (1.0 - t[i]) + rhs * t[i]).Normalized();
+			expected.StoreMatching(out[i], e);
+			return 0.0;
+		});
+}
+
+/// Whether every quaternion blended alone, by the scalar lanes, matches the same quaternion blended in a stream,
+/// by the widest lanes. Returns the time per single blend in ns.
+template <class Blend>
+double BlendTailMatches(const std::vector<Quaternion>& a, const std::vector<Quaternion>& b, const std::vector<float>& t,
+	Blend blend, bool& correct)
+{
+	std::vector<Quaternion> stream(kCOUNT), single(kCOUNT);
+	blend(&stream[0], &a[0], &b[0], &t[0], kCOUNT);
+	double ns = Measure(kCOUNT, [&]() {
+		for (unsigned i = 0; i < kCOUNT; ++i)
+			blend(&single[i], &a[i], &b[i], &t[i], 1);
+		DoNotOptimize(single[0]);
+	});
+	correct = correct && !memcmp(&stream[0], &single[0], kCOUNT * sizeof(Quaternion));
+	return ns;
+}
+
+}
+
+void RunBulkCases()
+{
+	Random random(5);
+	Matrix4 projective = RandomTransform(random).ToMatrix4();
+	projective.m30 = 0.01f;
+	projective.m31 = -0.02f;
+	projective.m32 = 0.03f;
+	TransformCases("Matrix3x4.BulkTransformPoints", "Matrix3x4.BulkTransformDirections", RandomTransform(random));
+	TransformCases("Matrix4.BulkTransformPoints", "Matrix4.BulkTransformDirections", projective);
+
+	std::vector<Quaternion> a(kCOUNT), b(kCOUNT);
+	std::vector<float> t(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		a[i] = RandomRotation(random);
+		b[i] = RandomRotation(random);
+		t[i] = random.Next();
+	}
+
+	void (*slerp)(Quaternion*, const Quaternion*, const Quaternion*, const float*, unsigned) = Quaternion::BulkSlerp;
+	void (*slerpFast)(Quaternion*, const Quaternion*, const Quaternion*, const float*, unsigned) = Quaternion::BulkSlerpFast;
+	void (*nlerp)(Quaternion*, const Quaternion*, const Quaternion*, const float*, unsigned) = Quaternion::BulkNlerp;
+	BlendCase("Quaternion.BulkSlerp", 16.0, a, b, t, true, slerp);
+	BlendCase("Quaternion.BulkSlerpFast", 16384.0, a, b, t, true, slerpFast);
+	BlendCase("Quaternion.BulkNlerp", 16.0, a, b, t, false, nlerp);
+
+	// The lane types promise the same results at every width, approximate reciprocal square roots included.
+	if (Enabled("Quaternion.BulkBlend.Tail")) {
+		bool correct = true;
+		double ns = BlendTailMatches(a, b, t, slerp, correct) + BlendTailMatches(a, b, t, slerpFast, correct) +
+			BlendTailMatches(a, b, t, nlerp, correct);
+		Report("Quaternion.BulkBlend.Tail", ns / 3, Accuracy(), 0.0, correct);
+	}
+}
+
+}
@@ -0,0 +1,173 @@
+#include "reference.h"
+#include "math/DynamicTree.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// Scene of boxes spread over a flat 2000 x 2000 x 200 world, seen by a camera near one edge.
+struct Scene
+{
+	explicit Scene(unsigned count) : boxes(count), centerX(count), centerY(count), centerZ(count),
+		halfX(count), halfY(count), halfZ(count), radius(count)
+	{
+		Random random(6);
+		for (unsigned i = 0; i < count; ++i) {
+			Vector3 center(random.Range(-1000.0f, 1000.0f), random.Range(-1000.0f, 1000.0f), random.Range(-100.0f, 100.0f));
+			Vector3 half(random.Range(0.5f, 3.0f), random.Range(0.5f, 3.0f), random.Range(0.5f, 3.0f));
+			boxes[i] = BoundingBox(center - half, center + half);
+			centerX[i] = center.x;
+			centerY[i] = center.y;
+			centerZ[i] = center.z;
+			halfX[i] = half.x;
+			halfY[i] = half.y;
+			halfZ[i] = half.z;
+			radius[i] = half.Length();
+		}
+		frustum.Define(70.0f, 50.0f, 0.1f, 800.0f, Vector3(0.0f, -900.0f, 10.0f), Quaternion(-5.0f, 10.0f, 0.0f).RotationMatrix());
+	}
+
+	std::vector<BoundingBox> boxes;
+	std::vector<float>       centerX, centerY, centerZ;
+	std::vector<float>       halfX, halfY, halfZ;
+	std::vector<float>       radius;
+	Frustum                  frustum;
+};
+
+void Sort(std::vector<int>& v)
+{
+	std::sort(v.begin(), v.end());
+}
+
+}
+
+void RunCullingCases()
+{
+	const unsigned count = 100000;
+	Scene scene(count);
+	std::vector<unsigned> visible(count);
+	Accuracy none;
+
+	// Reference answer from the scalar per-box test.
+	std::vector<unsigned> expected;
+	for (unsigned i = 0; i < count; ++i) {
+		if (scene.frustum.IsInsideFast(scene.boxes[i]))
+			expected.push_back(i);
+	}
+
+	if (Enabled("Frustum.IsInsideFast")) {
+		double ns = Measure(count, [&]() {
+			unsigned n = 0;
+			for (unsigned i = 0; i < count; ++i) {
+				visible[n] = i;
+				n += scene.frustum.IsInsideFast(scene.boxes[i]);
+			}
+			DoNotOptimize(n);
+		});
+		Report("Frustum.IsInsideFast", ns, none, 0.0);
+	}
+
+	if (Enabled("Frustum.CullBoxes")) {
+		unsigned n = 0;
+		double ns = Measure(count, [&]() {
+			n = scene.frustum.CullBoxes(&scene.centerX[0], &scene.centerY[0], &scene.centerZ[0],
+				&scene.halfX[0], &scene.halfY[0], &scene.halfZ[0], count, &visible[0]);
+			DoNotOptimize(n);
+		});
+		Report("Frustum.CullBoxes", ns, none, 0.0, std::vector<unsigned>(visible.begin(), visible.begin() + n) == expected);
+	}
+
+	if (Enabled("Frustum.CullSpheres")) {
+		unsigned n = 0;
+		double ns = Measure(count, [&]() {
+			n = scene.frustum.CullSpheres(&scene.centerX[0], &scene.centerY[0], &scene.centerZ[0], &scene.radius[0],
+				count, &visible[0]);
+			DoNotOptimize(n);
+		});
+		bool correct = true;
+		for (unsigned i = 0, k = 0; i < count; ++i) {
+			if (scene.frustum.IsInsideFast(Sphere(Vector3(scene.centerX[i], scene.centerY[i], scene.centerZ[i]), scene.radius[i])))
+				correct = correct && k < n && visible[k++] == i;
+		}
+		Report("Frustum.CullSpheres", ns, none, 0.0, correct);
+	}
+
+	// The tree cases report the time of one whole query over the scene.
+	if (!Enabled("DynamicTree") && !Enabled("BruteForce"))
+		return;
+
+	DynamicTree tree(0.5f);
+	std::vector<int> proxies(count);
+	if (Enabled("DynamicTree.Insert")) {
+		double ns = Measure(count, [&]() {
+			tree.Clear();
+			for (unsigned i = 0; i < count; ++i)
+				proxies[i] = tree.Insert(scene.boxes[i], i);
+		});
+		Report("DynamicTree.Insert", ns, none, 0.0);
+	}
+	tree.Clear();
+	for (unsigned i = 0; i < count; ++i)
+		proxies[i] = tree.Insert(scene.boxes[i], i);
+
+	std::vector<int> result, reference;
+	if (Enabled("DynamicTree.QueryFrustum") || Enabled("BruteForce.QueryFrustum")) {
+		double treeNs = Measure(1, [&]() { result.clear(); tree.Query(scene.frustum, result); });
+		double bruteNs = Measure(1, [&]() {
+			reference.clear();
+			for (unsigned i = 0; i < count; ++i) {
+				if (scene.frustum.IsInsideFast(tree.GetFatBox(proxies[i])))
+					reference.push_back(proxies[i]);
+			}
+		});
+		Sort(result);
+		Sort(reference);
+		Report("DynamicTree.QueryFrustum", treeNs, none, 0.0, result == reference);
+		Report("BruteForce.QueryFrustum", bruteNs, none, 0.0);
+	}
+
+	if (Enabled("DynamicTree.QueryRay") || Enabled("BruteForce.QueryRay")) {
+		Ray ray(Vector3(-1000.0f, -1000.0f, 0.0f), Vector3(1.0f, 1.0f, 0.01f));
+		double treeNs = Measure(1, [&]() { result.clear(); tree.Query(ray, 2000.0f, result); });
+		double bruteNs = Measure(1, [&]() {
+			reference.clear();
+			for (unsigned i = 0; i < count; ++i) {
+				if (ray.HitDistance(tree.GetFatBox(proxies[i])) <= 2000.0f)
+					reference.push_back(proxies[i]);
+			}
+		});
+		Sort(result);
+		Sort(reference);
+		Report("DynamicTree.QueryRay", treeNs, none, 0.0, result == reference);
+		Report("BruteForce.QueryRay", bruteNs, none, 0.0);
+	}
+
+	if (Enabled("DynamicTree.QueryPairs")) {
+		std::vector<std::pair<int, int> > pairs;
+		double ns = Measure(1, [&]() { pairs.clear(); tree.QueryPairs(pairs); });
+		Report("DynamicTree.QueryPairs", ns, none, 0.0);
+	}
+
+	if (Enabled("DynamicTree.Move")) {
+		// Every object drifts along its own constant velocity, as in a simulation step.
+		Random random(7);
+		std::vector<Vector3> velocity(count);
+		for (unsigned i = 0; i < count; ++i)
+			velocity[i] = RandomVector3(random, 0.2f);
+		std::vector<BoundingBox> boxes = scene.boxes;
+		double ns = Measure(count, [&]() {
+			for (unsigned i = 0; i < count; ++i) {
+				boxes[i] = BoundingBox(boxes[i].minimum + velocity[i], boxes[i].maximum + velocity[i]);
+				tree.Move(proxies[i], boxes[i], velocity[i] * 4.0f);
+			}
+		});
+		Report("DynamicTree.Move", ns, none, 0.0);
+	}
+}
+
+}
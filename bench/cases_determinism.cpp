@@ -0,0 +1,161 @@
+#include "math/Math.h"
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// The inputs of the workload come from the inline helpers of the bench, which have to leave contraction off as well.
+MATH_CONTRACT_OFF_BEGIN
+
+#include "reference.h"
+#include "math/TransformHierarchy.h"
+
+namespace Bench
+{
+
+namespace
+{
+
+/// Steps of the workload; every step hashes the results of one pass over the math library.
+const unsigned kSTEPS = 256;
+/// Nodes of the hierarchy the workload updates with several threads.
+const unsigned kNODES = 4096;
+
+/// Workload hashes of MATH_DETERMINISTIC builds, one per arithmetic path. Every compiler, optimization level and
+/// x86 processor has to reproduce them; the AVX2 build shares the SSE value. A change to the arithmetic of the
+/// math library changes them on purpose: update the values from the output of the benchmark then.
+#ifdef MATH_SSE
+const unsigned long long kDETERMINISTIC_HASH = 0xb06dd719c5386391ull;
+#else
+const unsigned long long kDETERMINISTIC_HASH = 0xa3eed1003f19b780ull;
+#endif
+
+/// 64-bit FNV-1a over the bits of the results.
+class Hash
+{
+public:
+	Hash() : m_Value(14695981039346656037ull) {}
+
+	void Add(const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+			m_Value = (m_Value ^ bytes[i]) * 1099511628211ull;
+	}
+	template <class T>
+	void Add(const T& value) { Add(&value, sizeof(T)); }
+
+	unsigned long long GetValue() const { return m_Value; }
+
+private:
+	unsigned long long m_Value;
+};
+
+/// Run the transcendental functions, vector, quaternion and matrix operations, the batched kernels and a threaded
+/// hierarchy update over fixed inputs and return the hash of every result.
+unsigned long long RunWorkload()
+{
+	Random random(16);
+	Hash hash;
+	std::vector<Quaternion> from(kSTEPS), to(kSTEPS), slerped(kSTEPS);
+	std::vector<Matrix3x4> transforms(kSTEPS), inverses(kSTEPS);
+
+	for (unsigned i = 0; i < kSTEPS; ++i) {
+		float angle = random.Range(-100.0f, 100.0f);
+		float x = random.Range(-1.0f, 1.0f);
+		float y = random.Range(-1.0f, 1.0f);
+		float s, c;
+		Math::Policy::SinCos(angle, s, c);
+		hash.Add(s);
+		hash.Add(c);
+		hash.Add(Math::Policy::Tan(angle));
+		hash.Add(Math::Policy::Atan2(y, x));
+		hash.Add(Math::Policy::Asin(x));
+		hash.Add(Math::Policy::Acos(y));
+		hash.Add(Math::Policy::RSqrt(random.Range(0.01f, 100.0f)));
+		hash.Add(Math::AtanDeg(x * 10.0f));
+
+		Vector3 v = RandomVector3(random, 10.0f);
+		Vector3 w = RandomVector3(random, 10.0f);
+		hash.Add(v.Normalized());
+		hash.Add(v.Length());
+		hash.Add(v.Cross(w));
+		hash.Add(v.Angle(w));
+
+		Quaternion a = RandomRotation(random);
+		Quaternion b(angle, w.Normalized());
+		Quaternion euler(random.Range(-89.0f, 89.0f), random.Range(-180.0f, 180.0f), random.Range(-180.0f, 180.0f));
+		hash.Add(b);
+		hash.Add(euler);
+		hash.Add(euler.EulerAngles());
+		hash.Add(a * b);
+		hash.Add(a * v);
+		hash.Add(a.Slerp(b, x * 0.5f + 0.5f));
+		hash.Add(a.Nlerp(b, y * 0.5f + 0.5f, true));
+		hash.Add(Quaternion(v, w));
+		hash.Add(a.RotationMatrix());
+		from[i] = a;
+		to[i] = euler;
+
+		Matrix3x4 m = RandomTransform(random);
+		Matrix3x4 n(v, b, Vector3(1.5f, 0.75f, 1.25f));
+		Vector3 translation, scale;
+		Quaternion rotation;
+		m.Decompose(translation, rotation, scale);
+		hash.Add(m * n);
+		hash.Add(m * w);
+		hash.Add(m.Inverse());
+		hash.Add(m.ToMatrix4().Inverse());
+		hash.Add(translation);
+		hash.Add(rotation);
+		hash.Add(scale);
+		transforms[i] = m;
+	}
+
+	Quaternion::BulkSlerp(&slerped[0], &from[0], &to[0], 0.25f, kSTEPS);
+	hash.Add(&slerped[0], kSTEPS * sizeof(Quaternion));
+	Quaternion::BulkNlerp(&slerped[0], &from[0], &to[0], 0.75f, kSTEPS);
+	hash.Add(&slerped[0], kSTEPS * sizeof(Quaternion));
+	Matrix3x4::BulkInverse(&inverses[0], &transforms[0], kSTEPS);
+	hash.Add(&inverses[0], kSTEPS * sizeof(Matrix3x4));
+
+	TransformHierarchy hierarchy;
+	for (unsigned i = 0; i < kNODES; ++i) {
+		unsigned parent = i < 4 ? TransformHierarchy::NO_PARENT : (unsigned)(random.Next() * i);
+		hierarchy.AddNode(parent, RandomVector3(random, 1.0f), RandomRotation(random), Vector3::ONE);
+	}
+	hierarchy.Update(4);
+	for (unsigned i = 0; i < kNODES; ++i)
+		hash.Add(hierarchy.GetWorldTransform(i));
+
+	return hash.GetValue();
+}
+
+}
+
+void RunDeterminismCases()
+{
+	if (!Enabled("Determinism.Hash"))
+		return;
+
+	unsigned long long value = 0;
+	double ns = Measure(1, [&]() { value = RunWorkload(); DoNotOptimize(value); });
+
+	// The hash has to be stable between runs and threads in every build, and match the recorded value in
+	// deterministic ones.
+	unsigned long long threadValue = 0;
+	std::thread thread([&]() { threadValue = RunWorkload(); });
+	thread.join();
+	bool correct = RunWorkload() == value && threadValue == value;
+#ifdef MATH_DETERMINISTIC
+	correct = correct && value == kDETERMINISTIC_HASH;
+#endif
+
+	char detail[32];
+	snprintf(detail, sizeof(detail), "hash %016llx", value);
+	Report("Determinism.Hash", ns, Accuracy(), 0.0, correct, detail);
+}
+
+}
+
+MATH_CONTRACT_OFF_END
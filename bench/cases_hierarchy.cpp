@@ -0,0 +1,103 @@
+#include "reference.h"
+#include "math/TransformHierarchy.h"
+
+#include <string.h>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// A large scene: 100k nodes under 16 roots. Every node hangs under a random earlier node, which gives a depth of
+/// about a dozen levels.
+const unsigned kNODES = 100000;
+const unsigned kROOTS = 16;
+
+void BuildScene(TransformHierarchy& hierarchy)
+{
+	Random random(12);
+	hierarchy.Reserve(kNODES);
+	for (unsigned i = 0; i < kNODES; ++i) {
+		unsigned parent = i < kROOTS ? TransformHierarchy::NO_PARENT : (unsigned)(random.Next() * i);
+		Vector3 scale(random.Range(0.9f, 1.1f), random.Range(0.9f, 1.1f), random.Range(0.9f, 1.1f));
+		hierarchy.AddNode(parent, RandomVector3(random, 1.0f), RandomRotation(random), scale);
+	}
+}
+
+/// World transforms of every node in double precision, in handle order.
+std::vector<DMat4> ReferenceWorld(const TransformHierarchy& hierarchy)
+{
+	std::vector<DMat4> world(hierarchy.GetNodeCount());
+	for (unsigned i = 0; i < hierarchy.GetNodeCount(); ++i) {
+		DMat4 local(Matrix3x4(hierarchy.GetPosition(i), hierarchy.GetRotation(i), hierarchy.GetScale(i)));
+		unsigned parent = hierarchy.GetParent(i);
+		world[i] = parent == TransformHierarchy::NO_PARENT ? local : world[parent] * local;
+	}
+	return world;
+}
+
+/// Time touch(hierarchy) followed by an update with threadCount threads, per node of the hierarchy, and compare
+/// every world transform with the double precision chain. When baseline is given, the world transforms must also
+/// match it bit for bit.
+template <class Touch>
+void UpdateCase(const char* name, unsigned threadCount, Touch touch, const TransformHierarchy* baseline = nullptr)
+{
+	if (!Enabled(name))
+		return;
+
+	TransformHierarchy hierarchy;
+	BuildScene(hierarchy);
+	hierarchy.Update(threadCount);
+	double ns = Measure(kNODES, [&]() {
+		touch(hierarchy);
+		hierarchy.Update(threadCount);
+		DoNotOptimize(hierarchy.GetWorldTransform(0));
+	});
+
+	std::vector<DMat4> reference = ReferenceWorld(hierarchy);
+	Accuracy accuracy;
+	bool identical = true;
+	for (unsigned i = 0; i < kNODES; ++i) {
+		const Matrix3x4& world = hierarchy.GetWorldTransform(i);
+		double expected[12];
+		for (unsigned e = 0; e < 12; ++e)
+			expected[e] = reference[i].m[e / 4][e % 4];
+		accuracy.Add(world.Data(), expected, 12);
+		if (baseline)
+			identical = identical && !memcmp(world.Data(), baseline->GetWorldTransform(i).Data(), sizeof(Matrix3x4));
+	}
+	Report(name, ns, accuracy, 64.0, identical);
+}
+
+}
+
+void RunHierarchyCases()
+{
+	// Moving the roots dirties every node; moving 1% of the nodes dirties their subtrees only.
+	auto touchRoots = [](TransformHierarchy& hierarchy) {
+		for (unsigned i = 0; i < kROOTS; ++i)
+			hierarchy.SetPosition(i, hierarchy.GetPosition(i));
+	};
+	Random random(13);
+	std::vector<unsigned> sparse(kNODES / 100);
+	for (unsigned& node : sparse)
+		node = kROOTS + (unsigned)(random.Next() * (kNODES - kROOTS));
+	auto touchSparse = [&](TransformHierarchy& hierarchy) {
+		for (unsigned node : sparse)
+			hierarchy.SetRotation(node, hierarchy.GetRotation(node));
+	};
+
+	// The serial result is the baseline the threaded updates must reproduce exactly.
+	TransformHierarchy serial;
+	BuildScene(serial);
+	serial.Update();
+
+	UpdateCase("TransformHierarchy.Update", 1, touchRoots);
+	UpdateCase("TransformHierarchy.Update.Sparse", 1, touchSparse);
+	UpdateCase("TransformHierarchy.UpdateParallel", 4, touchRoots, &serial);
+	UpdateCase("TransformHierarchy.UpdateParallel.Sparse", 4, touchSparse, &serial);
+}
+
+}
@@ -0,0 +1,517 @@
+#include "bench.h"
+#include "util/log_binary.h"
+#include "util/log_file.h"
+#include "util/log_format.h"
+#include "util/log_json.h"
+#include "util/logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// Messages of the latency cases, and ring size of the asynchronous ones: 1 MB, about 8k short messages.
+const unsigned kMESSAGES = 100000;
+const unsigned kRING_SIZE = 1 << 20;
+
+/// Sink that writes what it receives to the null device the way the console does, counts it and the notices of
+/// lost messages, and checks that the messages of every thread arrive in order. The messages of the ordering cases start with their thread's sequence
+/// number.
+class CountingSink : public LogSink
+{
+public:
+	CountingSink() : count(0), notices(0), ordered(true)
+	{
+		memset(next, 0, sizeof(next));
+#ifdef _WIN32
+		null = fopen("NUL", "w");
+#else
+		null = fopen("/dev/null", "w");
+#endif
+	}
+	~CountingSink()
+	{
+		if (null)
+			fclose(null);
+	}
+
+	void Write(const LogRecord& record) override
+	{
+		if (null)
+			fprintf(null, "[%lld]  [%d]  %s\n", record.time, record.level, record.text);
+		++count;
+		if (strstr(record.text, "dropped") || strstr(record.text, "suppressed"))
+			++notices;
+		unsigned sequence;
+		if (record.thread < kTHREADS && sscanf(record.text, "#%u", &sequence) == 1) {
+			ordered = ordered && sequence >= next[record.thread];
+			next[record.thread] = sequence + 1;
+		}
+	}
+
+	void Flush() override
+	{
+		if (null)
+			fflush(null);
+	}
+
+	static const unsigned kTHREADS = 64;
+
+	FILE*                           null;
+	std::atomic<unsigned long long> count;
+	unsigned                        notices;
+	bool                            ordered;
+	unsigned                        next[kTHREADS];
+};
+
+/// Log count messages, timing every call, and return the latencies in nanoseconds, sorted.
+std::vector<double> LogTimed(unsigned count)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	std::vector<double> latencies(count);
+	for (unsigned i = 0; i < count; ++i) {
+		Clock::time_point start = Clock::now();
+		util_log_info("frame %u: %d bodies awake, step %.3f ms", i, (int)(i & 255), i * 0.001);
+		latencies[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	}
+	std::sort(latencies.begin(), latencies.end());
+	return latencies;
+}
+
+/// The same messages as LogTimed, logged as binary messages.
+std::vector<double> LogTimedBinary(unsigned count)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	std::vector<double> latencies(count);
+	for (unsigned i = 0; i < count; ++i) {
+		Clock::time_point start = Clock::now();
+		util_log_binary_info("frame %u: %d bodies awake, step %.3f ms", i, (int)(i & 255), i * 0.001);
+		latencies[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	}
+	std::sort(latencies.begin(), latencies.end());
+	return latencies;
+}
+
+/// Sink that keeps the text of the last message.
+class CaptureSink : public LogSink
+{
+public:
+	void Write(const LogRecord& record) override { snprintf(text, sizeof(text), "%s", record.text); }
+
+	char text[512] = {};
+};
+
+/// Log a binary message and check that the text it is formatted into is what snprintf makes of it.
+template <class... Args>
+bool CheckBinary(CaptureSink& sink, const char* fmt, const Args&... args)
+{
+	// A site on the stack is enough in synchronous mode, where the message is written before the call returns.
+	LogSite site = { LogCategory_General, LogLevel_Info, fmt, __FILE__, __FUNCTION__, __LINE__, nullptr, { 0 } };
+	char expected[512];
+	snprintf(expected, sizeof(expected), fmt, args...);
+	util_log_binary_message(site, args...);
+	return !strcmp(sink.text, expected);
+}
+
+/// Contents of a file, empty if it does not exist.
+std::string ReadFile(const char* path)
+{
+	std::string data;
+	if (FILE* file = fopen(path, "rb")) {
+		char chunk[1 << 16];
+		size_t read;
+		while ((read = fread(chunk, 1, sizeof(chunk), file)) != 0)
+			data.append(chunk, read);
+		fclose(file);
+	}
+	return data;
+}
+
+/// Whether a log file holds complete lines only.
+bool IsCompleteLog(const std::string& data)
+{
+	return !data.empty() && data.back() == '\n' && data.find('\0') == std::string::npos;
+}
+
+/// Report the mean latency as ns/op and the percentiles as detail.
+void ReportLatency(const char* name, const std::vector<double>& latencies, bool correct, unsigned long long dropped)
+{
+	double sum = 0.0;
+	for (double latency : latencies)
+		sum += latency;
+	char detail[80];
+	snprintf(detail, sizeof(detail), "p50 %.0f ns, p99 %.0f ns, dropped %llu", latencies[latencies.size() / 2],
+		latencies[latencies.size() * 99 / 100], dropped);
+	Report(name, sum / latencies.size(), Accuracy(), 0.0, correct, detail);
+}
+
+}
+
+void RunLogCases()
+{
+	CountingSink sink;
+	util_log_set_console(false);
+	util_log_add_sink(&sink);
+	// The threads of Log.Async.Block log the same messages; the dedup window is tested on its own.
+	util_log_set_dedup(0);
+
+	// The caller writes to the sinks itself.
+	if (Enabled("Log.Sync")) {
+		sink.count = 0;
+		std::vector<double> latencies = LogTimed(kMESSAGES);
+		ReportLatency("Log.Sync", latencies, sink.count == kMESSAGES, 0);
+	}
+
+	// The caller formats and pushes into the ring. Whatever the sink thread cannot keep up with is dropped and
+	// has to be accounted for.
+	if (Enabled("Log.Async")) {
+		LogStats before, after;
+		util_log_get_stats(&before);
+		sink.count = 0;
+		util_log_start_async(kRING_SIZE, LogOverflow_Drop);
+		std::vector<double> latencies = LogTimed(kMESSAGES);
+		util_log_flush();
+		util_log_stop_async();
+		util_log_get_stats(&after);
+		unsigned long long dropped = after.dropped - before.dropped;
+		ReportLatency("Log.Async", latencies, sink.count + dropped == kMESSAGES, dropped);
+	}
+
+	// Blocking producers on a small ring: every message arrives, in order per thread.
+	if (Enabled("Log.Async.Block")) {
+		const unsigned kTHREADS = 4;
+		const unsigned kPER_THREAD = 20000;
+		sink.count = 0;
+		sink.ordered = true;
+		memset(sink.next, 0, sizeof(sink.next));
+		util_log_start_async(1 << 14, LogOverflow_Block);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for (unsigned t = 0; t < kTHREADS; ++t) {
+			threads.emplace_back([]() {
+				for (unsigned i = 0; i < kPER_THREAD; ++i)
+					util_log_info("#%u of a producer that waits for room", i);
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+		util_log_flush();
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		util_log_stop_async();
+		Report("Log.Async.Block", ns / (kTHREADS * kPER_THREAD), Accuracy(), 0.0,
+			sink.count == kTHREADS * kPER_THREAD && sink.ordered);
+	}
+
+	// A burst into a small ring with the count policy: the sink thread reports the messages it lost.
+	if (Enabled("Log.Async.Count")) {
+		LogStats before, after;
+		util_log_get_stats(&before);
+		sink.count = 0;
+		sink.notices = 0;
+		util_log_start_async(1 << 12, LogOverflow_Count);
+		std::vector<double> latencies = LogTimed(kMESSAGES / 10);
+		util_log_flush();
+		util_log_stop_async();
+		util_log_get_stats(&after);
+		unsigned long long dropped = after.dropped - before.dropped;
+		bool correct = sink.count - sink.notices + dropped == kMESSAGES / 10 && (!dropped || sink.notices > 0);
+		ReportLatency("Log.Async.Count", latencies, correct, dropped);
+	}
+
+	// A message of a category that is turned off costs the check of its level; its arguments are not evaluated.
+	if (Enabled("Log.Disabled")) {
+		util_log_set_level(LogCategory_Script, LogLevel_Warn);
+		unsigned long long before = sink.count;
+		unsigned evaluated = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < kMESSAGES; ++i) {
+			util_log_cat_info(LogCategory_Script, "frame %u: %u scripts", i, ++evaluated);
+			util_log_binary_cat(LogCategory_Script, LogLevel_Debug, "frame %u: %u scripts", i, ++evaluated);
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		util_log_set_level(LogCategory_Script, LogLevel_Debug);
+		Report("Log.Disabled", ns / (2 * kMESSAGES), Accuracy(), 0.0, evaluated == 0 && sink.count == before);
+	}
+
+	// A call site that logs every time through a loop: all but per_second messages a second are suppressed and
+	// counted.
+	if (Enabled("Log.RateLimit")) {
+		LogStats before, after;
+		util_log_get_stats(&before);
+		sink.count = 0;
+		sink.notices = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < kMESSAGES; ++i)
+			util_log_limited(LogCategory_General, LogLevel_Error, 10, "frame %u: callback failed", i);
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		util_log_get_stats(&after);
+		unsigned long long suppressed = after.suppressed - before.suppressed;
+		char detail[80];
+		snprintf(detail, sizeof(detail), "%llu written, %llu suppressed", (unsigned long long)sink.count, suppressed);
+		Report("Log.RateLimit", ns / kMESSAGES, Accuracy(), 0.0,
+			sink.count - sink.notices + suppressed == kMESSAGES && sink.count >= 10 && suppressed > 0, detail);
+	}
+
+	// Two messages that fail in turn every frame: each is written once, then once as "repeated N times" when the
+	// flush ends the window.
+	if (Enabled("Log.Dedup")) {
+		LogStats before, after;
+		util_log_get_stats(&before);
+		sink.count = 0;
+		util_log_set_dedup(1000);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < kMESSAGES; ++i) {
+			if (i & 1)
+				util_log_err("call function 'on_frame' error: attempt to index a nil value");
+			else
+				util_log_warn("call function 'on_frame' warning: missing ImGui.End");
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		util_log_flush();
+		util_log_set_dedup(0);
+		util_log_get_stats(&after);
+		Report("Log.Dedup", ns / kMESSAGES, Accuracy(), 0.0,
+			sink.count == 4 && after.repeated - before.repeated == kMESSAGES - 2);
+	}
+
+	// Binary messages only copy their arguments; the binary sink writes them to a file as they are.
+	const char* kBINARY_LOG = "math_bench_log.blog";
+	util_log_remove_sink(&sink);
+	if (Enabled("Log.Binary.Async")) {
+		LogStats before, after;
+		util_log_get_stats(&before);
+		BinaryLogSink binary(kBINARY_LOG);
+		util_log_add_sink(&binary);
+		util_log_start_async(kRING_SIZE, LogOverflow_Drop);
+		std::vector<double> latencies = LogTimedBinary(kMESSAGES);
+		util_log_flush();
+		util_log_stop_async();
+		util_log_remove_sink(&binary);
+		util_log_get_stats(&after);
+		unsigned long long dropped = after.dropped - before.dropped;
+		ReportLatency("Log.Binary.Async", latencies,
+			binary.IsOpen() && after.written - before.written + dropped == kMESSAGES, dropped);
+	}
+
+	// The file of the previous case read back: its size per message against the console's text, and the time
+	// to decode and format a message.
+	if (Enabled("Log.Binary.Decode")) {
+		std::vector<char> data;
+		if (FILE* file = fopen(kBINARY_LOG, "rb")) {
+			char chunk[1 << 16];
+			size_t read;
+			while ((read = fread(chunk, 1, sizeof(chunk), file)) != 0)
+				data.insert(data.end(), chunk, chunk + read);
+			fclose(file);
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BinaryLogReader reader(data.data(), data.size());
+		LogRecord record;
+		LogClock clock;
+		char line[LOG_LINE_SIZE];
+		unsigned count = 0;
+		unsigned long long textBytes = 0;
+		bool correct = reader.IsValid();
+		while (reader.Next(record)) {
+			unsigned i, bodies;
+			double step;
+			correct = correct && sscanf(record.text, "frame %u: %u bodies awake, step %lf ms", &i, &bodies, &step) == 3 &&
+				bodies == (i & 255);
+			textBytes += util_log_format_line(line, sizeof(line), record, clock.Text(reader.WallTime(record))) + 1;
+			++count;
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		char detail[80];
+		snprintf(detail, sizeof(detail), "%.1f B/message binary, %.1f B/message text", (double)data.size() / count,
+			(double)textBytes / count);
+		Report("Log.Binary.Decode", count ? ns / count : 0.0, Accuracy(), 0.0,
+			correct && count > 0 && data.size() * 3 < textBytes, detail);
+	}
+	remove(kBINARY_LOG);
+
+	// Formatting of the arguments on the sink thread gives what snprintf gives on the caller.
+	if (Enabled("Log.Binary.Format")) {
+		CaptureSink capture;
+		util_log_add_sink(&capture);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		int value = -42;
+		bool correct = CheckBinary(capture, "%d %u %x %X %o", -7, 7u, 255u, 0xbeefu, 8);
+		correct = CheckBinary(capture, "%lld %llu %+lld", -1234567890123LL, 18446744073709551615ULL, 5LL) && correct;
+		correct = CheckBinary(capture, "%f %.3f %8.2e %g %-9.1f|", 1.5, 3.14159f, -12345.678, 1e-7, 2.25) && correct;
+		correct = CheckBinary(capture, "[%s] [%8s] [%-8s] [%.3s]", "text", "pad", "left", "truncated") && correct;
+		correct = CheckBinary(capture, "%c%c %% %05d %*d %.*f", 'o', 'k', 42, 6, 17, 2, 0.125) && correct;
+		correct = CheckBinary(capture, "%p %ld %zu %hd", (void*)&value, 1L << 40, sizeof(value), (short)-3) && correct;
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		util_log_remove_sink(&capture);
+		Report("Log.Binary.Format", ns / 6, Accuracy(), 0.0, correct);
+	}
+
+	// The file sink formats the console's line and copies it into the mapping, against the same lines written
+	// through a buffered FILE. The messages fill about ten segments of 1 MB; three files are kept.
+	if (Enabled("Log.File")) {
+		const char* kPATHS[] = { "math_bench_log.txt", "math_bench_log.txt.1", "math_bench_log.txt.2",
+			"math_bench_log.txt.3" };
+		for (const char* path : kPATHS)
+			remove(path);
+
+		char text[128];
+		LogRecord record = { util_log_time(), 1, LogLevel_Info, LogCategory_General, __FILE__, __FUNCTION__, __LINE__,
+			text, 0, nullptr, nullptr, 0 };
+		record.length = (unsigned)snprintf(text, sizeof(text), "frame %u: %d bodies awake, step %.3f ms", 1u, 2, 0.001);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		bool opened;
+		{
+			FileLogSink file(kPATHS[0], 1 << 20, 3);
+			opened = file.IsOpen();
+			for (unsigned i = 0; i < kMESSAGES; ++i)
+				file.Write(record);
+			record.length = (unsigned)snprintf(text, sizeof(text), "last message");
+			file.Write(record);
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		std::string current = ReadFile(kPATHS[0]), previous = ReadFile(kPATHS[1]), oldest = ReadFile(kPATHS[2]);
+		bool correct = opened && IsCompleteLog(current) && IsCompleteLog(previous) && IsCompleteLog(oldest) &&
+			previous.size() <= (1 << 20) && oldest.size() <= (1 << 20) && ReadFile(kPATHS[3]).empty() &&
+			current.find("last message") != std::string::npos;
+
+		// The baseline goes through the same formatting.
+		record.length = (unsigned)snprintf(text, sizeof(text), "frame %u: %d bodies awake, step %.3f ms", 1u, 2, 0.001);
+		std::chrono::steady_clock::time_point baselineStart = std::chrono::steady_clock::now();
+		if (FILE* file = fopen(kPATHS[3], "wb")) {
+			char line[LOG_LINE_SIZE];
+			LogClock clock;
+			for (unsigned i = 0; i < kMESSAGES; ++i) {
+				unsigned length = util_log_format_line(line, sizeof(line) - 1, record, clock.Text(0));
+				line[length++] = '\n';
+				fwrite(line, 1, length, file);
+			}
+			fclose(file);
+		}
+		double baseline = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - baselineStart).count();
+
+		char detail[80];
+		snprintf(detail, sizeof(detail), "fwrite %.0f ns/message", baseline / kMESSAGES);
+		Report("Log.File", ns / (kMESSAGES + 1), Accuracy(), 0.0, correct, detail);
+		for (const char* path : kPATHS)
+			remove(path);
+	}
+
+	// JSON lines with the time of every record, against the same lines made with a wall clock call per message.
+	// Every line has to be an object with its steady time, never going back, and the last message has to come out
+	// escaped.
+	if (Enabled("Log.Json")) {
+		const char* kPATH = "math_bench_log.jsonl";
+		char text[128];
+		LogRecord record = { util_log_time(), 1, LogLevel_Info, LogCategory_Script, __FILE__, __FUNCTION__, __LINE__,
+			text, 0, nullptr, nullptr, 0 };
+		record.length = (unsigned)snprintf(text, sizeof(text), "frame %u: %d bodies awake, step %.3f ms", 1u, 2, 0.001);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		bool opened;
+		{
+			JsonLogSink json(kPATH);
+			opened = json.IsOpen();
+			for (unsigned i = 0; i < kMESSAGES; ++i) {
+				record.time += 1000;
+				json.Write(record);
+			}
+			record.length = (unsigned)snprintf(text, sizeof(text), "say \"hi\"\n\tC:\\x \x01");
+			json.Write(record);
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		std::string data = ReadFile(kPATH);
+		bool correct = opened && IsCompleteLog(data);
+		unsigned lines = 0;
+		long long last = 0;
+		for (size_t begin = 0; correct && begin < data.size(); ++lines) {
+			size_t end = data.find('\n', begin);
+			long long time = strtoll(data.c_str() + begin + 6, nullptr, 10);
+			correct = data.compare(begin, 6, "{\"ns\":") == 0 && data[end - 1] == '}' && time >= last &&
+				data.find("Z\",\"thread\":1,\"level\":\"info\",\"category\":\"script\",\"file\":", begin) < end;
+			last = time;
+			begin = end + 1;
+		}
+		std::string escaped = "\"msg\":\"say \\\"hi\\\"\\n\\tC:\\\\x \\u0001\"}\n";
+		correct = correct && lines == kMESSAGES + 1 && data.size() > escaped.size() &&
+			data.compare(data.size() - escaped.size(), escaped.size(), escaped) == 0;
+
+		// The baseline converts the wall clock of every message, as the console once did.
+		std::chrono::steady_clock::time_point baselineStart = std::chrono::steady_clock::now();
+		if (FILE* file = fopen(kPATH, "wb")) {
+			record.length = (unsigned)snprintf(text, sizeof(text), "frame %u: %d bodies awake, step %.3f ms", 1u, 2, 0.001);
+			for (unsigned i = 0; i < kMESSAGES; ++i) {
+				time_t now = time(0);
+				tm ts;
+#ifdef _WIN32
+				gmtime_s(&ts, &now);
+#else
+				gmtime_r(&now, &ts);
+#endif
+				char date[24];
+				strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &ts);
+				fprintf(file, "{\"ns\":%lld,\"time\":\"%sZ\",\"thread\":%u,\"level\":\"info\",\"category\":\"script\","
+					"\"file\":\"%s\",\"func\":\"%s\",\"line\":%d,\"msg\":\"%s\"}\n", record.time, date, record.thread,
+					record.file, record.func, record.line, record.text);
+			}
+			fclose(file);
+		}
+		double baseline = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - baselineStart).count();
+
+		char detail[80];
+		snprintf(detail, sizeof(detail), "clock per message %.0f ns/message", baseline / kMESSAGES);
+		Report("Log.Json", ns / (kMESSAGES + 1), Accuracy(), 0.0, correct, detail);
+		remove(kPATH);
+	}
+
+	// A file a crash left behind: complete lines, a line cut short and the zeros of the pre-allocated segment. The
+	// sink keeps the complete lines and goes on after them.
+	if (Enabled("Log.File.Recover")) {
+		const char* kPATH = "math_bench_log.txt";
+		std::string crashed = "[00:00:00]  [INF]  one\n[00:00:00]  [INF]  two\n[00:00:00]  [INF]  thr";
+		if (FILE* file = fopen(kPATH, "wb")) {
+			fwrite(crashed.data(), 1, crashed.size(), file);
+			for (unsigned i = 0; i < 8192; ++i)
+				fputc(0, file);
+			fclose(file);
+		}
+
+		LogRecord record = { util_log_time(), 1, LogLevel_Info, LogCategory_General, nullptr, nullptr, 0, "after", 5,
+			nullptr, nullptr, 0 };
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		{
+			FileLogSink file(kPATH, 1 << 16, 2);
+			file.Write(record);
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		std::string data = ReadFile(kPATH);
+		std::string kept = crashed.substr(0, crashed.rfind('\n') + 1);
+		bool correct = IsCompleteLog(data) && data.compare(0, kept.size(), kept) == 0 &&
+			data.find("after", kept.size()) != std::string::npos && data.find('\n', kept.size()) == data.size() - 1;
+		Report("Log.File.Recover", ns, Accuracy(), 0.0, correct);
+		remove(kPATH);
+	}
+
+	util_log_set_dedup(1000);
+	util_log_set_console(true);
+}
+
+}
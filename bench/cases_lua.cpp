@@ -0,0 +1,191 @@
+#include "bench.h"
+#include "lua/lua_math.h"
+#include "math/Matrix3x4.h"
+#include "math/Quaternion.h"
+
+extern "C"
+{
+#include "lua.h"
+#include "lualib.h"
+#include "lauxlib.h"
+}
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// Iterations of the script loops per call.
+const unsigned kITERATIONS = 10000;
+
+/// The same vector loop written with in-place methods, with operators and with plain Lua tables, plus a batch
+/// transform of a Vector3Array. Each function returns the sum of the transformed vectors.
+const char* kSCRIPT = R"(
+local v, w, acc = Vector3.new(), Vector3.new(1, 2, 3), Vector3.new()
+local q = Quaternion.from_euler(10, 20, 30)
+local m = Matrix3x4.new(Vector3.new(1, 2, 3), q, 1.5)
+
+function inplace(n)
+	acc:set(0, 0, 0)
+	for i = 1, n do
+		acc:add_(v:set(i, 0.5, -i):add_(w):mul_(0.25):rotate_(q):transform_(m))
+	end
+	return acc:unpack()
+end
+
+function operators(n)
+	acc:set(0, 0, 0)
+	for i = 1, n do
+		v.x, v.y, v.z = i, 0.5, -i
+		acc:add_(m * (q * ((v + w) * 0.25)))
+	end
+	return acc:unpack()
+end
+
+local source, points = Vector3Array.new(10000), Vector3Array.new(10000)
+for i = 1, #source do
+	source:set(i, i, 0.5, -i)
+end
+
+function batch(n)
+	points:copy_(source):add_(w):mul_(0.25):rotate_(q):transform_(m):sum(acc)
+	return acc:unpack()
+end
+
+-- Equality of equal values of each type, and of every pair of the types with each other and with other values,
+-- which is false. Returns 1 when the equal values always compared equal, and the number of mixed pairs that did.
+local u, q2, m2 = Vector3.new(), Quaternion.from_euler(10, 20, 30), Matrix3x4.new(Vector3.new(1, 2, 3), q, 1.5)
+local values = { w, q, m, source, 1, "w", {} }
+
+function equality(n)
+	local same, mixed = 1, 0
+	for i = 1, n do
+		u:set(i, 0.5, -i)
+		v:set(i, 0.5, -i)
+		if u ~= v or q ~= q2 or m ~= m2 then
+			same = 0
+		end
+		local a, b = i % #values + 1, i // #values % #values + 1
+		if a ~= b and values[a] == values[b] then
+			mixed = mixed + 1
+		end
+	end
+	return same, mixed, 0
+end
+
+-- Baseline: immutable vectors as tables, one new table per operation.
+local function vadd(a, b) return { x = a.x + b.x, y = a.y + b.y, z = a.z + b.z } end
+local function vmul(a, s) return { x = a.x * s, y = a.y * s, z = a.z * s } end
+local tw = { x = 1, y = 2, z = 3 }
+
+function tables(n)
+	local sum = { x = 0, y = 0, z = 0 }
+	for i = 1, n do
+		sum = vadd(sum, vmul(vadd({ x = i, y = 0.5, z = -i }, tw), 0.25))
+	end
+	return sum.x, sum.y, sum.z
+end
+)";
+
+struct Allocations
+{
+	unsigned long long count;
+};
+
+/// Lua allocator that counts the allocations and the reallocations that grow a block.
+void* CountingAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	if (!nsize) {
+		free(ptr);
+		return nullptr;
+	}
+	// Without ptr, osize is the type of the new object rather than a size.
+	if (!ptr || nsize > osize)
+		++static_cast<Allocations*>(ud)->count;
+	return realloc(ptr, nsize);
+}
+
+/// Call the global function name with n and return its three results as a Vector3.
+Vector3 Call(lua_State* L, const char* name, unsigned n)
+{
+	lua_getglobal(L, name);
+	lua_pushinteger(L, n);
+	if (lua_pcall(L, 1, 3, 0)) {
+		fprintf(stderr, "%s: %s\n", name, lua_tostring(L, -1));
+		lua_pop(L, 1);
+		return Vector3::ZERO;
+	}
+	Vector3 result((float)lua_tonumber(L, -3), (float)lua_tonumber(L, -2), (float)lua_tonumber(L, -1));
+	lua_pop(L, 3);
+	return result;
+}
+
+/// Time one call of the script function per kITERATIONS iterations, after a warm-up call that fills the temporary
+/// rings, and count the allocations of the timed calls. With allocationFree the case fails on any allocation.
+void LoopCase(const char* name, lua_State* L, Allocations& allocations, const char* function, const Vector3& expected,
+	bool allocationFree)
+{
+	if (!Enabled(name))
+		return;
+
+	Vector3 result = Call(L, function, kITERATIONS);
+	unsigned long long calls = 0;
+	unsigned long long before = allocations.count;
+	double ns = Measure(kITERATIONS, [&]() {
+		result = Call(L, function, kITERATIONS);
+		++calls;
+	});
+	double perIteration = (double)(allocations.count - before) / ((double)calls * kITERATIONS);
+
+	char detail[48];
+	snprintf(detail, sizeof(detail), "allocs/iter %.3f", perIteration);
+	bool correct = result.Equals(expected, Math::Abs(expected.x) * 1e-5f) && (!allocationFree || allocations.count == before);
+	Report(name, ns, Accuracy(), 0.0, correct, detail);
+}
+
+}
+
+void RunLuaCases()
+{
+	Allocations allocations = { 0 };
+	lua_State* L = lua_newstate(CountingAlloc, &allocations);
+	luaL_openlibs(L);
+	lua_open_math_lib(L);
+	if (luaL_dostring(L, kSCRIPT)) {
+		fprintf(stderr, "lua: %s\n", lua_tostring(L, -1));
+		lua_close(L);
+		return;
+	}
+
+	// The same computation in C++. The bindings run the same float operations; the batch rotates through a matrix
+	// and sums in a different order, hence the tolerance of the comparison.
+	Vector3 w(1.0f, 2.0f, 3.0f);
+	Quaternion q(10.0f, 20.0f, 30.0f);
+	Matrix3x4 m(Vector3(1.0f, 2.0f, 3.0f), q, Vector3(1.5f, 1.5f, 1.5f));
+	Vector3 expected = Vector3::ZERO;
+	for (unsigned i = 1; i <= kITERATIONS; ++i) {
+		Vector3 v((float)i, 0.5f, -(float)i);
+		expected += m * (q * ((v + w) * 0.25f));
+	}
+	// Lua numbers are doubles, so the table version sums in double precision.
+	double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+	for (unsigned i = 1; i <= kITERATIONS; ++i) {
+		sumX += (i + 1.0) * 0.25;
+		sumY += (0.5 + 2.0) * 0.25;
+		sumZ += (3.0 - i) * 0.25;
+	}
+	Vector3 sum((float)sumX, (float)sumY, (float)sumZ);
+
+	LoopCase("Lua.Vector3.InPlace", L, allocations, "inplace", expected, true);
+	LoopCase("Lua.Vector3.Operators", L, allocations, "operators", expected, true);
+	LoopCase("Lua.Vector3Array.Batch", L, allocations, "batch", expected, true);
+	LoopCase("Lua.Table.Baseline", L, allocations, "tables", sum, false);
+	LoopCase("Lua.Equality", L, allocations, "equality", Vector3(1.0f, 0.0f, 0.0f), true);
+	lua_close(L);
+}
+
+}
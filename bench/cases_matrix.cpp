@@ -0,0 +1,421 @@
+#include "reference.h"
+
+#include <string.h>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// Affine transform with a small projective row, so that the full 4x4 paths are exercised.
+Matrix4 RandomMatrix4(Random& random)
+{
+	Matrix4 m = RandomTransform(random).ToMatrix4();
+	m.m30 = random.Range(-0.1f, 0.1f);
+	m.m31 = random.Range(-0.1f, 0.1f);
+	m.m32 = random.Range(-0.1f, 0.1f);
+	return m;
+}
+
+/// Magnitude for a matrix product: the largest sum of absolute terms of any element.
+double ProductMagnitude(const DMat4& lhs, const DMat4& rhs)
+{
+	double magnitude = 0.0;
+	for (unsigned r = 0; r < 4; ++r) {
+		for (unsigned c = 0; c < 4; ++c) {
+			double sum = 0.0;
+			for (unsigned k = 0; k < 4; ++k)
+				sum += fabs(lhs.m[r][k] * rhs.m[k][c]);
+			magnitude = fmax(magnitude, sum);
+		}
+	}
+	return magnitude;
+}
+
+/// Magnitude for a matrix-vector product.
+double TransformMagnitude(const DMat4& m, const double* in)
+{
+	double magnitude = 0.0;
+	for (unsigned r = 0; r < 4; ++r)
+		magnitude = fmax(magnitude, fabs(m.m[r][0] * in[0]) + fabs(m.m[r][1] * in[1]) + fabs(m.m[r][2] * in[2]) + fabs(m.m[r][3] * in[3]));
+	return magnitude;
+}
+
+void TransposeInPlace(double* m, unsigned size)
+{
+	for (unsigned r = 0; r < size; ++r) {
+		for (unsigned c = r + 1; c < size; ++c) {
+			double t = m[r * size + c];
+			m[r * size + c] = m[c * size + r];
+			m[c * size + r] = t;
+		}
+	}
+}
+
+/// The scalar path of a product of row-major matrices, in its order of evaluation, as the reference of the SSE
+/// path. rows is 4 for Matrix4, or 3 for Matrix3x4 with its implied last row. Returns the magnitude of the largest
+/// element for Accuracy::Add.
+double ScalarMultiply(const float* lhs, const float* rhs, unsigned rows, double* out)
+{
+	double magnitude = 0.0;
+	for (unsigned r = 0; r < rows; ++r) {
+		for (unsigned c = 0; c < 4; ++c) {
+			float sum = lhs[r * 4] * rhs[c];
+			double terms = fabs((double)sum);
+			for (unsigned k = 1; k < rows; ++k) {
+				sum = sum + lhs[r * 4 + k] * rhs[k * 4 + c];
+				terms += fabs((double)lhs[r * 4 + k] * rhs[k * 4 + c]);
+			}
+			if (rows == 3 && c == 3) {
+				sum = sum + lhs[r * 4 + 3];
+				terms += fabs((double)lhs[r * 4 + 3]);
+			}
+			out[r * 4 + c] = sum;
+			magnitude = fmax(magnitude, terms);
+		}
+	}
+	return magnitude;
+}
+
+/// The scalar path of a row-major matrix times a vector, in its order of evaluation, as ScalarMultiply.
+double ScalarTransform(const float* m, const float* in, unsigned rows, double* out)
+{
+	double magnitude = 0.0;
+	for (unsigned r = 0; r < rows; ++r) {
+		float sum = m[r * 4] * in[0] + m[r * 4 + 1] * in[1] + m[r * 4 + 2] * in[2] + m[r * 4 + 3] * in[3];
+		out[r] = sum;
+		magnitude = fmax(magnitude, fabs((double)m[r * 4] * in[0]) + fabs((double)m[r * 4 + 1] * in[1]) +
+			fabs((double)m[r * 4 + 2] * in[2]) + fabs((double)m[r * 4 + 3] * in[3]));
+	}
+	return magnitude;
+}
+
+struct Decomposition
+{
+	Vector3    translation;
+	Quaternion rotation;
+	Vector3    scale;
+};
+
+/// Compare decompositions with the double-precision polar decomposition, translation, rotation and scale each
+/// against their own magnitude.
+template <class M>
+void AddDecompositions(Accuracy& accuracy, const std::vector<M>& in, const Decomposition* out)
+{
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		DVec3 translation, scale;
+		DQuat rotation;
+		Decompose(DMat4(in[i]), translation, rotation, scale);
+
+		double expected[4];
+		translation.Store(expected);
+		accuracy.Add(out[i].translation.Data(), expected, 3);
+		rotation.StoreMatching(out[i].rotation, expected);
+		accuracy.Add(out[i].rotation.Data(), expected, 4);
+		scale.Store(expected);
+		accuracy.Add(out[i].scale.Data(), expected, 3);
+	}
+}
+
+/// Whether recomposing every decomposition gives back its matrix. Only matrices without shear round-trip.
+template <class M>
+bool RoundTrips(const std::vector<M>& in, const Decomposition* out)
+{
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		Matrix3x4 recomposed(out[i].translation, out[i].rotation, out[i].scale);
+		Matrix3x4 original(in[i]);
+		for (unsigned e = 0; e < 12; ++e) {
+			float expected = original.Data()[e];
+			if (Math::Abs(recomposed.Data()[e] - expected) > 1e-5f * Math::Max(Math::Abs(expected), 10.0f))
+				return false;
+		}
+	}
+	return true;
+}
+
+/// Time Decompose over the working set and check it against the reference, and that it round-trips when the
+/// matrices have no shear.
+template <class M>
+void DecomposeCase(const char* name, double ulpLimit, const std::vector<M>& in, bool roundTrip)
+{
+	if (!Enabled(name))
+		return;
+
+	std::vector<Decomposition> out(kCOUNT);
+	double ns = Measure(kCOUNT, [&]() {
+		for (unsigned i = 0; i < kCOUNT; ++i)
+			in[i].Decompose(out[i].translation, out[i].rotation, out[i].scale);
+		DoNotOptimize(out[0]);
+	});
+
+	Accuracy accuracy;
+	AddDecompositions(accuracy, in, &out[0]);
+	Report(name, ns, accuracy, ulpLimit, !roundTrip || RoundTrips(in, &out[0]));
+}
+
+/// Time BulkDecompose, which has to agree with Decompose bit for bit, over the working set.
+void BulkDecomposeCase(const char* name, double ulpLimit, const std::vector<Matrix3x4>& in, bool roundTrip)
+{
+	if (!Enabled(name))
+		return;
+
+	std::vector<Vector3> translations(kCOUNT), scales(kCOUNT);
+	std::vector<Quaternion> rotations(kCOUNT);
+	double ns = Measure(kCOUNT, [&]() {
+		Matrix3x4::BulkDecompose(&in[0], &translations[0], &rotations[0], &scales[0], kCOUNT);
+		DoNotOptimize(rotations[0]);
+	});
+
+	std::vector<Decomposition> out(kCOUNT), single(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		out[i].translation = translations[i];
+		out[i].rotation = rotations[i];
+		out[i].scale = scales[i];
+		in[i].Decompose(single[i].translation, single[i].rotation, single[i].scale);
+	}
+	Accuracy accuracy;
+	AddDecompositions(accuracy, in, &out[0]);
+	bool correct = !memcmp(&out[0], &single[0], kCOUNT * sizeof(Decomposition)) && (!roundTrip || RoundTrips(in, &out[0]));
+	Report(name, ns, accuracy, ulpLimit, correct);
+}
+
+}
+
+void RunMatrixCases()
+{
+	Random random(2);
+	std::vector<Matrix3> a3(kCOUNT), b3(kCOUNT), out3(kCOUNT);
+	std::vector<Matrix3x4> a34(kCOUNT), b34(kCOUNT), out34(kCOUNT);
+	std::vector<Matrix4> a4(kCOUNT), b4(kCOUNT), out4(kCOUNT);
+	std::vector<Vector3> v3(kCOUNT), outV3(kCOUNT);
+	std::vector<Vector4> v4(kCOUNT), outV4(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		a34[i] = RandomTransform(random);
+		b34[i] = RandomTransform(random);
+		a3[i] = a34[i].ToMatrix3();
+		b3[i] = b34[i].ToMatrix3();
+		a4[i] = RandomMatrix4(random);
+		b4[i] = RandomMatrix4(random);
+		v3[i] = RandomVector3(random, 10.0f);
+		v4[i] = Vector4(RandomVector3(random, 10.0f), 1.0f);
+	}
+
+	ElementCase("Matrix3.Multiply", 4.0, 9, &out3[0],
+		[&](unsigned i) { out3[i] = a3[i] * b3[i]; },
+		[&](unsigned i, double* e) {
+			DMat4 lhs(a3[i]), rhs(b3[i]);
+			(lhs * rhs).Store(e, 3, 3);
+			return ProductMagnitude(lhs, rhs);
+		});
+
+	ElementCase("Matrix3.MultiplyVector3", 4.0, 3, &outV3[0],
+		[&](unsigned i) { outV3[i] = a3[i] * v3[i]; },
+		[&](unsigned i, double* e) {
+			double in[4] = { v3[i].x, v3[i].y, v3[i].z, 0.0 };
+			DMat4(a3[i]).Transform(in, e);
+			return TransformMagnitude(DMat4(a3[i]), in);
+		});
+
+	ElementCase("Matrix3.Inverse", 64.0, 9, &out3[0],
+		[&](unsigned i) { out3[i] = a3[i].Inverse(); },
+		[&](unsigned i, double* e) { DMat4(a3[i]).Inverse().Store(e, 3, 3); return 0.0; });
+
+	ElementCase("Matrix3x4.Multiply", 4.0, 12, &out34[0],
+		[&](unsigned i) { out34[i] = a34[i] * b34[i]; },
+		[&](unsigned i, double* e) {
+			DMat4 lhs(a34[i]), rhs(b34[i]);
+			(lhs * rhs).Store(e, 3, 4);
+			return ProductMagnitude(lhs, rhs);
+		});
+
+	ElementCase("Matrix3x4.MultiplyVector3", 4.0, 3, &outV3[0],
+		[&](unsigned i) { outV3[i] = a34[i] * v3[i]; },
+		[&](unsigned i, double* e) {
+			double in[4] = { v3[i].x, v3[i].y, v3[i].z, 1.0 };
+			DMat4(a34[i]).Transform(in, e);
+			return TransformMagnitude(DMat4(a34[i]), in);
+		});
+
+	ElementCase("Matrix3x4.Inverse", 64.0, 12, &out34[0],
+		[&](unsigned i) { out34[i] = a34[i].Inverse(); },
+		[&](unsigned i, double* e) { DMat4(a34[i]).Inverse().Store(e, 3, 4); return 0.0; });
+
+	// RandomTransform has no shear, so the same matrices take the Scaled path; the Rigid path gets them without scale.
+	std::vector<Matrix3x4> rigid34(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i)
+		rigid34[i] = Matrix3x4(RandomVector3(random, 10.0f), RandomRotation(random), 1.0f);
+
+	ElementCase("Matrix3x4.InverseRigid", 64.0, 12, &out34[0],
+		[&](unsigned i) { out34[i] = rigid34[i].InverseRigid(); },
+		[&](unsigned i, double* e) { DMat4(rigid34[i]).Inverse().Store(e, 3, 4); return 0.0; });
+
+	ElementCase("Matrix3x4.InverseScaled", 64.0, 12, &out34[0],
+		[&](unsigned i) { out34[i] = a34[i].InverseScaled(); },
+		[&](unsigned i, double* e) { DMat4(a34[i]).Inverse().Store(e, 3, 4); return 0.0; });
+
+	ElementCase("Matrix3x4.InverseTransposed", 64.0, 9, &out3[0],
+		[&](unsigned i) { out3[i] = a34[i].InverseTransposed(); },
+		[&](unsigned i, double* e) { DMat4(a34[i]).Inverse().Store(e, 3, 3); TransposeInPlace(e, 3); return 0.0; });
+
+	BulkCase("Matrix3x4.BulkInverse", 64.0, kCOUNT, 12,
+		[&]() { Matrix3x4::BulkInverse(&out34[0], &a34[0], kCOUNT); DoNotOptimize(out34[0]); },
+		[&](unsigned i, float* got) { memcpy(got, out34[i].Data(), sizeof(Matrix3x4)); },
+		[&](unsigned i, double* e) { DMat4(a34[i]).Inverse().Store(e, 3, 4); return 0.0; });
+
+	BulkCase("Matrix3x4.BulkInverse.Scaled", 64.0, kCOUNT, 12,
+		[&]() { Matrix3x4::BulkInverse(&out34[0], &a34[0], kCOUNT, TransformClass::Scaled); DoNotOptimize(out34[0]); },
+		[&](unsigned i, float* got) { memcpy(got, out34[i].Data(), sizeof(Matrix3x4)); },
+		[&](unsigned i, double* e) { DMat4(a34[i]).Inverse().Store(e, 3, 4); return 0.0; });
+
+	BulkCase("Matrix3x4.BulkInverse.Rigid", 64.0, kCOUNT, 12,
+		[&]() { Matrix3x4::BulkInverse(&out34[0], &rigid34[0], kCOUNT, TransformClass::Rigid); DoNotOptimize(out34[0]); },
+		[&](unsigned i, float* got) { memcpy(got, out34[i].Data(), sizeof(Matrix3x4)); },
+		[&](unsigned i, double* e) { DMat4(rigid34[i]).Inverse().Store(e, 3, 4); return 0.0; });
+
+	BulkCase("Matrix3x4.BulkInverseTransposed", 64.0, kCOUNT, 9,
+		[&]() { Matrix3x4::BulkInverseTransposed(&out3[0], &a34[0], kCOUNT); DoNotOptimize(out3[0]); },
+		[&](unsigned i, float* got) { memcpy(got, out3[i].Data(), sizeof(Matrix3)); },
+		[&](unsigned i, double* e) { DMat4(a34[i]).Inverse().Store(e, 3, 3); TransposeInPlace(e, 3); return 0.0; });
+
+	// The remainder of a bulk inverse goes through the single matrix functions, which have to match the lanes.
+	if (Enabled("Matrix3x4.BulkInverse.Tail")) {
+		bool correct = true;
+		double ns = 0.0;
+		std::vector<Matrix3x4> single(kCOUNT);
+		std::vector<Matrix3> singleNormal(kCOUNT);
+		const TransformClass classes[] = { TransformClass::Rigid, TransformClass::Scaled, TransformClass::Affine };
+		for (TransformClass cls : classes) {
+			const std::vector<Matrix3x4>& src = cls == TransformClass::Rigid ? rigid34 : a34;
+			Matrix3x4::BulkInverse(&out34[0], &src[0], kCOUNT, cls);
+			Matrix3x4::BulkInverseTransposed(&out3[0], &src[0], kCOUNT, cls);
+			ns += Measure(kCOUNT, [&]() {
+				for (unsigned i = 0; i < kCOUNT; ++i)
+					Matrix3x4::BulkInverse(&single[i], &src[i], 1, cls);
+				DoNotOptimize(single[0]);
+			});
+			for (unsigned i = 0; i < kCOUNT; ++i) {
+				singleNormal[i] = src[i].InverseTransposed(cls);
+				// The general Inverse has a scalar path of its own; the cheaper classes share the kernel expressions.
+				if (cls != TransformClass::Affine)
+					correct = correct && !memcmp(&out34[i], src[i].Inverse(cls).Data(), sizeof(Matrix3x4));
+			}
+			correct = correct && !memcmp(&out34[0], &single[0], kCOUNT * sizeof(Matrix3x4)) &&
+				!memcmp(&out3[0], &singleNormal[0], kCOUNT * sizeof(Matrix3));
+		}
+		Report("Matrix3x4.BulkInverse.Tail", ns / 3, Accuracy(), 0.0, correct);
+	}
+
+	// Mirrored transforms negate one or all three scale axes; sheared ones are products with a shear that
+	// Decompose cannot represent, so they do not round-trip.
+	std::vector<Matrix3x4> mirrored34(kCOUNT), sheared34(kCOUNT), mixed34(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		float flip = i & 1 ? -1.0f : 1.0f;
+		mirrored34[i] = a34[i] * Matrix3x4(Vector3::ZERO, Quaternion::IDENTITY, Vector3(-1.0f, flip, flip));
+		Matrix3x4 shear(
+			1.0f, random.Range(-0.5f, 0.5f), random.Range(-0.5f, 0.5f), 0.0f,
+			0.0f, 1.0f, random.Range(-0.5f, 0.5f), 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f);
+		sheared34[i] = b34[i] * shear;
+		mixed34[i] = i % 8 == 7 ? sheared34[i] : (i & 1 ? mirrored34[i] : a34[i]);
+	}
+
+	DecomposeCase("Matrix3x4.Decompose", 64.0, a34, true);
+	DecomposeCase("Matrix3x4.Decompose.Mirrored", 64.0, mirrored34, true);
+	DecomposeCase("Matrix3x4.Decompose.Sheared", 64.0, sheared34, false);
+	BulkDecomposeCase("Matrix3x4.BulkDecompose", 64.0, a34, true);
+	BulkDecomposeCase("Matrix3x4.BulkDecompose.Mixed", 64.0, mixed34, false);
+
+	ElementCase("Matrix4.Multiply", 4.0, 16, &out4[0],
+		[&](unsigned i) { out4[i] = a4[i] * b4[i]; },
+		[&](unsigned i, double* e) {
+			DMat4 lhs(a4[i]), rhs(b4[i]);
+			(lhs * rhs).Store(e, 4, 4);
+			return ProductMagnitude(lhs, rhs);
+		});
+
+	ElementCase("Matrix4.MultiplyVector4", 4.0, 4, &outV4[0],
+		[&](unsigned i) { outV4[i] = a4[i] * v4[i]; },
+		[&](unsigned i, double* e) {
+			double in[4] = { v4[i].x, v4[i].y, v4[i].z, v4[i].w };
+			DMat4(a4[i]).Transform(in, e);
+			return TransformMagnitude(DMat4(a4[i]), in);
+		});
+
+	// The projective row makes these matrices less well conditioned than the affine ones.
+	ElementCase("Matrix4.Inverse", 256.0, 16, &out4[0],
+		[&](unsigned i) { out4[i] = a4[i].Inverse(); },
+		[&](unsigned i, double* e) { DMat4(a4[i]).Inverse().Store(e, 4, 4); return 0.0; });
+
+	std::vector<Matrix4> affine4(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i)
+		affine4[i] = a34[i].ToMatrix4();
+	ElementCase("Matrix4.InverseAffine", 64.0, 16, &out4[0],
+		[&](unsigned i) { out4[i] = affine4[i].InverseAffine(); },
+		[&](unsigned i, double* e) { DMat4(affine4[i]).Inverse().Store(e, 4, 4); return 0.0; });
+
+	DecomposeCase("Matrix4.Decompose", 64.0, affine4, true);
+
+	// The products and transforms against their scalar path. The SSE paths sum in a different order and may differ
+	// by a few ulp; without SSE the results have to be identical.
+	if (Enabled("Matrix.ScalarAgreement")) {
+		double ns = Measure(kCOUNT, [&]() {
+			for (unsigned i = 0; i < kCOUNT; ++i) {
+				out4[i] = a4[i] * b4[i];
+				out34[i] = a34[i] * b34[i];
+				outV4[i] = a4[i] * v4[i];
+			}
+			DoNotOptimize(out4[0]);
+			DoNotOptimize(out34[0]);
+			DoNotOptimize(outV4[0]);
+		});
+
+		Accuracy accuracy;
+		for (unsigned i = 0; i < kCOUNT; ++i) {
+			double e[16];
+			Matrix4 product4 = a4[i] * b4[i];
+			accuracy.Add(product4.Data(), e, 16, ScalarMultiply(a4[i].Data(), b4[i].Data(), 4, e));
+			Matrix3x4 product34 = a34[i] * b34[i];
+			accuracy.Add(product34.Data(), e, 12, ScalarMultiply(a34[i].Data(), b34[i].Data(), 3, e));
+
+			Vector4 transformed4 = a4[i] * v4[i];
+			accuracy.Add(&transformed4.x, e, 4, ScalarTransform(a4[i].Data(), &v4[i].x, 4, e));
+			float point[4] = { v3[i].x, v3[i].y, v3[i].z, 1.0f };
+			Vector3 transformed34 = a34[i] * v3[i];
+			accuracy.Add(&transformed34.x, e, 3, ScalarTransform(a34[i].Data(), point, 3, e));
+
+			// The projective transform divides by w, which the scalar path does as a multiply by 1 / w. The rounding
+			// of w is scaled by the result, which grows as w cancels.
+			Vector3 projected = a4[i] * v3[i];
+			double magnitude = ScalarTransform(a4[i].Data(), point, 3, e);
+			double w;
+			double wMagnitude = ScalarTransform(a4[i].Data() + 12, point, 1, &w);
+			float invW = 1.0f / (float)w;
+			double largest = 0.0;
+			for (unsigned k = 0; k < 3; ++k) {
+				e[k] = (float)e[k] * invW;
+				largest = fmax(largest, fabs(e[k]));
+			}
+			accuracy.Add(&projected.x, e, 3, (magnitude + largest * wMagnitude) * fabs(invW));
+		}
+#ifdef MATH_SSE
+		const double kULP_LIMIT = 4.0;
+#else
+		const double kULP_LIMIT = 0.0;
+#endif
+		Report("Matrix.ScalarAgreement", ns, accuracy, kULP_LIMIT, accuracy.maxUlp <= kULP_LIMIT);
+	}
+
+	BulkCase("Matrix3.BulkTranspose", 0.5, kCOUNT, 9,
+		[&]() { Matrix3::BulkTranspose(&out3[0].m00, &a3[0].m00, kCOUNT); DoNotOptimize(out3[0]); },
+		[&](unsigned i, float* got) { memcpy(got, out3[i].Data(), sizeof(Matrix3)); },
+		[&](unsigned i, double* e) { DMat4(a3[i]).Store(e, 3, 3); TransposeInPlace(e, 3); return 0.0; });
+
+	BulkCase("Matrix4.BulkTranspose", 0.5, kCOUNT, 16,
+		[&]() { Matrix4::BulkTranspose(&out4[0].m00, &a4[0].m00, kCOUNT); DoNotOptimize(out4[0]); },
+		[&](unsigned i, float* got) { memcpy(got, out4[i].Data(), sizeof(Matrix4)); },
+		[&](unsigned i, double* e) { DMat4(a4[i]).Store(e, 4, 4); TransposeInPlace(e, 4); return 0.0; });
+}
+
+}
@@ -0,0 +1,206 @@
+#include "bench.h"
+#include "graphic/MeshOptimizer.h"
+#include "math/Vector3.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// Rings and segments of the test mesh, about 64k triangles.
+const unsigned kRINGS = 128;
+const unsigned kSEGMENTS = 256;
+
+/// Bumpy sphere with a closed seam, so that the overdraw sort has clusters at different depths.
+struct Mesh
+{
+	Mesh()
+	{
+		for (unsigned r = 0; r <= kRINGS; ++r) {
+			float theta = Math::kPI * r / kRINGS;
+			for (unsigned s = 0; s < kSEGMENTS; ++s) {
+				float phi = 2.0f * Math::kPI * s / kSEGMENTS;
+				float radius = 1.0f + 0.3f * sinf(5.0f * theta) * sinf(4.0f * phi);
+				positions.push_back(radius * sinf(theta) * cosf(phi));
+				positions.push_back(radius * sinf(theta) * sinf(phi));
+				positions.push_back(radius * cosf(theta));
+			}
+		}
+		for (unsigned r = 0; r < kRINGS; ++r) {
+			for (unsigned s = 0; s < kSEGMENTS; ++s) {
+				unsigned a = r * kSEGMENTS + s, b = r * kSEGMENTS + (s + 1) % kSEGMENTS;
+				unsigned c = a + kSEGMENTS, d = b + kSEGMENTS;
+				const unsigned quad[6] = { a, c, b, b, c, d };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+	}
+
+	unsigned VertexCount() const { return (unsigned)positions.size() / 3; }
+	unsigned IndexCount() const { return (unsigned)indices.size(); }
+	unsigned TriangleCount() const { return IndexCount() / 3; }
+
+	std::vector<float>    positions;
+	std::vector<unsigned> indices;
+};
+
+/// Triangles rotated to start at their smallest index, in order or sorted, for comparing index buffers that
+/// may rotate and reorder triangles.
+std::vector<unsigned long long> Triangles(const std::vector<unsigned>& indices, bool sorted)
+{
+	std::vector<unsigned long long> triangles;
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		unsigned a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		while (a > b || a > c) {
+			unsigned t = a;
+			a = b;
+			b = c;
+			c = t;
+		}
+		triangles.push_back((unsigned long long)a << 42 | (unsigned long long)b << 21 | c);
+	}
+	if (sorted)
+		std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+/// Vertex buffer bytes read per byte of vertices, for vertices of vertexSize bytes read in 64-byte lines through
+/// a FIFO of 64 lines behind a post-transform FIFO of the default size. 1 is a single pass over the buffer.
+double Overfetch(const std::vector<unsigned>& indices, unsigned vertexCount, unsigned vertexSize)
+{
+	const unsigned kLINE = 64;
+	const unsigned kLINES = 64;
+	unsigned cacheSize = MeshOptimizer::DEFAULT_CACHE_SIZE;
+	std::vector<unsigned> vertexStamps(vertexCount, 0), lineStamps(vertexCount * vertexSize / kLINE + 2, 0);
+	unsigned vertexTime = cacheSize + 1, lineTime = kLINES + 1;
+	unsigned long long lines = 0;
+	for (unsigned index : indices) {
+		if (vertexTime - vertexStamps[index] <= cacheSize)
+			continue;
+		vertexStamps[index] = vertexTime++;
+		// A vertex may straddle two lines.
+		for (unsigned line = index * vertexSize / kLINE; line <= (index * vertexSize + vertexSize - 1) / kLINE; ++line) {
+			if (lineTime - lineStamps[line] > kLINES) {
+				lineStamps[line] = lineTime++;
+				++lines;
+			}
+		}
+	}
+	return (double)lines * kLINE / ((double)vertexCount * vertexSize);
+}
+
+}
+
+void RunMeshCases()
+{
+	using namespace MeshOptimizer;
+
+	Mesh mesh;
+	unsigned vertexCount = mesh.VertexCount();
+	unsigned indexCount = mesh.IndexCount();
+	unsigned triangleCount = mesh.TriangleCount();
+
+	// The input comes with triangles and vertices in random order, as from an exporter that does not care.
+	Random random(19);
+	std::vector<unsigned> order(vertexCount);
+	for (unsigned v = 0; v < vertexCount; ++v)
+		order[v] = v;
+	for (unsigned v = vertexCount - 1; v > 0; --v)
+		std::swap(order[v], order[(unsigned)(random.Next() * (v + 1)) % (v + 1)]);
+	std::vector<float> positions(mesh.positions.size());
+	for (unsigned v = 0; v < vertexCount; ++v)
+		memcpy(&positions[order[v] * 3], &mesh.positions[v * 3], 3 * sizeof(float));
+	std::vector<unsigned> shuffled(indexCount);
+	for (unsigned i = 0; i < indexCount; ++i)
+		shuffled[i] = order[mesh.indices[i]];
+	for (unsigned t = triangleCount - 1; t > 0; --t) {
+		unsigned k = (unsigned)(random.Next() * (t + 1)) % (t + 1);
+		std::swap_ranges(&shuffled[t * 3], &shuffled[t * 3 + 3], &shuffled[k * 3]);
+	}
+	std::vector<unsigned long long> reference = Triangles(shuffled, true);
+
+	std::vector<unsigned> cached(indexCount), drawn(indexCount), fetched(indexCount);
+	OptimizeVertexCache(&cached[0], &shuffled[0], indexCount, vertexCount);
+	unsigned clusters = OptimizeOverdraw(&drawn[0], &cached[0], indexCount, &positions[0], vertexCount,
+		3 * sizeof(float));
+	std::vector<float> remapped(positions.size());
+	fetched = drawn;
+	unsigned used = OptimizeVertexFetch(&remapped[0], &fetched[0], indexCount, &positions[0], vertexCount,
+		3 * sizeof(float));
+
+	float shuffledACMR = ComputeACMR(&shuffled[0], indexCount, vertexCount);
+	float cachedACMR = ComputeACMR(&cached[0], indexCount, vertexCount);
+	float drawnACMR = ComputeACMR(&drawn[0], indexCount, vertexCount);
+	char detail[64];
+
+	if (Enabled("Mesh.OptimizeVertexCache")) {
+		std::vector<unsigned> out(indexCount);
+		double ns = Measure(triangleCount, [&]() { OptimizeVertexCache(&out[0], &shuffled[0], indexCount, vertexCount); });
+		snprintf(detail, sizeof(detail), "ACMR %.3f -> %.3f", shuffledACMR, cachedACMR);
+		bool correct = Triangles(cached, true) == reference && cachedACMR < 0.8f;
+		Report("Mesh.OptimizeVertexCache", ns, Accuracy(), 0.0, correct, detail);
+	}
+
+	// The default threshold has to keep the cache efficiency within about 5%.
+	if (Enabled("Mesh.OptimizeOverdraw")) {
+		std::vector<unsigned> out(indexCount);
+		double ns = Measure(triangleCount, [&]() {
+			OptimizeOverdraw(&out[0], &cached[0], indexCount, &positions[0], vertexCount, 3 * sizeof(float));
+		});
+		snprintf(detail, sizeof(detail), "ACMR %.3f -> %.3f, %u clusters", cachedACMR, drawnACMR, clusters);
+		bool correct = Triangles(drawn, true) == reference && drawnACMR < cachedACMR * 1.1f;
+		Report("Mesh.OptimizeOverdraw", ns, Accuracy(), 0.0, correct, detail);
+	}
+
+	// The remapped buffer has to reference the vertices in first-use order and draw the same positions. Overfetch is
+	// for 32-byte vertices, a position, a normal and a texture coordinate.
+	if (Enabled("Mesh.OptimizeVertexFetch")) {
+		std::vector<unsigned> remap(vertexCount);
+		double ns = Measure(triangleCount, [&]() { OptimizeVertexFetchRemap(&remap[0], &drawn[0], indexCount, vertexCount); });
+		bool correct = used == vertexCount;
+		unsigned next = 0;
+		for (unsigned i = 0; i < indexCount && correct; ++i) {
+			correct = fetched[i] <= next && !memcmp(&remapped[fetched[i] * 3], &positions[drawn[i] * 3], 3 * sizeof(float));
+			next = fetched[i] == next ? next + 1 : next;
+		}
+		snprintf(detail, sizeof(detail), "overfetch %.2f -> %.2f", Overfetch(drawn, vertexCount, 32),
+			Overfetch(fetched, vertexCount, 32));
+		Report("Mesh.OptimizeVertexFetch", ns, Accuracy(), 0.0, correct, detail);
+	}
+
+	std::vector<unsigned char> encoded(EncodeIndexBufferBound(indexCount));
+	size_t size = EncodeIndexBuffer(&encoded[0], encoded.size(), &fetched[0], indexCount);
+
+	if (Enabled("Mesh.EncodeIndexBuffer")) {
+		double ns = Measure(triangleCount, [&]() { DoNotOptimize(EncodeIndexBuffer(&encoded[0], encoded.size(), &fetched[0], indexCount)); });
+		std::vector<unsigned char> unoptimized(EncodeIndexBufferBound(indexCount));
+		size_t unoptimizedSize = EncodeIndexBuffer(&unoptimized[0], unoptimized.size(), &shuffled[0], indexCount);
+		// A buffer of exactly the encoded size has to be enough, and one byte less not.
+		std::vector<unsigned char> exact(size);
+		bool fits = size != 0 && EncodeIndexBuffer(&exact[0], size, &fetched[0], indexCount) == size &&
+			!memcmp(&exact[0], &encoded[0], size) && !EncodeIndexBuffer(&exact[0], size - 1, &fetched[0], indexCount);
+		snprintf(detail, sizeof(detail), "%.2f bytes/tri, unoptimized %.2f", (double)size / triangleCount,
+			(double)unoptimizedSize / triangleCount);
+		Report("Mesh.EncodeIndexBuffer", ns, Accuracy(), 0.0, fits && (double)size / triangleCount < 2.0, detail);
+	}
+
+	// Decoding has to give back the triangles in order, each at most rotated, and reject truncated data.
+	if (Enabled("Mesh.DecodeIndexBuffer")) {
+		std::vector<unsigned> decoded(indexCount);
+		bool valid = true;
+		double ns = Measure(triangleCount, [&]() { valid = DecodeIndexBuffer(&decoded[0], indexCount, &encoded[0], size) && valid; });
+		bool correct = valid && Triangles(decoded, false) == Triangles(fetched, false) &&
+			!DecodeIndexBuffer(&decoded[0], indexCount, &encoded[0], size - 1);
+		snprintf(detail, sizeof(detail), "%.0f MB/s of 32-bit indices", 3.0 * sizeof(unsigned) * 1e3 / ns);
+		Report("Mesh.DecodeIndexBuffer", ns, Accuracy(), 0.0, correct, detail);
+	}
+}
+
+}
@@ -0,0 +1,148 @@
+#include "reference.h"
+#include "math/Packed.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// Elements of the streaming cases: 24 MB of Vector3, well beyond the last level cache, so the time per element
+/// follows the bytes per element.
+const unsigned kSTREAM_COUNT = 1u << 21;
+
+/// Time BulkPack and BulkUnpack over values and report the round trip error against them.
+template <class P, class F>
+void FormatCases(const char* name, double ulpLimit, double magnitude, const std::vector<F>& values)
+{
+	const unsigned floats = sizeof(F) / sizeof(float);
+	std::vector<P> packed(kCOUNT);
+	std::vector<F> unpacked(kCOUNT);
+	auto ref = [&](unsigned i, double* e) {
+		for (unsigned k = 0; k < floats; ++k)
+			e[k] = reinterpret_cast<const float*>(&values[i])[k];
+		return magnitude;
+	};
+	char caseName[64];
+
+	snprintf(caseName, sizeof(caseName), "%s.BulkPack", name);
+	BulkCase(caseName, ulpLimit, kCOUNT, floats,
+		[&]() { P::BulkPack(&packed[0], &values[0], kCOUNT); DoNotOptimize(packed[0]); },
+		[&](unsigned i, float* got) {
+			F value;
+			P::BulkUnpack(&value, &packed[i], 1);
+			memcpy(got, &value, sizeof(F));
+		},
+		ref);
+
+	snprintf(caseName, sizeof(caseName), "%s.BulkUnpack", name);
+	BulkCase(caseName, ulpLimit, kCOUNT, floats,
+		[&]() { P::BulkUnpack(&unpacked[0], &packed[0], kCOUNT); DoNotOptimize(unpacked[0]); },
+		[&](unsigned i, float* got) { memcpy(got, &unpacked[i], sizeof(F)); },
+		ref);
+}
+
+/// Sum of all components, with independent accumulators so that the loop is not latency bound.
+template <class F>
+void Accumulate(float* sums, const F* values, unsigned count)
+{
+	const float* p = reinterpret_cast<const float*>(values);
+	unsigned floats = count * (sizeof(F) / sizeof(float));
+	for (unsigned i = 0; i + 8 <= floats; i += 8) {
+		for (unsigned k = 0; k < 8; ++k)
+			sums[k] += p[i + k];
+	}
+}
+
+/// Read an array of kSTREAM_COUNT float values from memory.
+template <class F>
+void StreamCase(const char* name, const std::vector<F>& values)
+{
+	if (!Enabled(name))
+		return;
+
+	double ns = Measure(kSTREAM_COUNT, [&]() {
+		float sums[8] = {};
+		Accumulate(sums, &values[0], kSTREAM_COUNT);
+		DoNotOptimize(sums);
+	});
+	Report(name, ns, Accuracy(), 0.0);
+}
+
+/// Read the same array stored packed, unpacking it in chunks that stay in the L1 cache.
+template <class P, class F>
+void PackedStreamCase(const char* name, const std::vector<F>& values)
+{
+	if (!Enabled(name))
+		return;
+
+	std::vector<P> packed(kSTREAM_COUNT);
+	P::BulkPack(&packed[0], &values[0], kSTREAM_COUNT);
+	double ns = Measure(kSTREAM_COUNT, [&]() {
+		const unsigned chunk = 256;
+		F buffer[chunk];
+		float sums[8] = {};
+		for (unsigned i = 0; i < kSTREAM_COUNT; i += chunk) {
+			P::BulkUnpack(buffer, &packed[i], chunk);
+			Accumulate(sums, buffer, chunk);
+		}
+		DoNotOptimize(sums);
+	});
+	Report(name, ns, Accuracy(), 0.0);
+}
+
+}
+
+void RunPackedCases()
+{
+	// Error limits are in float ulps at the largest component for the half formats, where the half precision
+	// rounding of 2^-11 relative is 4096 float ulps, and at 1 for the unit range formats.
+	Random random(9);
+	std::vector<Vector3> vectors(kCOUNT), directions(kCOUNT), units(kCOUNT);
+	std::vector<Vector4> vectors4(kCOUNT);
+	std::vector<Quaternion> rotations(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		vectors[i] = RandomVector3(random, 100.0f);
+		vectors4[i] = Vector4(RandomVector3(random, 100.0f), random.Range(-100.0f, 100.0f));
+		directions[i] = RandomVector3(random, 1.0f);
+		units[i] = RandomVector3(random, 1.0f).Normalized();
+		// Flip to the sign PackedQuaternion stores, so that the round trip compares like with like.
+		Quaternion q = RandomRotation(random);
+		float largest = q.w;
+		for (unsigned k = 1; k < 4; ++k) {
+			if (fabsf(q.Data()[k]) > fabsf(largest))
+				largest = q.Data()[k];
+		}
+		rotations[i] = largest < 0.0f ? -q : q;
+	}
+
+	FormatCases<HalfVector3>("HalfVector3", 4096.0, 0.0, vectors);
+	FormatCases<HalfVector4>("HalfVector4", 4096.0, 0.0, vectors4);
+	FormatCases<Snorm16Vector3>("Snorm16Vector3", 130.0, 1.0, directions);
+	FormatCases<OctahedralVector3>("OctahedralVector3", 640.0, 1.0, units);
+	FormatCases<PackedQuaternion>("PackedQuaternion", 640.0, 1.0, rotations);
+
+	// The same data at stream scale, plain and packed. Names carry the bytes per element.
+	std::vector<Vector3> streamVectors(kSTREAM_COUNT);
+	std::vector<Vector4> streamVectors4(kSTREAM_COUNT);
+	std::vector<Quaternion> streamRotations(kSTREAM_COUNT);
+	for (unsigned i = 0; i < kSTREAM_COUNT; ++i) {
+		streamVectors[i] = units[i % kCOUNT];
+		streamVectors4[i] = vectors4[i % kCOUNT];
+		streamRotations[i] = rotations[i % kCOUNT];
+	}
+	StreamCase("Stream.Vector3 (12 B)", streamVectors);
+	PackedStreamCase<HalfVector3>("Stream.HalfVector3 (6 B)", streamVectors);
+	PackedStreamCase<Snorm16Vector3>("Stream.Snorm16Vector3 (6 B)", streamVectors);
+	PackedStreamCase<OctahedralVector3>("Stream.OctahedralVector3 (4 B)", streamVectors);
+	StreamCase("Stream.Vector4 (16 B)", streamVectors4);
+	PackedStreamCase<HalfVector4>("Stream.HalfVector4 (8 B)", streamVectors4);
+	StreamCase("Stream.Quaternion (16 B)", streamRotations);
+	PackedStreamCase<PackedQuaternion>("Stream.PackedQuaternion (6 B)", streamRotations);
+}
+
+}
@@ -0,0 +1,68 @@
+#include "reference.h"
+
+#include <vector>
+
+namespace Bench
+{
+
+void RunQuaternionCases()
+{
+	Random random(3);
+	std::vector<Quaternion> a(kCOUNT), b(kCOUNT), out(kCOUNT);
+	std::vector<Matrix3> rotations(kCOUNT), outM(kCOUNT);
+	std::vector<Vector3> angles(kCOUNT), axes(kCOUNT), v(kCOUNT), outV(kCOUNT);
+	std::vector<float> t(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		a[i] = RandomRotation(random);
+		b[i] = RandomRotation(random);
+		rotations[i] = a[i].RotationMatrix();
+		angles[i] = RandomVector3(random, 180.0f);
+		axes[i] = RandomVector3(random, 1.0f);
+		v[i] = RandomVector3(random, 10.0f);
+		t[i] = random.Next();
+	}
+
+	ElementCase("Quaternion.FromEulerAngles", 8.0, 4, &out[0],
+		[&](unsigned i) { out[i].FromEulerAngles(angles[i].x, angles[i].y, angles[i].z); },
+		[&](unsigned i, double* e) { QuatFromEuler(angles[i].x, angles[i].y, angles[i].z).StoreMatching(out[i], e); return 0.0; });
+
+	ElementCase("Quaternion.FromAngleAxis", 8.0, 4, &out[0],
+		[&](unsigned i) { out[i].FromAngleAxis(angles[i].x, axes[i]); },
+		[&](unsigned i, double* e) {
+			DVec3 axis = DVec3(axes[i]).Normalized();
+			double half = angles[i].x * 3.14159265358979323846 / 360.0;
+			DQuat(cos(half), axis.x * sin(half), axis.y * sin(half), axis.z * sin(half)).StoreMatching(out[i], e);
+			return 0.0;
+		});
+
+	ElementCase("Quaternion.FromRotationMatrix", 16.0, 4, &out[0],
+		[&](unsigned i) { out[i].FromRotationMatrix(rotations[i]); },
+		[&](unsigned i, double* e) { QuatFromRotation(DMat4(rotations[i])).StoreMatching(out[i], e); return 0.0; });
+
+	ElementCase("Quaternion.RotationMatrix", 8.0, 9, &outM[0],
+		[&](unsigned i) { outM[i] = a[i].RotationMatrix(); },
+		[&](unsigned i, double* e) { RotationFromQuat(DQuat(a[i])).Store(e, 3, 3); return 0.0; });
+
+	// Products and rotations of unit quaternions are measured against the magnitude of their inputs.
+	ElementCase("Quaternion.Multiply", 4.0, 4, &out[0],
+		[&](unsigned i) { out[i] = a[i] * b[i]; },
+		[&](unsigned i, double* e) { (DQuat(a[i]) * DQuat(b[i])).StoreMatching(out[i], e); return 1.0; });
+
+	ElementCase("Quaternion.RotateVector3", 8.0, 3, &outV[0],
+		[&](unsigned i) { outV[i] = a[i] * v[i]; },
+		[&](unsigned i, double* e) { DQuat(a[i]).Rotate(DVec3(v[i])).Store(e); return DVec3(v[i]).Length(); });
+
+	ElementCase("Quaternion.Slerp", 16.0, 4, &out[0],
+		[&](unsigned i) { out[i] = a[i].Slerp(b[i], t[i]); },
+		[&](unsigned i, double* e) { Slerp(DQuat(a[i]), DQuat(b[i]), t[i]).StoreMatching(out[i], e); return 0.0; });
+
+	// Without MATH_SSE, Quaternion::Normalize leaves quaternions alone whose squared length is within 1e-4 of one.
+	ElementCase("Quaternion.Nlerp", 1024.0, 4, &out[0],
+		[&](unsigned i) { out[i] = a[i].Nlerp(b[i], t[i]); },
+		[&](unsigned i, double* e) {
+			(DQuat(a[i]) * (1.0 - t[i]) + DQuat(b[i]) * t[i]).Normalized().StoreMatching(out[i], e);
+			return 0.0;
+		});
+}
+
+}
@@ -0,0 +1,197 @@
+#include "reference.h"
+#include "math/Ray.h"
+
+#include <string.h>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// Primary rays of a 32 x 32 pixel camera at the origin looking along +y, grouped into packets of 4 x 2 pixels.
+const unsigned kRAYS_X = 32;
+const unsigned kRAYS_Y = 32;
+const unsigned kRAYS = kRAYS_X * kRAYS_Y;
+const unsigned kPACKETS = kRAYS / RayPacket::MAX_RAYS;
+const unsigned kBOXES = 64;
+const unsigned kTRIANGLES = 256;
+
+struct Scene
+{
+	Scene() : rays(kRAYS), packets(kPACKETS), boxes(kBOXES), vertices(kTRIANGLES * 3), indices(kTRIANGLES * 3)
+	{
+		// Ray k of packet p is pixel (4 * (p % 8) + k % 4, 2 * (p / 8) + k / 4), so the rays of a packet are neighbours.
+		for (unsigned p = 0; p < kPACKETS; ++p) {
+			for (unsigned k = 0; k < RayPacket::MAX_RAYS; ++k) {
+				unsigned px = 4 * (p % (kRAYS_X / 4)) + k % 4;
+				unsigned py = 2 * (p / (kRAYS_X / 4)) + k / 4;
+				float x = (px + 0.5f) / kRAYS_X * 2.0f - 1.0f;
+				float z = (py + 0.5f) / kRAYS_Y * 2.0f - 1.0f;
+				rays[p * RayPacket::MAX_RAYS + k] = Ray(Vector3::ZERO, Vector3(x, 1.5f, z));
+			}
+			packets[p].Define(&rays[p * RayPacket::MAX_RAYS], RayPacket::MAX_RAYS);
+		}
+
+		// Boxes and triangles in front of the camera, most of them inside the view.
+		Random random(14);
+		for (unsigned b = 0; b < kBOXES; ++b) {
+			Vector3 center(random.Range(-20.0f, 20.0f), random.Range(10.0f, 40.0f), random.Range(-20.0f, 20.0f));
+			Vector3 half(random.Range(1.0f, 4.0f), random.Range(1.0f, 4.0f), random.Range(1.0f, 4.0f));
+			boxes[b] = BoundingBox(center - half, center + half);
+		}
+		for (unsigned t = 0; t < kTRIANGLES; ++t) {
+			Vector3 center(random.Range(-20.0f, 20.0f), random.Range(10.0f, 40.0f), random.Range(-20.0f, 20.0f));
+			for (unsigned v = 0; v < 3; ++v) {
+				vertices[t * 3 + v] = center + RandomVector3(random, 4.0f);
+				indices[t * 3 + v] = t * 3 + v;
+			}
+		}
+	}
+
+	std::vector<Ray>         rays;
+	std::vector<RayPacket>   packets;
+	std::vector<BoundingBox> boxes;
+	std::vector<Vector3>     vertices;
+	std::vector<unsigned>    indices;
+};
+
+/// Distance along the ray to triangle t in double precision, or -1 on a miss.
+double TriangleReference(const Scene& scene, const Ray& ray, unsigned t)
+{
+	DVec3 v0(scene.vertices[t * 3]), v1(scene.vertices[t * 3 + 1]), v2(scene.vertices[t * 3 + 2]);
+	DVec3 origin(ray.origin), direction(ray.direction);
+	DVec3 edge1 = v1 - v0, edge2 = v2 - v0;
+	DVec3 p = direction.Cross(edge2);
+	double invDet = 1.0 / edge1.Dot(p);
+	DVec3 s = origin - v0;
+	double u = s.Dot(p) * invDet;
+	DVec3 q = s.Cross(edge1);
+	double v = direction.Dot(q) * invDet;
+	double distance = edge2.Dot(q) * invDet;
+	return u >= 0.0 && v >= 0.0 && u + v <= 1.0 && distance >= 0.0 ? distance : -1.0;
+}
+
+/// Entry distance of the ray into box b in double precision, or -1 on a miss.
+double BoxReference(const Scene& scene, const Ray& ray, unsigned b)
+{
+	const BoundingBox& box = scene.boxes[b];
+	const float* lo = &box.minimum.x;
+	const float* hi = &box.maximum.x;
+	const float* origin = &ray.origin.x;
+	const float* direction = &ray.direction.x;
+	double tMin = -DBL_MAX, tMax = DBL_MAX;
+	for (unsigned axis = 0; axis < 3; ++axis) {
+		double t1 = (lo[axis] - (double)origin[axis]) / direction[axis];
+		double t2 = (hi[axis] - (double)origin[axis]) / direction[axis];
+		tMin = fmax(tMin, fmin(t1, t2));
+		tMax = fmin(tMax, fmax(t1, t2));
+	}
+	return tMax < 0.0 || tMin > tMax ? -1.0 : fmax(tMin, 0.0);
+}
+
+/// Time every ray against every one of count primitives, one at a time with single(ray, index) and a packet at a
+/// time with packet(packet, index, distances), per ray and primitive. The packets must reproduce the single ray
+/// distances exactly; the distances of the hits are compared with ref(ray, index).
+template <class Single, class Packet, class Ref>
+void PrimitiveCase(const char* singleName, const char* packetName, const Scene& scene, unsigned count, double ulpLimit,
+	Single single, Packet packet, Ref ref)
+{
+	if (!Enabled(singleName) && !Enabled(packetName))
+		return;
+
+	std::vector<float> singleResult(kRAYS * count), packetResult(kRAYS * count);
+	auto castSingle = [&]() {
+		for (unsigned i = 0; i < kRAYS; ++i) {
+			for (unsigned k = 0; k < count; ++k)
+				singleResult[i * count + k] = single(scene.rays[i], k);
+		}
+	};
+	auto castPackets = [&]() {
+		float distances[RayPacket::MAX_RAYS];
+		for (unsigned p = 0; p < kPACKETS; ++p) {
+			for (unsigned k = 0; k < count; ++k) {
+				packet(scene.packets[p], k, distances);
+				for (unsigned j = 0; j < RayPacket::MAX_RAYS; ++j)
+					packetResult[(p * RayPacket::MAX_RAYS + j) * count + k] = distances[j];
+			}
+		}
+	};
+	double singleNs = Measure(kRAYS * count, [&]() { castSingle(); DoNotOptimize(singleResult[0]); });
+	double packetNs = Measure(kRAYS * count, [&]() { castPackets(); DoNotOptimize(packetResult[0]); });
+
+	Accuracy accuracy;
+	castSingle();
+	castPackets();
+	for (unsigned i = 0; i < kRAYS; ++i) {
+		for (unsigned k = 0; k < count; ++k) {
+			double expected = ref(scene.rays[i], k);
+			if (singleResult[i * count + k] != FLT_MAX && expected >= 0.0)
+				accuracy.Add(&singleResult[i * count + k], &expected, 1);
+		}
+	}
+	Report(singleName, singleNs, accuracy, ulpLimit);
+	Report(packetName, packetNs, accuracy, ulpLimit, !memcmp(&singleResult[0], &packetResult[0], kRAYS * count * sizeof(float)));
+}
+
+}
+
+void RunRayCases()
+{
+	Scene scene;
+	const Vector3* vertices = &scene.vertices[0];
+	const unsigned* indices = &scene.indices[0];
+
+	// Per ray and primitive.
+	PrimitiveCase("Ray.HitDistance.Box", "RayPacket.HitDistance.Box", scene, kBOXES, 16.0,
+		[&](const Ray& ray, unsigned b) { return ray.HitDistance(scene.boxes[b]); },
+		[&](const RayPacket& packet, unsigned b, float* distances) { packet.HitDistance(scene.boxes[b], distances); },
+		[&](const Ray& ray, unsigned b) { return BoxReference(scene, ray, b); });
+	PrimitiveCase("Ray.HitDistance.Triangle", "RayPacket.HitDistance.Triangle", scene, kTRIANGLES, 256.0,
+		[&](const Ray& ray, unsigned t) { return ray.HitDistance(vertices[t * 3], vertices[t * 3 + 1], vertices[t * 3 + 2]); },
+		[&](const RayPacket& packet, unsigned t, float* distances) {
+			packet.HitDistance(vertices[t * 3], vertices[t * 3 + 1], vertices[t * 3 + 2], distances);
+		},
+		[&](const Ray& ray, unsigned t) { return TriangleReference(scene, ray, t); });
+
+	// Closest hit against the whole mesh, per ray: ops/sec is the throughput in rays per second.
+	if (Enabled("Ray.HitDistance.Mesh") || Enabled("RayPacket.HitDistance.Mesh")) {
+		std::vector<float> singleDistance(kRAYS), packetDistance(kRAYS);
+		std::vector<unsigned> singleTriangle(kRAYS), packetTriangle(kRAYS);
+		auto castSingle = [&]() {
+			for (unsigned i = 0; i < kRAYS; ++i)
+				singleDistance[i] = scene.rays[i].HitDistance(vertices, indices, kTRIANGLES, &singleTriangle[i]);
+		};
+		auto castPackets = [&]() {
+			for (unsigned p = 0; p < kPACKETS; ++p) {
+				float* distances = &packetDistance[p * RayPacket::MAX_RAYS];
+				for (unsigned j = 0; j < RayPacket::MAX_RAYS; ++j)
+					distances[j] = FLT_MAX;
+				scene.packets[p].HitDistance(vertices, indices, kTRIANGLES, distances, &packetTriangle[p * RayPacket::MAX_RAYS]);
+			}
+		};
+		double singleNs = Measure(kRAYS, [&]() { castSingle(); DoNotOptimize(singleDistance[0]); });
+		double packetNs = Measure(kRAYS, [&]() { castPackets(); DoNotOptimize(packetDistance[0]); });
+
+		Accuracy accuracy;
+		castSingle();
+		castPackets();
+		unsigned hits = 0;
+		bool identical = true;
+		for (unsigned i = 0; i < kRAYS; ++i) {
+			if (singleDistance[i] == FLT_MAX)
+				continue;
+			++hits;
+			double expected = TriangleReference(scene, scene.rays[i], singleTriangle[i]);
+			accuracy.Add(&singleDistance[i], &expected, 1);
+			identical = identical && packetDistance[i] == singleDistance[i] && packetTriangle[i] == singleTriangle[i];
+		}
+		identical = identical && !memcmp(&singleDistance[0], &packetDistance[0], kRAYS * sizeof(float));
+		// The scene is built so that most rays hit something; a handful of hits would hide broken kernels.
+		Report("Ray.HitDistance.Mesh", singleNs, accuracy, 256.0, hits > kRAYS / 2);
+		Report("RayPacket.HitDistance.Mesh", packetNs, accuracy, 256.0, identical && hits > kRAYS / 2);
+	}
+}
+
+}
@@ -0,0 +1,71 @@
+#include "reference.h"
+#include "math/MathPolicy.h"
+
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+struct SinCosResult
+{
+	float s;
+	float c;
+};
+
+template <void (*SinCos)(float, float&, float&)>
+void SinCosCase(const char* name, double ulpLimit, const std::vector<float>& angles)
+{
+	std::vector<SinCosResult> out(kCOUNT);
+	// Absolute error, measured in ulps of 1.
+	ElementCase(name, ulpLimit, 2, &out[0],
+		[&](unsigned i) { SinCos(angles[i], out[i].s, out[i].c); },
+		[&](unsigned i, double* e) { e[0] = sin((double)angles[i]); e[1] = cos((double)angles[i]); return 1.0; });
+}
+
+template <float (*RSqrt)(float)>
+void RSqrtCase(const char* name, double ulpLimit, const std::vector<float>& values)
+{
+	std::vector<float> out(kCOUNT);
+	ElementCase(name, ulpLimit, 1, &out[0],
+		[&](unsigned i) { out[i] = RSqrt(values[i]); },
+		[&](unsigned i, double* e) { *e = 1.0 / sqrt((double)values[i]); return 0.0; });
+}
+
+template <float (*Atan2)(float, float)>
+void Atan2Case(const char* name, double ulpLimit, const std::vector<float>& y, const std::vector<float>& x)
+{
+	std::vector<float> out(kCOUNT);
+	ElementCase(name, ulpLimit, 1, &out[0],
+		[&](unsigned i) { out[i] = Atan2(y[i], x[i]); },
+		[&](unsigned i, double* e) { *e = atan2((double)y[i], (double)x[i]); return 1.0; });
+}
+
+}
+
+void RunScalarCases()
+{
+	Random random(8);
+	std::vector<float> values(kCOUNT), angles(kCOUNT), x(kCOUNT), y(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		values[i] = ldexpf(random.Range(1.0f, 2.0f), (int)random.Range(-20.0f, 20.0f));
+		angles[i] = random.Range(-100.0f, 100.0f);
+		x[i] = random.Range(-10.0f, 10.0f);
+		y[i] = random.Range(-10.0f, 10.0f);
+	}
+
+	RSqrtCase<Math::Precise::RSqrt>("Math.Precise.RSqrt", 2.0, values);
+#ifdef MATH_SSE
+	RSqrtCase<Math::Fast::RSqrt>("Math.Fast.RSqrt", 8.0, values);
+#else
+	RSqrtCase<Math::Fast::RSqrt>("Math.Fast.RSqrt", 128.0, values);
+#endif
+	SinCosCase<Math::Precise::SinCos>("Math.Precise.SinCos", 1.0, angles);
+	SinCosCase<Math::Fast::SinCos>("Math.Fast.SinCos", 2.0, angles);
+	Atan2Case<Math::Precise::Atan2>("Math.Precise.Atan2", 2.0, y, x);
+	Atan2Case<Math::Fast::Atan2>("Math.Fast.Atan2", 4.0, y, x);
+}
+
+}
@@ -0,0 +1,202 @@
+#include "reference.h"
+#include "math/Skinning.h"
+
+#include <string.h>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// A character sized mesh: 100k vertices with up to four of 64 bones each.
+const unsigned kVERTICES = 100000;
+const unsigned kBONES = 64;
+
+struct Mesh
+{
+	Mesh(unsigned influences) : x(kVERTICES), y(kVERTICES), z(kVERTICES), nx(kVERTICES), ny(kVERTICES), nz(kVERTICES)
+	{
+		Random random(10);
+		for (unsigned k = 0; k < influences; ++k) {
+			indices[k].resize(kVERTICES);
+			weights[k].resize(kVERTICES);
+		}
+		for (unsigned i = 0; i < kVERTICES; ++i) {
+			Vector3 position = RandomVector3(random, 1.0f);
+			// Normalized() leaves vectors within kLARGE_EPSILON of unit length alone; dual-quaternion skinning preserves
+			// the length of the normal, so scale it to unit length exactly.
+			Vector3 normal = RandomVector3(random, 1.0f);
+			normal *= 1.0f / normal.Length();
+			x[i] = position.x;
+			y[i] = position.y;
+			z[i] = position.z;
+			nx[i] = normal.x;
+			ny[i] = normal.y;
+			nz[i] = normal.z;
+
+			// Neighbouring bones with decreasing weights, the heaviest first.
+			unsigned first = (unsigned)(random.Next() * (kBONES - influences));
+			float total = 0.0f;
+			float w[SkinSource::MAX_INFLUENCES];
+			for (unsigned k = 0; k < influences; ++k) {
+				w[k] = random.Range(0.1f, 1.0f) / (float)(k + 1);
+				total += w[k];
+			}
+			for (unsigned k = 0; k < influences; ++k) {
+				indices[k][i] = (unsigned short)(first + k);
+				weights[k][i] = w[k] / total;
+			}
+		}
+
+		source.x = &x[0];
+		source.y = &y[0];
+		source.z = &z[0];
+		source.nx = &nx[0];
+		source.ny = &ny[0];
+		source.nz = &nz[0];
+		for (unsigned k = 0; k < influences; ++k) {
+			source.boneIndices[k] = &indices[k][0];
+			source.boneWeights[k] = &weights[k][0];
+		}
+		source.influences = influences;
+	}
+
+	std::vector<float>          x, y, z, nx, ny, nz;
+	std::vector<unsigned short> indices[SkinSource::MAX_INFLUENCES];
+	std::vector<float>          weights[SkinSource::MAX_INFLUENCES];
+	SkinSource                  source;
+};
+
+/// Skinned positions and normals.
+struct Output
+{
+	Output() : x(kVERTICES), y(kVERTICES), z(kVERTICES), nx(kVERTICES), ny(kVERTICES), nz(kVERTICES)
+	{
+		target.x = &x[0];
+		target.y = &y[0];
+		target.z = &z[0];
+		target.nx = &nx[0];
+		target.ny = &ny[0];
+		target.nz = &nz[0];
+	}
+
+	bool operator ==(const Output& rhs) const
+	{
+		size_t bytes = kVERTICES * sizeof(float);
+		return !memcmp(&x[0], &rhs.x[0], bytes) && !memcmp(&y[0], &rhs.y[0], bytes) && !memcmp(&z[0], &rhs.z[0], bytes) &&
+			!memcmp(&nx[0], &rhs.nx[0], bytes) && !memcmp(&ny[0], &rhs.ny[0], bytes) && !memcmp(&nz[0], &rhs.nz[0], bytes);
+	}
+
+	std::vector<float> x, y, z, nx, ny, nz;
+	SkinTarget         target;
+};
+
+/// Linear blend skinning of vertex i in double precision: position, then normal.
+void LinearReference(const Mesh& mesh, const Matrix3x4* bones, unsigned i, double* e)
+{
+	double m[3][4] = {};
+	for (unsigned k = 0; k < mesh.source.influences; ++k) {
+		DMat4 bone(bones[mesh.indices[k][i]]);
+		double w = mesh.weights[k][i];
+		for (unsigned r = 0; r < 3; ++r) {
+			for (unsigned c = 0; c < 4; ++c)
+				m[r][c] += w * bone.m[r][c];
+		}
+	}
+	double n[3];
+	for (unsigned r = 0; r < 3; ++r) {
+		e[r] = m[r][0] * mesh.x[i] + m[r][1] * mesh.y[i] + m[r][2] * mesh.z[i] + m[r][3];
+		n[r] = m[r][0] * mesh.nx[i] + m[r][1] * mesh.ny[i] + m[r][2] * mesh.nz[i];
+	}
+	DVec3(n[0], n[1], n[2]).Normalized().Store(e + 3);
+}
+
+/// Dual-quaternion skinning of vertex i in double precision: position, then normal.
+void DualQuaternionReference(const Mesh& mesh, const DualQuaternion* bones, unsigned i, double* e)
+{
+	DQuat real(0.0, 0.0, 0.0, 0.0), dual(0.0, 0.0, 0.0, 0.0);
+	DQuat first(bones[mesh.indices[0][i]].real);
+	for (unsigned k = 0; k < mesh.source.influences; ++k) {
+		const DualQuaternion& bone = bones[mesh.indices[k][i]];
+		double w = mesh.weights[k][i];
+		if (first.Dot(DQuat(bone.real)) < 0.0)
+			w = -w;
+		real = real + DQuat(bone.real) * w;
+		dual = dual + DQuat(bone.dual) * w;
+	}
+	double invLen = 1.0 / sqrt(real.Dot(real));
+	real = real * invLen;
+	dual = dual * invLen;
+	DQuat t = dual * DQuat(real.w, -real.x, -real.y, -real.z);
+	(real.Rotate(DVec3(mesh.x[i], mesh.y[i], mesh.z[i])) + DVec3(t.x, t.y, t.z) * 2.0).Store(e);
+	real.Rotate(DVec3(mesh.nx[i], mesh.ny[i], mesh.nz[i])).Store(e + 3);
+}
+
+/// Time skin(output) over the whole mesh and compare every vertex with ref(i, expected). When baseline is given,
+/// the output must also match it bit for bit.
+template <class Skin, class Ref>
+void SkinCase(const char* name, double ulpLimit, Skin skin, Ref ref, const Output* baseline = nullptr)
+{
+	if (!Enabled(name))
+		return;
+
+	Output output;
+	double ns = Measure(kVERTICES, [&]() { skin(output.target); DoNotOptimize(output.x[0]); });
+
+	Accuracy accuracy;
+	skin(output.target);
+	for (unsigned i = 0; i < kVERTICES; ++i) {
+		float got[6] = { output.x[i], output.y[i], output.z[i], output.nx[i], output.ny[i], output.nz[i] };
+		double expected[6];
+		ref(i, expected);
+		accuracy.Add(got, expected, 6);
+	}
+	Report(name, ns, accuracy, ulpLimit, !baseline || output == *baseline);
+}
+
+}
+
+void RunSkinningCases()
+{
+	// Rigid bones, so that both methods apply to the same skeleton.
+	Random random(11);
+	std::vector<Matrix3x4> matrices(kBONES);
+	std::vector<DualQuaternion> dualQuats(kBONES);
+	for (unsigned b = 0; b < kBONES; ++b) {
+		Quaternion rotation = RandomRotation(random);
+		Vector3 translation = RandomVector3(random, 10.0f);
+		matrices[b] = Matrix3x4(translation, rotation, 1.0f);
+		dualQuats[b] = DualQuaternion(rotation, translation);
+	}
+	const Matrix3x4* lbsBones = &matrices[0];
+	const DualQuaternion* dqsBones = &dualQuats[0];
+
+	// Per vertex timings; 100k vertices take a hundred thousand times as long.
+	Mesh mesh(4);
+	Output linear, dualQuat;
+	Skinning::LinearBlend(linear.target, mesh.source, lbsBones, 0, kVERTICES);
+	Skinning::DualQuaternionBlend(dualQuat.target, mesh.source, dqsBones, 0, kVERTICES);
+	auto linearRef = [&](unsigned i, double* e) { LinearReference(mesh, lbsBones, i, e); };
+	auto dualQuatRef = [&](unsigned i, double* e) { DualQuaternionReference(mesh, dqsBones, i, e); };
+
+	SkinCase("Skinning.LinearBlend", 16.0,
+		[&](const SkinTarget& out) { Skinning::LinearBlend(out, mesh.source, lbsBones, 0, kVERTICES); }, linearRef);
+	SkinCase("Skinning.LinearBlendParallel", 16.0,
+		[&](const SkinTarget& out) { Skinning::LinearBlendParallel(out, mesh.source, lbsBones, kVERTICES); }, linearRef, &linear);
+	SkinCase("Skinning.DualQuaternionBlend", 16.0,
+		[&](const SkinTarget& out) { Skinning::DualQuaternionBlend(out, mesh.source, dqsBones, 0, kVERTICES); }, dualQuatRef);
+	SkinCase("Skinning.DualQuaternionBlendParallel", 16.0,
+		[&](const SkinTarget& out) { Skinning::DualQuaternionBlendParallel(out, mesh.source, dqsBones, kVERTICES); },
+		dualQuatRef, &dualQuat);
+
+	// With one bone per vertex both methods are the same rigid transform, so dual-quaternion skinning must agree
+	// with the linear blend reference.
+	Mesh rigid(1);
+	SkinCase("Skinning.DualQuaternionBlend.Rigid", 16.0,
+		[&](const SkinTarget& out) { Skinning::DualQuaternionBlend(out, rigid.source, dqsBones, 0, kVERTICES); },
+		[&](unsigned i, double* e) { LinearReference(rigid, lbsBones, i, e); });
+}
+
+}
@@ -0,0 +1,239 @@
+#include "reference.h"
+#include "math/Spline.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace Bench
+{
+
+namespace
+{
+
+/// Control points of every curve, and curves in the many-curves case.
+const unsigned kPOINTS = 25;
+const unsigned kCURVES = 64;
+
+/// Control points of a wandering camera path.
+std::vector<Vector3> RandomPath(Random& random, unsigned count)
+{
+	std::vector<Vector3> points(count);
+	Vector3 position = Vector3::ZERO;
+	for (unsigned i = 0; i < count; ++i) {
+		position += RandomVector3(random, 5.0f);
+		points[i] = position;
+	}
+	return points;
+}
+
+/// Point of a curve in double precision from the basis functions of its type, rather than the power-basis
+/// segments the library evaluates. Writes the point to out and returns the sum of the absolute terms.
+double ReferencePoint(const Spline& spline, float t, double* out)
+{
+	const std::vector<Vector3>& p = spline.GetPoints();
+	unsigned count = spline.GetSegmentCount();
+	double scaled = Math::Clamp(t, 0.0f, 1.0f) * (double)count;
+	unsigned segment = scaled >= count ? count - 1 : (unsigned)scaled;
+	double u = scaled - segment;
+	double u2 = u * u, u3 = u2 * u;
+
+	DVec3 points[4];
+	double weights[4];
+	switch (spline.GetType()) {
+	case SplineType::Bezier:
+		for (unsigned k = 0; k < 4; ++k)
+			points[k] = DVec3(p[segment * 3 + k]);
+		weights[0] = (1.0 - u) * (1.0 - u) * (1.0 - u);
+		weights[1] = 3.0 * u * (1.0 - u) * (1.0 - u);
+		weights[2] = 3.0 * u2 * (1.0 - u);
+		weights[3] = u3;
+		break;
+
+	case SplineType::CatmullRom:
+	case SplineType::Hermite:
+		{
+			// Both as Hermite with the tangents of the type.
+			unsigned n = (unsigned)p.size();
+			DVec3 p0(p[segment]), p1(p[segment + 1]), m0, m1;
+			if (spline.GetType() == SplineType::Hermite) {
+				m0 = DVec3(spline.GetTangents()[segment]);
+				m1 = DVec3(spline.GetTangents()[segment + 1]);
+			}
+			else {
+				DVec3 before = segment > 0 ? DVec3(p[segment - 1]) : p0 * 2.0 - p1;
+				DVec3 after = segment + 2 < n ? DVec3(p[segment + 2]) : p1 * 2.0 - p0;
+				m0 = (p1 - before) * 0.5;
+				m1 = (after - p0) * 0.5;
+			}
+			points[0] = p0;
+			points[1] = m0;
+			points[2] = p1;
+			points[3] = m1;
+			weights[0] = 2.0 * u3 - 3.0 * u2 + 1.0;
+			weights[1] = u3 - 2.0 * u2 + u;
+			weights[2] = 3.0 * u2 - 2.0 * u3;
+			weights[3] = u3 - u2;
+		}
+		break;
+
+	case SplineType::BSpline:
+		for (unsigned k = 0; k < 4; ++k)
+			points[k] = DVec3(p[segment + k]);
+		weights[0] = (1.0 - u) * (1.0 - u) * (1.0 - u) / 6.0;
+		weights[1] = (3.0 * u3 - 6.0 * u2 + 4.0) / 6.0;
+		weights[2] = (-3.0 * u3 + 3.0 * u2 + 3.0 * u + 1.0) / 6.0;
+		weights[3] = u3 / 6.0;
+		break;
+	}
+
+	DVec3 result;
+	double magnitude = 0.0;
+	for (unsigned k = 0; k < 4; ++k) {
+		result = result + points[k] * weights[k];
+		magnitude += fabs(weights[k]) * (fabs(points[k].x) + fabs(points[k].y) + fabs(points[k].z));
+	}
+	result.Store(out);
+	return magnitude;
+}
+
+/// Check GetParameter against arc lengths integrated in double precision: the distance the returned t lies at
+/// along the curve, minus the requested distance. Returns the largest error relative to the curve length.
+double ConstantSpeedError(const Spline& spline, const float* distances, const float* t, unsigned count)
+{
+	// Cumulative chord lengths of a dense polyline in double, which converge on the arc length.
+	const unsigned kSTEPS = 1 << 18;
+	std::vector<double> cumulative(kSTEPS + 1);
+	double previous[3], point[3];
+	ReferencePoint(spline, 0.0f, previous);
+	cumulative[0] = 0.0;
+	for (unsigned i = 1; i <= kSTEPS; ++i) {
+		ReferencePoint(spline, (float)((double)i / kSTEPS), point);
+		double dx = point[0] - previous[0], dy = point[1] - previous[1], dz = point[2] - previous[2];
+		cumulative[i] = cumulative[i - 1] + sqrt(dx * dx + dy * dy + dz * dz);
+		memcpy(previous, point, sizeof(point));
+	}
+
+	double maxError = 0.0;
+	for (unsigned i = 0; i < count; ++i) {
+		double position = t[i] * (double)kSTEPS;
+		unsigned k = position >= kSTEPS ? kSTEPS - 1 : (unsigned)position;
+		double distance = cumulative[k] + (cumulative[k + 1] - cumulative[k]) * (position - k);
+		maxError = fmax(maxError, fabs(distance - distances[i]));
+	}
+	return maxError / cumulative[kSTEPS];
+}
+
+}
+
+void RunSplineCases()
+{
+	Random random(18);
+	const SplineType types[4] = { SplineType::Bezier, SplineType::CatmullRom, SplineType::Hermite, SplineType::BSpline };
+	std::vector<Spline> curves(kCURVES);
+	for (unsigned c = 0; c < kCURVES; ++c) {
+		std::vector<Vector3> points = RandomPath(random, kPOINTS);
+		std::vector<Vector3> tangents(kPOINTS);
+		for (unsigned i = 0; i < kPOINTS; ++i)
+			tangents[i] = (points[i < kPOINTS - 1 ? i + 1 : i] - points[i > 0 ? i - 1 : i]) * random.Range(0.25f, 0.75f);
+		curves[c].SetPoints(types[c % 4], points, tangents);
+	}
+	const Spline& path = curves[1];
+
+	std::vector<float> t(kCOUNT), x(kCOUNT), y(kCOUNT), z(kCOUNT);
+	std::vector<const Spline*> many(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		t[i] = random.Next();
+		many[i] = &curves[i % kCURVES];
+	}
+	std::vector<Vector3> out(kCOUNT);
+
+	ElementCase("Spline.GetPoint", 16.0, 3, &out[0],
+		[&](unsigned i) { out[i] = path.GetPoint(t[i]); },
+		[&](unsigned i, double* e) { return ReferencePoint(path, t[i], e); });
+
+	// The batches have to match GetPoint bit for bit as well as the reference.
+	if (Enabled("Spline.BulkEvaluate")) {
+		double ns = Measure(kCOUNT, [&]() { path.BulkEvaluate(&x[0], &y[0], &z[0], &t[0], kCOUNT); DoNotOptimize(x[0]); });
+		Accuracy accuracy;
+		bool correct = true;
+		for (unsigned i = 0; i < kCOUNT; ++i) {
+			const float got[3] = { x[i], y[i], z[i] };
+			double expected[3];
+			accuracy.Add(got, expected, 3, ReferencePoint(path, t[i], expected));
+			correct = correct && !memcmp(got, path.GetPoint(t[i]).Data(), sizeof(got));
+		}
+		Report("Spline.BulkEvaluate", ns, accuracy, 16.0, correct);
+	}
+
+	if (Enabled("Spline.BulkEvaluate.Curves")) {
+		double ns = Measure(kCOUNT, [&]() {
+			Spline::BulkEvaluate(&x[0], &y[0], &z[0], &many[0], &t[0], kCOUNT);
+			DoNotOptimize(x[0]);
+		});
+		Accuracy accuracy;
+		bool correct = true;
+		for (unsigned i = 0; i < kCOUNT; ++i) {
+			const float got[3] = { x[i], y[i], z[i] };
+			double expected[3];
+			accuracy.Add(got, expected, 3, ReferencePoint(*many[i], t[i], expected));
+			correct = correct && !memcmp(got, many[i]->GetPoint(t[i]).Data(), sizeof(got));
+		}
+		Report("Spline.BulkEvaluate.Curves", ns, accuracy, 16.0, correct);
+	}
+
+	// Constant-speed sampling at the default table resolution: the distance of every returned t along the curve
+	// has to be within 5e-4 of the curve length of the requested one, for every curve type. The error falls with
+	// the square of the resolution.
+	if (Enabled("Spline.GetParameter")) {
+		std::vector<float> distances(kCOUNT), parameters(kCOUNT);
+		for (unsigned i = 0; i < kCOUNT; ++i)
+			distances[i] = t[i] * path.GetLength();
+		double ns = Measure(kCOUNT, [&]() {
+			for (unsigned i = 0; i < kCOUNT; ++i)
+				parameters[i] = path.GetParameter(distances[i]);
+			DoNotOptimize(parameters[0]);
+		});
+
+		double maxError = 0.0;
+		for (unsigned c = 0; c < 4; ++c) {
+			for (unsigned i = 0; i < kCOUNT; ++i)
+				distances[i] = t[i] * curves[c].GetLength();
+			curves[c].BulkGetParameter(&parameters[0], &distances[0], kCOUNT);
+			maxError = fmax(maxError, ConstantSpeedError(curves[c], &distances[0], &parameters[0], kCOUNT));
+		}
+		char detail[48];
+		snprintf(detail, sizeof(detail), "distance error %.2e of length", maxError);
+		Report("Spline.GetParameter", ns, Accuracy(), 0.0, maxError < 5e-4, detail);
+	}
+
+	// Squad through random keys: it has to pass through every key, and the batch has to match GetRotation bit for bit.
+	std::vector<Quaternion> keys(kPOINTS);
+	for (unsigned i = 0; i < kPOINTS; ++i)
+		keys[i] = RandomRotation(random);
+	QuaternionSpline rotations;
+	rotations.SetRotations(keys);
+	std::vector<Quaternion> rotated(kCOUNT);
+
+	if (Enabled("QuaternionSpline.GetRotation")) {
+		double ns = Measure(kCOUNT, [&]() {
+			for (unsigned i = 0; i < kCOUNT; ++i)
+				rotated[i] = rotations.GetRotation(t[i]);
+			DoNotOptimize(rotated[0]);
+		});
+		bool correct = true;
+		for (unsigned i = 0; i < kPOINTS; ++i)
+			correct = correct && Math::Abs(rotations.GetRotation((float)i / (kPOINTS - 1)).Dot(keys[i])) > 1.0f - 1e-6f;
+		Report("QuaternionSpline.GetRotation", ns, Accuracy(), 0.0, correct);
+	}
+
+	if (Enabled("QuaternionSpline.BulkEvaluate")) {
+		double ns = Measure(kCOUNT, [&]() { rotations.BulkEvaluate(&rotated[0], &t[0], kCOUNT); DoNotOptimize(rotated[0]); });
+		bool correct = true;
+		for (unsigned i = 0; i < kCOUNT; ++i)
+			correct = correct && !memcmp(rotations.GetRotation(t[i]).Data(), rotated[i].Data(), sizeof(Quaternion));
+		Report("QuaternionSpline.BulkEvaluate", ns, Accuracy(), 0.0, correct);
+	}
+}
+
+}
@@ -0,0 +1,91 @@
+#include "reference.h"
+#include "math/Vector4.h"
+
+#include <vector>
+
+namespace Bench
+{
+
+void RunVectorCases()
+{
+	Random random(1);
+	std::vector<Vector3> a3(kCOUNT), b3(kCOUNT), out3(kCOUNT);
+	std::vector<Vector4> a4(kCOUNT), b4(kCOUNT), out4(kCOUNT);
+	std::vector<float> t(kCOUNT), out(kCOUNT);
+	for (unsigned i = 0; i < kCOUNT; ++i) {
+		a3[i] = RandomVector3(random, 100.0f);
+		b3[i] = RandomVector3(random, 100.0f);
+		a4[i] = Vector4(RandomVector3(random, 100.0f), random.Range(-100.0f, 100.0f));
+		b4[i] = Vector4(RandomVector3(random, 100.0f), random.Range(-100.0f, 100.0f));
+		t[i] = random.Next();
+	}
+
+	ElementCase("Vector3.Add", 0.5, 3, &out3[0],
+		[&](unsigned i) { out3[i] = a3[i] + b3[i]; },
+		[&](unsigned i, double* e) { (DVec3(a3[i]) + DVec3(b3[i])).Store(e); return 0.0; });
+
+	ElementCase("Vector3.Dot", 4.0, 1, &out[0],
+		[&](unsigned i) { out[i] = a3[i].Dot(b3[i]); },
+		[&](unsigned i, double* e) {
+			*e = DVec3(a3[i]).Dot(DVec3(b3[i]));
+			return DVec3(a3[i].Abs()).Dot(DVec3(b3[i].Abs()));
+		});
+
+	ElementCase("Vector3.Cross", 4.0, 3, &out3[0],
+		[&](unsigned i) { out3[i] = a3[i].Cross(b3[i]); },
+		[&](unsigned i, double* e) {
+			DVec3(a3[i]).Cross(DVec3(b3[i])).Store(e);
+			return DVec3(a3[i]).Length() * DVec3(b3[i]).Length();
+		});
+
+	ElementCase("Vector3.Length", 4.0, 1, &out[0],
+		[&](unsigned i) { out[i] = a3[i].Length(); },
+		[&](unsigned i, double* e) { *e = DVec3(a3[i]).Length(); return 0.0; });
+
+	ElementCase("Vector3.Normalized", 4.0, 3, &out3[0],
+		[&](unsigned i) { out3[i] = a3[i].Normalized(); },
+		[&](unsigned i, double* e) { DVec3(a3[i]).Normalized().Store(e); return 0.0; });
+
+	ElementCase("Vector3.Lerp", 4.0, 3, &out3[0],
+		[&](unsigned i) { out3[i] = a3[i].Lerp(b3[i], t[i]); },
+		[&](unsigned i, double* e) {
+			(DVec3(a3[i]) * (1.0 - t[i]) + DVec3(b3[i]) * t[i]).Store(e);
+			double magnitude = 0.0;
+			for (unsigned k = 0; k < 3; ++k)
+				magnitude = fmax(magnitude, fabs(a3[i].Data()[k]) + fabs(b3[i].Data()[k]));
+			return magnitude;
+		});
+
+	ElementCase("Vector4.Add", 0.5, 4, &out4[0],
+		[&](unsigned i) { out4[i] = a4[i] + b4[i]; },
+		[&](unsigned i, double* e) {
+			for (unsigned k = 0; k < 4; ++k)
+				e[k] = (double)a4[i].Data()[k] + b4[i].Data()[k];
+			return 0.0;
+		});
+
+	ElementCase("Vector4.Dot", 4.0, 1, &out[0],
+		[&](unsigned i) { out[i] = a4[i].Dot(b4[i]); },
+		[&](unsigned i, double* e) {
+			*e = 0.0;
+			double magnitude = 0.0;
+			for (unsigned k = 0; k < 4; ++k) {
+				*e += (double)a4[i].Data()[k] * b4[i].Data()[k];
+				magnitude += fabs((double)a4[i].Data()[k] * b4[i].Data()[k]);
+			}
+			return magnitude;
+		});
+
+	ElementCase("Vector4.Lerp", 4.0, 4, &out4[0],
+		[&](unsigned i) { out4[i] = a4[i].Lerp(b4[i], t[i]); },
+		[&](unsigned i, double* e) {
+			double magnitude = 0.0;
+			for (unsigned k = 0; k < 4; ++k) {
+				e[k] = a4[i].Data()[k] * (1.0 - t[i]) + b4[i].Data()[k] * (double)t[i];
+				magnitude = fmax(magnitude, fabs(a4[i].Data()[k]) + fabs(b4[i].Data()[k]));
+			}
+			return magnitude;
+		});
+}
+
+}
@@ -0,0 +1,164 @@
+// Micro-benchmark and accuracy report for Test3D/math.
+//
+// Every case times one operation over a working set that stays in cache and compares the results with a
+// double precision reference. CMakeLists.txt builds one executable per math mode (scalar, MATH_SSE and
+// MATH_SSE with AVX2), so the modes can be compared side by side, plus the scalar and SSE modes again with
+// MATH_DETERMINISTIC. The Determinism.Hash case hashes a fixed workload; the deterministic builds compare it with
+// a recorded value, so a mismatch on any compiler or optimization level fails the case.
+//
+// Accuracy is reported as the largest error in units in the last place. The ulp is taken at the magnitude of
+// the largest element of each result, so a component that cancels to almost zero does not report millions of
+// ulps for an error far below float precision.
+//
+// Usage: math_bench [--filter <text>] [--min-time <ms>] [--json] [--check]
+//   --filter    run only the cases whose name contains text
+//   --min-time  time each case for at least this many milliseconds (default 100)
+//   --json      print one JSON object per case instead of a table
+//   --check     exit with status 1 when a case exceeds its ulp limit or fails its correctness check
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace Bench
+{
+
+double      g_MinTimeMs = 100.0;
+const char* g_Filter    = nullptr;
+static bool g_Json      = false;
+static bool g_Check     = false;
+static int  g_Failures  = 0;
+
+const char* Mode()
+{
+#if defined(MATH_DETERMINISTIC) && defined(MATH_AVX2)
+	return "avx2-deterministic";
+#elif defined(MATH_DETERMINISTIC) && defined(MATH_SSE)
+	return "sse-deterministic";
+#elif defined(MATH_DETERMINISTIC)
+	return "scalar-deterministic";
+#elif defined(MATH_AVX2)
+	return "avx2";
+#elif defined(MATH_SSE)
+	return "sse";
+#else
+	return "scalar";
+#endif
+}
+
+bool Enabled(const char* name)
+{
+	return !g_Filter || strstr(name, g_Filter);
+}
+
+static double UlpAt(double magnitude)
+{
+	if (magnitude < FLT_MIN)
+		return ldexp(1.0, -149);
+	int exponent;
+	frexp(magnitude, &exponent);
+	return ldexp(1.0, exponent - 24);
+}
+
+void Accuracy::Add(const float* result, const double* reference, unsigned count, double magnitude)
+{
+	bool fromReference = magnitude == 0.0;
+	double error = 0.0;
+	for (unsigned i = 0; i < count; ++i) {
+		if (fromReference)
+			magnitude = fmax(magnitude, fabs(reference[i]));
+		error = fmax(error, fabs((double)result[i] - reference[i]));
+	}
+	maxAbs = fmax(maxAbs, error);
+	maxUlp = fmax(maxUlp, error / UlpAt(magnitude));
+	measured = true;
+}
+
+static void PrintHeader()
+{
+	if (g_Json)
+		return;
+	printf("math_bench, mode %s\n", Mode());
+	printf("%-36s %12s %14s %12s %12s %10s\n", "case", "ns/op", "ops/sec", "max ulp", "max abs", "ulp limit");
+}
+
+void Report(const char* name, double nsPerOp, const Accuracy& accuracy, double ulpLimit, bool correct, const char* detail)
+{
+	bool failed = !correct || (accuracy.measured && ulpLimit > 0.0 && accuracy.maxUlp > ulpLimit);
+	if (failed)
+		++g_Failures;
+
+	double opsPerSec = nsPerOp > 0.0 ? 1e9 / nsPerOp : 0.0;
+	if (g_Json) {
+		printf("{\"case\":\"%s\",\"mode\":\"%s\",\"ns_per_op\":%.4f,\"ops_per_sec\":%.1f,", name, Mode(), nsPerOp, opsPerSec);
+		if (accuracy.measured)
+			printf("\"max_ulp\":%.2f,\"max_abs_error\":%.3g,", accuracy.maxUlp, accuracy.maxAbs);
+		else
+			printf("\"max_ulp\":null,\"max_abs_error\":null,");
+		if (ulpLimit > 0.0)
+			printf("\"ulp_limit\":%g,", ulpLimit);
+		else
+			printf("\"ulp_limit\":null,");
+		if (detail)
+			printf("\"detail\":\"%s\",", detail);
+		printf("\"ok\":%s}\n", failed ? "false" : "true");
+	}
+	else {
+		printf("%-36s %12.3f %14.0f ", name, nsPerOp, opsPerSec);
+		if (accuracy.measured)
+			printf("%12.2f %12.3g ", accuracy.maxUlp, accuracy.maxAbs);
+		else
+			printf("%12s %12s ", "-", "-");
+		if (ulpLimit > 0.0)
+			printf("%10g", ulpLimit);
+		else
+			printf("%10s", "-");
+		if (detail)
+			printf("  %s", detail);
+		printf("%s\n", failed ? "  FAILED" : "");
+	}
+	fflush(stdout);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	using namespace Bench;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+			g_Filter = argv[++i];
+		else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+			g_MinTimeMs = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--json"))
+			g_Json = true;
+		else if (!strcmp(argv[i], "--check"))
+			g_Check = true;
+		else {
+			fprintf(stderr, "usage: %s [--filter <text>] [--min-time <ms>] [--json] [--check]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	PrintHeader();
+	RunScalarCases();
+	RunVectorCases();
+	RunMatrixCases();
+	RunQuaternionCases();
+	RunBulkCases();
+	RunCullingCases();
+	RunPackedCases();
+	RunSkinningCases();
+	RunHierarchyCases();
+	RunRayCases();
+	RunSplineCases();
+	RunMeshCases();
+	RunDeterminismCases();
+	RunLuaCases();
+	RunLogCases();
+
+	return g_Check && g_Failures ? 1 : 0;
+}
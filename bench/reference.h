@@ -0,0 +1,285 @@
+#pragma once
+
+#include "bench.h"
+#include "math/Matrix3x4.h"
+#include "math/Quaternion.h"
+
+// Double precision reference implementations for the accuracy checks. Matrices of every size are widened to
+// row-major 4x4 with the missing rows and columns taken from the identity.
+
+namespace Bench
+{
+
+struct DVec3
+{
+	DVec3() : x(0.0), y(0.0), z(0.0) {}
+	DVec3(double _x, double _y, double _z) : x(_x), y(_y), z(_z) {}
+	explicit DVec3(const Vector3& v) : x(v.x), y(v.y), z(v.z) {}
+
+	DVec3  operator +(const DVec3& rhs) const { return DVec3(x + rhs.x, y + rhs.y, z + rhs.z); }
+	DVec3  operator -(const DVec3& rhs) const { return DVec3(x - rhs.x, y - rhs.y, z - rhs.z); }
+	DVec3  operator *(double rhs) const       { return DVec3(x * rhs, y * rhs, z * rhs); }
+	double Dot(const DVec3& rhs) const        { return x * rhs.x + y * rhs.y + z * rhs.z; }
+	DVec3  Cross(const DVec3& rhs) const
+	{
+		return DVec3(y * rhs.z - z * rhs.y, z * rhs.x - x * rhs.z, x * rhs.y - y * rhs.x);
+	}
+	double Length() const                     { return sqrt(Dot(*this)); }
+	DVec3  Normalized() const                 { return *this * (1.0 / Length()); }
+
+	void   Store(double* out) const           { out[0] = x; out[1] = y; out[2] = z; }
+
+	double x, y, z;
+};
+
+struct DQuat
+{
+	DQuat() : w(1.0), x(0.0), y(0.0), z(0.0) {}
+	DQuat(double _w, double _x, double _y, double _z) : w(_w), x(_x), y(_y), z(_z) {}
+	explicit DQuat(const Quaternion& q) : w(q.w), x(q.x), y(q.y), z(q.z) {}
+
+	DQuat  operator +(const DQuat& rhs) const { return DQuat(w + rhs.w, x + rhs.x, y + rhs.y, z + rhs.z); }
+	DQuat  operator *(double rhs) const       { return DQuat(w * rhs, x * rhs, y * rhs, z * rhs); }
+	DQuat  operator *(const DQuat& rhs) const
+	{
+		return DQuat(
+			w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z,
+			w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+			w * rhs.y + y * rhs.w + z * rhs.x - x * rhs.z,
+			w * rhs.z + z * rhs.w + x * rhs.y - y * rhs.x);
+	}
+	double Dot(const DQuat& rhs) const        { return w * rhs.w + x * rhs.x + y * rhs.y + z * rhs.z; }
+	DQuat  Normalized() const                 { return *this * (1.0 / sqrt(Dot(*this))); }
+	DVec3  Rotate(const DVec3& v) const
+	{
+		DQuat r = *this * DQuat(0.0, v.x, v.y, v.z) * DQuat(w, -x, -y, -z);
+		return DVec3(r.x, r.y, r.z);
+	}
+
+	/// Store as w, x, y, z with the sign of the reference matching q, since q and -q are the same rotation.
+	void   StoreMatching(const Quaternion& q, double* out) const
+	{
+		double sign = w * q.w + x * q.x + y * q.y + z * q.z < 0.0 ? -1.0 : 1.0;
+		out[0] = w * sign;
+		out[1] = x * sign;
+		out[2] = y * sign;
+		out[3] = z * sign;
+	}
+
+	double w, x, y, z;
+};
+
+struct DMat4
+{
+	DMat4()
+	{
+		for (unsigned r = 0; r < 4; ++r) {
+			for (unsigned c = 0; c < 4; ++c)
+				m[r][c] = r == c ? 1.0 : 0.0;
+		}
+	}
+	/// Widen a row-major matrix of rows x cols floats.
+	DMat4(const float* data, unsigned rows, unsigned cols) : DMat4()
+	{
+		for (unsigned r = 0; r < rows; ++r) {
+			for (unsigned c = 0; c < cols; ++c)
+				m[r][c] = data[r * cols + c];
+		}
+	}
+	explicit DMat4(const Matrix3& matrix) : DMat4(matrix.Data(), 3, 3) {}
+	explicit DMat4(const Matrix3x4& matrix) : DMat4(matrix.Data(), 3, 4) {}
+	explicit DMat4(const Matrix4& matrix) : DMat4(matrix.Data(), 4, 4) {}
+
+	DMat4 operator *(const DMat4& rhs) const
+	{
+		DMat4 ret;
+		for (unsigned r = 0; r < 4; ++r) {
+			for (unsigned c = 0; c < 4; ++c)
+				ret.m[r][c] = m[r][0] * rhs.m[0][c] + m[r][1] * rhs.m[1][c] + m[r][2] * rhs.m[2][c] + m[r][3] * rhs.m[3][c];
+		}
+		return ret;
+	}
+
+	/// Transform (x, y, z, w).
+	void Transform(const double* in, double* out) const
+	{
+		for (unsigned r = 0; r < 4; ++r)
+			out[r] = m[r][0] * in[0] + m[r][1] * in[1] + m[r][2] * in[2] + m[r][3] * in[3];
+	}
+
+	/// Gauss-Jordan elimination with partial pivoting.
+	DMat4 Inverse() const
+	{
+		DMat4 a = *this;
+		DMat4 ret;
+		for (unsigned c = 0; c < 4; ++c) {
+			unsigned pivot = c;
+			for (unsigned r = c + 1; r < 4; ++r) {
+				if (fabs(a.m[r][c]) > fabs(a.m[pivot][c]))
+					pivot = r;
+			}
+			for (unsigned k = 0; k < 4; ++k) {
+				double t = a.m[c][k]; a.m[c][k] = a.m[pivot][k]; a.m[pivot][k] = t;
+				t = ret.m[c][k]; ret.m[c][k] = ret.m[pivot][k]; ret.m[pivot][k] = t;
+			}
+			double inv = 1.0 / a.m[c][c];
+			for (unsigned k = 0; k < 4; ++k) {
+				a.m[c][k] *= inv;
+				ret.m[c][k] *= inv;
+			}
+			for (unsigned r = 0; r < 4; ++r) {
+				if (r == c)
+					continue;
+				double f = a.m[r][c];
+				for (unsigned k = 0; k < 4; ++k) {
+					a.m[r][k] -= f * a.m[c][k];
+					ret.m[r][k] -= f * ret.m[c][k];
+				}
+			}
+		}
+		return ret;
+	}
+
+	/// Store the upper-left rows x cols block row-major.
+	void Store(double* out, unsigned rows, unsigned cols) const
+	{
+		for (unsigned r = 0; r < rows; ++r) {
+			for (unsigned c = 0; c < cols; ++c)
+				out[r * cols + c] = m[r][c];
+		}
+	}
+
+	double m[4][4];
+};
+
+/// Rotation of an orthonormal upper-left 3x3 block, Shepperd's method.
+inline DQuat QuatFromRotation(const DMat4& r)
+{
+	double trace = r.m[0][0] + r.m[1][1] + r.m[2][2];
+	if (trace > 0.0) {
+		double s = sqrt(trace + 1.0) * 2.0;
+		return DQuat(0.25 * s, (r.m[2][1] - r.m[1][2]) / s, (r.m[0][2] - r.m[2][0]) / s, (r.m[1][0] - r.m[0][1]) / s);
+	}
+	if (r.m[0][0] > r.m[1][1] && r.m[0][0] > r.m[2][2]) {
+		double s = sqrt(1.0 + r.m[0][0] - r.m[1][1] - r.m[2][2]) * 2.0;
+		return DQuat((r.m[2][1] - r.m[1][2]) / s, 0.25 * s, (r.m[0][1] + r.m[1][0]) / s, (r.m[0][2] + r.m[2][0]) / s);
+	}
+	if (r.m[1][1] > r.m[2][2]) {
+		double s = sqrt(1.0 + r.m[1][1] - r.m[0][0] - r.m[2][2]) * 2.0;
+		return DQuat((r.m[0][2] - r.m[2][0]) / s, (r.m[0][1] + r.m[1][0]) / s, 0.25 * s, (r.m[1][2] + r.m[2][1]) / s);
+	}
+	double s = sqrt(1.0 + r.m[2][2] - r.m[0][0] - r.m[1][1]) * 2.0;
+	return DQuat((r.m[1][0] - r.m[0][1]) / s, (r.m[0][2] + r.m[2][0]) / s, (r.m[1][2] + r.m[2][1]) / s, 0.25 * s);
+}
+
+/// Rotation matrix of a unit quaternion.
+inline DMat4 RotationFromQuat(const DQuat& q)
+{
+	DMat4 r;
+	r.m[0][0] = 1.0 - 2.0 * (q.y * q.y + q.z * q.z);
+	r.m[0][1] = 2.0 * (q.x * q.y - q.w * q.z);
+	r.m[0][2] = 2.0 * (q.x * q.z + q.w * q.y);
+	r.m[1][0] = 2.0 * (q.x * q.y + q.w * q.z);
+	r.m[1][1] = 1.0 - 2.0 * (q.x * q.x + q.z * q.z);
+	r.m[1][2] = 2.0 * (q.y * q.z - q.w * q.x);
+	r.m[2][0] = 2.0 * (q.x * q.z - q.w * q.y);
+	r.m[2][1] = 2.0 * (q.y * q.z + q.w * q.x);
+	r.m[2][2] = 1.0 - 2.0 * (q.x * q.x + q.y * q.y);
+	return r;
+}
+
+/// Same rotation order as Quaternion::FromEulerAngles: Z first, then X, then Y. Angles in degrees.
+inline DQuat QuatFromEuler(double x, double y, double z)
+{
+	const double halfDegToRad = 3.14159265358979323846 / 360.0;
+	double sinX = sin(x * halfDegToRad), cosX = cos(x * halfDegToRad);
+	double sinY = sin(y * halfDegToRad), cosY = cos(y * halfDegToRad);
+	double sinZ = sin(z * halfDegToRad), cosZ = cos(z * halfDegToRad);
+	return DQuat(
+		cosY * cosX * cosZ + sinY * sinX * sinZ,
+		cosY * sinX * cosZ + sinY * cosX * sinZ,
+		sinY * cosX * cosZ - cosY * sinX * sinZ,
+		cosY * cosX * sinZ - sinY * sinX * cosZ);
+}
+
+/// Shortest-arc spherical interpolation of unit quaternions.
+inline DQuat Slerp(const DQuat& lhs, DQuat rhs, double t)
+{
+	double cosAngle = lhs.Dot(rhs);
+	if (cosAngle < 0.0) {
+		cosAngle = -cosAngle;
+		rhs = rhs * -1.0;
+	}
+	if (cosAngle > 1.0 - 1e-12)
+		return (lhs * (1.0 - t) + rhs * t).Normalized();
+	double angle = acos(cosAngle);
+	double invSin = 1.0 / sin(angle);
+	return lhs * (sin((1.0 - t) * angle) * invSin) + rhs * (sin(t * angle) * invSin);
+}
+
+/// Decomposition of an affine matrix with the conventions of Matrix3x4::Decompose: the rotation is the orthogonal
+/// factor of the polar decomposition of the upper-left block, found with the plain Newton iteration, after flipping
+/// the column of a mirroring matrix that points furthest away from its axis; the scale is the diagonal of the
+/// symmetric factor.
+inline void Decompose(const DMat4& m, DVec3& translation, DQuat& rotation, DVec3& scale)
+{
+	translation = DVec3(m.m[0][3], m.m[1][3], m.m[2][3]);
+	const DVec3 c[3] = {
+		DVec3(m.m[0][0], m.m[1][0], m.m[2][0]),
+		DVec3(m.m[0][1], m.m[1][1], m.m[2][1]),
+		DVec3(m.m[0][2], m.m[1][2], m.m[2][2]),
+	};
+	DVec3 q[3] = { c[0], c[1], c[2] };
+	if (c[0].Dot(c[1].Cross(c[2])) < 0.0) {
+		const double d[3] = { c[0].x / c[0].Length(), c[1].y / c[1].Length(), c[2].z / c[2].Length() };
+		unsigned k = d[0] <= d[1] && d[0] <= d[2] ? 0 : (d[1] <= d[2] ? 1 : 2);
+		q[k] = q[k] * -1.0;
+	}
+	for (unsigned iteration = 0; iteration < 100; ++iteration) {
+		const DVec3 cofactors[3] = { q[1].Cross(q[2]), q[2].Cross(q[0]), q[0].Cross(q[1]) };
+		double invDet = 1.0 / q[0].Dot(cofactors[0]);
+		double step = 0.0;
+		for (unsigned i = 0; i < 3; ++i) {
+			DVec3 next = (q[i] + cofactors[i] * invDet) * 0.5;
+			step += (next - q[i]).Dot(next - q[i]);
+			q[i] = next;
+		}
+		if (step < 1e-30)
+			break;
+	}
+
+	DMat4 r;
+	for (unsigned col = 0; col < 3; ++col) {
+		r.m[0][col] = q[col].x;
+		r.m[1][col] = q[col].y;
+		r.m[2][col] = q[col].z;
+	}
+	rotation = QuatFromRotation(r);
+	scale = DVec3(q[0].Dot(c[0]), q[1].Dot(c[1]), q[2].Dot(c[2]));
+}
+
+// Random inputs.
+
+inline Vector3 RandomVector3(Random& random, float range)
+{
+	return Vector3(random.Range(-range, range), random.Range(-range, range), random.Range(-range, range));
+}
+
+inline Quaternion RandomRotation(Random& random)
+{
+	for (;;) {
+		Quaternion q(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f));
+		float lenSquared = q.LengthSquared();
+		if (lenSquared > 0.01f && lenSquared <= 1.0f)
+			return q.Normalized();
+	}
+}
+
+/// Affine transform with translation in [-10, 10] and a positive scale in [0.5, 2] per axis.
+inline Matrix3x4 RandomTransform(Random& random)
+{
+	Vector3 scale(random.Range(0.5f, 2.0f), random.Range(0.5f, 2.0f), random.Range(0.5f, 2.0f));
+	return Matrix3x4(RandomVector3(random, 10.0f), RandomRotation(random), scale);
+}
+
+}
@@ -1,12 +1,18 @@
-local function __emit_log_fmt_func(fnlog)
+local _util_log_enabled = util_log_enabled
+local _util_log_allow   = util_log_allow
+
+-- The level is checked before the message is built, so that disabled logs cost no formatting.
+local function __emit_log_fmt_func(fnlog, level)
 	return function (fmt, ...)
+		if not _util_log_enabled(level) then return end
 		local msg = string.format(fmt, ...)
 		fnlog(msg)
 	end
 end
 
-local function __emit_log_func(fnlog)
+local function __emit_log_func(fnlog, level)
 	return function (...)
+		if not _util_log_enabled(level) then return end
 		local args = {...}
 		local argstrings = {}
 		for _, v in ipairs(args) do 
@@ -17,21 +23,37 @@ local function __emit_log_func(fnlog)
 	end
 end
 
+-- At most per_second messages a second from the line that calls the logger; the others are counted as suppressed.
+local function __emit_log_limited_func(fnlog, level)
+	return function (per_second, fmt, ...)
+		if not _util_log_allow(level, per_second, 2) then return end
+		local msg = string.format(fmt, ...)
+		fnlog(msg)
+	end
+end
+
 local _util_log_debug = util_log_debug
 local _util_log_info  = util_log_info 
 local _util_log_sys   = util_log_sys  
 local _util_log_warn  = util_log_warn 
 local _util_log_err   = util_log_err  
 
-log_fmt_debug = __emit_log_fmt_func(_util_log_debug)
-log_fmt_info  = __emit_log_fmt_func(_util_log_info )
-log_fmt_sys   = __emit_log_fmt_func(_util_log_sys  )
-log_fmt_warn  = __emit_log_fmt_func(_util_log_warn )
-log_fmt_err   = __emit_log_fmt_func(_util_log_err  )
-
-log_debug     = __emit_log_func(_util_log_debug)
-log_info      = __emit_log_func(_util_log_info )
-log_sys       = __emit_log_func(_util_log_sys  )
-log_warn      = __emit_log_func(_util_log_warn )
-log_err       = __emit_log_func(_util_log_err  )
+log_fmt_debug = __emit_log_fmt_func(_util_log_debug, "debug")
+log_fmt_info  = __emit_log_fmt_func(_util_log_info,  "info")
+log_fmt_sys   = __emit_log_fmt_func(_util_log_sys,   "sys")
+log_fmt_warn  = __emit_log_fmt_func(_util_log_warn,  "warn")
+log_fmt_err   = __emit_log_fmt_func(_util_log_err,   "err")
+
+log_debug     = __emit_log_func(_util_log_debug, "debug")
+log_info      = __emit_log_func(_util_log_info,  "info")
+log_sys       = __emit_log_func(_util_log_sys,   "sys")
+log_warn      = __emit_log_func(_util_log_warn,  "warn")
+log_err       = __emit_log_func(_util_log_err,   "err")
+
+log_limited_debug = __emit_log_limited_func(_util_log_debug, "debug")
+log_limited_info  = __emit_log_limited_func(_util_log_info,  "info")
+log_limited_sys   = __emit_log_limited_func(_util_log_sys,   "sys")
+log_limited_warn  = __emit_log_limited_func(_util_log_warn,  "warn")
+log_limited_err   = __emit_log_limited_func(_util_log_err,   "err")
+
 print         = log_debug
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Prints a binary log file of BinaryLogSink as the console's lines.
+//
+//   log_decode game.blog [-t]
+//
+// -t prints the steady clock time of every message in nanoseconds and its thread ahead of the line.
+
+#include "util/log_binary.h"
+#include "util/log_format.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	const char* path = nullptr;
+	bool times = false;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-t"))
+			times = true;
+		else
+			path = argv[i];
+	}
+	if (!path) {
+		fprintf(stderr, "usage: log_decode file [-t]\n");
+		return 2;
+	}
+
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		fprintf(stderr, "log_decode: cannot open %s\n", path);
+		return 1;
+	}
+	std::vector<char> data;
+	char chunk[1 << 16];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) != 0)
+		data.insert(data.end(), chunk, chunk + read);
+	fclose(file);
+
+	BinaryLogReader reader(data.data(), data.size());
+	if (!reader.IsValid()) {
+		fprintf(stderr, "log_decode: %s is not a binary log\n", path);
+		return 1;
+	}
+
+	LogRecord record;
+	LogClock clock;
+	char line[LOG_LINE_SIZE];
+	while (reader.Next(record)) {
+		util_log_format_line(line, sizeof(line), record, clock.Text(reader.WallTime(record)));
+		if (times)
+			printf("%lld %u ", record.time, record.thread);
+		puts(line);
+	}
+	return 0;
+}